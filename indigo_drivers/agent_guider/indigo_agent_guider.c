@@ -23,7 +23,7 @@
  \file indigo_agent_guider.c
  */
 
-#define DRIVER_VERSION 0x000C
+#define DRIVER_VERSION 0x0010
 #define DRIVER_NAME	"indigo_agent_guider"
 
 #include <stdlib.h>
@@ -32,11 +32,13 @@
 #include <math.h>
 #include <assert.h>
 #include <pthread.h>
+#include <fcntl.h>
 
 #include <indigo/indigo_driver_xml.h>
 #include <indigo/indigo_filter.h>
 #include <indigo/indigo_ccd_driver.h>
 #include <indigo/indigo_guider_utils.h>
+#include <indigo/indigo_io.h>
 
 #include "indigo_agent_guider.h"
 
@@ -50,6 +52,7 @@
 #define AGENT_GUIDER_DETECTION_DONUTS_ITEM  	(AGENT_GUIDER_DETECTION_MODE_PROPERTY->items+0)
 #define AGENT_GUIDER_DETECTION_SELECTION_ITEM (AGENT_GUIDER_DETECTION_MODE_PROPERTY->items+1)
 #define AGENT_GUIDER_DETECTION_CENTROID_ITEM  (AGENT_GUIDER_DETECTION_MODE_PROPERTY->items+2)
+#define AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM (AGENT_GUIDER_DETECTION_MODE_PROPERTY->items+3)
 
 #define AGENT_GUIDER_DEC_MODE_PROPERTY				(DEVICE_PRIVATE_DATA->agent_guider_dec_mode_property)
 #define AGENT_GUIDER_DEC_MODE_BOTH_ITEM    		(AGENT_GUIDER_DEC_MODE_PROPERTY->items+0)
@@ -57,6 +60,15 @@
 #define AGENT_GUIDER_DEC_MODE_SOUTH_ITEM    	(AGENT_GUIDER_DEC_MODE_PROPERTY->items+2)
 #define AGENT_GUIDER_DEC_MODE_NONE_ITEM    		(AGENT_GUIDER_DEC_MODE_PROPERTY->items+3)
 
+#define AGENT_GUIDER_ROI_MODE_PROPERTY				(DEVICE_PRIVATE_DATA->agent_guider_roi_mode_property)
+#define AGENT_GUIDER_ROI_MODE_DISABLED_ITEM  	(AGENT_GUIDER_ROI_MODE_PROPERTY->items+0)
+#define AGENT_GUIDER_ROI_MODE_WINDOW_ITEM  		(AGENT_GUIDER_ROI_MODE_PROPERTY->items+1)
+#define AGENT_GUIDER_ROI_MODE_SUBFRAME_ITEM  	(AGENT_GUIDER_ROI_MODE_PROPERTY->items+2)
+
+#define AGENT_GUIDER_CALIBRATION_MODE_PROPERTY	(DEVICE_PRIVATE_DATA->agent_guider_calibration_mode_property)
+#define AGENT_GUIDER_CALIBRATION_MODE_ALWAYS_ITEM	(AGENT_GUIDER_CALIBRATION_MODE_PROPERTY->items+0)
+#define AGENT_GUIDER_CALIBRATION_MODE_REUSE_ITEM	(AGENT_GUIDER_CALIBRATION_MODE_PROPERTY->items+1)
+
 #define AGENT_START_PROCESS_PROPERTY					(DEVICE_PRIVATE_DATA->agent_start_process_property)
 #define AGENT_GUIDER_START_PREVIEW_ITEM  			(AGENT_START_PROCESS_PROPERTY->items+0)
 #define AGENT_GUIDER_START_CALIBRATION_ITEM 	(AGENT_START_PROCESS_PROPERTY->items+1)
@@ -88,8 +100,14 @@
 #define AGENT_GUIDER_SETTINGS_STACK_ITEM  		(AGENT_GUIDER_SETTINGS_PROPERTY->items+18)
 #define AGENT_GUIDER_SETTINGS_DITH_X_ITEM  		(AGENT_GUIDER_SETTINGS_PROPERTY->items+19)
 #define AGENT_GUIDER_SETTINGS_DITH_Y_ITEM  		(AGENT_GUIDER_SETTINGS_PROPERTY->items+20)
+#define AGENT_GUIDER_SETTINGS_ROI_SIZE_ITEM  	(AGENT_GUIDER_SETTINGS_PROPERTY->items+21)
+#define AGENT_GUIDER_SETTINGS_STAR_COUNT_ITEM (AGENT_GUIDER_SETTINGS_PROPERTY->items+22)
+#define AGENT_GUIDER_SETTINGS_PEC_PERIOD_ITEM (AGENT_GUIDER_SETTINGS_PROPERTY->items+23)
+#define AGENT_GUIDER_SETTINGS_PEC_GAIN_ITEM		(AGENT_GUIDER_SETTINGS_PROPERTY->items+24)
 
 #define MAX_STAR_COUNT												50
+#define MAX_GUIDE_STARS												24
+#define MAX_LOST_FRAMES												5
 #define AGENT_GUIDER_STARS_PROPERTY						(DEVICE_PRIVATE_DATA->agent_stars_property)
 #define AGENT_GUIDER_STARS_REFRESH_ITEM  			(AGENT_GUIDER_STARS_PROPERTY->items+0)
 
@@ -100,6 +118,16 @@
 
 #define MAX_STACK															10
 #define MAX_DITHERING_RMSE_STACK							5
+
+#define MAX_CALIBRATIONS											32
+#define MAX_VALIDATION_PULSE									5
+#define VALIDATION_TOLERANCE									0.3
+#define MIN_COS_DEC														0.1
+
+#define PEC_HARMONICS													3
+#define PEC_MAX_TERMS													(2 + 2 * PEC_HARMONICS)
+#define PEC_FORGETTING												0.995
+#define PEC_INITIAL_COVARIANCE								1000
 #define AGENT_GUIDER_STATS_PROPERTY						(DEVICE_PRIVATE_DATA->agent_stats_property)
 #define AGENT_GUIDER_STATS_PHASE_ITEM      		(AGENT_GUIDER_STATS_PROPERTY->items+0)
 #define AGENT_GUIDER_STATS_FRAME_ITEM      		(AGENT_GUIDER_STATS_PROPERTY->items+1)
@@ -118,9 +146,25 @@
 #define AGENT_GUIDER_STATS_DITHERING_ITEM			(AGENT_GUIDER_STATS_PROPERTY->items+14)
 
 
+typedef struct {
+	int terms;
+	double theta[PEC_MAX_TERMS];
+	double p[PEC_MAX_TERMS][PEC_MAX_TERMS];
+	unsigned long samples;
+} pec_model;
+
+typedef struct {
+	char ccd[INDIGO_NAME_SIZE];
+	char guider[INDIGO_NAME_SIZE];
+	double angle, backlash, speed_ra, speed_dec, dec;
+	int side_of_pier;
+} calibration_entry;
+
 typedef struct {
 	indigo_property *agent_guider_detection_mode_property;
 	indigo_property *agent_guider_dec_mode_property;
+	indigo_property *agent_guider_roi_mode_property;
+	indigo_property *agent_guider_calibration_mode_property;
 	indigo_property *agent_start_process_property;
 	indigo_property *agent_abort_process_property;
 	indigo_property *agent_settings_property;
@@ -130,6 +174,19 @@ typedef struct {
 	bool properties_defined;
 	indigo_star_detection stars[MAX_STAR_COUNT];
 	indigo_frame_digest reference;
+	indigo_frame_digest digest;
+	indigo_frame_digest roi_reference;
+	indigo_frame_digest star_reference[MAX_GUIDE_STARS];
+	double star_x[MAX_GUIDE_STARS], star_y[MAX_GUIDE_STARS];
+	int star_lost[MAX_GUIDE_STARS];
+	int star_count;
+	bool roi_active;
+	int roi_x, roi_y, roi_size;
+	int roi_reference_x, roi_reference_y;
+	bool subframe;
+	int subframe_x, subframe_y;
+	double bin_x, bin_y;
+	double frame_left, frame_top, frame_width, frame_height;
 	double drift_x, drift_y, drift;
 	double avg_drift_x, avg_drift_y;
 	double rmse_ra_sum, rmse_dec_sum;
@@ -138,6 +195,10 @@ typedef struct {
 	enum { PREVIEW = -1, GUIDING, INIT, CLEAR_DEC, CLEAR_RA, MOVE_NORTH, MOVE_SOUTH, MOVE_WEST, MOVE_EAST, FAILED, DONE } phase;
 	double stack_x[MAX_STACK], stack_y[MAX_STACK];
 	int stack_size;
+	pec_model pec_ra, pec_dec;
+	double pec_start_time, pec_frame_time, pec_cycle;
+	double pec_guided_ra, pec_guided_dec;
+	bool pec_dithering;
 	pthread_mutex_t mutex;
 } agent_private_data;
 
@@ -148,6 +209,8 @@ static void save_config(indigo_device *device) {
 	indigo_save_property(device, NULL, AGENT_GUIDER_SETTINGS_PROPERTY);
 	indigo_save_property(device, NULL, AGENT_GUIDER_DETECTION_MODE_PROPERTY);
 	indigo_save_property(device, NULL, AGENT_GUIDER_DEC_MODE_PROPERTY);
+	indigo_save_property(device, NULL, AGENT_GUIDER_ROI_MODE_PROPERTY);
+	indigo_save_property(device, NULL, AGENT_GUIDER_CALIBRATION_MODE_PROPERTY);
 	if (DEVICE_CONTEXT->property_save_file_handle) {
 		CONFIG_PROPERTY->state = INDIGO_OK_STATE;
 		close(DEVICE_CONTEXT->property_save_file_handle);
@@ -160,6 +223,247 @@ static void save_config(indigo_device *device) {
 	pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->mutex);
 }
 
+static bool exposure_started(indigo_device *device, void *data) {
+	return ((indigo_property *)data)->state == INDIGO_BUSY_STATE || AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE;
+}
+
+static bool exposure_finished(indigo_device *device, void *data) {
+	indigo_property **properties = (indigo_property **)data;
+	return (properties[0]->state != INDIGO_BUSY_STATE && properties[1]->state != INDIGO_BUSY_STATE) || AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE;
+}
+
+static bool property_idle(indigo_device *device, void *data) {
+	return ((indigo_property *)data)->state != INDIGO_BUSY_STATE;
+}
+
+static bool roi_enabled(indigo_device *device) {
+	return AGENT_GUIDER_STATS_PHASE_ITEM->number.value == GUIDING && !AGENT_GUIDER_ROI_MODE_DISABLED_ITEM->sw.value && !AGENT_GUIDER_DETECTION_SELECTION_ITEM->sw.value && !AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM->sw.value;
+}
+
+static void select_subframe(indigo_device *device, bool window) {
+	if (window == DEVICE_PRIVATE_DATA->subframe && (!window || (DEVICE_PRIVATE_DATA->subframe_x == DEVICE_PRIVATE_DATA->roi_x && DEVICE_PRIVATE_DATA->subframe_y == DEVICE_PRIVATE_DATA->roi_y)))
+		return;
+	indigo_property *remote_frame_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_FRAME_PROPERTY_NAME);
+	if (remote_frame_property == NULL || remote_frame_property->perm == INDIGO_RO_PERM) {
+		DEVICE_PRIVATE_DATA->subframe = false;
+		return;
+	}
+	indigo_property *local_frame_property = indigo_copy_property(NULL, remote_frame_property);
+	if (local_frame_property == NULL)
+		return;
+	if (!DEVICE_PRIVATE_DATA->subframe) {
+		/* remember the frame selected by the user, window is relative to it and it is restored later */
+		DEVICE_PRIVATE_DATA->bin_x = DEVICE_PRIVATE_DATA->bin_y = 1;
+		indigo_property *remote_bin_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_BIN_PROPERTY_NAME);
+		for (int i = 0; remote_bin_property && i < remote_bin_property->count; i++) {
+			indigo_item *item = remote_bin_property->items + i;
+			if (!strcmp(item->name, CCD_BIN_HORIZONTAL_ITEM_NAME) && item->number.value > 0)
+				DEVICE_PRIVATE_DATA->bin_x = item->number.value;
+			else if (!strcmp(item->name, CCD_BIN_VERTICAL_ITEM_NAME) && item->number.value > 0)
+				DEVICE_PRIVATE_DATA->bin_y = item->number.value;
+		}
+		for (int i = 0; i < remote_frame_property->count; i++) {
+			indigo_item *item = remote_frame_property->items + i;
+			if (!strcmp(item->name, CCD_FRAME_LEFT_ITEM_NAME))
+				DEVICE_PRIVATE_DATA->frame_left = item->number.value;
+			else if (!strcmp(item->name, CCD_FRAME_TOP_ITEM_NAME))
+				DEVICE_PRIVATE_DATA->frame_top = item->number.value;
+			else if (!strcmp(item->name, CCD_FRAME_WIDTH_ITEM_NAME))
+				DEVICE_PRIVATE_DATA->frame_width = item->number.value;
+			else if (!strcmp(item->name, CCD_FRAME_HEIGHT_ITEM_NAME))
+				DEVICE_PRIVATE_DATA->frame_height = item->number.value;
+		}
+	}
+	for (int i = 0; i < local_frame_property->count; i++) {
+		indigo_item *item = local_frame_property->items + i;
+		if (!strcmp(item->name, CCD_FRAME_LEFT_ITEM_NAME))
+			item->number.value = DEVICE_PRIVATE_DATA->frame_left + (window ? DEVICE_PRIVATE_DATA->roi_x * DEVICE_PRIVATE_DATA->bin_x : 0);
+		else if (!strcmp(item->name, CCD_FRAME_TOP_ITEM_NAME))
+			item->number.value = DEVICE_PRIVATE_DATA->frame_top + (window ? DEVICE_PRIVATE_DATA->roi_y * DEVICE_PRIVATE_DATA->bin_y : 0);
+		else if (!strcmp(item->name, CCD_FRAME_WIDTH_ITEM_NAME))
+			item->number.value = window ? DEVICE_PRIVATE_DATA->roi_size * DEVICE_PRIVATE_DATA->bin_x : DEVICE_PRIVATE_DATA->frame_width;
+		else if (!strcmp(item->name, CCD_FRAME_HEIGHT_ITEM_NAME))
+			item->number.value = window ? DEVICE_PRIVATE_DATA->roi_size * DEVICE_PRIVATE_DATA->bin_y : DEVICE_PRIVATE_DATA->frame_height;
+	}
+	local_frame_property->access_token = indigo_get_device_or_master_token(local_frame_property->device);
+	indigo_change_property(FILTER_DEVICE_CONTEXT->client, local_frame_property);
+	indigo_release_property(local_frame_property);
+	DEVICE_PRIVATE_DATA->subframe = window;
+	DEVICE_PRIVATE_DATA->subframe_x = DEVICE_PRIVATE_DATA->roi_x;
+	DEVICE_PRIVATE_DATA->subframe_y = DEVICE_PRIVATE_DATA->roi_y;
+	if (window)
+		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Subframe [%d, %d] selected", DEVICE_PRIVATE_DATA->roi_x, DEVICE_PRIVATE_DATA->roi_y);
+	else
+		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Full frame restored");
+}
+
+static void image_origin(indigo_device *device, int *x, int *y) {
+	*x = *y = 0;
+	if (DEVICE_PRIVATE_DATA->subframe) {
+		/* driver may align the frame, so the origin is taken from the frame it really used */
+		indigo_property *remote_frame_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_FRAME_PROPERTY_NAME);
+		for (int i = 0; remote_frame_property && i < remote_frame_property->count; i++) {
+			indigo_item *item = remote_frame_property->items + i;
+			if (!strcmp(item->name, CCD_FRAME_LEFT_ITEM_NAME))
+				*x = (int)round((item->number.value - DEVICE_PRIVATE_DATA->frame_left) / DEVICE_PRIVATE_DATA->bin_x);
+			else if (!strcmp(item->name, CCD_FRAME_TOP_ITEM_NAME))
+				*y = (int)round((item->number.value - DEVICE_PRIVATE_DATA->frame_top) / DEVICE_PRIVATE_DATA->bin_y);
+		}
+	}
+}
+
+static indigo_result roi_digest(indigo_device *device, indigo_raw_header *header, int x, int y, indigo_frame_digest *digest) {
+	int origin_x, origin_y;
+	image_origin(device, &origin_x, &origin_y);
+	int size = DEVICE_PRIVATE_DATA->roi_size;
+	indigo_result result;
+	if (AGENT_GUIDER_DETECTION_DONUTS_ITEM->sw.value) {
+		result = indigo_donuts_roi_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, x - origin_x, y - origin_y, size, size, digest);
+		if (result == INDIGO_OK && digest->snr < 9)
+			result = INDIGO_GUIDE_ERROR;
+	} else {
+		indigo_delete_frame_digest(digest);
+		result = indigo_centroid_roi_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, x - origin_x, y - origin_y, size, size, digest);
+	}
+	if (result == INDIGO_OK) {
+		/* window position is kept relative to the full frame */
+		if (digest->algorithm == centroid) {
+			digest->centroid_x += origin_x;
+			digest->centroid_y += origin_y;
+		}
+		digest->roi_x += origin_x;
+		digest->roi_y += origin_y;
+	}
+	return result;
+}
+
+static void roi_reference(indigo_device *device, indigo_raw_header *header) {
+	int size = (int)AGENT_GUIDER_SETTINGS_ROI_SIZE_ITEM->number.value;
+	DEVICE_PRIVATE_DATA->roi_active = false;
+	indigo_delete_frame_digest(&DEVICE_PRIVATE_DATA->roi_reference);
+	/* window is worth it only if it is substantially smaller than the frame */
+	if (2 * size > header->width || 2 * size > header->height)
+		return;
+	indigo_star_detection star;
+	int star_count = 0;
+	indigo_find_stars(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, 1, &star, &star_count);
+	if (star_count == 0)
+		return;
+	DEVICE_PRIVATE_DATA->roi_size = size;
+	DEVICE_PRIVATE_DATA->roi_reference_x = (int)fmin(fmax(round(star.x) - size / 2, 0), header->width - size);
+	DEVICE_PRIVATE_DATA->roi_reference_y = (int)fmin(fmax(round(star.y) - size / 2, 0), header->height - size);
+	if (roi_digest(device, header, DEVICE_PRIVATE_DATA->roi_reference_x, DEVICE_PRIVATE_DATA->roi_reference_y, &DEVICE_PRIVATE_DATA->roi_reference) == INDIGO_OK) {
+		DEVICE_PRIVATE_DATA->roi_x = DEVICE_PRIVATE_DATA->roi_reference_x;
+		DEVICE_PRIVATE_DATA->roi_y = DEVICE_PRIVATE_DATA->roi_reference_y;
+		DEVICE_PRIVATE_DATA->roi_active = true;
+		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Guiding window %dx%d at [%d, %d]", size, size, DEVICE_PRIVATE_DATA->roi_x, DEVICE_PRIVATE_DATA->roi_y);
+	} else {
+		indigo_delete_frame_digest(&DEVICE_PRIVATE_DATA->roi_reference);
+	}
+}
+
+static void roi_follow(indigo_device *device, indigo_raw_header *header, double drift_x, double drift_y) {
+	if (DEVICE_PRIVATE_DATA->roi_reference.algorithm == none)
+		return;
+	int size = DEVICE_PRIVATE_DATA->roi_size;
+	int width = header->width, height = header->height;
+	if (DEVICE_PRIVATE_DATA->subframe) {
+		width = (int)round(DEVICE_PRIVATE_DATA->frame_width / DEVICE_PRIVATE_DATA->bin_x);
+		height = (int)round(DEVICE_PRIVATE_DATA->frame_height / DEVICE_PRIVATE_DATA->bin_y);
+	}
+	int x = (int)fmin(fmax(DEVICE_PRIVATE_DATA->roi_reference_x + round(drift_x), 0), width - size);
+	int y = (int)fmin(fmax(DEVICE_PRIVATE_DATA->roi_reference_y + round(drift_y), 0), height - size);
+	/* window is moved only if the star is far enough from its centre, so the subframe doesn't change every frame */
+	if (!DEVICE_PRIVATE_DATA->roi_active || abs(x - DEVICE_PRIVATE_DATA->roi_x) > size / 8 || abs(y - DEVICE_PRIVATE_DATA->roi_y) > size / 8) {
+		DEVICE_PRIVATE_DATA->roi_x = x;
+		DEVICE_PRIVATE_DATA->roi_y = y;
+		if (!DEVICE_PRIVATE_DATA->roi_active)
+			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Guiding window restored at [%d, %d]", x, y);
+		DEVICE_PRIVATE_DATA->roi_active = true;
+	}
+}
+
+static int compare_doubles(const void *a, const void *b) {
+	double d = *(const double *)a - *(const double *)b;
+	return d < 0 ? -1 : d > 0 ? 1 : 0;
+}
+
+static double median(double *values, int count) {
+	qsort(values, count, sizeof(double), compare_doubles);
+	return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+static indigo_result multi_star_reference(indigo_device *device, indigo_raw_header *header) {
+	int star_count = 0, max_count = (int)fmin(AGENT_GUIDER_SETTINGS_STAR_COUNT_ITEM->number.value, MAX_GUIDE_STARS);
+	for (int i = 0; i < DEVICE_PRIVATE_DATA->star_count; i++)
+		indigo_delete_frame_digest(DEVICE_PRIVATE_DATA->star_reference + i);
+	DEVICE_PRIVATE_DATA->star_count = 0;
+	indigo_find_stars(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, MAX_STAR_COUNT, (indigo_star_detection *)&DEVICE_PRIVATE_DATA->stars, &star_count);
+	for (int i = 0; i < star_count && DEVICE_PRIVATE_DATA->star_count < max_count; i++) {
+		int j = DEVICE_PRIVATE_DATA->star_count;
+		DEVICE_PRIVATE_DATA->star_x[j] = DEVICE_PRIVATE_DATA->stars[i].x;
+		DEVICE_PRIVATE_DATA->star_y[j] = DEVICE_PRIVATE_DATA->stars[i].y;
+		DEVICE_PRIVATE_DATA->star_lost[j] = 0;
+		if (indigo_selection_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), DEVICE_PRIVATE_DATA->star_x + j, DEVICE_PRIVATE_DATA->star_y + j, AGENT_GUIDER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, DEVICE_PRIVATE_DATA->star_reference + j) == INDIGO_OK)
+			DEVICE_PRIVATE_DATA->star_count++;
+	}
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Multi-star reference with %d of %d detected stars", DEVICE_PRIVATE_DATA->star_count, star_count);
+	if (DEVICE_PRIVATE_DATA->star_count == 0) {
+		indigo_send_message(device, "Can not detect any guide star");
+		return INDIGO_GUIDE_ERROR;
+	}
+	/* primary star stands for the whole set in selection and reference statistics */
+	DEVICE_PRIVATE_DATA->reference = DEVICE_PRIVATE_DATA->star_reference[0];
+	AGENT_GUIDER_SELECTION_X_ITEM->number.target = AGENT_GUIDER_SELECTION_X_ITEM->number.value = DEVICE_PRIVATE_DATA->star_x[0];
+	AGENT_GUIDER_SELECTION_Y_ITEM->number.target = AGENT_GUIDER_SELECTION_Y_ITEM->number.value = DEVICE_PRIVATE_DATA->star_y[0];
+	indigo_update_property(device, AGENT_GUIDER_SELECTION_PROPERTY, NULL);
+	return INDIGO_OK;
+}
+
+static indigo_result multi_star_drift(indigo_device *device, indigo_raw_header *header, double *drift_x, double *drift_y) {
+	double star_drift_x[MAX_GUIDE_STARS], star_drift_y[MAX_GUIDE_STARS], deviation[MAX_GUIDE_STARS];
+	double tmp_x[MAX_GUIDE_STARS], tmp_y[MAX_GUIDE_STARS];
+	int count = 0;
+	for (int i = 0; i < DEVICE_PRIVATE_DATA->star_count; i++) {
+		indigo_frame_digest digest = { 0 };
+		double x = DEVICE_PRIVATE_DATA->star_x[i], y = DEVICE_PRIVATE_DATA->star_y[i];
+		if (DEVICE_PRIVATE_DATA->star_lost[i] > MAX_LOST_FRAMES)
+			continue;
+		if (indigo_selection_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), &x, &y, AGENT_GUIDER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, &digest) == INDIGO_OK && indigo_calculate_drift(DEVICE_PRIVATE_DATA->star_reference + i, &digest, star_drift_x + count, star_drift_y + count) == INDIGO_OK) {
+			DEVICE_PRIVATE_DATA->star_x[i] = x;
+			DEVICE_PRIVATE_DATA->star_y[i] = y;
+			DEVICE_PRIVATE_DATA->star_lost[i] = 0;
+			count++;
+		} else if (++DEVICE_PRIVATE_DATA->star_lost[i] > MAX_LOST_FRAMES) {
+			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Guide star #%d lost", i);
+		}
+		indigo_delete_frame_digest(&digest);
+	}
+	if (count == 0)
+		return INDIGO_GUIDE_ERROR;
+	memcpy(tmp_x, star_drift_x, count * sizeof(double));
+	memcpy(tmp_y, star_drift_y, count * sizeof(double));
+	double median_x = median(tmp_x, count), median_y = median(tmp_y, count);
+	for (int i = 0; i < count; i++)
+		deviation[i] = hypot(star_drift_x[i] - median_x, star_drift_y[i] - median_y);
+	memcpy(tmp_x, deviation, count * sizeof(double));
+	/* stars deviating more than 3 sigma (MAD estimate, at least 0.1px) from median drift are clipped */
+	double limit = 3 * fmax(1.4826 * median(tmp_x, count), 0.1);
+	double sum_x = 0, sum_y = 0;
+	int used = 0;
+	for (int i = 0; i < count; i++) {
+		if (deviation[i] <= limit) {
+			sum_x += star_drift_x[i];
+			sum_y += star_drift_y[i];
+			used++;
+		}
+	}
+	*drift_x = sum_x / used;
+	*drift_y = sum_y / used;
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Multi-star drift from %d of %d stars", used, DEVICE_PRIVATE_DATA->star_count);
+	return INDIGO_OK;
+}
+
 static indigo_property_state capture_raw_frame(indigo_device *device) {
 	indigo_property *remote_exposure_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_EXPOSURE_PROPERTY_NAME);
 	indigo_property *remote_image_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_IMAGE_PROPERTY_NAME);
@@ -178,17 +482,16 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 				indigo_release_property(local_format_property);
 			}
 		}
-		indigo_property *local_exposure_property = indigo_init_number_property(NULL, remote_exposure_property->device, remote_exposure_property->name, NULL, NULL, INDIGO_OK_STATE, INDIGO_RW_PERM, remote_exposure_property->count);
+		select_subframe(device, DEVICE_PRIVATE_DATA->roi_active && AGENT_GUIDER_ROI_MODE_SUBFRAME_ITEM->sw.value && AGENT_GUIDER_STATS_FRAME_ITEM->number.value > 0 && roi_enabled(device));
+		indigo_property *local_exposure_property = indigo_copy_property(NULL, remote_exposure_property);
 		if (local_exposure_property == NULL) {
 			return INDIGO_ALERT_STATE;
 		} else {
-			memcpy(local_exposure_property, remote_exposure_property, sizeof(indigo_property) + remote_exposure_property->count * sizeof(indigo_item));
 			double time = AGENT_GUIDER_SETTINGS_EXPOSURE_ITEM->number.value;
 			local_exposure_property->items[0].number.value = time;
 			local_exposure_property->access_token = indigo_get_device_or_master_token(local_exposure_property->device);
 			indigo_change_property(FILTER_DEVICE_CONTEXT->client, local_exposure_property);
-			for (int i = 0; remote_exposure_property->state != INDIGO_BUSY_STATE && i < 1000 && AGENT_ABORT_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE; i++)
-				indigo_usleep(1000);
+			indigo_filter_wait(device, exposure_started, remote_exposure_property, 1);
 			if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
 				indigo_release_property(local_exposure_property);
 				return INDIGO_ALERT_STATE;
@@ -198,15 +501,9 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 				indigo_release_property(local_exposure_property);
 				return INDIGO_ALERT_STATE;
 			}
-			while ((remote_exposure_property->state == INDIGO_BUSY_STATE || remote_image_property->state == INDIGO_BUSY_STATE) && AGENT_ABORT_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE) {
-				if (time > 1) {
-					indigo_usleep(ONE_SECOND_DELAY);
-					time -= 1;
-				} else {
-					indigo_usleep(10000);
-					time -= 0.01;
-				}
-			}
+			indigo_property *remote_properties[] = { remote_exposure_property, remote_image_property };
+			while (!indigo_filter_wait(device, exposure_finished, remote_properties, 1))
+				;
 			if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
 				indigo_release_property(local_exposure_property);
 				return INDIGO_ALERT_STATE;
@@ -265,6 +562,8 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 								header->height,
 								&DEVICE_PRIVATE_DATA->reference
 							);
+						} else if (AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM->sw.value) {
+							result = multi_star_reference(device, header);
 						} else {
 							result = indigo_selection_frame_digest(
 								header->signature,
@@ -287,6 +586,10 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 								AGENT_GUIDER_STATS_REFERENCE_X_ITEM->number.value = DEVICE_PRIVATE_DATA->reference.centroid_x + AGENT_GUIDER_SETTINGS_DITH_X_ITEM->number.value;
 								AGENT_GUIDER_STATS_REFERENCE_Y_ITEM->number.value = DEVICE_PRIVATE_DATA->reference.centroid_y + AGENT_GUIDER_SETTINGS_DITH_Y_ITEM->number.value;
 							}
+							if (roi_enabled(device))
+								roi_reference(device, header);
+							else
+								DEVICE_PRIVATE_DATA->roi_active = false;
 							AGENT_GUIDER_STATS_FRAME_ITEM->number.value++;
 							indigo_update_property(device, AGENT_GUIDER_STATS_PROPERTY, NULL);
 						} else {
@@ -294,18 +597,49 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 							return INDIGO_ALERT_STATE;
 						}
 					} else {
-						indigo_frame_digest digest = { 0 };
+						/* donuts digest keeps its spectra between frames */
+						indigo_frame_digest *digest = &DEVICE_PRIVATE_DATA->digest;
+						indigo_frame_digest *reference = &DEVICE_PRIVATE_DATA->reference;
 						indigo_result result;
-						if (AGENT_GUIDER_DETECTION_DONUTS_ITEM->sw.value) {
-							result = indigo_donuts_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, &digest);
-							AGENT_GUIDER_STATS_SNR_ITEM->number.value = digest.snr;
-							if (AGENT_GUIDER_STATS_PHASE_ITEM->number.value >= GUIDING && digest.snr < 9) {
+						double drift_x = 0, drift_y = 0;
+						if (DEVICE_PRIVATE_DATA->roi_active && !roi_enabled(device))
+							DEVICE_PRIVATE_DATA->roi_active = false;
+						if (DEVICE_PRIVATE_DATA->roi_active && roi_digest(device, header, DEVICE_PRIVATE_DATA->roi_x, DEVICE_PRIVATE_DATA->roi_y, digest) != INDIGO_OK) {
+							DEVICE_PRIVATE_DATA->roi_active = false;
+							indigo_send_message(device, "Guide star lost in the window, searching full frame");
+							if (DEVICE_PRIVATE_DATA->subframe) {
+								DEVICE_PRIVATE_DATA->drift_x = DEVICE_PRIVATE_DATA->drift_y = 0;
+								indigo_release_property(local_exposure_property);
+								return INDIGO_OK_STATE;
+							}
+						}
+						if (DEVICE_PRIVATE_DATA->roi_active) {
+							/* only the window around the last solution was processed */
+							result = INDIGO_OK;
+							AGENT_GUIDER_STATS_SNR_ITEM->number.value = digest->snr;
+							reference = &DEVICE_PRIVATE_DATA->roi_reference;
+						} else if (AGENT_GUIDER_DETECTION_DONUTS_ITEM->sw.value) {
+							result = indigo_donuts_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, digest);
+							AGENT_GUIDER_STATS_SNR_ITEM->number.value = digest->snr;
+							if (AGENT_GUIDER_STATS_PHASE_ITEM->number.value >= GUIDING && digest->snr < 9) {
 								result = INDIGO_FAILED;
 								indigo_send_message(device, "Signal to noise ratio is poor, increase exposure time or use different star detection mode");
 							}
 						} else if (AGENT_GUIDER_DETECTION_CENTROID_ITEM->sw.value) {
-							result = indigo_centroid_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, &digest);
+							indigo_delete_frame_digest(digest);
+							result = indigo_centroid_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), header->width, header->height, digest);
+						} else if (AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM->sw.value) {
+							result = multi_star_drift(device, header, &drift_x, &drift_y);
+							if (result == INDIGO_GUIDE_ERROR) {
+								if (DEVICE_PRIVATE_DATA->drift_x || DEVICE_PRIVATE_DATA->drift_y) {
+									indigo_send_message(device, "Can not detect any guide star");
+									DEVICE_PRIVATE_DATA->drift_x = DEVICE_PRIVATE_DATA->drift_y = 0;
+								}
+								indigo_release_property(local_exposure_property);
+								return INDIGO_OK_STATE;
+							}
 						} else {
+							indigo_delete_frame_digest(digest);
 							result = indigo_selection_frame_digest(
 								header->signature,
 								(void*)header + sizeof(indigo_raw_header),
@@ -314,7 +648,7 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 								AGENT_GUIDER_SELECTION_RADIUS_ITEM->number.value,
 								header->width,
 								header->height,
-								&digest
+								digest
 							);
 							if (result == INDIGO_OK) {
 								indigo_update_property(device, AGENT_GUIDER_SELECTION_PROPERTY, NULL);
@@ -327,8 +661,10 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 							}
 						}
 						if (result == INDIGO_OK) {
-							double drift_x, drift_y;
-							result = indigo_calculate_drift(&DEVICE_PRIVATE_DATA->reference, &digest, &drift_x, &drift_y);
+							if (!AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM->sw.value)
+								result = indigo_calculate_drift(reference, digest, &drift_x, &drift_y);
+							if (result == INDIGO_OK && roi_enabled(device))
+								roi_follow(device, header, drift_x, drift_y);
 							DEVICE_PRIVATE_DATA->drift_x = drift_x - AGENT_GUIDER_SETTINGS_DITH_X_ITEM->number.value;
 							DEVICE_PRIVATE_DATA->drift_y = drift_y - AGENT_GUIDER_SETTINGS_DITH_Y_ITEM->number.value;
 							memcpy(DEVICE_PRIVATE_DATA->stack_x + 1, DEVICE_PRIVATE_DATA->stack_x, sizeof(double) * (MAX_STACK - 1));
@@ -363,7 +699,6 @@ static indigo_property_state capture_raw_frame(indigo_device *device) {
 							indigo_release_property(local_exposure_property);
 							return INDIGO_ALERT_STATE;
 						}
-						indigo_delete_frame_digest(&digest);
 					}
 				} else {
 					indigo_send_message(device, "Invalid image format, only RAW is supported");
@@ -384,11 +719,10 @@ static indigo_property_state pulse_guide(indigo_device *device, double ra, doubl
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "GUIDER_GUIDE_RA_PROPERTY not found");
 			return INDIGO_ALERT_STATE;
 		} else {
-			indigo_property *local_guide_property = indigo_init_number_property(NULL, remote_guide_property->device, remote_guide_property->name, NULL, NULL, INDIGO_OK_STATE, INDIGO_RW_PERM, remote_guide_property->count);
+			indigo_property *local_guide_property = indigo_copy_property(NULL, remote_guide_property);
 			if (remote_guide_property == NULL) {
 				return INDIGO_ALERT_STATE;
 			} else {
-				memcpy(local_guide_property, remote_guide_property, sizeof(indigo_property) + remote_guide_property->count * sizeof(indigo_item));
 				for (int i = 0; i < local_guide_property->count; i++) {
 					indigo_item *item = local_guide_property->items + i;
 					if (!strcmp(item->name, GUIDER_GUIDE_WEST_ITEM_NAME)) {
@@ -399,9 +733,8 @@ static indigo_property_state pulse_guide(indigo_device *device, double ra, doubl
 				}
 				local_guide_property->access_token = indigo_get_device_or_master_token(local_guide_property->device);
 				indigo_change_property(FILTER_DEVICE_CONTEXT->client, local_guide_property);
-				while (remote_guide_property->state == INDIGO_BUSY_STATE) {
-					indigo_usleep(50000);
-				}
+				while (!indigo_filter_wait(device, property_idle, remote_guide_property, 1))
+					;
 				indigo_release_property(local_guide_property);
 			}
 		}
@@ -412,11 +745,10 @@ static indigo_property_state pulse_guide(indigo_device *device, double ra, doubl
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "GUIDER_GUIDE_DEC_PROPERTY not found");
 			return INDIGO_ALERT_STATE;
 		} else {
-			indigo_property *local_guide_property = indigo_init_number_property(NULL, remote_guide_property->device, remote_guide_property->name, NULL, NULL, INDIGO_OK_STATE, INDIGO_RW_PERM, remote_guide_property->count);
+			indigo_property *local_guide_property = indigo_copy_property(NULL, remote_guide_property);
 			if (remote_guide_property == NULL) {
 				return INDIGO_ALERT_STATE;
 			} else {
-				memcpy(local_guide_property, remote_guide_property, sizeof(indigo_property) + remote_guide_property->count * sizeof(indigo_item));
 				for (int i = 0; i < local_guide_property->count; i++) {
 					indigo_item *item = local_guide_property->items + i;
 					if (!strcmp(item->name, GUIDER_GUIDE_NORTH_ITEM_NAME)) {
@@ -427,9 +759,8 @@ static indigo_property_state pulse_guide(indigo_device *device, double ra, doubl
 				}
 				local_guide_property->access_token = indigo_get_device_or_master_token(local_guide_property->device);
 				indigo_change_property(FILTER_DEVICE_CONTEXT->client, local_guide_property);
-				while (remote_guide_property->state == INDIGO_BUSY_STATE) {
-					indigo_usleep(50000);
-				}
+				while (!indigo_filter_wait(device, property_idle, remote_guide_property, 1))
+					;
 				indigo_release_property(local_guide_property);
 			}
 		}
@@ -437,6 +768,68 @@ static indigo_property_state pulse_guide(indigo_device *device, double ra, doubl
 	return INDIGO_OK_STATE;
 }
 
+/* Predictive guiding model: uncorrected mount error (measured drift minus accumulated guiding pulses) is fitted online by exponentially
+ * weighted recursive least squares to offset + linear drift + PEC_HARMONICS harmonics of worm period. Prediction of error change
+ * over next guiding cycle is issued as feed-forward part of correction pulse.
+ */
+
+static void pec_reset(pec_model *model, int terms) {
+	memset(model, 0, sizeof(pec_model));
+	model->terms = terms;
+	for (int i = 0; i < terms; i++)
+		model->p[i][i] = PEC_INITIAL_COVARIANCE;
+}
+
+static void pec_basis(double period, double t, int terms, double *phi) {
+	phi[0] = 1;
+	phi[1] = t / period;
+	for (int k = 1; 2 * k + 1 < terms; k++) {
+		double a = 2 * PI * k * t / period;
+		phi[2 * k] = sin(a);
+		phi[2 * k + 1] = cos(a);
+	}
+}
+
+static double pec_evaluate(pec_model *model, double period, double t) {
+	double phi[PEC_MAX_TERMS], value = 0;
+	pec_basis(period, t, model->terms, phi);
+	for (int i = 0; i < model->terms; i++)
+		value += model->theta[i] * phi[i];
+	return value;
+}
+
+static void pec_update(pec_model *model, double period, double t, double error) {
+	int n = model->terms;
+	double phi[PEC_MAX_TERMS], pphi[PEC_MAX_TERMS], gain[PEC_MAX_TERMS];
+	pec_basis(period, t, n, phi);
+	double denominator = PEC_FORGETTING, residual = error;
+	for (int i = 0; i < n; i++) {
+		pphi[i] = 0;
+		for (int j = 0; j < n; j++)
+			pphi[i] += model->p[i][j] * phi[j];
+		denominator += phi[i] * pphi[i];
+		residual -= model->theta[i] * phi[i];
+	}
+	for (int i = 0; i < n; i++) {
+		gain[i] = pphi[i] / denominator;
+		model->theta[i] += gain[i] * residual;
+	}
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++)
+			model->p[i][j] = (model->p[i][j] - gain[i] * pphi[j]) / PEC_FORGETTING;
+	model->samples++;
+}
+
+static void pec_rebase(pec_model *model, double period, double t, double error) {
+	model->theta[0] += error - pec_evaluate(model, period, t);
+}
+
+static double pec_time(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
 static void preview_process(indigo_device *device) {
 	AGENT_GUIDER_STATS_PHASE_ITEM->number.value = PREVIEW;
 	AGENT_GUIDER_STATS_FRAME_ITEM->number.value =
@@ -507,6 +900,164 @@ static bool guide_and_capture_frame(indigo_device *device, double ra, double dec
 
 static void guide_process(indigo_device *device);
 
+static bool mount_position(indigo_device *device, double *dec, int *side_of_pier) {
+	/* returns false if no mount is selected or its position is not known yet, dec is NAN then */
+	bool known = false;
+	*dec = NAN;
+	*side_of_pier = 0;
+	indigo_property *property = indigo_filter_cached_property(device, INDIGO_FILTER_MOUNT_INDEX, MOUNT_EQUATORIAL_COORDINATES_PROPERTY_NAME);
+	if (property) {
+		for (int i = 0; i < property->count; i++) {
+			if (!strcmp(property->items[i].name, MOUNT_EQUATORIAL_COORDINATES_DEC_ITEM_NAME)) {
+				*dec = property->items[i].number.value;
+				known = true;
+			}
+		}
+	}
+	if (!known)
+		return false;
+	property = indigo_filter_cached_property(device, INDIGO_FILTER_MOUNT_INDEX, MOUNT_SIDE_OF_PIER_PROPERTY_NAME);
+	if (property) {
+		for (int i = 0; i < property->count; i++) {
+			if (property->items[i].sw.value) {
+				if (!strcmp(property->items[i].name, MOUNT_SIDE_OF_PIER_EAST_ITEM_NAME))
+					*side_of_pier = 1;
+				else if (!strcmp(property->items[i].name, MOUNT_SIDE_OF_PIER_WEST_ITEM_NAME))
+					*side_of_pier = -1;
+			}
+		}
+	}
+	return true;
+}
+
+static int load_calibrations(indigo_device *device, calibration_entry *entries) {
+	int count = 0;
+	int handle = indigo_open_config_file(device->name, 0, O_RDONLY, ".calibration");
+	if (handle > 0) {
+		char buffer[1024];
+		indigo_reader reader;
+		indigo_init_reader(&reader, handle, 0);
+		while (count < MAX_CALIBRATIONS && indigo_reader_read_line(&reader, buffer, sizeof(buffer)) > 0) {
+			calibration_entry *entry = entries + count;
+			if (sscanf(buffer, "%127[^\t]\t%127[^\t]\t%lg %lg %lg %lg %lg %d", entry->ccd, entry->guider, &entry->angle, &entry->backlash, &entry->speed_ra, &entry->speed_dec, &entry->dec, &entry->side_of_pier) == 8)
+				count++;
+		}
+		close(handle);
+	}
+	return count;
+}
+
+static bool find_calibration(indigo_device *device, calibration_entry *entry) {
+	calibration_entry entries[MAX_CALIBRATIONS];
+	int count = load_calibrations(device, entries);
+	for (int i = 0; i < count; i++) {
+		if (!strcmp(entries[i].ccd, FILTER_DEVICE_CONTEXT->device_name[INDIGO_FILTER_CCD_INDEX]) && !strcmp(entries[i].guider, FILTER_DEVICE_CONTEXT->device_name[INDIGO_FILTER_GUIDER_INDEX])) {
+			*entry = entries[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+static void store_calibration(indigo_device *device) {
+	calibration_entry entries[MAX_CALIBRATIONS];
+	int count = load_calibrations(device, entries), index = 0;
+	/* most recent calibration goes first, the oldest one falls out when the table is full */
+	for (int i = 0; i < count; i++) {
+		if (!strcmp(entries[i].ccd, FILTER_DEVICE_CONTEXT->device_name[INDIGO_FILTER_CCD_INDEX]) && !strcmp(entries[i].guider, FILTER_DEVICE_CONTEXT->device_name[INDIGO_FILTER_GUIDER_INDEX]))
+			continue;
+		if (index < MAX_CALIBRATIONS - 1)
+			entries[index++] = entries[i];
+	}
+	int handle = indigo_open_config_file(device->name, 0, O_WRONLY | O_CREAT | O_TRUNC, ".calibration");
+	if (handle > 0) {
+		char b1[32], b2[32], b3[32], b4[32], b5[32];
+		double dec;
+		int side_of_pier;
+		mount_position(device, &dec, &side_of_pier);
+		indigo_printf(handle, "%s\t%s\t%s %s %s %s %s %d\n", FILTER_DEVICE_CONTEXT->device_name[INDIGO_FILTER_CCD_INDEX], FILTER_DEVICE_CONTEXT->device_name[INDIGO_FILTER_GUIDER_INDEX], indigo_dtoa(AGENT_GUIDER_SETTINGS_ANGLE_ITEM->number.value, b1), indigo_dtoa(AGENT_GUIDER_SETTINGS_BACKLASH_ITEM->number.value, b2), indigo_dtoa(AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value, b3), indigo_dtoa(AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value, b4), indigo_dtoa(dec, b5), side_of_pier);
+		for (int i = 0; i < index; i++) {
+			calibration_entry *entry = entries + i;
+			indigo_printf(handle, "%s\t%s\t%s %s %s %s %s %d\n", entry->ccd, entry->guider, indigo_dtoa(entry->angle, b1), indigo_dtoa(entry->backlash, b2), indigo_dtoa(entry->speed_ra, b3), indigo_dtoa(entry->speed_dec, b4), indigo_dtoa(entry->dec, b5), entry->side_of_pier);
+		}
+		close(handle);
+	}
+}
+
+static bool apply_calibration(indigo_device *device) {
+	calibration_entry entry;
+	double dec;
+	int side_of_pier;
+	if (!find_calibration(device, &entry))
+		return false;
+	double angle = entry.angle, scale = 1;
+	/* entry stored without mount has NAN declination, without known position on either side the entry is used unscaled */
+	if (mount_position(device, &dec, &side_of_pier) && !isnan(entry.dec)) {
+		double cos_dec = cos(PI * dec / 180), cos_entry_dec = cos(PI * entry.dec / 180);
+		if (cos_dec < MIN_COS_DEC || cos_entry_dec < MIN_COS_DEC) {
+			indigo_send_message(device, "Cached calibration can't be used close to the pole");
+			return false;
+		}
+		scale = cos_dec / cos_entry_dec;
+		if (side_of_pier && entry.side_of_pier && side_of_pier != entry.side_of_pier) {
+			/* after meridian flip the camera is rotated by 180° relative to the sky */
+			angle = angle > 0 ? angle - 180 : angle + 180;
+		}
+	}
+	AGENT_GUIDER_SETTINGS_ANGLE_ITEM->number.value = AGENT_GUIDER_SETTINGS_ANGLE_ITEM->number.target = angle;
+	AGENT_GUIDER_SETTINGS_BACKLASH_ITEM->number.value = AGENT_GUIDER_SETTINGS_BACKLASH_ITEM->number.target = entry.backlash;
+	AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value = AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.target = round(1000 * entry.speed_ra * scale) / 1000;
+	AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value = AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.target = entry.speed_dec;
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Cached calibration calibrated at dec %g side %d used at dec %g side %d", entry.dec, entry.side_of_pier, dec, side_of_pier);
+	indigo_update_property(device, AGENT_GUIDER_SETTINGS_PROPERTY, NULL);
+	return true;
+}
+
+/* pulse one axis, drift in guiding coordinates has to match the speed on the pulsed axis and stay small on the other one, the star is pulsed back then */
+static bool validate_axis(indigo_device *device, double ra, double dec, double speed, bool *valid) {
+	double step = ra ? ra : dec;
+	AGENT_GUIDER_STATS_FRAME_ITEM->number.value = AGENT_GUIDER_STATS_DRIFT_X_ITEM->number.value = AGENT_GUIDER_STATS_DRIFT_Y_ITEM->number.value = 0;
+	if (capture_raw_frame(device) != INDIGO_OK_STATE)
+		return false;
+	indigo_update_property(device, AGENT_GUIDER_STATS_PROPERTY, ra ? "Validating cached calibration in RA" : "Validating cached calibration in Dec");
+	if (!guide_and_capture_frame(device, ra, dec))
+		return false;
+	indigo_update_property(device, AGENT_GUIDER_STATS_PROPERTY, NULL);
+	double angle = -PI * AGENT_GUIDER_SETTINGS_ANGLE_ITEM->number.value / 180;
+	double drift_ra = DEVICE_PRIVATE_DATA->drift_x * cos(angle) + DEVICE_PRIVATE_DATA->drift_y * sin(angle);
+	double drift_dec = DEVICE_PRIVATE_DATA->drift_x * sin(angle) - DEVICE_PRIVATE_DATA->drift_y * cos(angle);
+	double expected = step * speed, along = ra ? drift_ra : drift_dec, across = ra ? drift_dec : drift_ra;
+	/* sign of the drift is checked too, wrong direction means angle is off by 180° and guiding would run away */
+	*valid = fabs(along - expected) < VALIDATION_TOLERANCE * fabs(expected) && fabs(across) < VALIDATION_TOLERANCE * fabs(expected);
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Calibration validation: expected %s drift %.3gpx, measured %.3gpx RA %.3gpx Dec -> %s", ra ? "RA" : "Dec", expected, drift_ra, drift_dec, *valid ? "valid" : "invalid");
+	return pulse_guide(device, -ra, -dec) == INDIGO_OK_STATE;
+}
+
+static bool validate_calibration(indigo_device *device) {
+	double speed_ra = AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value;
+	double speed_dec = AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value;
+	bool valid = false;
+	if (speed_ra == 0)
+		return false;
+	double step = fmin(AGENT_GUIDER_SETTINGS_CAL_DRIFT_ITEM->number.value / 2 / fabs(speed_ra), MAX_VALIDATION_PULSE);
+	if (!validate_axis(device, step, 0, speed_ra, &valid) || !valid)
+		return false;
+	if (AGENT_GUIDER_DEC_MODE_NONE_ITEM->sw.value)
+		return true;
+	if (speed_dec == 0)
+		return false;
+	step = fmin(AGENT_GUIDER_SETTINGS_CAL_DRIFT_ITEM->number.value / 2 / fabs(speed_dec), MAX_VALIDATION_PULSE);
+	/* backlash is taken up by a pulse in the same direction before the reference frame, so the measured drift isn't shortened by it */
+	double backlash = fmin(AGENT_GUIDER_SETTINGS_BACKLASH_ITEM->number.value / fabs(speed_dec), MAX_VALIDATION_PULSE);
+	if (backlash > 0 && pulse_guide(device, 0, backlash) != INDIGO_OK_STATE)
+		return false;
+	if (!validate_axis(device, 0, step, speed_dec, &valid))
+		return false;
+	if (backlash > 0 && pulse_guide(device, 0, -backlash) != INDIGO_OK_STATE)
+		return false;
+	return valid;
+}
+
 static void _calibrate_process(indigo_device *device, bool will_guide) {
 	indigo_delete_property(device, AGENT_GUIDER_DETECTION_MODE_PROPERTY, NULL);
 	AGENT_GUIDER_DETECTION_MODE_PROPERTY->perm = INDIGO_RO_PERM;
@@ -516,6 +1067,7 @@ static void _calibrate_process(indigo_device *device, bool will_guide) {
 	indigo_define_property(device, AGENT_GUIDER_SELECTION_PROPERTY, NULL);
 	double last_drift = 0, dec_angle = 0;
 	int last_count = 0;
+	bool cached = false;
 	AGENT_GUIDER_STATS_PHASE_ITEM->number.value = DEVICE_PRIVATE_DATA->phase = INIT;
 	AGENT_GUIDER_STATS_FRAME_ITEM->number.value =
 	AGENT_GUIDER_STATS_FRAME_ITEM->number.value =
@@ -538,6 +1090,15 @@ static void _calibrate_process(indigo_device *device, bool will_guide) {
 
 	indigo_update_property(device, AGENT_GUIDER_STATS_PROPERTY, NULL);
 	indigo_update_property(device, AGENT_GUIDER_SETTINGS_PROPERTY, NULL);
+	if (AGENT_GUIDER_CALIBRATION_MODE_REUSE_ITEM->sw.value && apply_calibration(device)) {
+		if (validate_calibration(device)) {
+			indigo_send_message(device, "Cached calibration reused");
+			cached = true;
+			DEVICE_PRIVATE_DATA->phase = DONE;
+		} else if (AGENT_START_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
+			indigo_send_message(device, "Cached calibration validation failed");
+		}
+	}
 	while (AGENT_START_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
 		AGENT_GUIDER_STATS_PHASE_ITEM->number.value = DEVICE_PRIVATE_DATA->phase;
 		switch (DEVICE_PRIVATE_DATA->phase) {
@@ -756,7 +1317,10 @@ static void _calibrate_process(indigo_device *device, bool will_guide) {
 				break;
 			}
 			case DONE: {
-				indigo_send_message(device, "Calibration done");
+				if (!cached) {
+					indigo_send_message(device, "Calibration done");
+					store_calibration(device);
+				}
 				save_config(device);
 				AGENT_START_PROCESS_PROPERTY->state = INDIGO_OK_STATE;
 				break;
@@ -819,6 +1383,12 @@ static void guide_process(indigo_device *device) {
 
 	indigo_update_property(device, AGENT_GUIDER_SETTINGS_PROPERTY, NULL);
 	DEVICE_PRIVATE_DATA->rmse_ra_sum = DEVICE_PRIVATE_DATA->rmse_dec_sum = DEVICE_PRIVATE_DATA->rmse_count = 0;
+	pec_reset(&DEVICE_PRIVATE_DATA->pec_ra, PEC_MAX_TERMS);
+	pec_reset(&DEVICE_PRIVATE_DATA->pec_dec, 2);
+	DEVICE_PRIVATE_DATA->pec_start_time = DEVICE_PRIVATE_DATA->pec_frame_time = pec_time();
+	DEVICE_PRIVATE_DATA->pec_cycle = 0;
+	DEVICE_PRIVATE_DATA->pec_guided_ra = DEVICE_PRIVATE_DATA->pec_guided_dec = 0;
+	DEVICE_PRIVATE_DATA->pec_dithering = false;
 	indigo_send_message(device, "Guiding started");
 	indigo_update_property(device, AGENT_GUIDER_STATS_PROPERTY, NULL);
 	if (capture_raw_frame(device) != INDIGO_OK_STATE) {
@@ -843,8 +1413,36 @@ static void guide_process(indigo_device *device) {
 			AGENT_GUIDER_STATS_DRIFT_RA_ITEM->number.value = round(1000 * drift_ra) / 1000;
 			AGENT_GUIDER_STATS_DRIFT_DEC_ITEM->number.value = round(1000 * drift_dec) / 1000;
 			double correction_ra = 0, correction_dec = 0;
-			if (fabs(drift_ra) > min_error) {
-				correction_ra = -AGENT_GUIDER_SETTINGS_AGG_RA_ITEM->number.value * (drift_ra * AGENT_GUIDER_SETTINGS_PW_RA_ITEM->number.value + avg_drift_ra * (1 - AGENT_GUIDER_SETTINGS_PW_RA_ITEM->number.value)) / AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value / 100;
+			double pec_period = AGENT_GUIDER_SETTINGS_PEC_PERIOD_ITEM->number.value;
+			if (pec_period > 0) {
+				double now = pec_time();
+				double t = now - DEVICE_PRIVATE_DATA->pec_start_time;
+				DEVICE_PRIVATE_DATA->pec_cycle = now - DEVICE_PRIVATE_DATA->pec_frame_time;
+				DEVICE_PRIVATE_DATA->pec_frame_time = now;
+				double error_ra = drift_ra - DEVICE_PRIVATE_DATA->pec_guided_ra;
+				double error_dec = drift_dec - DEVICE_PRIVATE_DATA->pec_guided_dec;
+				if (AGENT_GUIDER_STATS_DITHERING_ITEM->number.value != 0) {
+					DEVICE_PRIVATE_DATA->pec_dithering = true;
+				} else if (DEVICE_PRIVATE_DATA->pec_dithering) {
+					/* reference moved by dithering, keep learned shape and shift offset only */
+					pec_rebase(&DEVICE_PRIVATE_DATA->pec_ra, pec_period, t, error_ra);
+					pec_rebase(&DEVICE_PRIVATE_DATA->pec_dec, pec_period, t, error_dec);
+					DEVICE_PRIVATE_DATA->pec_dithering = false;
+				} else {
+					pec_update(&DEVICE_PRIVATE_DATA->pec_ra, pec_period, t, error_ra);
+					pec_update(&DEVICE_PRIVATE_DATA->pec_dec, pec_period, t, error_dec);
+				}
+				if (t >= pec_period && !DEVICE_PRIVATE_DATA->pec_dithering) {
+					double gain = AGENT_GUIDER_SETTINGS_PEC_GAIN_ITEM->number.value / 100;
+					double next = t + DEVICE_PRIVATE_DATA->pec_cycle;
+					correction_ra = -gain * (pec_evaluate(&DEVICE_PRIVATE_DATA->pec_ra, pec_period, next) - pec_evaluate(&DEVICE_PRIVATE_DATA->pec_ra, pec_period, t)) / AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value;
+					correction_dec = -gain * (pec_evaluate(&DEVICE_PRIVATE_DATA->pec_dec, pec_period, next) - pec_evaluate(&DEVICE_PRIVATE_DATA->pec_dec, pec_period, t)) / AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value;
+					INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Predictive correction RA %.3fs, Dec %.3fs over %.1fs", correction_ra, correction_dec, DEVICE_PRIVATE_DATA->pec_cycle);
+				}
+			}
+			if (fabs(drift_ra) > min_error || correction_ra) {
+				if (fabs(drift_ra) > min_error)
+					correction_ra -= AGENT_GUIDER_SETTINGS_AGG_RA_ITEM->number.value * (drift_ra * AGENT_GUIDER_SETTINGS_PW_RA_ITEM->number.value + avg_drift_ra * (1 - AGENT_GUIDER_SETTINGS_PW_RA_ITEM->number.value)) / AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value / 100;
 				if (correction_ra > max_pulse)
 					correction_ra = max_pulse;
 				else if (correction_ra < -max_pulse)
@@ -852,8 +1450,9 @@ static void guide_process(indigo_device *device) {
 				else if (fabs(correction_ra) < min_pulse)
 					correction_ra = 0;
 			}
-			if (fabs(drift_dec) > min_error) {
-				correction_dec = -AGENT_GUIDER_SETTINGS_AGG_DEC_ITEM->number.value * (drift_dec * AGENT_GUIDER_SETTINGS_PW_DEC_ITEM->number.value + avg_drift_dec * (1 - AGENT_GUIDER_SETTINGS_PW_DEC_ITEM->number.value))/ AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value / 100;
+			if (fabs(drift_dec) > min_error || correction_dec) {
+				if (fabs(drift_dec) > min_error)
+					correction_dec -= AGENT_GUIDER_SETTINGS_AGG_DEC_ITEM->number.value * (drift_dec * AGENT_GUIDER_SETTINGS_PW_DEC_ITEM->number.value + avg_drift_dec * (1 - AGENT_GUIDER_SETTINGS_PW_DEC_ITEM->number.value))/ AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value / 100;
 				if (correction_dec > max_pulse)
 					correction_dec = max_pulse;
 				else if (correction_dec < -max_pulse)
@@ -873,6 +1472,8 @@ static void guide_process(indigo_device *device) {
 				AGENT_START_PROCESS_PROPERTY->state = AGENT_START_PROCESS_PROPERTY->state == INDIGO_OK_STATE ? INDIGO_OK_STATE : INDIGO_ALERT_STATE;
 				break;
 			}
+			DEVICE_PRIVATE_DATA->pec_guided_ra += correction_ra * AGENT_GUIDER_SETTINGS_SPEED_RA_ITEM->number.value;
+			DEVICE_PRIVATE_DATA->pec_guided_dec += correction_dec * AGENT_GUIDER_SETTINGS_SPEED_DEC_ITEM->number.value;
 			if (AGENT_GUIDER_STATS_DITHERING_ITEM->number.value == 0) {
 				DEVICE_PRIVATE_DATA->rmse_ra_sum += drift_ra * drift_ra;
 				DEVICE_PRIVATE_DATA->rmse_dec_sum += drift_dec * drift_dec;
@@ -921,6 +1522,8 @@ static void guide_process(indigo_device *device) {
 		}
 		indigo_update_property(device, AGENT_GUIDER_STATS_PROPERTY, NULL);
 	}
+	DEVICE_PRIVATE_DATA->roi_active = false;
+	select_subframe(device, false);
 	indigo_delete_property(device, AGENT_GUIDER_DETECTION_MODE_PROPERTY, NULL);
 	AGENT_GUIDER_DETECTION_MODE_PROPERTY->perm = INDIGO_RW_PERM;
 	indigo_define_property(device, AGENT_GUIDER_DETECTION_MODE_PROPERTY, NULL);
@@ -989,13 +1592,15 @@ static indigo_result agent_device_attach(indigo_device *device) {
 		// -------------------------------------------------------------------------------- Device properties
 		FILTER_CCD_LIST_PROPERTY->hidden = false;
 		FILTER_GUIDER_LIST_PROPERTY->hidden = false;
+		FILTER_MOUNT_LIST_PROPERTY->hidden = false;
 		// -------------------------------------------------------------------------------- Process properties
-		AGENT_GUIDER_DETECTION_MODE_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_GUIDER_DETECTION_MODE_PROPERTY_NAME, "Agent", "Drift detection mode", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 3);
+		AGENT_GUIDER_DETECTION_MODE_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_GUIDER_DETECTION_MODE_PROPERTY_NAME, "Agent", "Drift detection mode", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 4);
 		if (AGENT_GUIDER_DETECTION_MODE_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_switch_item(AGENT_GUIDER_DETECTION_DONUTS_ITEM, AGENT_GUIDER_DETECTION_DONUTS_ITEM_NAME, "Donuts", true);
 		indigo_init_switch_item(AGENT_GUIDER_DETECTION_SELECTION_ITEM, AGENT_GUIDER_DETECTION_SELECTION_ITEM_NAME, "Selection", false);
 		indigo_init_switch_item(AGENT_GUIDER_DETECTION_CENTROID_ITEM, AGENT_GUIDER_DETECTION_CENTROID_ITEM_NAME, "Centroid", false);
+		indigo_init_switch_item(AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM, AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM_NAME, "Multi-star", false);
 		AGENT_GUIDER_DEC_MODE_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_GUIDER_DEC_MODE_PROPERTY_NAME, "Agent", "Dec guiding mode", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 4);
 		if (AGENT_GUIDER_DEC_MODE_PROPERTY == NULL)
 			return INDIGO_FAILED;
@@ -1003,6 +1608,17 @@ static indigo_result agent_device_attach(indigo_device *device) {
 		indigo_init_switch_item(AGENT_GUIDER_DEC_MODE_NORTH_ITEM, AGENT_GUIDER_DEC_MODE_NORTH_ITEM_NAME, "North only", false);
 		indigo_init_switch_item(AGENT_GUIDER_DEC_MODE_SOUTH_ITEM, AGENT_GUIDER_DEC_MODE_SOUTH_ITEM_NAME, "South only", false);
 		indigo_init_switch_item(AGENT_GUIDER_DEC_MODE_NONE_ITEM, AGENT_GUIDER_DEC_MODE_NONE_ITEM_NAME, "None", false);
+		AGENT_GUIDER_ROI_MODE_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_GUIDER_ROI_MODE_PROPERTY_NAME, "Agent", "Guiding window", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 3);
+		if (AGENT_GUIDER_ROI_MODE_PROPERTY == NULL)
+			return INDIGO_FAILED;
+		indigo_init_switch_item(AGENT_GUIDER_ROI_MODE_DISABLED_ITEM, AGENT_GUIDER_ROI_MODE_DISABLED_ITEM_NAME, "Full frame", true);
+		indigo_init_switch_item(AGENT_GUIDER_ROI_MODE_WINDOW_ITEM, AGENT_GUIDER_ROI_MODE_WINDOW_ITEM_NAME, "Process window only", false);
+		indigo_init_switch_item(AGENT_GUIDER_ROI_MODE_SUBFRAME_ITEM, AGENT_GUIDER_ROI_MODE_SUBFRAME_ITEM_NAME, "Process and download window only", false);
+		AGENT_GUIDER_CALIBRATION_MODE_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_GUIDER_CALIBRATION_MODE_PROPERTY_NAME, "Agent", "Calibration mode", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 2);
+		if (AGENT_GUIDER_CALIBRATION_MODE_PROPERTY == NULL)
+			return INDIGO_FAILED;
+		indigo_init_switch_item(AGENT_GUIDER_CALIBRATION_MODE_ALWAYS_ITEM, AGENT_GUIDER_CALIBRATION_MODE_ALWAYS_ITEM_NAME, "Always calibrate", true);
+		indigo_init_switch_item(AGENT_GUIDER_CALIBRATION_MODE_REUSE_ITEM, AGENT_GUIDER_CALIBRATION_MODE_REUSE_ITEM_NAME, "Reuse validated calibration", false);
 		AGENT_START_PROCESS_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_START_PROCESS_PROPERTY_NAME, "Agent", "Start process", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, 4);
 		if (AGENT_START_PROCESS_PROPERTY == NULL)
 			return INDIGO_FAILED;
@@ -1015,7 +1631,7 @@ static indigo_result agent_device_attach(indigo_device *device) {
 			return INDIGO_FAILED;
 		indigo_init_switch_item(AGENT_ABORT_PROCESS_ITEM, AGENT_ABORT_PROCESS_ITEM_NAME, "Abort", false);
 		// -------------------------------------------------------------------------------- Guiding settings
-		AGENT_GUIDER_SETTINGS_PROPERTY = indigo_init_number_property(NULL, device->name, AGENT_GUIDER_SETTINGS_PROPERTY_NAME, "Agent", "Settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 21);
+		AGENT_GUIDER_SETTINGS_PROPERTY = indigo_init_number_property(NULL, device->name, AGENT_GUIDER_SETTINGS_PROPERTY_NAME, "Agent", "Settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 25);
 		if (AGENT_GUIDER_SETTINGS_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(AGENT_GUIDER_SETTINGS_EXPOSURE_ITEM, AGENT_GUIDER_SETTINGS_EXPOSURE_ITEM_NAME, "Exposure time (s)", 0, 60, 0, 1);
@@ -1039,6 +1655,10 @@ static indigo_result agent_device_attach(indigo_device *device) {
 		indigo_init_number_item(AGENT_GUIDER_SETTINGS_STACK_ITEM, AGENT_GUIDER_SETTINGS_STACK_ITEM_NAME, "Integral stacking", 1, MAX_STACK, 1, 1);
 		indigo_init_number_item(AGENT_GUIDER_SETTINGS_DITH_X_ITEM, AGENT_GUIDER_SETTINGS_DITH_X_ITEM_NAME, "Dithering offset X (px)", -15, 15, 0, 0);
 		indigo_init_number_item(AGENT_GUIDER_SETTINGS_DITH_Y_ITEM, AGENT_GUIDER_SETTINGS_DITH_Y_ITEM_NAME, "Dithering offset Y (px)", -15, 15, 0, 0);
+		indigo_init_number_item(AGENT_GUIDER_SETTINGS_ROI_SIZE_ITEM, AGENT_GUIDER_SETTINGS_ROI_SIZE_ITEM_NAME, "Guiding window size (px)", 32, 1024, 16, 128);
+		indigo_init_number_item(AGENT_GUIDER_SETTINGS_STAR_COUNT_ITEM, AGENT_GUIDER_SETTINGS_STAR_COUNT_ITEM_NAME, "Multi-star guide stars", 1, MAX_GUIDE_STARS, 1, 5);
+		indigo_init_number_item(AGENT_GUIDER_SETTINGS_PEC_PERIOD_ITEM, AGENT_GUIDER_SETTINGS_PEC_PERIOD_ITEM_NAME, "Predictive PEC period (s, 0 = off)", 0, 3600, 1, 0);
+		indigo_init_number_item(AGENT_GUIDER_SETTINGS_PEC_GAIN_ITEM, AGENT_GUIDER_SETTINGS_PEC_GAIN_ITEM_NAME, "Predictive PEC gain (%)", 0, 100, 5, 50);
 		// -------------------------------------------------------------------------------- Detected stars
 		AGENT_GUIDER_STARS_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_GUIDER_STARS_PROPERTY_NAME, "Agent", "Stars", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, MAX_STAR_COUNT + 1);
 		if (AGENT_GUIDER_STARS_PROPERTY == NULL)
@@ -1096,6 +1716,10 @@ static indigo_result agent_enumerate_properties(indigo_device *device, indigo_cl
 		indigo_define_property(device, AGENT_GUIDER_STATS_PROPERTY, NULL);
 	if (indigo_property_match(AGENT_GUIDER_DEC_MODE_PROPERTY, property))
 		indigo_define_property(device, AGENT_GUIDER_DEC_MODE_PROPERTY, NULL);
+	if (indigo_property_match(AGENT_GUIDER_ROI_MODE_PROPERTY, property))
+		indigo_define_property(device, AGENT_GUIDER_ROI_MODE_PROPERTY, NULL);
+	if (indigo_property_match(AGENT_GUIDER_CALIBRATION_MODE_PROPERTY, property))
+		indigo_define_property(device, AGENT_GUIDER_CALIBRATION_MODE_PROPERTY, NULL);
 	if (!FILTER_CCD_LIST_PROPERTY->items->sw.value) {
 		if (indigo_property_match(AGENT_START_PROCESS_PROPERTY, property))
 			indigo_define_property(device, AGENT_START_PROCESS_PROPERTY, NULL);
@@ -1123,6 +1747,18 @@ static indigo_result agent_change_property(indigo_device *device, indigo_client
 		AGENT_GUIDER_DEC_MODE_PROPERTY->state = INDIGO_OK_STATE;
 		save_config(device);
 		indigo_update_property(device, AGENT_GUIDER_DEC_MODE_PROPERTY, NULL);
+	} else if (indigo_property_match(AGENT_GUIDER_ROI_MODE_PROPERTY, property)) {
+// -------------------------------------------------------------------------------- AGENT_GUIDER_ROI_MODE
+		indigo_property_copy_values(AGENT_GUIDER_ROI_MODE_PROPERTY, property, false);
+		AGENT_GUIDER_ROI_MODE_PROPERTY->state = INDIGO_OK_STATE;
+		save_config(device);
+		indigo_update_property(device, AGENT_GUIDER_ROI_MODE_PROPERTY, NULL);
+	} else if (indigo_property_match(AGENT_GUIDER_CALIBRATION_MODE_PROPERTY, property)) {
+// -------------------------------------------------------------------------------- AGENT_GUIDER_CALIBRATION_MODE
+		indigo_property_copy_values(AGENT_GUIDER_CALIBRATION_MODE_PROPERTY, property, false);
+		AGENT_GUIDER_CALIBRATION_MODE_PROPERTY->state = INDIGO_OK_STATE;
+		save_config(device);
+		indigo_update_property(device, AGENT_GUIDER_CALIBRATION_MODE_PROPERTY, NULL);
 	} else if (indigo_property_match(AGENT_GUIDER_SETTINGS_PROPERTY, property)) {
 // -------------------------------------------------------------------------------- AGENT_GUIDER_SETTINGS
 		double dith_x = AGENT_GUIDER_SETTINGS_DITH_X_ITEM->number.value;
@@ -1235,6 +1871,7 @@ static indigo_result agent_change_property(indigo_device *device, indigo_client
 			AGENT_ABORT_PROCESS_ITEM->sw.value = false;
 			AGENT_ABORT_PROCESS_PROPERTY->state = INDIGO_OK_STATE;
 			indigo_update_property(device, AGENT_ABORT_PROCESS_PROPERTY, NULL);
+			indigo_filter_notify(device);
 		} else {
 			AGENT_ABORT_PROCESS_PROPERTY->state = INDIGO_ALERT_STATE;
 			indigo_update_property(device, AGENT_ABORT_PROCESS_PROPERTY, "No CCD is selected");
@@ -1253,7 +1890,13 @@ static indigo_result agent_device_detach(indigo_device *device) {
 	indigo_release_property(AGENT_GUIDER_SELECTION_PROPERTY);
 	indigo_release_property(AGENT_GUIDER_STATS_PROPERTY);
 	indigo_release_property(AGENT_GUIDER_DEC_MODE_PROPERTY);
+	indigo_release_property(AGENT_GUIDER_ROI_MODE_PROPERTY);
+	indigo_release_property(AGENT_GUIDER_CALIBRATION_MODE_PROPERTY);
 	indigo_delete_frame_digest(&DEVICE_PRIVATE_DATA->reference);
+	indigo_delete_frame_digest(&DEVICE_PRIVATE_DATA->roi_reference);
+	for (int i = 0; i < DEVICE_PRIVATE_DATA->star_count; i++)
+		indigo_delete_frame_digest(DEVICE_PRIVATE_DATA->star_reference + i);
+	indigo_delete_frame_digest(&DEVICE_PRIVATE_DATA->digest);
 	pthread_mutex_destroy(&DEVICE_PRIVATE_DATA->mutex);
 	return indigo_filter_device_detach(device);
 }
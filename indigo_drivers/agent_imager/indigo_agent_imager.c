@@ -23,7 +23,7 @@
  \file indigo_agent_imager.c
  */
 
-#define DRIVER_VERSION 0x0015
+#define DRIVER_VERSION 0x0016
 #define DRIVER_NAME	"indigo_agent_imager"
 
 #include <stdio.h>
@@ -59,6 +59,11 @@
 #define AGENT_IMAGER_FOCUS_FINAL_ITEM  				(AGENT_IMAGER_FOCUS_PROPERTY->items+1)
 #define AGENT_IMAGER_FOCUS_BACKLASH_ITEM     	(AGENT_IMAGER_FOCUS_PROPERTY->items+2)
 #define AGENT_IMAGER_FOCUS_STACK_ITEM					(AGENT_IMAGER_FOCUS_PROPERTY->items+3)
+#define AGENT_IMAGER_FOCUS_SAMPLES_ITEM				(AGENT_IMAGER_FOCUS_PROPERTY->items+4)
+
+#define AGENT_IMAGER_FOCUS_METHOD_PROPERTY		(DEVICE_PRIVATE_DATA->agent_imager_focus_method_property)
+#define AGENT_IMAGER_FOCUS_METHOD_ITERATIVE_ITEM	(AGENT_IMAGER_FOCUS_METHOD_PROPERTY->items+0)
+#define AGENT_IMAGER_FOCUS_METHOD_V_CURVE_ITEM	(AGENT_IMAGER_FOCUS_METHOD_PROPERTY->items+1)
 
 #define AGENT_IMAGER_DITHERING_PROPERTY				(DEVICE_PRIVATE_DATA->agent_imager_dithering_property)
 #define AGENT_IMAGER_DITHERING_AGGRESSIVITY_ITEM (AGENT_IMAGER_DITHERING_PROPERTY->items+0)
@@ -126,6 +131,7 @@
 typedef struct {
 	indigo_property *agent_imager_batch_property;
 	indigo_property *agent_imager_focus_property;
+	indigo_property *agent_imager_focus_method_property;
 	indigo_property *agent_imager_dithering_property;
 	indigo_property *agent_imager_download_file_property;
 	indigo_property *agent_imager_download_files_property;
@@ -151,6 +157,11 @@ typedef struct {
 	pthread_mutex_t mutex;
 	double focus_exposure;
 	bool dithering_started, dithering_finished;
+	pthread_t analysis_thread;
+	pthread_mutex_t analysis_mutex;
+	pthread_cond_t analysis_cond;
+	indigo_item analysis_items[2];
+	bool analysis_running, analysis_exit, analysis_pending, analysis_busy;
 } agent_private_data;
 
 // -------------------------------------------------------------------------------- INDIGO agent common code
@@ -159,6 +170,7 @@ static void save_config(indigo_device *device) {
 	pthread_mutex_lock(&DEVICE_PRIVATE_DATA->mutex);
 	indigo_save_property(device, NULL, AGENT_IMAGER_BATCH_PROPERTY);
 	indigo_save_property(device, NULL, AGENT_IMAGER_FOCUS_PROPERTY);
+	indigo_save_property(device, NULL, AGENT_IMAGER_FOCUS_METHOD_PROPERTY);
 	indigo_save_property(device, NULL, AGENT_IMAGER_DITHERING_PROPERTY);
 	indigo_save_property(device, NULL, AGENT_IMAGER_SEQUENCE_PROPERTY);
 	if (DEVICE_CONTEXT->property_save_file_handle) {
@@ -212,6 +224,129 @@ static void set_headers(indigo_device *device) {
 	}
 }
 
+static bool process_resumed(indigo_device *device, void *data) {
+	return AGENT_PAUSE_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE;
+}
+
+static bool remote_started(indigo_device *device, void *data) {
+	return ((indigo_property *)data)->state == INDIGO_BUSY_STATE || AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE || AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE;
+}
+
+static bool exposure_changed(indigo_device *device, void *data) {
+	indigo_property *property = (indigo_property *)data;
+	return property->state != INDIGO_BUSY_STATE || property->items[0].number.value != AGENT_IMAGER_STATS_EXPOSURE_ITEM->number.value;
+}
+
+static bool streaming_changed(indigo_device *device, void *data) {
+	indigo_property *property = (indigo_property *)data;
+	indigo_item *count_item = indigo_get_item(property, CCD_STREAMING_COUNT_ITEM_NAME);
+	return property->state != INDIGO_BUSY_STATE || (count_item && count_item->number.value != AGENT_IMAGER_STATS_FRAME_ITEM->number.value);
+}
+
+static bool property_idle(indigo_device *device, void *data) {
+	return ((indigo_property *)data)->state != INDIGO_BUSY_STATE;
+}
+
+static bool dithering_did_start(indigo_device *device, void *data) {
+	return DEVICE_PRIVATE_DATA->dithering_started || AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE;
+}
+
+static bool dithering_did_finish(indigo_device *device, void *data) {
+	return DEVICE_PRIVATE_DATA->dithering_finished || AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE;
+}
+
+static void analyze_frame(indigo_device *device, indigo_item *image_item) {
+	indigo_raw_header *header = (indigo_raw_header *)(image_item->blob.value);
+	if (header && (header->signature == INDIGO_RAW_MONO8 || header->signature == INDIGO_RAW_MONO16 || header->signature == INDIGO_RAW_RGB24 || header->signature == INDIGO_RAW_RGB48)) {
+		indigo_frame_digest digest;
+		if (indigo_selection_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), &AGENT_IMAGER_SELECTION_X_ITEM->number.value, &AGENT_IMAGER_SELECTION_Y_ITEM->number.value, AGENT_IMAGER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, &digest) == INDIGO_OK) {
+			indigo_selection_psf(header->signature, (void*)header + sizeof(indigo_raw_header), AGENT_IMAGER_SELECTION_X_ITEM->number.value, AGENT_IMAGER_SELECTION_Y_ITEM->number.value, AGENT_IMAGER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, &AGENT_IMAGER_STATS_FWHM_ITEM->number.value, &AGENT_IMAGER_STATS_HFD_ITEM->number.value, &AGENT_IMAGER_STATS_PEAK_ITEM->number.value);
+			indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
+		}
+	}
+}
+
+static void *analysis_thread(indigo_device *device) {
+	pthread_mutex_lock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+	while (true) {
+		if (!DEVICE_PRIVATE_DATA->analysis_pending) {
+			if (DEVICE_PRIVATE_DATA->analysis_exit)
+				break;
+			pthread_cond_wait(&DEVICE_PRIVATE_DATA->analysis_cond, &DEVICE_PRIVATE_DATA->analysis_mutex);
+			continue;
+		}
+		// items[0] is filled by client thread, items[1] is owned by this thread
+		indigo_item tmp = DEVICE_PRIVATE_DATA->analysis_items[1];
+		DEVICE_PRIVATE_DATA->analysis_items[1] = DEVICE_PRIVATE_DATA->analysis_items[0];
+		DEVICE_PRIVATE_DATA->analysis_items[0] = tmp;
+		DEVICE_PRIVATE_DATA->analysis_pending = false;
+		DEVICE_PRIVATE_DATA->analysis_busy = true;
+		pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+		indigo_item *image_item = DEVICE_PRIVATE_DATA->analysis_items + 1;
+		if (*image_item->blob.url == 0 || indigo_populate_http_blob_item(image_item))
+			analyze_frame(device, image_item);
+		pthread_mutex_lock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+		DEVICE_PRIVATE_DATA->analysis_busy = false;
+		pthread_cond_broadcast(&DEVICE_PRIVATE_DATA->analysis_cond);
+	}
+	pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+	return NULL;
+}
+
+static void queue_analysis(indigo_device *device, indigo_item *image_item, bool remote) {
+	pthread_mutex_lock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+	if (!DEVICE_PRIVATE_DATA->analysis_running) {
+		DEVICE_PRIVATE_DATA->analysis_exit = false;
+		if (pthread_create(&DEVICE_PRIVATE_DATA->analysis_thread, NULL, (void *(*)(void *))analysis_thread, device)) {
+			pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+			INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to start analysis thread (%s)", strerror(errno));
+			if (remote)
+				indigo_populate_http_blob_item(image_item);
+			analyze_frame(device, image_item);
+			return;
+		}
+		DEVICE_PRIVATE_DATA->analysis_running = true;
+	}
+	indigo_item *pending_item = DEVICE_PRIVATE_DATA->analysis_items;
+	if (DEVICE_PRIVATE_DATA->analysis_pending)
+		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Analysis is too slow, previous frame skipped");
+	strcpy(pending_item->name, image_item->name);
+	if (remote) {
+		strncpy(pending_item->blob.url, image_item->blob.url, INDIGO_VALUE_SIZE);
+	} else {
+		*pending_item->blob.url = 0;
+		if (pending_item->blob.size != image_item->blob.size)
+			pending_item->blob.value = realloc(pending_item->blob.value, image_item->blob.size);
+		pending_item->blob.size = image_item->blob.size;
+		memcpy(pending_item->blob.value, image_item->blob.value, image_item->blob.size);
+	}
+	DEVICE_PRIVATE_DATA->analysis_pending = true;
+	pthread_cond_broadcast(&DEVICE_PRIVATE_DATA->analysis_cond);
+	pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+}
+
+static void wait_for_analysis(indigo_device *device) {
+	pthread_mutex_lock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+	while (DEVICE_PRIVATE_DATA->analysis_pending || DEVICE_PRIVATE_DATA->analysis_busy)
+		pthread_cond_wait(&DEVICE_PRIVATE_DATA->analysis_cond, &DEVICE_PRIVATE_DATA->analysis_mutex);
+	pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+}
+
+static void stop_analysis(indigo_device *device) {
+	pthread_mutex_lock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+	bool running = DEVICE_PRIVATE_DATA->analysis_running;
+	DEVICE_PRIVATE_DATA->analysis_exit = true;
+	DEVICE_PRIVATE_DATA->analysis_running = false;
+	pthread_cond_broadcast(&DEVICE_PRIVATE_DATA->analysis_cond);
+	pthread_mutex_unlock(&DEVICE_PRIVATE_DATA->analysis_mutex);
+	if (running)
+		pthread_join(DEVICE_PRIVATE_DATA->analysis_thread, NULL);
+	for (int i = 0; i < 2; i++) {
+		if (DEVICE_PRIVATE_DATA->analysis_items[i].blob.value)
+			free(DEVICE_PRIVATE_DATA->analysis_items[i].blob.value);
+	}
+}
+
 static bool capture_raw_frame(indigo_device *device) {
 	indigo_property *remote_exposure_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_EXPOSURE_PROPERTY_NAME);
 	if (remote_exposure_property == NULL) {
@@ -235,16 +370,15 @@ static bool capture_raw_frame(indigo_device *device) {
 	}
 	for (int exposure_attempt = 0; exposure_attempt < 3; exposure_attempt++) {
 		double exposure_time = AGENT_IMAGER_BATCH_EXPOSURE_ITEM->number.target;
-		while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-			indigo_usleep(200000);
+		while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+			;
 		if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
 			return false;
 		indigo_change_number_property_1(FILTER_DEVICE_CONTEXT->client, remote_exposure_property->device, CCD_EXPOSURE_PROPERTY_NAME, CCD_EXPOSURE_ITEM_NAME, exposure_time);
-		for (int i = 0; i < 1000 && remote_exposure_property->state != INDIGO_BUSY_STATE && AGENT_ABORT_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE && AGENT_PAUSE_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE; i++)
-			indigo_usleep(1000);
+		indigo_filter_wait(device, remote_started, remote_exposure_property, 1);
 		if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
-			while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-				indigo_usleep(200000);
+			while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+				;
 			exposure_attempt--;
 			continue;
 		}
@@ -265,15 +399,11 @@ static bool capture_raw_frame(indigo_device *device) {
 				AGENT_IMAGER_STATS_EXPOSURE_ITEM->number.value = reported_exposure_time = remote_exposure_property->items[0].number.value;
 				indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
 			}
-			if (reported_exposure_time > 1) {
-				indigo_usleep(200000);
-			} else {
-				indigo_usleep(10000);
-			}
+			indigo_filter_wait(device, exposure_changed, remote_exposure_property, 1);
 		}
 		if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
-			while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-				indigo_usleep(200000);
+			while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+				;
 			exposure_attempt--;
 			continue;
 		}
@@ -392,16 +522,15 @@ static bool exposure_batch(indigo_device *device) {
 			remaining_exposures = -1;
 		for (int exposure_attempt = 0; exposure_attempt < 3; exposure_attempt++) {
 			double exposure_time = AGENT_IMAGER_BATCH_EXPOSURE_ITEM->number.target;
-			while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-				indigo_usleep(200000);
+			while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+				;
 			if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
 				return false;
 			indigo_change_number_property_1(FILTER_DEVICE_CONTEXT->client, remote_exposure_property->device, CCD_EXPOSURE_PROPERTY_NAME, CCD_EXPOSURE_ITEM_NAME, exposure_time);
-			for (int i = 0; i < 1000 && remote_exposure_property->state != INDIGO_BUSY_STATE && AGENT_ABORT_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE && AGENT_PAUSE_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE; i++)
-				indigo_usleep(1000);
+			indigo_filter_wait(device, remote_started, remote_exposure_property, 1);
 			if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
-				while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-					indigo_usleep(200000);
+				while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+					;
 				exposure_attempt--;
 				continue;
 			}
@@ -420,15 +549,11 @@ static bool exposure_batch(indigo_device *device) {
 					AGENT_IMAGER_STATS_EXPOSURE_ITEM->number.value = reported_exposure_time = remote_exposure_property->items[0].number.value;
 					indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
 				}
-				if (reported_exposure_time > 1) {
-					indigo_usleep(200000);
-				} else {
-					indigo_usleep(10000);
-				}
+				indigo_filter_wait(device, exposure_changed, remote_exposure_property, 1);
 			}
 			if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
-				while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-					indigo_usleep(200000);
+				while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+					;
 				exposure_attempt--;
 				continue;
 			}
@@ -448,6 +573,7 @@ static bool exposure_batch(indigo_device *device) {
 		if (light_frame) {
 			if (remaining_exposures != 0) {
 				if (AGENT_IMAGER_DITHERING_AGGRESSIVITY_ITEM->number.target != 0) {
+					wait_for_analysis(device);
 					for (int item_index = 0; item_index < FILTER_DEVICE_CONTEXT->filter_related_agent_list_property->count; item_index++) {
 						indigo_item *agent = FILTER_DEVICE_CONTEXT->filter_related_agent_list_property->items + item_index;
 						if (agent->sw.value && !strncmp(agent->name, "Guider Agent", 12)) {
@@ -457,27 +583,17 @@ static bool exposure_batch(indigo_device *device) {
 							double item_values[] = { x_value, y_value };
 							DEVICE_PRIVATE_DATA->dithering_started = false;
 							indigo_change_number_property(FILTER_DEVICE_CONTEXT->client, agent->name, AGENT_GUIDER_SETTINGS_PROPERTY_NAME, 2, item_names, item_values);
-							for (int i = 0; i < 15; i++) { // wait up to 3s to start dithering
-								if (DEVICE_PRIVATE_DATA->dithering_started) {
-									break;
-								}
-								if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-									return false;
-								indigo_usleep(200000);
-							}
+							indigo_filter_wait(device, dithering_did_start, NULL, 3); // wait up to 3s to start dithering
+							if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
+								return false;
 							if (DEVICE_PRIVATE_DATA->dithering_started) {
 								INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Dithering started");
 								DEVICE_PRIVATE_DATA->dithering_finished = false;
-								double time_limit = AGENT_IMAGER_DITHERING_TIME_LIMIT_ITEM->number.value * 5;
-								for (int i = 0; i < time_limit; i++) { // wait up to time limit to finish dithering
-									if (DEVICE_PRIVATE_DATA->dithering_finished) {
-										INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Dithering finished");
-										break;
-									}
-									if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-										return false;
-									indigo_usleep(200000);
-								}
+								indigo_filter_wait(device, dithering_did_finish, NULL, AGENT_IMAGER_DITHERING_TIME_LIMIT_ITEM->number.value); // wait up to time limit to finish dithering
+								if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
+									return false;
+								if (DEVICE_PRIVATE_DATA->dithering_finished)
+									INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Dithering finished");
 								if (!DEVICE_PRIVATE_DATA->dithering_finished) {
 									INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Dithering failed");
 									indigo_send_message(device, "Dithering failed to settle down");
@@ -492,8 +608,8 @@ static bool exposure_batch(indigo_device *device) {
 				AGENT_IMAGER_STATS_DELAY_ITEM->number.value = reported_delay_time;
 				indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
 				while (reported_delay_time > 0) {
-					while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-						indigo_usleep(200000);
+					while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+						;
 					if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
 						return false;
 					if (reported_delay_time < floor(AGENT_IMAGER_STATS_DELAY_ITEM->number.value)) {
@@ -516,6 +632,7 @@ static bool exposure_batch(indigo_device *device) {
 			}
 		}
 	}
+	wait_for_analysis(device);
 	return true;
 }
 
@@ -570,8 +687,7 @@ static bool streaming_batch(indigo_device *device) {
 	char const *names[] = { AGENT_IMAGER_BATCH_COUNT_ITEM_NAME, AGENT_IMAGER_BATCH_EXPOSURE_ITEM_NAME };
 	double values[] = { AGENT_IMAGER_BATCH_COUNT_ITEM->number.target, AGENT_IMAGER_BATCH_EXPOSURE_ITEM->number.target };
 	indigo_change_number_property(FILTER_DEVICE_CONTEXT->client, remote_streaming_property->device, CCD_STREAMING_PROPERTY_NAME, 2, names, values);
-	for (int i = 0; i < 1000 && remote_streaming_property->state != INDIGO_BUSY_STATE && AGENT_ABORT_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE && AGENT_PAUSE_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE; i++)
-		indigo_usleep(1000);
+	indigo_filter_wait(device, remote_started, remote_streaming_property, 1);
 	if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE || AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
 		return false;
 	if (remote_streaming_property->state != INDIGO_BUSY_STATE) {
@@ -579,7 +695,7 @@ static bool streaming_batch(indigo_device *device) {
 		return false;
 	}
 	while (remote_streaming_property->state == INDIGO_BUSY_STATE) {
-		indigo_usleep(20000);
+		indigo_filter_wait(device, streaming_changed, remote_streaming_property, 1);
 		int count = remote_streaming_property->items[count_index].number.value;
 		if (count != AGENT_IMAGER_STATS_FRAME_ITEM->number.value) {
 			AGENT_IMAGER_STATS_FRAME_ITEM->number.value = count;
@@ -699,11 +815,10 @@ static bool autofocus(indigo_device *device) {
 			}
 			indigo_change_number_property_1(FILTER_DEVICE_CONTEXT->client, remote_steps_property->device, remote_steps_property->name, FOCUSER_STEPS_ITEM_NAME, steps_with_backlash);
 		}
-		for (int i = 0; i < 1000 && remote_steps_property->state != INDIGO_BUSY_STATE && AGENT_ABORT_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE && AGENT_PAUSE_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE; i++)
-			indigo_usleep(1000);
+		indigo_filter_wait(device, remote_started, remote_steps_property, 1);
 		if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
-			while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-				indigo_usleep(200000);
+			while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+				;
 			continue;
 		}
 		if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
@@ -712,30 +827,229 @@ static bool autofocus(indigo_device *device) {
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "FOCUSER_STEPS_PROPERTY didn't become busy in 1 second");
 			return false;
 		}
-		while (remote_steps_property->state == INDIGO_BUSY_STATE) {
-			indigo_usleep(200000);
-		}
+		while (!indigo_filter_wait(device, property_idle, remote_steps_property, 1))
+			;
 		if (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE) {
-			while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-				indigo_usleep(200000);
+			while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+				;
 			continue;
 		}
 		if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
 			return false;
 		last_quality = quality;
 	}
-	while (AGENT_PAUSE_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
-		indigo_usleep(200000);
+	while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+		;
 	if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
 		return false;
 	indigo_usleep(ONE_SECOND_DELAY);
 	return capture_raw_frame(device);
 }
 
+static int compare_doubles(const void *a, const void *b) {
+	double d = *(const double *)a - *(const double *)b;
+	return d < 0 ? -1 : d > 0 ? 1 : 0;
+}
+
+static double frame_hfd(indigo_device *device) {
+	indigo_property *remote_image_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_IMAGE_PROPERTY_NAME);
+	if (remote_image_property == NULL)
+		return 0;
+	indigo_raw_header *header = (indigo_raw_header *)(remote_image_property->items->blob.value);
+	if (header == NULL || (header->signature != INDIGO_RAW_MONO8 && header->signature != INDIGO_RAW_MONO16 && header->signature != INDIGO_RAW_RGB24 && header->signature != INDIGO_RAW_RGB48))
+		return 0;
+	void *data = (void*)header + sizeof(indigo_raw_header);
+	indigo_star_detection stars[MAX_STAR_COUNT];
+	double hfds[MAX_STAR_COUNT];
+	int star_count = 0, hfd_count = 0;
+	indigo_find_stars(header->signature, data, header->width, header->height, MAX_STAR_COUNT, stars, &star_count);
+	for (int i = 0; i < star_count; i++) {
+		double fwhm, hfd, peak;
+		if (indigo_selection_psf(header->signature, data, stars[i].x, stars[i].y, AGENT_IMAGER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, &fwhm, &hfd, &peak) == INDIGO_OK && isfinite(hfd) && hfd > 0)
+			hfds[hfd_count++] = hfd;
+	}
+	if (hfd_count == 0)
+		return 0;
+	qsort(hfds, hfd_count, sizeof(double), compare_doubles);
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "HFD measured on %d of %d stars", hfd_count, star_count);
+	return hfd_count % 2 ? hfds[hfd_count / 2] : (hfds[hfd_count / 2 - 1] + hfds[hfd_count / 2]) / 2;
+}
+
+// HFD of a defocused star follows hyperbola HFD^2 = a^2 * (1 + ((x - c) / b)^2), so HFD^2 is a parabola in x
+// fitted by least squares weighted for relative error, samples deviating more than 3 sigma (estimated from MAD) are rejected one by one
+
+static bool fit_v_curve(const double position[], const double hfd[], int count, double *minimum) {
+	bool used[count];
+	int used_count = 0;
+	double origin = 0;
+	for (int i = 0; i < count; i++) {
+		if ((used[i] = hfd[i] > 0)) {
+			used_count++;
+			origin += position[i];
+		}
+	}
+	if (used_count < 4)
+		return false;
+	origin /= used_count;
+	double a, b, c;
+	while (true) {
+		double s[5] = { 0 }, t[3] = { 0 };
+		for (int i = 0; i < count; i++) {
+			if (used[i]) {
+				double u = position[i] - origin, y = hfd[i] * hfd[i], p = 1 / (y * y);
+				for (int k = 0; k < 5; k++) {
+					if (k < 3)
+						t[k] += y * p;
+					s[k] += p;
+					p *= u;
+				}
+			}
+		}
+		double det = s[4] * (s[2] * s[0] - s[1] * s[1]) - s[3] * (s[3] * s[0] - s[1] * s[2]) + s[2] * (s[3] * s[1] - s[2] * s[2]);
+		if (det == 0)
+			return false;
+		a = (t[2] * (s[2] * s[0] - s[1] * s[1]) - s[3] * (t[1] * s[0] - s[1] * t[0]) + s[2] * (t[1] * s[1] - s[2] * t[0])) / det;
+		b = (s[4] * (t[1] * s[0] - s[1] * t[0]) - t[2] * (s[3] * s[0] - s[1] * s[2]) + s[2] * (s[3] * t[0] - t[1] * s[2])) / det;
+		c = (s[4] * (s[2] * t[0] - t[1] * s[1]) - s[3] * (s[3] * t[0] - t[1] * s[2]) + t[2] * (s[3] * s[1] - s[2] * s[2])) / det;
+		if (used_count <= 5)
+			break;
+		double residual[count], deviation[count];
+		int n = 0, worst = -1;
+		for (int i = 0; i < count; i++) {
+			if (used[i]) {
+				double u = position[i] - origin;
+				residual[i] = 1 - ((a * u + b) * u + c) / (hfd[i] * hfd[i]);
+				deviation[n++] = fabs(residual[i]);
+				if (worst < 0 || fabs(residual[i]) > fabs(residual[worst]))
+					worst = i;
+			}
+		}
+		qsort(deviation, n, sizeof(double), compare_doubles);
+		double sigma = fmax(1.4826 * (n % 2 ? deviation[n / 2] : (deviation[n / 2 - 1] + deviation[n / 2]) / 2), 0.05);
+		if (fabs(residual[worst]) <= 3 * sigma)
+			break;
+		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "V-curve sample at %g rejected (HFD = %g)", position[worst], hfd[worst]);
+		used[worst] = false;
+		used_count--;
+	}
+	if (a <= 0)
+		return false;
+	*minimum = origin - b / (2 * a);
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "V-curve fit with %d of %d samples, minimum at %g, HFD = %g", used_count, count, *minimum, sqrt(fmax(c - b * b / (4 * a), 0)));
+	return true;
+}
+
+static bool move_focuser(indigo_device *device, indigo_property *remote_steps_property, indigo_property *remote_direction_property, bool moving_out, double steps) {
+	if (steps < 1)
+		return true;
+	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Moving %s %d steps", moving_out ? "out" : "in", (int)steps);
+	indigo_change_switch_property_1(FILTER_DEVICE_CONTEXT->client, remote_direction_property->device, remote_direction_property->name, moving_out ? FOCUSER_DIRECTION_MOVE_OUTWARD_ITEM_NAME : FOCUSER_DIRECTION_MOVE_INWARD_ITEM_NAME, true);
+	indigo_change_number_property_1(FILTER_DEVICE_CONTEXT->client, remote_steps_property->device, remote_steps_property->name, FOCUSER_STEPS_ITEM_NAME, steps);
+	indigo_filter_wait(device, remote_started, remote_steps_property, 1);
+	if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
+		return false;
+	if (remote_steps_property->state != INDIGO_BUSY_STATE && AGENT_PAUSE_PROCESS_PROPERTY->state != INDIGO_BUSY_STATE) {
+		INDIGO_DRIVER_ERROR(DRIVER_NAME, "FOCUSER_STEPS_PROPERTY didn't become busy in 1 second");
+		return false;
+	}
+	while (!indigo_filter_wait(device, property_idle, remote_steps_property, 1))
+		;
+	while (!indigo_filter_wait(device, process_resumed, NULL, 1))
+		;
+	if (AGENT_ABORT_PROCESS_PROPERTY->state == INDIGO_BUSY_STATE)
+		return false;
+	return remote_steps_property->state == INDIGO_OK_STATE;
+}
+
+// final approach to any position is always outward, backlash is taken up by moving in by extra backlash steps first
+
+static bool move_focuser_to(indigo_device *device, indigo_property *remote_steps_property, indigo_property *remote_direction_property, double *position, double target) {
+	double backlash = AGENT_IMAGER_FOCUS_BACKLASH_ITEM->number.value;
+	if (target > *position) {
+		if (!move_focuser(device, remote_steps_property, remote_direction_property, true, target - *position))
+			return false;
+	} else if (target < *position) {
+		if (!move_focuser(device, remote_steps_property, remote_direction_property, false, *position - target + backlash))
+			return false;
+		if (!move_focuser(device, remote_steps_property, remote_direction_property, true, backlash))
+			return false;
+	}
+	*position = target;
+	return true;
+}
+
+static bool v_curve_autofocus(indigo_device *device) {
+	int samples = AGENT_IMAGER_FOCUS_SAMPLES_ITEM->number.value;
+	double step = AGENT_IMAGER_FOCUS_INITIAL_ITEM->number.value;
+	double position = 0, positions[samples], hfds[samples];
+	AGENT_IMAGER_STATS_EXPOSURE_ITEM->number.value = 0;
+	AGENT_IMAGER_STATS_DELAY_ITEM->number.value = 0;
+	AGENT_IMAGER_STATS_FRAME_ITEM->number.value = 0;
+	AGENT_IMAGER_STATS_FRAMES_ITEM->number.value = samples * AGENT_IMAGER_FOCUS_STACK_ITEM->number.value;
+	indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
+	indigo_property *remote_upload_mode_property = indigo_filter_cached_property(device, INDIGO_FILTER_CCD_INDEX, CCD_UPLOAD_MODE_PROPERTY_NAME);
+	if (remote_upload_mode_property == NULL) {
+		INDIGO_DRIVER_ERROR(DRIVER_NAME, "CCD_UPLOAD_MODE_PROPERTY_NAME not found");
+		return false;
+	}
+	indigo_property *remote_steps_property = indigo_filter_cached_property(device, INDIGO_FILTER_FOCUSER_INDEX, FOCUSER_STEPS_PROPERTY_NAME);
+	if (remote_steps_property == NULL) {
+		INDIGO_DRIVER_ERROR(DRIVER_NAME, "FOCUSER_STEPS not found");
+		return false;
+	}
+	indigo_property *remote_direction_property = indigo_filter_cached_property(device, INDIGO_FILTER_FOCUSER_INDEX, FOCUSER_DIRECTION_PROPERTY_NAME);
+	if (remote_direction_property == NULL) {
+		INDIGO_DRIVER_ERROR(DRIVER_NAME, "FOCUSER_DIRECTION_PROPERTY_NAME not found");
+		return false;
+	}
+	if (step < 1 || samples < 5) {
+		indigo_send_message(device, "V-curve needs at least 5 samples and non-zero step");
+		return false;
+	}
+	indigo_change_switch_property_1(FILTER_DEVICE_CONTEXT->client, remote_upload_mode_property->device, remote_upload_mode_property->name, CCD_UPLOAD_MODE_CLIENT_ITEM_NAME, true);
+	if (!move_focuser_to(device, remote_steps_property, remote_direction_property, &position, -step * (samples - 1) / 2))
+		return false;
+	for (int i = 0; i < samples; i++) {
+		if (i > 0 && !move_focuser_to(device, remote_steps_property, remote_direction_property, &position, position + step))
+			return false;
+		double hfd = 0;
+		int frame_count = 0;
+		for (int j = 0; j < AGENT_IMAGER_FOCUS_STACK_ITEM->number.value; j++) {
+			if (!capture_raw_frame(device))
+				return false;
+			double frame = frame_hfd(device);
+			if (frame > 0) {
+				hfd += frame;
+				frame_count++;
+			}
+		}
+		positions[i] = position;
+		hfds[i] = frame_count ? hfd / frame_count : 0;
+		AGENT_IMAGER_STATS_HFD_ITEM->number.value = round(1000 * hfds[i]) / 1000;
+		indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
+		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "V-curve sample %d at %g, HFD = %g", i, position, hfds[i]);
+	}
+	double minimum;
+	bool result = fit_v_curve(positions, hfds, samples, &minimum);
+	if (!result) {
+		indigo_send_message(device, "V-curve fit failed, returning to initial position");
+		minimum = 0;
+	} else if (minimum < positions[0] || minimum > positions[samples - 1]) {
+		indigo_send_message(device, "Focus is outside of sampled range, returning to initial position");
+		minimum = 0;
+		result = false;
+	}
+	if (!move_focuser_to(device, remote_steps_property, remote_direction_property, &position, round(minimum)))
+		return false;
+	if (!result)
+		return false;
+	return capture_raw_frame(device);
+}
+
 static void autofocus_process(indigo_device *device) {
 	int upload_mode = save_switch_state(device, INDIGO_FILTER_CCD_INDEX, CCD_UPLOAD_MODE_PROPERTY_NAME);
 	int image_format = save_switch_state(device, INDIGO_FILTER_CCD_INDEX, CCD_IMAGE_FORMAT_PROPERTY_NAME);
-	if (autofocus(device)) {
+	if (AGENT_IMAGER_FOCUS_METHOD_V_CURVE_ITEM->sw.value ? v_curve_autofocus(device) : autofocus(device)) {
 		AGENT_START_PROCESS_PROPERTY->state = AGENT_IMAGER_STATS_PROPERTY->state = INDIGO_OK_STATE;
 		indigo_send_message(device, "Focusing finished");
 	} else {
@@ -783,6 +1097,7 @@ static void set_property(indigo_device *device, char *name, char *value) {
 		AGENT_IMAGER_BATCH_DELAY_ITEM->number.target = atof(value);
 		indigo_update_property(device, AGENT_IMAGER_BATCH_PROPERTY, NULL);
 	} else if (!strcasecmp(name, "filter")) {
+		wait_for_analysis(device);
 		remote_property = indigo_filter_cached_property(device, INDIGO_FILTER_WHEEL_INDEX, WHEEL_SLOT_PROPERTY_NAME);
 		if (remote_property) {
 			for (int j = 0; j < AGENT_WHEEL_FILTER_PROPERTY->count; j++) {
@@ -882,9 +1197,8 @@ static void set_property(indigo_device *device, char *name, char *value) {
 	}
 	if (remote_property) {
 		indigo_usleep(200000);
-		while (remote_property->state == INDIGO_BUSY_STATE) {
-			indigo_usleep(200000);
-		}
+		while (!indigo_filter_wait(device, property_idle, remote_property, 1))
+			;
 	}
 }
 
@@ -1068,13 +1382,19 @@ static indigo_result agent_device_attach(indigo_device *device) {
 		indigo_init_number_item(AGENT_IMAGER_BATCH_EXPOSURE_ITEM, AGENT_IMAGER_BATCH_EXPOSURE_ITEM_NAME, "Exposure time", 0, 0xFFFF, 1, 1);
 		indigo_init_number_item(AGENT_IMAGER_BATCH_DELAY_ITEM, AGENT_IMAGER_BATCH_DELAY_ITEM_NAME, "Delay after each exposure", 0, 0xFFFF, 1, 0);
 		// -------------------------------------------------------------------------------- Focus properties
-		AGENT_IMAGER_FOCUS_PROPERTY = indigo_init_number_property(NULL, device->name, AGENT_IMAGER_FOCUS_PROPERTY_NAME, "Agent", "Autofocus settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 4);
+		AGENT_IMAGER_FOCUS_PROPERTY = indigo_init_number_property(NULL, device->name, AGENT_IMAGER_FOCUS_PROPERTY_NAME, "Agent", "Autofocus settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 5);
 		if (AGENT_IMAGER_FOCUS_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(AGENT_IMAGER_FOCUS_INITIAL_ITEM, AGENT_IMAGER_FOCUS_INITIAL_ITEM_NAME, "Initial step", 0, 0xFFFF, 1, 20);
 		indigo_init_number_item(AGENT_IMAGER_FOCUS_FINAL_ITEM, AGENT_IMAGER_FOCUS_FINAL_ITEM_NAME, "Final step", 0, 0xFFFF, 1, 5);
 		indigo_init_number_item(AGENT_IMAGER_FOCUS_BACKLASH_ITEM, AGENT_IMAGER_FOCUS_BACKLASH_ITEM_NAME, "Backlash", 0, 0xFFFF, 1, 0);
 		indigo_init_number_item(AGENT_IMAGER_FOCUS_STACK_ITEM, AGENT_IMAGER_FOCUS_STACK_ITEM_NAME, "Stacking", 1, 5, 1, 3);
+		indigo_init_number_item(AGENT_IMAGER_FOCUS_SAMPLES_ITEM, AGENT_IMAGER_FOCUS_SAMPLES_ITEM_NAME, "V-curve samples", 5, 31, 2, 9);
+		AGENT_IMAGER_FOCUS_METHOD_PROPERTY = indigo_init_switch_property(NULL, device->name, AGENT_IMAGER_FOCUS_METHOD_PROPERTY_NAME, "Agent", "Autofocus method", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 2);
+		if (AGENT_IMAGER_FOCUS_METHOD_PROPERTY == NULL)
+			return INDIGO_FAILED;
+		indigo_init_switch_item(AGENT_IMAGER_FOCUS_METHOD_ITERATIVE_ITEM, AGENT_IMAGER_FOCUS_METHOD_ITERATIVE_ITEM_NAME, "Iterative", true);
+		indigo_init_switch_item(AGENT_IMAGER_FOCUS_METHOD_V_CURVE_ITEM, AGENT_IMAGER_FOCUS_METHOD_V_CURVE_ITEM_NAME, "V-curve fit", false);
 		// -------------------------------------------------------------------------------- Dithering properties
 		AGENT_IMAGER_DITHERING_PROPERTY = indigo_init_number_property(NULL, device->name, AGENT_IMAGER_DITHERING_PROPERTY_NAME, "Agent", "Dithering settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 2);
 		if (AGENT_IMAGER_DITHERING_PROPERTY == NULL)
@@ -1177,6 +1497,8 @@ static indigo_result agent_device_attach(indigo_device *device) {
 		// --------------------------------------------------------------------------------
 		CONNECTION_PROPERTY->hidden = true;
 		pthread_mutex_init(&DEVICE_PRIVATE_DATA->mutex, NULL);
+		pthread_mutex_init(&DEVICE_PRIVATE_DATA->analysis_mutex, NULL);
+		pthread_cond_init(&DEVICE_PRIVATE_DATA->analysis_cond, NULL);
 		indigo_load_properties(device, false);
 		INDIGO_DEVICE_ATTACH_LOG(DRIVER_NAME, device->name);
 		return agent_enumerate_properties(device, NULL, NULL);
@@ -1191,6 +1513,8 @@ static indigo_result agent_enumerate_properties(indigo_device *device, indigo_cl
 		indigo_define_property(device, AGENT_IMAGER_BATCH_PROPERTY, NULL);
 	if (indigo_property_match(AGENT_IMAGER_FOCUS_PROPERTY, property))
 		indigo_define_property(device, AGENT_IMAGER_FOCUS_PROPERTY, NULL);
+	if (indigo_property_match(AGENT_IMAGER_FOCUS_METHOD_PROPERTY, property))
+		indigo_define_property(device, AGENT_IMAGER_FOCUS_METHOD_PROPERTY, NULL);
 	if (indigo_property_match(AGENT_IMAGER_DITHERING_PROPERTY, property))
 		indigo_define_property(device, AGENT_IMAGER_DITHERING_PROPERTY, NULL);
 	if (indigo_property_match(AGENT_IMAGER_DOWNLOAD_IMAGE_PROPERTY, property))
@@ -1238,6 +1562,13 @@ static indigo_result agent_change_property(indigo_device *device, indigo_client
 		save_config(device);
 		indigo_update_property(device, AGENT_IMAGER_FOCUS_PROPERTY, NULL);
 		return INDIGO_OK;
+	} else if (indigo_property_match(AGENT_IMAGER_FOCUS_METHOD_PROPERTY, property)) {
+		// -------------------------------------------------------------------------------- AGENT_IMAGER_FOCUS_METHOD
+		indigo_property_copy_values(AGENT_IMAGER_FOCUS_METHOD_PROPERTY, property, false);
+		AGENT_IMAGER_FOCUS_METHOD_PROPERTY->state = INDIGO_OK_STATE;
+		save_config(device);
+		indigo_update_property(device, AGENT_IMAGER_FOCUS_METHOD_PROPERTY, NULL);
+		return INDIGO_OK;
 	} else if (indigo_property_match(AGENT_IMAGER_DITHERING_PROPERTY, property)) {
 			// -------------------------------------------------------------------------------- AGENT_DITHERING
 		indigo_property_copy_values(AGENT_IMAGER_DITHERING_PROPERTY, property, false);
@@ -1314,6 +1645,7 @@ static indigo_result agent_change_property(indigo_device *device, indigo_client
 		}
 		AGENT_PAUSE_PROCESS_ITEM->sw.value = false;
 		indigo_update_property(device, AGENT_PAUSE_PROCESS_PROPERTY, NULL);
+		indigo_filter_notify(device);
 		return INDIGO_OK;
 	} else 	if (indigo_property_match(AGENT_ABORT_PROCESS_PROPERTY, property)) {
 // -------------------------------------------------------------------------------- AGENT_ABORT_PROCESS
@@ -1328,6 +1660,7 @@ static indigo_result agent_change_property(indigo_device *device, indigo_client
 		}
 		AGENT_ABORT_PROCESS_ITEM->sw.value = false;
 		indigo_update_property(device, AGENT_ABORT_PROCESS_PROPERTY, NULL);
+		indigo_filter_notify(device);
 		return INDIGO_OK;
 		// -------------------------------------------------------------------------------- AGENT_IMAGER_DOWNLOAD_FILE
 	} else 	if (indigo_property_match(AGENT_IMAGER_DOWNLOAD_FILE_PROPERTY, property)) {
@@ -1455,6 +1788,7 @@ static indigo_result agent_device_detach(indigo_device *device) {
 	assert(device != NULL);
 	indigo_release_property(AGENT_IMAGER_BATCH_PROPERTY);
 	indigo_release_property(AGENT_IMAGER_FOCUS_PROPERTY);
+	indigo_release_property(AGENT_IMAGER_FOCUS_METHOD_PROPERTY);
 	indigo_release_property(AGENT_IMAGER_DITHERING_PROPERTY);
 	indigo_release_property(AGENT_IMAGER_DOWNLOAD_IMAGE_PROPERTY);
 	indigo_release_property(AGENT_IMAGER_DOWNLOAD_FILE_PROPERTY);
@@ -1468,6 +1802,9 @@ static indigo_result agent_device_detach(indigo_device *device) {
 	indigo_release_property(AGENT_ABORT_PROCESS_PROPERTY);
 	indigo_release_property(AGENT_IMAGER_SEQUENCE_PROPERTY);
 	pthread_mutex_destroy(&DEVICE_PRIVATE_DATA->mutex);
+	stop_analysis(device);
+	pthread_cond_destroy(&DEVICE_PRIVATE_DATA->analysis_cond);
+	pthread_mutex_destroy(&DEVICE_PRIVATE_DATA->analysis_mutex);
 	if (DEVICE_PRIVATE_DATA->image_buffer)
 		free(DEVICE_PRIVATE_DATA->image_buffer);
 	return indigo_filter_device_detach(device);
@@ -1535,7 +1872,7 @@ static indigo_result agent_define_property(indigo_client *client, indigo_device
 		indigo_property *agent_wheel_filter_property = CLIENT_PRIVATE_DATA->agent_wheel_filter_property;
 		agent_wheel_filter_property->count = property->count;
 		for (int i = 0; i < property->count; i++)
-			strcpy(agent_wheel_filter_property->items[i].label, property->items[i].text.value);
+			indigo_set_item_label(agent_wheel_filter_property->items + i, "%s", property->items[i].text.value);
 		agent_wheel_filter_property->hidden = false;
 		indigo_define_property(FILTER_CLIENT_CONTEXT->device, agent_wheel_filter_property, NULL);
 	} else if (*FILTER_CLIENT_CONTEXT->device_name[INDIGO_FILTER_WHEEL_INDEX] && !strcmp(property->device, FILTER_CLIENT_CONTEXT->device_name[INDIGO_FILTER_WHEEL_INDEX]) && !strcmp(property->name, WHEEL_SLOT_PROPERTY_NAME)) {
@@ -1591,16 +1928,12 @@ static indigo_result agent_update_property(indigo_client *client, indigo_device
 
 			indigo_device *device = FILTER_CLIENT_CONTEXT->device;
 			if (!AGENT_IMAGER_START_FOCUSING_ITEM->sw.value && AGENT_IMAGER_SELECTION_X_ITEM->number.value > 0 && AGENT_IMAGER_SELECTION_X_ITEM->number.value > 0) {
-				if (strchr(property->device, '@'))
-					indigo_populate_http_blob_item(property->items);
-				indigo_raw_header *header = (indigo_raw_header *)(property->items->blob.value);
-				if (header && (header->signature == INDIGO_RAW_MONO8 || header->signature == INDIGO_RAW_MONO16 || header->signature == INDIGO_RAW_RGB24 || header->signature == INDIGO_RAW_RGB48)) {
-					indigo_frame_digest digest;
-					if (indigo_selection_frame_digest(header->signature, (void*)header + sizeof(indigo_raw_header), &AGENT_IMAGER_SELECTION_X_ITEM->number.value, &AGENT_IMAGER_SELECTION_Y_ITEM->number.value, AGENT_IMAGER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, &digest) == INDIGO_OK) {
-						indigo_selection_psf(header->signature, (void*)header + sizeof(indigo_raw_header), AGENT_IMAGER_SELECTION_X_ITEM->number.value, AGENT_IMAGER_SELECTION_Y_ITEM->number.value, AGENT_IMAGER_SELECTION_RADIUS_ITEM->number.value, header->width, header->height, &AGENT_IMAGER_STATS_FWHM_ITEM->number.value, &AGENT_IMAGER_STATS_HFD_ITEM->number.value, &AGENT_IMAGER_STATS_PEAK_ITEM->number.value);
-						indigo_update_property(device, AGENT_IMAGER_STATS_PROPERTY, NULL);
-					}
-				}
+				// download and analysis run on worker thread, so the next exposure can start meanwhile
+				// remote devices send either URL or inline data
+				if (strchr(property->device, '@') && *property->items->blob.url)
+					queue_analysis(device, property->items, true);
+				else if (property->items->blob.value)
+					queue_analysis(device, property->items, false);
 			}
 
 		} else if (property->state == INDIGO_OK_STATE && !strcmp(property->name, CCD_IMAGE_FILE_PROPERTY_NAME)) {
@@ -1639,7 +1972,7 @@ static indigo_result agent_update_property(indigo_client *client, indigo_device
 		indigo_property *agent_wheel_filter_property = CLIENT_PRIVATE_DATA->agent_wheel_filter_property;
 		agent_wheel_filter_property->count = property->count;
 		for (int i = 0; i < property->count; i++)
-			strcpy(agent_wheel_filter_property->items[i].label, property->items[i].text.value);
+			indigo_set_item_label(agent_wheel_filter_property->items + i, "%s", property->items[i].text.value);
 		agent_wheel_filter_property->hidden = false;
 		indigo_delete_property(FILTER_CLIENT_CONTEXT->device, agent_wheel_filter_property, NULL);
 		indigo_define_property(FILTER_CLIENT_CONTEXT->device, agent_wheel_filter_property, NULL);
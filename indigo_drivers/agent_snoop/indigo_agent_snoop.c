@@ -98,10 +98,8 @@ static indigo_result forward_property(indigo_device *device, indigo_client *clie
 		if (!any_set)
 			return INDIGO_OK;
 	}
-	int size = sizeof(indigo_property) + source_property->count * sizeof(indigo_item);
-	indigo_property *property = malloc(size);
+	indigo_property *property = indigo_copy_property(NULL, source_property);
 	assert(property != NULL);
-	memcpy(property, source_property, size);
 	strncpy(property->device, r->target_device_name, INDIGO_NAME_SIZE);
 	strncpy(property->name, r->target_property_name, INDIGO_NAME_SIZE);
 	indigo_trace_property("Property set by rule", property, false, true);
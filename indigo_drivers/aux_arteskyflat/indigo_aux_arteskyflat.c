@@ -52,18 +52,20 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_property *light_switch_property;
 	indigo_property *light_intensity_property;
 	pthread_mutex_t mutex;
 } arteskyflat_private_data;
 
-static bool artesky_command(int handle, char *command, char *response) {
+static bool artesky_command(indigo_reader *reader, char *command, char *response) {
+	int handle = reader->handle;
 	int result = indigo_write(handle, command, strlen(command));
 	result |= indigo_write(handle, "\n", 1);
 	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d <- %s (%s)", handle, command, result ? "OK" : strerror(errno));
 	if (result) {
 		*response = 0;
-		result = indigo_read_line(handle, response, 10) > 0;
+		result = indigo_reader_read_line(reader, response, 10) > 0;
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d -> %s (%s)", handle, response, result ? "OK" : strerror(errno));
 	}
 	return result;
@@ -86,7 +88,7 @@ static indigo_result aux_attach(indigo_device *device) {
 		if (AUX_LIGHT_INTENSITY_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(AUX_LIGHT_INTENSITY_ITEM, AUX_LIGHT_INTENSITY_ITEM_NAME, "Intensity", 0, 255, 1, 0);
-		strcpy(AUX_LIGHT_INTENSITY_ITEM->number.format, "%g");
+		indigo_set_number_item_format(AUX_LIGHT_INTENSITY_ITEM, "%g");
 		// -------------------------------------------------------------------------------- DEVICE_PORT, DEVICE_PORTS
 		DEVICE_PORT_PROPERTY->hidden = false;
 		DEVICE_PORTS_PROPERTY->hidden = false;
@@ -125,16 +127,17 @@ static void aux_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		for (int i = 0; i < 2; i++) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected on %s", DEVICE_PORT_ITEM->text.value);
 				sprintf(command, ">B%03d", (int)(AUX_LIGHT_INTENSITY_ITEM->number.value));
-				if (artesky_command(PRIVATE_DATA->handle, command, response) && *response == '*') {
+				if (artesky_command(&PRIVATE_DATA->reader, command, response) && *response == '*') {
 					INDIGO_DRIVER_LOG(DRIVER_NAME, "Artesky Flat Box detected");
 					AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_OK_STATE;
 					break;
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Handshake failed");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			}
@@ -151,8 +154,8 @@ static void aux_connection_handler(indigo_device *device) {
 	} else {
 		indigo_delete_property(device, AUX_LIGHT_SWITCH_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_LIGHT_INTENSITY_PROPERTY, NULL);
-		artesky_command(PRIVATE_DATA->handle, ">D000", response);
-		close(PRIVATE_DATA->handle);
+		artesky_command(&PRIVATE_DATA->reader, ">D000", response);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
@@ -165,7 +168,7 @@ static void aux_switch_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	char command[16],	response[16];
 	strcpy(command, AUX_LIGHT_SWITCH_ON_ITEM->sw.value ? ">L000" : ">D000");
-	if (artesky_command(PRIVATE_DATA->handle, command, response) && *response == '*')
+	if (artesky_command(&PRIVATE_DATA->reader, command, response) && *response == '*')
 		AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_OK_STATE;
 	else
 		AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_ALERT_STATE;
@@ -177,7 +180,7 @@ static void aux_intensity_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	char command[16],	response[16];
 	sprintf(command, ">B%03d", (int)(AUX_LIGHT_INTENSITY_ITEM->number.value));
-	if (artesky_command(PRIVATE_DATA->handle, command, response))
+	if (artesky_command(&PRIVATE_DATA->reader, command, response))
 		AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_OK_STATE;
 	else
 		AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_ALERT_STATE;
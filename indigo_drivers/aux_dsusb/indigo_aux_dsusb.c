@@ -69,7 +69,7 @@ static indigo_result aux_attach(indigo_device *device) {
 		if (X_CCD_EXPOSURE_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(X_CCD_EXPOSURE_ITEM, CCD_EXPOSURE_ITEM_NAME, "Start exposure", 0, 10000, 1, 0);
-		strcpy(X_CCD_EXPOSURE_ITEM->number.format, "%g");
+		indigo_set_number_item_format(X_CCD_EXPOSURE_ITEM, "%g");
 		// -------------------------------------------------------------------------------- X_CCD_ABORT_EXPOSURE
 		X_CCD_ABORT_EXPOSURE_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_ABORT_EXPOSURE_PROPERTY_NAME, AUX_MAIN_GROUP, "Abort exposure", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_AT_MOST_ONE_RULE, 1);
 		if (X_CCD_ABORT_EXPOSURE_PROPERTY == NULL)
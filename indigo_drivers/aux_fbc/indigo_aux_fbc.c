@@ -61,6 +61,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_timer *exposure_timer, *illumination_timer;
 	indigo_property *light_switch_property;
 	indigo_property *light_intensity_property;
@@ -69,10 +70,12 @@ typedef struct {
 	pthread_mutex_t mutex;
 } fbc_private_data;
 
-static bool fbc_command(int handle, char *command, char *response, int resp_len) {
+static bool fbc_command(indigo_reader *reader, char *command, char *response, int resp_len) {
+	int handle = reader->handle;
 	if(response) {
 		indigo_usleep(20000);
 		tcflush(handle, TCIOFLUSH);
+		indigo_reader_discard(reader);
 	}
 
 	int result = indigo_write(handle, command, strlen(command));
@@ -81,7 +84,7 @@ static bool fbc_command(int handle, char *command, char *response, int resp_len)
 	if ((result) && (response)) {
 		READ_AGAIN:
 		*response = 0;
-		result = indigo_read_line(handle, response, resp_len) > 0;
+		result = indigo_reader_read_line(reader, response, resp_len) > 0;
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d -> %s (%s)", handle, response, result ? "OK" : strerror(errno));
 		if ((result) && (!strncmp("D -", response, 3))) goto READ_AGAIN;
 	}
@@ -140,7 +143,7 @@ static indigo_result aux_attach(indigo_device *device) {
 		if (AUX_LIGHT_INTENSITY_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(AUX_LIGHT_INTENSITY_ITEM, AUX_LIGHT_INTENSITY_ITEM_NAME, "Intensity (%)", 0, 100, 1, 50);
-		strcpy(AUX_LIGHT_INTENSITY_ITEM->number.format, "%g");
+		indigo_set_number_item_format(AUX_LIGHT_INTENSITY_ITEM, "%g");
 		// -------------------------------------------------------------------------------- AUX_LIGHT_IMPULSE
 		AUX_LIGHT_IMPULSE_PROPERTY = indigo_init_number_property(NULL, device->name, AUX_LIGHT_IMPULSE_PROPERTY_NAME, AUX_MAIN_GROUP, "Light impulse", INDIGO_OK_STATE, INDIGO_RW_PERM, 1);
 		if (AUX_LIGHT_IMPULSE_PROPERTY == NULL)
@@ -195,6 +198,7 @@ static void aux_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		for (int i = 0; i < 2; i++) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				int fc_flag;
 				fc_flag = TIOCM_RTS;   /* Modem Constant for RTS pin */
@@ -203,42 +207,42 @@ static void aux_connection_handler(indigo_device *device) {
 				ioctl(PRIVATE_DATA->handle,TIOCMBIC,&fc_flag);
 
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected on %s", DEVICE_PORT_ITEM->text.value);
-				if (fbc_command(PRIVATE_DATA->handle, ": I #", response, sizeof(response)) && !strcmp("I FBC", response)) {
-					if (fbc_command(PRIVATE_DATA->handle, ": P #", response, sizeof(response))) {
+				if (fbc_command(&PRIVATE_DATA->reader, ": I #", response, sizeof(response)) && !strcmp("I FBC", response)) {
+					if (fbc_command(&PRIVATE_DATA->reader, ": P #", response, sizeof(response))) {
 						if (strcmp("P SerialMode", response)) {
 							INDIGO_DRIVER_ERROR(DRIVER_NAME, "FBC is not in SerialMode. Turn all knobs to 0 and powercycle the device.");
 							indigo_send_message(device, "FBC is not in SerialMode. Turn all knobs to 0 and powercycle the device.");
-							close(PRIVATE_DATA->handle);
+							indigo_close(PRIVATE_DATA->handle);
 							PRIVATE_DATA->handle = 0;
 							break;
 						}
 					}
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Handshake failed");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			}
 		}
 		if (PRIVATE_DATA->handle > 0) {
-			if (fbc_command(PRIVATE_DATA->handle, ": V #", response, sizeof(response))) {
+			if (fbc_command(&PRIVATE_DATA->reader, ": V #", response, sizeof(response))) {
 				sscanf(response, "V %s", INFO_DEVICE_FW_REVISION_ITEM->text.value);
 				indigo_update_property(device, INFO_PROPERTY, NULL);
 			}
 
 			/*
 			sprintf(command, ": E 15000 #");
-			fbc_command(PRIVATE_DATA->handle, command, NULL, 0);
+			fbc_command(&PRIVATE_DATA->reader, command, NULL, 0);
 
 			sprintf(command, ": F 15000 #");
-			fbc_command(PRIVATE_DATA->handle, command, NULL, 0);
+			fbc_command(&PRIVATE_DATA->reader, command, NULL, 0);
 			*/
 
 			/* Stop ilumination and exposure */
-			fbc_command(PRIVATE_DATA->handle, ": E 0 #", NULL, 0);
-			fbc_command(PRIVATE_DATA->handle, ": F 0 #", NULL, 0);
+			fbc_command(&PRIVATE_DATA->reader, ": E 0 #", NULL, 0);
+			fbc_command(&PRIVATE_DATA->reader, ": F 0 #", NULL, 0);
 			sprintf(command, ": B %d #", (int)AUX_LIGHT_INTENSITY_ITEM->number.value);
-			fbc_command(PRIVATE_DATA->handle, command, NULL, 0);
+			fbc_command(&PRIVATE_DATA->reader, command, NULL, 0);
 
 			indigo_define_property(device, AUX_LIGHT_IMPULSE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_EXPOSURE_PROPERTY, NULL);
@@ -256,10 +260,10 @@ static void aux_connection_handler(indigo_device *device) {
 		indigo_delete_property(device, AUX_LIGHT_INTENSITY_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_LIGHT_SWITCH_PROPERTY, NULL);
 		// turn off fbc at disconnecect - stop ilumination and exposure */
-		fbc_command(PRIVATE_DATA->handle, ": E 0 #", NULL, 0);
-		fbc_command(PRIVATE_DATA->handle, ": F 0 #", NULL, 0);
+		fbc_command(&PRIVATE_DATA->reader, ": E 0 #", NULL, 0);
+		fbc_command(&PRIVATE_DATA->reader, ": F 0 #", NULL, 0);
 
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
@@ -274,7 +278,7 @@ static void aux_intensity_handler(indigo_device *device) {
 	if (AUX_LIGHT_INTENSITY_PROPERTY->state != INDIGO_BUSY_STATE) {
 		char command[16];
 		sprintf(command, ": B %d #", (int)AUX_LIGHT_INTENSITY_ITEM->number.value);
-		if (fbc_command(PRIVATE_DATA->handle, command, NULL, 0))
+		if (fbc_command(&PRIVATE_DATA->reader, command, NULL, 0))
 			AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_OK_STATE;
 		else
 			AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_ALERT_STATE;
@@ -289,7 +293,7 @@ static void aux_impulse_handler(indigo_device *device) {
 	if (AUX_LIGHT_IMPULSE_PROPERTY->state != INDIGO_BUSY_STATE) {
 		char command[16];
 		sprintf(command, ": F %d #", (int)(AUX_LIGHT_IMPULSE_DURATION_ITEM->number.value * 1000));
-		if (fbc_command(PRIVATE_DATA->handle, command, NULL, 0)) {
+		if (fbc_command(&PRIVATE_DATA->reader, command, NULL, 0)) {
 			AUX_LIGHT_IMPULSE_PROPERTY->state = INDIGO_BUSY_STATE;
 			double delay = AUX_LIGHT_IMPULSE_DURATION_ITEM->number.value;
 			if (AUX_LIGHT_IMPULSE_DURATION_ITEM->number.value > 1)
@@ -309,7 +313,7 @@ static void aux_shutter_handler(indigo_device *device) {
 	if (CCD_EXPOSURE_PROPERTY->state != INDIGO_BUSY_STATE) {
 		char command[16];
 		sprintf(command, ": E %d #", (int)(CCD_EXPOSURE_ITEM->number.value * 1000));
-		if (fbc_command(PRIVATE_DATA->handle, command, NULL, 0)) {
+		if (fbc_command(&PRIVATE_DATA->reader, command, NULL, 0)) {
 			CCD_EXPOSURE_PROPERTY->state = INDIGO_BUSY_STATE;
 			double delay = CCD_EXPOSURE_ITEM->number.value;
 			if (CCD_EXPOSURE_ITEM->number.value > 1)
@@ -329,7 +333,7 @@ static void aux_switch_handler(indigo_device *device) {
 	if (AUX_LIGHT_SWITCH_PROPERTY->state != INDIGO_BUSY_STATE) {
 		char command[16],	response[16];
 		sprintf(command, "E:%d", AUX_LIGHT_SWITCH_ON_ITEM->sw.value);
-		if (fbc_command(PRIVATE_DATA->handle, command, response, sizeof(response)))
+		if (fbc_command(&PRIVATE_DATA->reader, command, response, sizeof(response)))
 			AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_OK_STATE;
 		else
 			AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_ALERT_STATE;
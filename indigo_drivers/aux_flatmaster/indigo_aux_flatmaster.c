@@ -55,18 +55,20 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_property *light_switch_property;
 	indigo_property *light_intensity_property;
 	pthread_mutex_t mutex;
 } flatmaster_private_data;
 
-static bool flatmaster_command(int handle, char *command, char *response, int resp_len) {
+static bool flatmaster_command(indigo_reader *reader, char *command, char *response, int resp_len) {
+	int handle = reader->handle;
 	int result = indigo_write(handle, command, strlen(command));
 	result |= indigo_write(handle, "\n", 1);
 	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d <- %s (%s)", handle, command, result ? "OK" : strerror(errno));
 	if (result) {
 		*response = 0;
-		result = indigo_read_line(handle, response, resp_len) > 0;
+		result = indigo_reader_read_line(reader, response, resp_len) > 0;
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d -> %s (%s)", handle, response, result ? "OK" : strerror(errno));
 	}
 	return result;
@@ -93,7 +95,7 @@ static indigo_result aux_attach(indigo_device *device) {
 		if (AUX_LIGHT_INTENSITY_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(AUX_LIGHT_INTENSITY_ITEM, AUX_LIGHT_INTENSITY_ITEM_NAME, "Intensity (%)", 0, 100, 1, 50);
-		strcpy(AUX_LIGHT_INTENSITY_ITEM->number.format, "%g");
+		indigo_set_number_item_format(AUX_LIGHT_INTENSITY_ITEM, "%g");
 		// -------------------------------------------------------------------------------- DEVICE_PORT, DEVICE_PORTS
 		DEVICE_PORT_PROPERTY->hidden = false;
 		DEVICE_PORTS_PROPERTY->hidden = false;
@@ -132,19 +134,20 @@ static void aux_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		for (int i = 0; i < 2; i++) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected on %s", DEVICE_PORT_ITEM->text.value);
-				if (flatmaster_command(PRIVATE_DATA->handle, "#", response, sizeof(response)) && !strcmp("OK_FM", response)) {
+				if (flatmaster_command(&PRIVATE_DATA->reader, "#", response, sizeof(response)) && !strcmp("OK_FM", response)) {
 					break;
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Handshake failed");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			}
 		}
 		if (PRIVATE_DATA->handle > 0) {
-			if (flatmaster_command(PRIVATE_DATA->handle, "V", response, sizeof(response))) {
+			if (flatmaster_command(&PRIVATE_DATA->reader, "V", response, sizeof(response))) {
 				snprintf(INFO_DEVICE_FW_REVISION_ITEM->text.value, INDIGO_VALUE_SIZE, "%s", response);
 				indigo_update_property(device, INFO_PROPERTY, NULL);
 
@@ -152,14 +155,14 @@ static void aux_connection_handler(indigo_device *device) {
 			/* FlatMaster does not report intensity and ON/OFF state, so we set it to be consistent */
 			/* bring 220-20 in range of 0-100 */
 			sprintf(command, "L:%d", CALCULATE_INTENSITY(AUX_LIGHT_INTENSITY_ITEM->number.value));
-			if (flatmaster_command(PRIVATE_DATA->handle, command, response, sizeof(response)))
+			if (flatmaster_command(&PRIVATE_DATA->reader, command, response, sizeof(response)))
 				AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_OK_STATE;
 			else
 				AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_ALERT_STATE;
 			indigo_define_property(device, AUX_LIGHT_INTENSITY_PROPERTY, NULL);
 
 			sprintf(command, "E:%d", AUX_LIGHT_SWITCH_ON_ITEM->sw.value);
-			if (flatmaster_command(PRIVATE_DATA->handle, command, response, sizeof(response)))
+			if (flatmaster_command(&PRIVATE_DATA->reader, command, response, sizeof(response)))
 				AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_OK_STATE;
 			else
 				AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_ALERT_STATE;
@@ -174,8 +177,8 @@ static void aux_connection_handler(indigo_device *device) {
 		indigo_delete_property(device, AUX_LIGHT_INTENSITY_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_LIGHT_SWITCH_PROPERTY, NULL);
 		// turn off flatmaster at disconnect
-		flatmaster_command(PRIVATE_DATA->handle, "E:0", response, sizeof(response));
-		close(PRIVATE_DATA->handle);
+		flatmaster_command(&PRIVATE_DATA->reader, "E:0", response, sizeof(response));
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
@@ -190,7 +193,7 @@ static void aux_intensity_handler(indigo_device *device) {
 		char command[16],	response[16];
 		/* bring 220-20 in range of 0-100 */
 		sprintf(command, "L:%d", CALCULATE_INTENSITY(AUX_LIGHT_INTENSITY_ITEM->number.value));
-		if (flatmaster_command(PRIVATE_DATA->handle, command, response, sizeof(response)))
+		if (flatmaster_command(&PRIVATE_DATA->reader, command, response, sizeof(response)))
 			AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_OK_STATE;
 		else
 			AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_ALERT_STATE;
@@ -204,7 +207,7 @@ static void aux_switch_handler(indigo_device *device) {
 	if (AUX_LIGHT_SWITCH_PROPERTY->state != INDIGO_BUSY_STATE) {
 		char command[16],	response[16];
 		sprintf(command, "E:%d", AUX_LIGHT_SWITCH_ON_ITEM->sw.value);
-		if (flatmaster_command(PRIVATE_DATA->handle, command, response, sizeof(response)))
+		if (flatmaster_command(&PRIVATE_DATA->reader, command, response, sizeof(response)))
 			AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_OK_STATE;
 		else
 			AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_ALERT_STATE;
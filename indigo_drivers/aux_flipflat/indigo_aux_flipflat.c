@@ -56,6 +56,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_property *light_switch_property;
 	indigo_property *light_intensity_property;
 	indigo_property *cover_property;
@@ -63,13 +64,14 @@ typedef struct {
 	int type;
 } flipflat_private_data;
 
-static bool flipflat_command(int handle, char *command, char *response) {
+static bool flipflat_command(indigo_reader *reader, char *command, char *response) {
+	int handle = reader->handle;
 	int result = indigo_write(handle, command, strlen(command));
 	result |= indigo_write(handle, "\n", 1);
 	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d <- %s (%s)", handle, command, result ? "OK" : strerror(errno));
 	if (result) {
 		*response = 0;
-		result = indigo_read_line(handle, response, 10) > 0;
+		result = indigo_reader_read_line(reader, response, 10) > 0;
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d -> %s (%s)", handle, response, result ? "OK" : strerror(errno));
 	}
 	return result;
@@ -92,7 +94,7 @@ static indigo_result aux_attach(indigo_device *device) {
 		if (AUX_LIGHT_INTENSITY_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		indigo_init_number_item(AUX_LIGHT_INTENSITY_ITEM, AUX_LIGHT_INTENSITY_ITEM_NAME, "Intensity", 0, 255, 1, 0);
-		strcpy(AUX_LIGHT_INTENSITY_ITEM->number.format, "%g");
+		indigo_set_number_item_format(AUX_LIGHT_INTENSITY_ITEM, "%g");
 		// -------------------------------------------------------------------------------- AUX_COVER
 		AUX_COVER_PROPERTY = indigo_init_switch_property(NULL, device->name, AUX_COVER_PROPERTY_NAME, AUX_MAIN_GROUP, "Cover (open/close)", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 2);
 		if (AUX_COVER_PROPERTY == NULL)
@@ -139,6 +141,7 @@ static void aux_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		for (int i = 0; i < 2; i++) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected on %s", DEVICE_PORT_ITEM->text.value);
 				int bits = TIOCM_DTR;
@@ -149,7 +152,7 @@ static void aux_connection_handler(indigo_device *device) {
 				result = ioctl(PRIVATE_DATA->handle, TIOCMBIC, &bits);
 				INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%d ← RTS %s", PRIVATE_DATA->handle, result < 0 ? strerror(errno) : "cleared");
 				indigo_usleep(2 * ONE_SECOND_DELAY);
-				if (flipflat_command(PRIVATE_DATA->handle, ">P000", response) && *response == '*') {
+				if (flipflat_command(&PRIVATE_DATA->reader, ">P000", response) && *response == '*') {
 					if (sscanf(response, "*P%02d000", &PRIVATE_DATA->type) != 1)
 						PRIVATE_DATA->type = 0;
 					switch (PRIVATE_DATA->type) {
@@ -187,7 +190,7 @@ static void aux_connection_handler(indigo_device *device) {
 					break;
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Handshake failed");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			}
@@ -196,7 +199,7 @@ static void aux_connection_handler(indigo_device *device) {
 			if (!AUX_LIGHT_SWITCH_PROPERTY->hidden) {
 				AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_ALERT_STATE;
 				AUX_COVER_PROPERTY->state = INDIGO_ALERT_STATE;
-				if (flipflat_command(PRIVATE_DATA->handle, ">S000", response) && *response == '*') {
+				if (flipflat_command(&PRIVATE_DATA->reader, ">S000", response) && *response == '*') {
 					int type, q, r, s;
 					if (sscanf(response, "*S%02d%1d%1d%1d", &type, &q, &r, &s) == 4) {
 						if (s == 1 || s == 2) {
@@ -210,7 +213,7 @@ static void aux_connection_handler(indigo_device *device) {
 			}
 			if (!AUX_LIGHT_INTENSITY_PROPERTY->hidden) {
 				AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_ALERT_STATE;
-				if (flipflat_command(PRIVATE_DATA->handle, ">J000", response) && *response == '*') {
+				if (flipflat_command(&PRIVATE_DATA->reader, ">J000", response) && *response == '*') {
 					int type, value;
 					if (sscanf(response, "*J%02d%3d", &type, &value) == 2) {
 						AUX_LIGHT_INTENSITY_ITEM->number.value = AUX_LIGHT_INTENSITY_ITEM->number.target = value;
@@ -231,7 +234,7 @@ static void aux_connection_handler(indigo_device *device) {
 		indigo_delete_property(device, AUX_LIGHT_SWITCH_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_LIGHT_INTENSITY_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_COVER_PROPERTY, NULL);
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
@@ -244,7 +247,7 @@ static void aux_switch_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	char command[16],	response[16];
 	strcpy(command, AUX_LIGHT_SWITCH_ON_ITEM->sw.value ? ">L000" : ">D000");
-	if (flipflat_command(PRIVATE_DATA->handle, command, response) && *response == '*')
+	if (flipflat_command(&PRIVATE_DATA->reader, command, response) && *response == '*')
 		AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_OK_STATE;
 	else
 		AUX_LIGHT_SWITCH_PROPERTY->state = INDIGO_ALERT_STATE;
@@ -256,7 +259,7 @@ static void aux_intensity_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	char command[16],	response[16];
 	sprintf(command, ">B%03d", (int)(AUX_LIGHT_INTENSITY_ITEM->number.value));
-	if (flipflat_command(PRIVATE_DATA->handle, command, response))
+	if (flipflat_command(&PRIVATE_DATA->reader, command, response))
 		AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_OK_STATE;
 	else
 		AUX_LIGHT_INTENSITY_PROPERTY->state = INDIGO_ALERT_STATE;
@@ -268,13 +271,13 @@ static void aux_cover_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	char command[16],	response[16];
 	strcpy(command, AUX_COVER_OPEN_ITEM->sw.value ? ">O000" : ">C000");
-	if (flipflat_command(PRIVATE_DATA->handle, command, response) && *response == '*') {
+	if (flipflat_command(&PRIVATE_DATA->reader, command, response) && *response == '*') {
 		AUX_COVER_PROPERTY->state = INDIGO_BUSY_STATE;
 		indigo_update_property(device, AUX_COVER_PROPERTY, NULL);
 		AUX_COVER_PROPERTY->state = INDIGO_ALERT_STATE;
 		for (int i = 0; i < 10; i++) {
 			indigo_usleep(ONE_SECOND_DELAY);
-			if (flipflat_command(PRIVATE_DATA->handle, ">S000", response) && *response == '*') {
+			if (flipflat_command(&PRIVATE_DATA->reader, ">S000", response) && *response == '*') {
 				int type, q, r, s;
 				if (sscanf(response, "*S%02d%1d%1d%1d", &type, &q, &r, &s) == 4) {
 					if ((AUX_COVER_OPEN_ITEM->sw.value && s == 2) || (AUX_COVER_CLOSE_ITEM->sw.value && s == 1)) {
@@ -109,6 +109,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	int count_open;
 	pthread_mutex_t serial_mutex,
 	                reset_mutex;
@@ -191,7 +192,7 @@ static void data_refresh_callback(indigo_device *gdevice) {
 	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "NMEA reader started");
 	while (PRIVATE_DATA->handle >= 0) {
 		pthread_mutex_lock(&PRIVATE_DATA->reset_mutex);
-		int result = indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer));
+		int result = indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer));
 		pthread_mutex_unlock(&PRIVATE_DATA->reset_mutex);
 		buffer[INDIGO_VALUE_SIZE-1] = '\0';
 		if (result > 0 && (tokens = parse(buffer))) {
@@ -417,10 +418,12 @@ static bool mgbox_open(indigo_device *device) {
 		if (!indigo_is_device_url(name, "mgbox")) {
 			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Opening local device on port: '%s', baudrate = %s", DEVICE_PORT_ITEM->text.value, DEVICE_BAUDRATE_ITEM->text.value);
 			PRIVATE_DATA->handle = indigo_open_serial_with_speed(name, atoi(DEVICE_BAUDRATE_ITEM->text.value));
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 		} else {
 			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Opening netwotk device on host: %s", DEVICE_PORT_ITEM->text.value);
 			indigo_network_protocol proto = INDIGO_PROTOCOL_TCP;
 			PRIVATE_DATA->handle = indigo_open_network_device(name, 9999, &proto);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 		}
 		if (PRIVATE_DATA->handle >= 0) {
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected to %s", name);
@@ -445,7 +448,7 @@ static bool mgbox_open(indigo_device *device) {
 
 			// no responce to ":devicetype*"
 			if (PRIVATE_DATA->device_type[0] == '\0') {
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = -1;
 				indigo_cancel_timer_sync(gps, &global_timer);
 				PRIVATE_DATA->count_open--;
@@ -470,7 +473,7 @@ static bool mgbox_open(indigo_device *device) {
 static void mgbox_close(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->serial_mutex);
 	if (--PRIVATE_DATA->count_open == 0) {
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = -1;
 		indigo_cancel_timer_sync(gps, &global_timer);
 		PRIVATE_DATA->firmware[0] = '\0';
@@ -752,13 +755,13 @@ static int aux_init_properties(indigo_device *device) {
 	if (AUX_WEATHER_PROPERTY == NULL)
 		return INDIGO_FAILED;
 	indigo_init_number_item(AUX_WEATHER_TEMPERATURE_ITEM, AUX_WEATHER_TEMPERATURE_ITEM_NAME, "Ambient temperature (°C)", -200, 80, 0, 0);
-	strncpy(AUX_WEATHER_TEMPERATURE_ITEM->number.format, "%.1f", INDIGO_VALUE_SIZE);
+	indigo_set_number_item_format(AUX_WEATHER_TEMPERATURE_ITEM, "%.1f");
 	indigo_init_number_item(AUX_WEATHER_DEWPOINT_ITEM, AUX_WEATHER_DEWPOINT_ITEM_NAME, "Dewpoint (°C)", -200, 80, 1, 0);
-	strncpy(AUX_WEATHER_DEWPOINT_ITEM->number.format, "%.1f", INDIGO_VALUE_SIZE);
+	indigo_set_number_item_format(AUX_WEATHER_DEWPOINT_ITEM, "%.1f");
 	indigo_init_number_item(AUX_WEATHER_HUMIDITY_ITEM, AUX_WEATHER_HUMIDITY_ITEM_NAME, "Relative humidity (%)", 0, 100, 0, 0);
-	strncpy(AUX_WEATHER_HUMIDITY_ITEM->number.format, "%.1f", INDIGO_VALUE_SIZE);
+	indigo_set_number_item_format(AUX_WEATHER_HUMIDITY_ITEM, "%.1f");
 	indigo_init_number_item(AUX_WEATHER_PRESSURE_ITEM, AUX_WEATHER_PRESSURE_ITEM_NAME, "Atmospheric Pressure (hPa)", 0, 10000, 0, 0);
-	strncpy(AUX_WEATHER_PRESSURE_ITEM->number.format, "%.2f", INDIGO_VALUE_SIZE);
+	indigo_set_number_item_format(AUX_WEATHER_PRESSURE_ITEM, "%.2f");
 	//--------------------------------------------------------------------------- X_SEND_WEATHER_MOUNT
 	X_SEND_WEATHER_MOUNT_PROPERTY = indigo_init_switch_property(NULL, device->name, X_SEND_WEATHER_MOUNT_PROPERTY_NAME, SETTINGS_GROUP, "Send weather data to mount", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, 1);
 	if (X_SEND_WEATHER_MOUNT_PROPERTY == NULL)
@@ -877,8 +880,8 @@ static indigo_result aux_change_property(indigo_device *device, indigo_client *c
 			indigo_delete_property(device, AUX_GPIO_OUTLET_PROPERTY, NULL);
 			indigo_delete_property(device, AUX_OUTLET_PULSE_LENGTHS_PROPERTY, NULL);
 		}
-		snprintf(AUX_GPIO_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_1_ITEM, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_1_ITEM, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
 		if (IS_CONNECTED) {
 			indigo_define_property(device, AUX_GPIO_OUTLET_PROPERTY, NULL);
 			indigo_define_property(device, AUX_OUTLET_PULSE_LENGTHS_PROPERTY, NULL);
@@ -89,6 +89,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_timer *aux_timer;
 	indigo_property *outlet_names_property;
 	indigo_property *power_outlet_property;
@@ -108,10 +109,11 @@ typedef struct {
 
 static bool ppb_command(indigo_device *device, char *command, char *response, int max) {
 	tcflush(PRIVATE_DATA->handle, TCIOFLUSH);
+	indigo_reader_discard(&PRIVATE_DATA->reader);
 	indigo_write(PRIVATE_DATA->handle, command, strlen(command));
 	indigo_write(PRIVATE_DATA->handle, "\n", 1);
 	if (response != NULL) {
-		if (indigo_read_line(PRIVATE_DATA->handle, response, max) == -1) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, response, max) == -1) {
 			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Command %s -> no response", command);
 			return false;
 		}
@@ -382,6 +384,7 @@ static void aux_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		if (PRIVATE_DATA->count++ == 0) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				bool connected = false;
 				int attempt = 0;
@@ -405,7 +408,7 @@ static void aux_connection_handler(indigo_device *device) {
 					}
 					if (attempt++ == 3) {
 						INDIGO_DRIVER_ERROR(DRIVER_NAME, "PPB not detected");
-						close(PRIVATE_DATA->handle);
+						indigo_close(PRIVATE_DATA->handle);
 						PRIVATE_DATA->handle = 0;
 						break;
 					}
@@ -465,7 +468,7 @@ static void aux_connection_handler(indigo_device *device) {
 				}
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read 'PA' response");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -516,7 +519,7 @@ static void aux_connection_handler(indigo_device *device) {
 			if (PRIVATE_DATA->handle > 0) {
 				ppb_command(device, "PL:0", response, sizeof(response));
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -534,8 +537,8 @@ static void aux_outlet_names_handler(indigo_device *device) {
 			indigo_delete_property(device, AUX_POWER_OUTLET_STATE_PROPERTY, NULL);
 		}
 	}
-	snprintf(AUX_HEATER_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_2_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_1_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_2_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
 	AUX_OUTLET_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 	if (IS_CONNECTED) {
 		indigo_define_property(device, AUX_HEATER_OUTLET_PROPERTY, NULL);
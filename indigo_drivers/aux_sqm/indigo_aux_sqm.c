@@ -52,6 +52,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_property *info_property;
 	indigo_timer *timer_callback;
 	pthread_mutex_t mutex;
@@ -72,9 +73,9 @@ static indigo_result aux_attach(indigo_device *device) {
 			return INDIGO_FAILED;
 		indigo_init_number_item(X_AUX_SKY_BRIGHTNESS_ITEM, "X_AUX_SKY_BRIGHTNESS", "Sky brightness [m/arcsec\u00B2]", -20, 30, 0, 0);
 		indigo_init_number_item(X_AUX_SENSOR_FREQUENCY_ITEM, "X_AUX_SENSOR_FREQUENCY", "SQM sensor frequency [Hz]", 0, 1000000000, 0, 0);
-		strcpy(X_AUX_SENSOR_FREQUENCY_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(X_AUX_SENSOR_FREQUENCY_ITEM, "%.0f");
 		indigo_init_number_item(X_AUX_SENSOR_COUNTS_ITEM, "X_AUX_SENSOR_COUNTS", "SQM sensor period [counts]", 0, 1000000000, 0, 0);
-		strcpy(X_AUX_SENSOR_COUNTS_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(X_AUX_SENSOR_COUNTS_ITEM, "%.0f");
 		indigo_init_number_item(X_AUX_SENSOR_PERIOD_ITEM, "X_AUX_SENSOR_PERIOD", "SQM sensor period [sec]", 0, 1000000000, 0, 0);
 		indigo_init_number_item(X_AUX_SKY_TEMPERATURE_ITEM, "X_AUX_SKY_TEMPERATURE", "Sky temperature [\u00B0C]", -100, 100, 0, 0);
 		// -------------------------------------------------------------------------------- DEVICE_PORT, DEVICE_PORTS
@@ -119,7 +120,7 @@ static void aux_timer_callback(indigo_device *device) {
 	memset(buffer, 0, sizeof(buffer));
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	indigo_printf(PRIVATE_DATA->handle, "rx");
-	indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer));
+	indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer));
 	INDIGO_DRIVER_DEBUG(DRIVER_NAME, "%s", buffer);
 	char *tok = strtok_r(buffer, ",", &pnt);
 	if (tok == NULL) {
@@ -141,15 +142,16 @@ static void aux_connection_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		PRIVATE_DATA->handle = indigo_open_serial_with_speed(DEVICE_PORT_ITEM->text.value, 115200);
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 		if (PRIVATE_DATA->handle > 0) {
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected on %s", DEVICE_PORT_ITEM->text.value);
 			char buffer[120] = {0};
 			indigo_printf(PRIVATE_DATA->handle, "ix");
-			indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer));
+			indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer));
 			if (buffer[0] == 'i' && buffer[1] == ',') {
 				INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Unit info: %s", buffer);
 			} else {
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -165,7 +167,7 @@ static void aux_connection_handler(indigo_device *device) {
 	} else {
 		indigo_cancel_timer_sync(device, &PRIVATE_DATA->timer_callback);
 		indigo_delete_property(device, AUX_INFO_PROPERTY, NULL);
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
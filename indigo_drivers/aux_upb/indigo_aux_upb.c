@@ -148,6 +148,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_timer *aux_timer;
 	indigo_timer *focuser_timer;
 	indigo_property *outlet_names_property;
@@ -175,10 +176,11 @@ typedef struct {
 
 static bool upb_command(indigo_device *device, char *command, char *response, int max) {
 	tcflush(PRIVATE_DATA->handle, TCIOFLUSH);
+	indigo_reader_discard(&PRIVATE_DATA->reader);
 	indigo_write(PRIVATE_DATA->handle, command, strlen(command));
 	indigo_write(PRIVATE_DATA->handle, "\n", 1);
 	if (response != NULL) {
-		if (indigo_read_line(PRIVATE_DATA->handle, response, max) == -1) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, response, max) == -1) {
 			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Command %s -> no response", command);
 			return false;
 		}
@@ -734,6 +736,7 @@ static void aux_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		if (PRIVATE_DATA->count++ == 0) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				bool connected = false;
 				int attempt = 0;
@@ -761,7 +764,7 @@ static void aux_connection_handler(indigo_device *device) {
 					}
 					if (attempt++ == 3) {
 						INDIGO_DRIVER_ERROR(DRIVER_NAME, "UPB not detected");
-						close(PRIVATE_DATA->handle);
+						indigo_close(PRIVATE_DATA->handle);
 						PRIVATE_DATA->handle = 0;
 						break;
 					}
@@ -865,12 +868,12 @@ static void aux_connection_handler(indigo_device *device) {
 					indigo_set_switch(AUX_DEW_CONTROL_PROPERTY, atoi(token) == 0 ? AUX_DEW_CONTROL_MANUAL_ITEM : AUX_DEW_CONTROL_AUTOMATIC_ITEM, true);
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to parse 'PA' response");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read 'SA' response");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -996,7 +999,7 @@ static void aux_connection_handler(indigo_device *device) {
 			if (PRIVATE_DATA->handle > 0) {
 				upb_command(device, "PL:0", response, sizeof(response));
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -1018,39 +1021,39 @@ static void aux_outlet_names_handler(indigo_device *device) {
 		indigo_delete_property(device, AUX_USB_PORT_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_USB_PORT_STATE_PROPERTY, NULL);
 	}
-	snprintf(AUX_POWER_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_POWER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_POWER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_POWER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_POWER_OUTLET_NAME_4_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_2_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_3_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_STATE_1_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_POWER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_STATE_2_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_POWER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_STATE_3_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_POWER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_STATE_4_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_POWER_OUTLET_NAME_4_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_STATE_1_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_STATE_2_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_STATE_3_ITEM->label, INDIGO_NAME_SIZE, "%s state", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_CURRENT_1_ITEM->label, INDIGO_NAME_SIZE, "%s current [A] ", AUX_POWER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_CURRENT_2_ITEM->label, INDIGO_NAME_SIZE, "%s current [A]", AUX_POWER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_CURRENT_3_ITEM->label, INDIGO_NAME_SIZE, "%s current [A]", AUX_POWER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_POWER_OUTLET_CURRENT_4_ITEM->label, INDIGO_NAME_SIZE, "%s current [A]", AUX_POWER_OUTLET_NAME_4_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_CURRENT_1_ITEM->label, INDIGO_NAME_SIZE, "%s current [A]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_CURRENT_2_ITEM->label, INDIGO_NAME_SIZE, "%s current [A]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_CURRENT_3_ITEM->label, INDIGO_NAME_SIZE, "%s current [A]", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_USB_PORT_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_1_ITEM->text.value);
-	snprintf(AUX_USB_PORT_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_2_ITEM->text.value);
-	snprintf(AUX_USB_PORT_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_3_ITEM->text.value);
-	snprintf(AUX_USB_PORT_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_4_ITEM->text.value);
-	snprintf(AUX_USB_PORT_5_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_5_ITEM->text.value);
-	snprintf(AUX_USB_PORT_6_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_6_ITEM->text.value);
-	snprintf(AUX_USB_PORT_STATE_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_1_ITEM->text.value);
-	snprintf(AUX_USB_PORT_STATE_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_2_ITEM->text.value);
-	snprintf(AUX_USB_PORT_STATE_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_3_ITEM->text.value);
-	snprintf(AUX_USB_PORT_STATE_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_4_ITEM->text.value);
-	snprintf(AUX_USB_PORT_STATE_5_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_5_ITEM->text.value);
-	snprintf(AUX_USB_PORT_STATE_6_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_USB_PORT_NAME_6_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_1_ITEM, "%s", AUX_POWER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_2_ITEM, "%s", AUX_POWER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_3_ITEM, "%s", AUX_POWER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_4_ITEM, "%s", AUX_POWER_OUTLET_NAME_4_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_1_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_2_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_3_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_STATE_1_ITEM, "%s state", AUX_POWER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_STATE_2_ITEM, "%s state", AUX_POWER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_STATE_3_ITEM, "%s state", AUX_POWER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_STATE_4_ITEM, "%s state", AUX_POWER_OUTLET_NAME_4_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_STATE_1_ITEM, "%s state", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_STATE_2_ITEM, "%s state", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_STATE_3_ITEM, "%s state", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_CURRENT_1_ITEM, "%s current [A] ", AUX_POWER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_CURRENT_2_ITEM, "%s current [A]", AUX_POWER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_CURRENT_3_ITEM, "%s current [A]", AUX_POWER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_POWER_OUTLET_CURRENT_4_ITEM, "%s current [A]", AUX_POWER_OUTLET_NAME_4_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_CURRENT_1_ITEM, "%s current [A]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_CURRENT_2_ITEM, "%s current [A]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_CURRENT_3_ITEM, "%s current [A]", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_1_ITEM, "%s", AUX_USB_PORT_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_2_ITEM, "%s", AUX_USB_PORT_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_3_ITEM, "%s", AUX_USB_PORT_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_4_ITEM, "%s", AUX_USB_PORT_NAME_4_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_5_ITEM, "%s", AUX_USB_PORT_NAME_5_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_6_ITEM, "%s", AUX_USB_PORT_NAME_6_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_STATE_1_ITEM, "%s", AUX_USB_PORT_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_STATE_2_ITEM, "%s", AUX_USB_PORT_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_STATE_3_ITEM, "%s", AUX_USB_PORT_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_STATE_4_ITEM, "%s", AUX_USB_PORT_NAME_4_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_STATE_5_ITEM, "%s", AUX_USB_PORT_NAME_5_ITEM->text.value);
+	indigo_set_item_label(AUX_USB_PORT_STATE_6_ITEM, "%s", AUX_USB_PORT_NAME_6_ITEM->text.value);
 	AUX_OUTLET_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 	if (IS_CONNECTED) {
 		indigo_define_property(device, AUX_POWER_OUTLET_PROPERTY, NULL);
@@ -1387,6 +1390,7 @@ static void focuser_connection_handler(indigo_device *device) {
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		if (PRIVATE_DATA->count++ == 0) {
 			PRIVATE_DATA->handle = indigo_open_serial(DEVICE_PORT_ITEM->text.value);
+			indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 			if (PRIVATE_DATA->handle > 0) {
 				if (upb_command(device, "P#", response, sizeof(response))) {
 					if (!strcmp(response, "UPB_OK")) {
@@ -1397,12 +1401,12 @@ static void focuser_connection_handler(indigo_device *device) {
 						PRIVATE_DATA->version = 2;
 					} else {
 						INDIGO_DRIVER_ERROR(DRIVER_NAME, "UPB not detected");
-						close(PRIVATE_DATA->handle);
+						indigo_close(PRIVATE_DATA->handle);
 						PRIVATE_DATA->handle = 0;
 					}
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "UPB not detected");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			}
@@ -1423,12 +1427,12 @@ static void focuser_connection_handler(indigo_device *device) {
 					FOCUSER_BACKLASH_ITEM->number.value = FOCUSER_BACKLASH_ITEM->number.target = atoi(token);
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to parse 'SA' response");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read 'SA' response");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -1456,7 +1460,7 @@ static void focuser_connection_handler(indigo_device *device) {
 			if (PRIVATE_DATA->handle > 0) {
 				upb_command(device, "PL:0", response, sizeof(response));
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -115,6 +115,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	uint8_t requested_aggressivity;
 	indigo_timer *aux_timer;
 	indigo_property *outlet_names_property;
@@ -196,10 +197,11 @@ static bool usbdp_command(indigo_device *device, char *command, char *response,
 	/* Wait a bit before flushing as usb to serial caches data */
 	indigo_usleep(20000);
 	tcflush(PRIVATE_DATA->handle, TCIOFLUSH);
+	indigo_reader_discard(&PRIVATE_DATA->reader);
 	indigo_write(PRIVATE_DATA->handle, command, strlen(command));
 
 	if (response != NULL) {
-		if (indigo_read_line(PRIVATE_DATA->handle, response, max) == -1) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, response, max) == -1) {
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Command %s -> no response", command);
 			return false;
 		}
@@ -619,6 +621,7 @@ static void aux_connection_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		PRIVATE_DATA->handle = indigo_open_serial_with_speed(DEVICE_PORT_ITEM->text.value, 19200);
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 		if (PRIVATE_DATA->handle > 0) {
 			if (usbdp_command(device, UDP_IDENTIFY_CMD, response, sizeof(response))) {
 				if (!strcmp(response, UDP1_IDENTIFY_RESPONSE)) {
@@ -663,13 +666,13 @@ static void aux_connection_handler(indigo_device *device) {
 					indigo_define_property(device, AUX_DEW_WARNING_PROPERTY, NULL);
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "USB_Dewpoint not detected");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 				indigo_update_property(device, INFO_PROPERTY, NULL);
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "USB_Dewpoint not detected");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -682,12 +685,12 @@ static void aux_connection_handler(indigo_device *device) {
 
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to parse 'SGETAL' response");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read 'SGETAL' response");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 			indigo_set_timer(device, 0, aux_timer_callback, &PRIVATE_DATA->aux_timer);
@@ -729,7 +732,7 @@ static void aux_connection_handler(indigo_device *device) {
 				// maybe check responce if "DONE" ?
 			}
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
-			close(PRIVATE_DATA->handle);
+			indigo_close(PRIVATE_DATA->handle);
 			PRIVATE_DATA->handle = 0;
 		}
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
@@ -749,20 +752,20 @@ static void aux_outlet_names_handler(indigo_device *device) {
 		indigo_delete_property(device, AUX_DEW_THRESHOLD_PROPERTY, NULL);
 		indigo_delete_property(device, AUX_DEW_WARNING_PROPERTY, NULL);
 	}
-	snprintf(AUX_HEATER_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_2_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_3_ITEM->label, INDIGO_NAME_SIZE, "%s [%%]", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_STATE_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_STATE_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_HEATER_OUTLET_STATE_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
-	snprintf(AUX_TEMPERATURE_SENSOR_1_ITEM->label, INDIGO_NAME_SIZE, "%s (°C)", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_TEMPERATURE_SENSOR_2_ITEM->label, INDIGO_NAME_SIZE, "%s (°C)", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_CALLIBRATION_SENSOR_1_ITEM->label, INDIGO_NAME_SIZE, "%s (°C)", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_CALLIBRATION_SENSOR_2_ITEM->label, INDIGO_NAME_SIZE, "%s (°C)", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_DEW_THRESHOLD_SENSOR_1_ITEM->label, INDIGO_NAME_SIZE, "%s (°C)", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_DEW_THRESHOLD_SENSOR_2_ITEM->label, INDIGO_NAME_SIZE, "%s (°C)", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
-	snprintf(AUX_DEW_WARNING_SENSOR_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
-	snprintf(AUX_DEW_WARNING_SENSOR_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_1_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_2_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_3_ITEM, "%s [%%]", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_STATE_1_ITEM, "%s", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_STATE_2_ITEM, "%s", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_HEATER_OUTLET_STATE_3_ITEM, "%s", AUX_HEATER_OUTLET_NAME_3_ITEM->text.value);
+	indigo_set_item_label(AUX_TEMPERATURE_SENSOR_1_ITEM, "%s (°C)", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_TEMPERATURE_SENSOR_2_ITEM, "%s (°C)", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_CALLIBRATION_SENSOR_1_ITEM, "%s (°C)", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_CALLIBRATION_SENSOR_2_ITEM, "%s (°C)", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_DEW_THRESHOLD_SENSOR_1_ITEM, "%s (°C)", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_DEW_THRESHOLD_SENSOR_2_ITEM, "%s (°C)", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
+	indigo_set_item_label(AUX_DEW_WARNING_SENSOR_1_ITEM, "%s", AUX_HEATER_OUTLET_NAME_1_ITEM->text.value);
+	indigo_set_item_label(AUX_DEW_WARNING_SENSOR_2_ITEM, "%s", AUX_HEATER_OUTLET_NAME_2_ITEM->text.value);
 	AUX_OUTLET_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 	if (IS_CONNECTED) {
 		indigo_define_property(device, AUX_HEATER_OUTLET_PROPERTY, NULL);
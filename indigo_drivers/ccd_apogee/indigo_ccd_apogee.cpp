@@ -1109,8 +1109,8 @@ static indigo_result ethernet_attach(indigo_device *device) {
 		// -------------------------------------------------------------------------------- DEVICE_PORT
 		DEVICE_PORT_PROPERTY->hidden = false;
 		strncpy(DEVICE_PORT_ITEM->text.value, "192.168.0.255", INDIGO_VALUE_SIZE);
-		strncpy(DEVICE_PORT_PROPERTY->label, "Network", INDIGO_VALUE_SIZE);
-		strncpy(DEVICE_PORT_ITEM->label, "Broadcast address", INDIGO_VALUE_SIZE);
+		indigo_set_property_label(DEVICE_PORT_PROPERTY, "Network");
+		indigo_set_item_label(DEVICE_PORT_ITEM, "Broadcast address");
 		// -------------------------------------------------------------------------------- DEVICE_PORTS
 		DEVICE_PORTS_PROPERTY->hidden = true;
 		// --------------------------------------------------------------------------------
@@ -1158,10 +1158,10 @@ bool ptp_update_property(indigo_device *device, ptp_property *property) {
 				for (int i = 0; i < property->count; i++) {
 					if (property->type == ptp_str_type) {
 						strcpy(str, property->value.sw_str.values[i]);
-						strncpy(property->property->items[i].label, str, INDIGO_VALUE_SIZE);
+						indigo_set_item_label(property->property->items + i, "%s", str);
 					} else {
 						sprintf(str, "%llx", property->value.sw.values[i]);
-						strncpy(property->property->items[i].label, PRIVATE_DATA->property_value_code_label(device, property->code, property->value.sw.values[i]), INDIGO_VALUE_SIZE);
+						indigo_set_item_label(property->property->items + i, "%s", PRIVATE_DATA->property_value_code_label(device, property->code, property->value.sw.values[i]));
 					}
 					if (strncmp(property->property->items[i].name, str, INDIGO_NAME_SIZE)) {
 						strncpy(property->property->items[i].name, str, INDIGO_NAME_SIZE);
@@ -1685,8 +1685,8 @@ static indigo_result eth_attach(indigo_device *device) {
 		// -------------------------------------------------------------------------------- DEVICE_PORT
 		DEVICE_PORT_PROPERTY->hidden = false;
 		strncpy(DEVICE_PORT_ITEM->text.value, "192.168.0.100", INDIGO_VALUE_SIZE);
-		strncpy(DEVICE_PORT_PROPERTY->label, "Remote camera", INDIGO_VALUE_SIZE);
-		strncpy(DEVICE_PORT_ITEM->label, "IP address / hostname", INDIGO_VALUE_SIZE);
+		indigo_set_property_label(DEVICE_PORT_PROPERTY, "Remote camera");
+		indigo_set_item_label(DEVICE_PORT_ITEM, "IP address / hostname");
 		// -------------------------------------------------------------------------------- DEVICE_PORTS
 		DEVICE_PORTS_PROPERTY->hidden = true;
 		// --------------------------------------------------------------------------------
@@ -90,9 +90,6 @@ typedef struct {
 	indigo_property *guider_settings_property;
 
 	int star_x[STARS], star_y[STARS], star_a[STARS], hotpixel_x[HOTPIXELS + 1], hotpixel_y[HOTPIXELS + 1];
-	char imager_image[FITS_HEADER_SIZE + 3 * WIDTH * HEIGHT + 2880];
-	char guider_image[FITS_HEADER_SIZE + 3 * WIDTH * HEIGHT + 2880];
-	char dslr_image[FITS_HEADER_SIZE + 3 * WIDTH * HEIGHT + 2880];
 	pthread_mutex_t image_mutex;
 	double target_temperature, current_temperature;
 	int current_slot;
@@ -186,8 +183,14 @@ static void gauss_blur(unsigned short *scl, unsigned short *tcl, int w, int h, d
 static void create_frame(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->image_mutex);
 	simulator_private_data *private_data = PRIVATE_DATA;
+	char *image = indigo_ccd_frame_buffer(device, FITS_HEADER_SIZE + 3 * WIDTH * HEIGHT);
+	if (image == NULL) {
+		INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to allocate frame buffer");
+		pthread_mutex_unlock(&PRIVATE_DATA->image_mutex);
+		return;
+	}
 	if (device == PRIVATE_DATA->dslr) {
-		unsigned char *raw = (unsigned char *)(private_data->dslr_image+FITS_HEADER_SIZE);
+		unsigned char *raw = (unsigned char *)(image + FITS_HEADER_SIZE);
 		int size = WIDTH * HEIGHT * 3;
 		for (int i = 0; i < size; i++) {
 			int rgb = indigo_ccd_simulator_rgb_image[i];
@@ -196,9 +199,9 @@ static void create_frame(indigo_device *device) {
 			else
 				raw[i] = rgb;
 		}
-		indigo_process_image(device, private_data->dslr_image, WIDTH, HEIGHT, 24, true, true, NULL);
+		indigo_process_image(device, image, WIDTH, HEIGHT, 24, true, true, NULL);
 	} else {
-		unsigned short *raw = (unsigned short *)((device == PRIVATE_DATA->guider ? private_data->guider_image : private_data->imager_image) + FITS_HEADER_SIZE);
+		unsigned short *raw = (unsigned short *)(image + FITS_HEADER_SIZE);
 		int horizontal_bin = (int)CCD_BIN_HORIZONTAL_ITEM->number.value;
 		int vertical_bin = (int)CCD_BIN_VERTICAL_ITEM->number.value;
 		int frame_left = (int)CCD_FRAME_LEFT_ITEM->number.value / horizontal_bin;
@@ -338,7 +341,7 @@ static void create_frame(indigo_device *device) {
 				}
 			}
 		}
-		indigo_process_image(device, device == PRIVATE_DATA->guider ? private_data->guider_image : private_data->imager_image, frame_width, frame_height, 16, true, true, NULL);
+		indigo_process_image(device, image, frame_width, frame_height, 16, true, true, NULL);
 	}
 	pthread_mutex_unlock(&PRIVATE_DATA->image_mutex);
 }
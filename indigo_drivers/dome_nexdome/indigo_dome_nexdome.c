@@ -691,7 +691,7 @@ static indigo_result dome_attach(indigo_device *device) {
 		// -------------------------------------------------------------------------------- DOME_SPEED
 		DOME_SPEED_PROPERTY->hidden = true;
 		// -------------------------------------------------------------------------------- DOME_STEPS_PROPERTY
-		strncpy(DOME_STEPS_ITEM->label, "Relative move (°)", INDIGO_VALUE_SIZE);
+		indigo_set_item_label(DOME_STEPS_ITEM, "Relative move (°)");
 		// -------------------------------------------------------------------------------- DEVICE_PORT
 		DEVICE_PORT_PROPERTY->hidden = false;
 		// -------------------------------------------------------------------------------- DEVICE_PORTS
@@ -735,9 +735,9 @@ static indigo_result dome_attach(indigo_device *device) {
 			return INDIGO_FAILED;
 		NEXDOME_POWER_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_POWER_ROTATOR_ITEM, NEXDOME_POWER_ROTATOR_ITEM_NAME, "Rotator (Volts)", 0, 500, 1, 0);
-		strcpy(NEXDOME_POWER_ROTATOR_ITEM->number.format, "%.2f");
+		indigo_set_number_item_format(NEXDOME_POWER_ROTATOR_ITEM, "%.2f");
 		indigo_init_number_item(NEXDOME_POWER_SHUTTER_ITEM, NEXDOME_POWER_SHUTTER_ITEM_NAME, "Shutter (Volts)", 0, 500, 1, 0);
-		strcpy(NEXDOME_POWER_SHUTTER_ITEM->number.format, "%.2f");
+		indigo_set_number_item_format(NEXDOME_POWER_SHUTTER_ITEM, "%.2f");
 		// --------------------------------------------------------------------------------
 		INDIGO_DEVICE_ATTACH_LOG(DRIVER_NAME, device->name);
 		return indigo_dome_enumerate_properties(device, NULL, NULL);
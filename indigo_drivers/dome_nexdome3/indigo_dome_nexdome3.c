@@ -667,7 +667,7 @@ static indigo_result dome_attach(indigo_device *device) {
 		// -------------------------------------------------------------------------------- DOME_SPEED
 		DOME_SPEED_PROPERTY->hidden = true;
 		// -------------------------------------------------------------------------------- DOME_STEPS_PROPERTY
-		strncpy(DOME_STEPS_ITEM->label, "Relative move (°)", INDIGO_VALUE_SIZE);
+		indigo_set_item_label(DOME_STEPS_ITEM, "Relative move (°)");
 		// -------------------------------------------------------------------------------- DEVICE_PORT
 		DEVICE_PORT_PROPERTY->hidden = false;
 		// -------------------------------------------------------------------------------- DEVICE_PORTS
@@ -692,48 +692,48 @@ static indigo_result dome_attach(indigo_device *device) {
 			return INDIGO_FAILED;
 		NEXDOME_MOVE_THRESHOLD_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_MOVE_THRESHOLD_ITEM, NEXDOME_MOVE_THRESHOLD_ITEM_NAME, "Minimal move (steps, ~153 steps/°)", 0, 10000, 1, 300);
-		strcpy(NEXDOME_MOVE_THRESHOLD_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_MOVE_THRESHOLD_ITEM, "%.0f");
 		// -------------------------------------------------------------------------------- NEXDOME_HOME_POSITION
 		NEXDOME_HOME_POSITION_PROPERTY = indigo_init_number_property(NULL, device->name, NEXDOME_HOME_POSITION_PROPERTY_NAME, NEXDOME_SETTINGS_GROUP, "Home position", INDIGO_OK_STATE, INDIGO_RW_PERM, 1);
 		if (NEXDOME_HOME_POSITION_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		NEXDOME_HOME_POSITION_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_HOME_POSITION_ITEM, NEXDOME_HOME_POSITION_ITEM_NAME, "Position (steps, ~153 steps/°)", 0, 100000, 1, 0);
-		strcpy(NEXDOME_HOME_POSITION_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_HOME_POSITION_ITEM, "%.0f");
 		// -------------------------------------------------------------------------------- NEXDOME_POWER
 		NEXDOME_POWER_PROPERTY = indigo_init_number_property(NULL, device->name, NEXDOME_POWER_PROPERTY_NAME, NEXDOME_SETTINGS_GROUP, "Power status", INDIGO_OK_STATE, INDIGO_RO_PERM, 1);
 		if (NEXDOME_POWER_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		NEXDOME_POWER_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_POWER_VOLTAGE_ITEM, NEXDOME_POWER_VOLTAGE_ITEM_NAME, "Battery charge (Volts)", 0, 500, 1, 0);
-		strcpy(NEXDOME_POWER_VOLTAGE_ITEM->number.format, "%.2f");
+		indigo_set_number_item_format(NEXDOME_POWER_VOLTAGE_ITEM, "%.2f");
 		// -------------------------------------------------------------------------------- NEXDOME_ACCELERATION
 		NEXDOME_ACCELERATION_PROPERTY = indigo_init_number_property(NULL, device->name, NEXDOME_ACCELERATION_PROPERTY_NAME, NEXDOME_SETTINGS_GROUP, "Acceleration time", INDIGO_OK_STATE, INDIGO_RW_PERM, 2);
 		if (NEXDOME_ACCELERATION_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		NEXDOME_ACCELERATION_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_ACCELERATION_ROTATOR_ITEM, NEXDOME_ACCELERATION_ROTATOR_ITEM_NAME, "Rotator (ms)", 100, 10000, 1, 1500);
-		strcpy(NEXDOME_ACCELERATION_ROTATOR_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_ACCELERATION_ROTATOR_ITEM, "%.0f");
 		indigo_init_number_item(NEXDOME_ACCELERATION_SHUTTER_ITEM, NEXDOME_ACCELERATION_SHUTTER_ITEM_NAME, "Shutter (ms)", 100, 10000, 1, 1500);
-		strcpy(NEXDOME_ACCELERATION_SHUTTER_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_ACCELERATION_SHUTTER_ITEM, "%.0f");
 		// -------------------------------------------------------------------------------- NEXDOME_VELOCITY
 		NEXDOME_VELOCITY_PROPERTY = indigo_init_number_property(NULL, device->name, NEXDOME_VELOCITY_PROPERTY_NAME, NEXDOME_SETTINGS_GROUP, "Movement velocity", INDIGO_OK_STATE, INDIGO_RW_PERM, 2);
 		if (NEXDOME_VELOCITY_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		NEXDOME_VELOCITY_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_VELOCITY_ROTATOR_ITEM, NEXDOME_VELOCITY_ROTATOR_ITEM_NAME, "Rotator (steps/s)", 32, 5000, 1, 600);
-		strcpy(NEXDOME_VELOCITY_ROTATOR_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_VELOCITY_ROTATOR_ITEM, "%.0f");
 		indigo_init_number_item(NEXDOME_VELOCITY_SHUTTER_ITEM, NEXDOME_VELOCITY_SHUTTER_ITEM_NAME, "Shutter (steps/s)", 32, 5000, 1, 800);
-		strcpy(NEXDOME_VELOCITY_SHUTTER_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_VELOCITY_SHUTTER_ITEM, "%.0f");
 		// -------------------------------------------------------------------------------- NEXDOME_RANGE
 		NEXDOME_RANGE_PROPERTY = indigo_init_number_property(NULL, device->name, NEXDOME_RANGE_PROPERTY_NAME, NEXDOME_SETTINGS_GROUP, "Movement range", INDIGO_OK_STATE, INDIGO_RW_PERM, 2);
 		if (NEXDOME_RANGE_PROPERTY == NULL)
 			return INDIGO_FAILED;
 		NEXDOME_RANGE_PROPERTY->hidden = false;
 		indigo_init_number_item(NEXDOME_RANGE_ROTATOR_ITEM, NEXDOME_RANGE_ROTATOR_ITEM_NAME, "Dome circumference (steps)", 30000, 100000, 1, 55080);
-		strcpy(NEXDOME_RANGE_ROTATOR_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_RANGE_ROTATOR_ITEM, "%.0f");
 		indigo_init_number_item(NEXDOME_RANGE_SHUTTER_ITEM, NEXDOME_RANGE_SHUTTER_ITEM_NAME, "Shutter travel (steps)", 20000, 90000, 1, 46000);
-		strcpy(NEXDOME_RANGE_SHUTTER_ITEM->number.format, "%.0f");
+		indigo_set_number_item_format(NEXDOME_RANGE_SHUTTER_ITEM, "%.0f");
 		// -------------------------------------------------------------------------------- NEXDOME_FIND_HOME
 		NEXDOME_SETTINGS_PROPERTY = indigo_init_switch_property(NULL, device->name, NEXDOME_SETTINGS_PROPERTY_NAME, NEXDOME_SETTINGS_GROUP, "Settings management", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_AT_MOST_ONE_RULE, 3);
 		if (NEXDOME_SETTINGS_PROPERTY == NULL)
@@ -59,6 +59,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_timer *timer;
 	indigo_property *motor_type_property;
 	indigo_property *encoder_property;
@@ -71,10 +72,11 @@ typedef struct {
 
 static bool dmfc_command(indigo_device *device, char *command, char *response, int max) {
 	tcflush(PRIVATE_DATA->handle, TCIOFLUSH);
+	indigo_reader_discard(&PRIVATE_DATA->reader);
 	indigo_write(PRIVATE_DATA->handle, command, strlen(command));
 	indigo_write(PRIVATE_DATA->handle, "\n", 1);
 	if (response != NULL) {
-		if (indigo_read_line(PRIVATE_DATA->handle, response, max) == 0) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, response, max) == 0) {
 			INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Command %s -> no response", command);
 			return false;
 		}
@@ -215,12 +217,13 @@ static void focuser_connection_handler(indigo_device *device) {
 	char response[64];
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		PRIVATE_DATA->handle = indigo_open_serial_with_speed(DEVICE_PORT_ITEM->text.value, 19200);
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 		if (PRIVATE_DATA->handle > 0) {
 			if (dmfc_command(device, "#", response, sizeof(response)) && !strncmp(response, "OK_", 3)) {
 				INDIGO_DRIVER_LOG(DRIVER_NAME, "%s OK", response + 3);
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Focuser not detected");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -265,12 +268,12 @@ static void focuser_connection_handler(indigo_device *device) {
 					FOCUSER_BACKLASH_ITEM->number.value = FOCUSER_BACKLASH_ITEM->number.target = atoi(token);
 				} else {
 					INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to parse 'A' response");
-					close(PRIVATE_DATA->handle);
+					indigo_close(PRIVATE_DATA->handle);
 					PRIVATE_DATA->handle = 0;
 				}
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read 'A' response");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -297,7 +300,7 @@ static void focuser_connection_handler(indigo_device *device) {
 			strcpy(INFO_DEVICE_MODEL_ITEM->text.value, "Undefined");
 			indigo_update_property(device, INFO_PROPERTY, NULL);
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
-			close(PRIVATE_DATA->handle);
+			indigo_close(PRIVATE_DATA->handle);
 			PRIVATE_DATA->handle = 0;
 		}
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
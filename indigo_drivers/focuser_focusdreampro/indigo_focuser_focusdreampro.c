@@ -49,6 +49,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_property *duty_cycle_property;
 	indigo_timer *timer;
 	pthread_mutex_t mutex;
@@ -60,7 +61,7 @@ static int SPEED[] = { 500, 250, 110, 40, 10, 5 };
 // -------------------------------------------------------------------------------- Low level communication routines
 
 static bool focusdreampro_command(indigo_device *device, char *command, char *response, int length) {
-	if (indigo_write(PRIVATE_DATA->handle, command, strlen(command)) && indigo_write(PRIVATE_DATA->handle, "\n", 1) && indigo_read_line(PRIVATE_DATA->handle, response, length) < 0) {
+	if (indigo_write(PRIVATE_DATA->handle, command, strlen(command)) && indigo_write(PRIVATE_DATA->handle, "\n", 1) && indigo_reader_read_line(&PRIVATE_DATA->reader, response, length) < 0) {
 		*response = 0;
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Command %s failed", command);
 		return false;
@@ -196,6 +197,7 @@ static void focuser_connection_handler(indigo_device *device) {
 	char command[16], response[16];
 	if (CONNECTION_CONNECTED_ITEM->sw.value) {
 		PRIVATE_DATA->handle = indigo_open_serial_with_speed(DEVICE_PORT_ITEM->text.value, 9600);
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 		if (PRIVATE_DATA->handle > 0) {
 			if (focusdreampro_command(device, "#", response, sizeof(response))) {
 				if (!strcmp(response, "FD")) {
@@ -210,7 +212,7 @@ static void focuser_connection_handler(indigo_device *device) {
 				indigo_update_property(device, INFO_PROPERTY, NULL);
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "FocusDreamPro not detected");
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -264,7 +266,7 @@ static void focuser_connection_handler(indigo_device *device) {
 			focusdreampro_command(device, "H", response, sizeof(response));
 			indigo_delete_property(device, X_FOCUSER_DUTY_CYCLE_PROPERTY, NULL);
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
-			close(PRIVATE_DATA->handle);
+			indigo_close(PRIVATE_DATA->handle);
 			PRIVATE_DATA->handle = 0;
 		}
 		CONNECTION_PROPERTY->state = INDIGO_OK_STATE;
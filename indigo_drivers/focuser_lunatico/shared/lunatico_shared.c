@@ -1257,10 +1257,10 @@ static indigo_result aux_change_property(indigo_device *device, indigo_client *c
 		if (DEVICE_CONNECTED) {
 			indigo_delete_property(device, AUX_POWER_OUTLET_PROPERTY, NULL);
 		}
-		snprintf(AUX_POWER_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
-		snprintf(AUX_POWER_OUTLET_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_2_ITEM->text.value);
-		snprintf(AUX_POWER_OUTLET_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_3_ITEM->text.value);
-		snprintf(AUX_POWER_OUTLET_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_4_ITEM->text.value);
+		indigo_set_item_label(AUX_POWER_OUTLET_1_ITEM, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_POWER_OUTLET_2_ITEM, "%s", AUX_OUTLET_NAME_2_ITEM->text.value);
+		indigo_set_item_label(AUX_POWER_OUTLET_3_ITEM, "%s", AUX_OUTLET_NAME_3_ITEM->text.value);
+		indigo_set_item_label(AUX_POWER_OUTLET_4_ITEM, "%s", AUX_OUTLET_NAME_4_ITEM->text.value);
 		AUX_OUTLET_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 		if (DEVICE_CONNECTED) {
 			indigo_define_property(device, AUX_POWER_OUTLET_PROPERTY, NULL);
@@ -1285,10 +1285,10 @@ static indigo_result aux_change_property(indigo_device *device, indigo_client *c
 		if (DEVICE_CONNECTED) {
 			indigo_delete_property(device, AUX_GPIO_SENSORS_PROPERTY, NULL);
 		}
-		snprintf(AUX_GPIO_SENSOR_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_1_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_2_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_3_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_4_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_1_ITEM, "%s", AUX_SENSOR_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_2_ITEM, "%s", AUX_SENSOR_NAME_2_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_3_ITEM, "%s", AUX_SENSOR_NAME_3_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_4_ITEM, "%s", AUX_SENSOR_NAME_4_ITEM->text.value);
 		AUX_SENSOR_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 		if (DEVICE_CONNECTED) {
 			indigo_define_property(device, AUX_GPIO_SENSORS_PROPERTY, NULL);
@@ -1878,7 +1878,7 @@ static indigo_result focuser_attach(indigo_device *device) {
 		FOCUSER_SPEED_ITEM->number.max = 20;
 		FOCUSER_SPEED_ITEM->number.step = 0.1;
 		FOCUSER_SPEED_ITEM->number.value = FOCUSER_SPEED_ITEM->number.target = 0.1;
-		strcpy(FOCUSER_SPEED_ITEM->label, "Speed (kHz)");
+		indigo_set_item_label(FOCUSER_SPEED_ITEM, "Speed (kHz)");
 
 		FOCUSER_POSITION_ITEM->number.min = 0;
 		FOCUSER_POSITION_ITEM->number.step = 100;
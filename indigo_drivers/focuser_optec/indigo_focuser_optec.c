@@ -46,6 +46,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_timer *timer;
 	pthread_mutex_t mutex;
 } optec_private_data;
@@ -55,31 +56,32 @@ typedef struct {
 static bool optec_open(indigo_device *device) {
 	char *name = DEVICE_PORT_ITEM->text.value;
 	PRIVATE_DATA->handle = indigo_open_serial_with_speed(name, 19200);
+	indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 	if (PRIVATE_DATA->handle >= 0) {
 		char reply;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected to %s", name);
-		if (indigo_printf(PRIVATE_DATA->handle, "FMMODE\r\n") && indigo_scanf(PRIVATE_DATA->handle, "%c\r\n", &reply) == 1 && reply == '!') {
+		if (indigo_printf(PRIVATE_DATA->handle, "FMMODE\r\n") && indigo_reader_scanf(&PRIVATE_DATA->reader, "%c\r\n", &reply) == 1 && reply == '!') {
 			double value;
 			indigo_printf(PRIVATE_DATA->handle, "FPOSRO\r\n");
-			if (indigo_scanf(PRIVATE_DATA->handle, "P=%lf\r\n", &value) == 1) {
+			if (indigo_reader_scanf(&PRIVATE_DATA->reader, "P=%lf\r\n", &value) == 1) {
 				FOCUSER_POSITION_ITEM->number.value = FOCUSER_POSITION_ITEM->number.target = value;
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read current position");
 			}
 			indigo_printf(PRIVATE_DATA->handle, "FTMPRO\r\n");
-			if (indigo_scanf(PRIVATE_DATA->handle, "T=%lf\r\n", &value) == 1) {
+			if (indigo_reader_scanf(&PRIVATE_DATA->reader, "T=%lf\r\n", &value) == 1) {
 				FOCUSER_TEMPERATURE_ITEM->number.value = value;
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read current temperature");
 			}
 			indigo_printf(PRIVATE_DATA->handle, "FREADA\r\n");
-			if (indigo_scanf(PRIVATE_DATA->handle, "A=%lf\r\n", &value) == 1) {
+			if (indigo_reader_scanf(&PRIVATE_DATA->reader, "A=%lf\r\n", &value) == 1) {
 				FOCUSER_COMPENSATION_ITEM->number.value = value;
 			} else {
 				INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read current compensation");
 			}
 			indigo_printf(PRIVATE_DATA->handle, "FTxxxA\r\n");
-			if (indigo_scanf(PRIVATE_DATA->handle, "A=%lf\r\n", &value) == 1) {
+			if (indigo_reader_scanf(&PRIVATE_DATA->reader, "A=%lf\r\n", &value) == 1) {
 				if (value == 1)
 					FOCUSER_COMPENSATION_ITEM->number.value = -FOCUSER_COMPENSATION_ITEM->number.value;
 			} else {
@@ -98,7 +100,7 @@ static bool optec_open(indigo_device *device) {
 static void optec_close(indigo_device *device) {
 	if (PRIVATE_DATA->handle > 0) {
 		indigo_printf(PRIVATE_DATA->handle, "FFMODE\r\n");
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected from %s", DEVICE_PORT_ITEM->text.value);
 	}
@@ -159,14 +161,14 @@ static void focuser_timer_callback(indigo_device *device) {
 	double value;
 	if (FOCUSER_MODE_PROPERTY->state == INDIGO_OK_STATE && FOCUSER_MODE_MANUAL_ITEM->sw.value) {
 		indigo_printf(PRIVATE_DATA->handle, "FPOSRO\r\n");
-		if (indigo_scanf(PRIVATE_DATA->handle, "P=%lf\r\n", &value) == 1) {
+		if (indigo_reader_scanf(&PRIVATE_DATA->reader, "P=%lf\r\n", &value) == 1) {
 			FOCUSER_POSITION_ITEM->number.value = value;
 			FOCUSER_STEPS_PROPERTY->state = FOCUSER_POSITION_PROPERTY->state = FOCUSER_POSITION_ITEM->number.value == FOCUSER_POSITION_ITEM->number.target ? INDIGO_OK_STATE : INDIGO_BUSY_STATE;
 			indigo_update_property(device, FOCUSER_STEPS_PROPERTY, NULL);
 			indigo_update_property(device, FOCUSER_POSITION_PROPERTY, NULL);
 		}
 		indigo_printf(PRIVATE_DATA->handle, "FTMPRO\r\n");
-		if (indigo_scanf(PRIVATE_DATA->handle, "T=%lf\r\n", &value) == 1) {
+		if (indigo_reader_scanf(&PRIVATE_DATA->reader, "T=%lf\r\n", &value) == 1) {
 			FOCUSER_TEMPERATURE_ITEM->number.value = value;
 			FOCUSER_TEMPERATURE_PROPERTY->state = INDIGO_OK_STATE;
 			indigo_update_property(device, FOCUSER_TEMPERATURE_PROPERTY, NULL);
@@ -202,7 +204,7 @@ static void focuser_steps_handler(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->mutex);
 	char response[16];
 	int direction = FOCUSER_DIRECTION_MOVE_INWARD_ITEM->sw.value ^ FOCUSER_REVERSE_MOTION_ENABLED_ITEM->sw.value ? 'I' : 'O';
-	if (indigo_printf(PRIVATE_DATA->handle, "F%c%04d\r\n", direction, (int)FOCUSER_STEPS_ITEM->number.value) && indigo_read_line(PRIVATE_DATA->handle, response, sizeof(response)) > 0 && strcmp(response, "*") == 0) {
+	if (indigo_printf(PRIVATE_DATA->handle, "F%c%04d\r\n", direction, (int)FOCUSER_STEPS_ITEM->number.value) && indigo_reader_read_line(&PRIVATE_DATA->reader, response, sizeof(response)) > 0 && strcmp(response, "*") == 0) {
 		FOCUSER_POSITION_ITEM->number.target += (FOCUSER_DIRECTION_MOVE_INWARD_ITEM->sw.value ? -FOCUSER_STEPS_ITEM->number.value : FOCUSER_STEPS_ITEM->number.value);
 		FOCUSER_STEPS_PROPERTY->state = FOCUSER_POSITION_PROPERTY->state = INDIGO_BUSY_STATE;
 		indigo_update_property(device, FOCUSER_POSITION_PROPERTY, NULL);
@@ -218,7 +220,7 @@ static void focuser_mode_handler(indigo_device *device) {
 	char response[16];
 	FOCUSER_MODE_PROPERTY->state = INDIGO_ALERT_STATE;
 	if (FOCUSER_MODE_AUTOMATIC_ITEM->sw.value) {
-		if (indigo_printf(PRIVATE_DATA->handle, "FQUIT1\r\n") && indigo_read_line(PRIVATE_DATA->handle, response, sizeof(response)) > 0 && strcmp(response, "DONE") == 0) {
+		if (indigo_printf(PRIVATE_DATA->handle, "FQUIT1\r\n") && indigo_reader_read_line(&PRIVATE_DATA->reader, response, sizeof(response)) > 0 && strcmp(response, "DONE") == 0) {
 			if (indigo_printf(PRIVATE_DATA->handle, "FAMODE\r\n")) {
 				FOCUSER_MODE_PROPERTY->state = INDIGO_OK_STATE;
 				indigo_delete_property(device, FOCUSER_POSITION_PROPERTY, NULL);
@@ -228,7 +230,7 @@ static void focuser_mode_handler(indigo_device *device) {
 		}
 	} else {
 		for (int i = 0; i < 10; i++) {
-			if (indigo_printf(PRIVATE_DATA->handle, "FMMODE\r\n") && indigo_read_line(PRIVATE_DATA->handle, response, sizeof(response)) > 0 && strcmp(response, "!") == 0) {
+			if (indigo_printf(PRIVATE_DATA->handle, "FMMODE\r\n") && indigo_reader_read_line(&PRIVATE_DATA->reader, response, sizeof(response)) > 0 && strcmp(response, "!") == 0) {
 				FOCUSER_MODE_PROPERTY->state = INDIGO_OK_STATE;
 				indigo_define_property(device, FOCUSER_POSITION_PROPERTY, NULL);
 				indigo_define_property(device, FOCUSER_DIRECTION_PROPERTY, NULL);
@@ -247,8 +249,8 @@ static void focuser_compensation_handler(indigo_device *device) {
 	char response[16];
 	if (IS_CONNECTED) {
 		FOCUSER_STEPS_PROPERTY->state = INDIGO_ALERT_STATE;
-		if (indigo_printf(PRIVATE_DATA->handle, "FLA%04d\r\n", (int)fabs(FOCUSER_COMPENSATION_ITEM->number.value)) && indigo_read_line(PRIVATE_DATA->handle, response, sizeof(response)) > 0 && strcmp(response, "DONE") == 0) {
-			if (indigo_printf(PRIVATE_DATA->handle, "FZAxx%c\r\n", FOCUSER_COMPENSATION_ITEM->number.value >= 0 ? '0' : '1') && indigo_read_line(PRIVATE_DATA->handle, response, sizeof(response)) > 0 && strcmp(response, "DONE") == 0) {
+		if (indigo_printf(PRIVATE_DATA->handle, "FLA%04d\r\n", (int)fabs(FOCUSER_COMPENSATION_ITEM->number.value)) && indigo_reader_read_line(&PRIVATE_DATA->reader, response, sizeof(response)) > 0 && strcmp(response, "DONE") == 0) {
+			if (indigo_printf(PRIVATE_DATA->handle, "FZAxx%c\r\n", FOCUSER_COMPENSATION_ITEM->number.value >= 0 ? '0' : '1') && indigo_reader_read_line(&PRIVATE_DATA->reader, response, sizeof(response)) > 0 && strcmp(response, "DONE") == 0) {
 				FOCUSER_COMPENSATION_PROPERTY->state = INDIGO_OK_STATE;
 			}
 		}
@@ -103,6 +103,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	indigo_property *x_name_property;
 	indigo_property *x_saved_values_property;
 	indigo_property *x_status_property;
@@ -168,7 +169,7 @@ static bool steeldrive2_command(indigo_device *device, char *command, char *resp
 #endif
 	int len = (int)strlen(command);
 	while (true) {
-		if (indigo_read_line(PRIVATE_DATA->handle, tmp, sizeof(tmp)) < 0) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, tmp, sizeof(tmp)) < 0) {
 			return false;
 		}
 		if (!strncmp(command, tmp, len)) {
@@ -176,7 +177,7 @@ static bool steeldrive2_command(indigo_device *device, char *command, char *resp
 		}
 	}
 	while (true) {
-		if (indigo_read_line(PRIVATE_DATA->handle, tmp, sizeof(tmp)) < 0) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, tmp, sizeof(tmp)) < 0) {
 			return false;
 		}
 		if (!strncmp("$BS DEBUG:", tmp, 10)) {
@@ -215,11 +216,12 @@ static bool steeldrive2_command(indigo_device *device, char *command, char *resp
 
 static void steeldrive2_connect(indigo_device *device) {
 	PRIVATE_DATA->handle = indigo_open_serial_with_speed(DEVICE_PORT_ITEM->text.value, 19200);
+	indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 	if (PRIVATE_DATA->handle > 0) {
 		PRIVATE_DATA->use_crc = false;
 		char response[256], *colon;
 		for (int i = 0; i < 3; i++) {
-			if (indigo_read_line(PRIVATE_DATA->handle, response, sizeof(response)) > 0 && !strcmp(response, "$BS Hello World!")) {
+			if (indigo_reader_read_line(&PRIVATE_DATA->reader, response, sizeof(response)) > 0 && !strcmp(response, "$BS Hello World!")) {
 				if (steeldrive2_command(device, "$BS GET VERSION", response, sizeof(response)) && (colon = strchr(response, ':'))) {
 					strcpy(INFO_DEVICE_MODEL_ITEM->text.value, "Baader Planetarium SteelDriveII");
 					strcpy(INFO_DEVICE_FW_REVISION_ITEM->text.value, colon + 1);
@@ -234,7 +236,7 @@ static void steeldrive2_connect(indigo_device *device) {
 			}
 			indigo_usleep(100000);
 		}
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 	}
 }
@@ -564,7 +566,7 @@ static void focuser_connection_handler(indigo_device *device) {
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 			if (--PRIVATE_DATA->count == 0) {
 				indigo_cancel_timer_sync(device, &PRIVATE_DATA->timer);
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -1068,7 +1070,7 @@ static void aux_connection_handler(indigo_device *device) {
 			INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected");
 			if (--PRIVATE_DATA->count == 0) {
 				indigo_cancel_timer_sync(device, &PRIVATE_DATA->timer);
-				close(PRIVATE_DATA->handle);
+				indigo_close(PRIVATE_DATA->handle);
 				PRIVATE_DATA->handle = 0;
 			}
 		}
@@ -44,6 +44,7 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	pthread_mutex_t serial_mutex;
 	indigo_timer *timer_callback;
 } nmea_private_data;
@@ -56,10 +57,12 @@ static bool gps_open(indigo_device *device) {
 	if (!indigo_is_device_url(name, "gps")) {
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Opening local device on port: '%s', baudrate = %s", DEVICE_PORT_ITEM->text.value, DEVICE_BAUDRATE_ITEM->text.value);
 		PRIVATE_DATA->handle = indigo_open_serial_with_config(name, DEVICE_BAUDRATE_ITEM->text.value);
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 	} else {
 		INDIGO_DRIVER_DEBUG(DRIVER_NAME, "Opening netwotk device on host: %s", DEVICE_PORT_ITEM->text.value);
 		indigo_network_protocol proto = INDIGO_PROTOCOL_TCP;
 		PRIVATE_DATA->handle = indigo_open_network_device(name, 9999, &proto);
+		indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 	}
 	if (PRIVATE_DATA->handle >= 0) {
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected to %s", name);
@@ -74,7 +77,7 @@ static bool gps_open(indigo_device *device) {
 
 static void gps_close(indigo_device *device) {
 	pthread_mutex_lock(&PRIVATE_DATA->serial_mutex);
-	close(PRIVATE_DATA->handle);
+	indigo_close(PRIVATE_DATA->handle);
 	PRIVATE_DATA->handle = -1;
 	INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected from %s", DEVICE_PORT_ITEM->text.value);
 	pthread_mutex_unlock(&PRIVATE_DATA->serial_mutex);
@@ -114,7 +117,7 @@ static void gps_refresh_callback(indigo_device *device) {
 	INDIGO_DRIVER_LOG(DRIVER_NAME, "NMEA reader started");
 	while (IS_CONNECTED && PRIVATE_DATA->handle >= 0) {
 		//pthread_mutex_lock(&PRIVATE_DATA->serial_mutex);
-		if (indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer)) > 0 && (tokens = parse(buffer))) {
+		if (indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer)) > 0 && (tokens = parse(buffer))) {
 			if (!strcmp(tokens[0], "RMC")) { // Recommended Minimum sentence C
 				int time = atoi(tokens[1]);
 				int date = atoi(tokens[9]);
@@ -799,7 +799,7 @@ static indigo_result mount_attach(indigo_device *device) {
 		MOUNT_GEOGRAPHIC_COORDINATES_PROPERTY->count = 2; // we can not set elevation from the protocol
 		MOUNT_UTC_TIME_PROPERTY->hidden = false;
 		MOUNT_SET_HOST_TIME_PROPERTY->hidden = false;
-		strncpy(MOUNT_GUIDE_RATE_PROPERTY->label,"ST4 guide rate", INDIGO_VALUE_SIZE);
+		indigo_set_property_label(MOUNT_GUIDE_RATE_PROPERTY, "ST4 guide rate");
 		MOUNT_TRACK_RATE_PROPERTY->hidden = true;
 		MOUNT_SLEW_RATE_PROPERTY->hidden = false;
 		INDIGO_DEVICE_ATTACH_LOG(DRIVER_NAME, device->name);
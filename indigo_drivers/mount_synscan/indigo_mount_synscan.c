@@ -79,7 +79,7 @@ static indigo_result mount_attach(indigo_device *device) {
 		MOUNT_TRACKING_ON_ITEM->sw.value = false;
 		MOUNT_TRACKING_OFF_ITEM->sw.value = true;
 		// -------------------------------------------------------------------------------- MOUNT_GUIDE_RATE
-		strncpy(MOUNT_GUIDE_RATE_PROPERTY->label,"ST4 guide rate", INDIGO_VALUE_SIZE);
+		indigo_set_property_label(MOUNT_GUIDE_RATE_PROPERTY, "ST4 guide rate");
 		// -------------------------------------------------------------------------------- MOUNT_RAW_COORDINATES
 		MOUNT_RAW_COORDINATES_PROPERTY->hidden = false;
 		// -------------------------------------------------------------------------------- DEVICE_PORTS
@@ -406,8 +406,8 @@ static indigo_result guider_attach(indigo_device *device) {
 		// -------------------------------------------------------------------------------- GUIDER_RATE
 		GUIDER_RATE_PROPERTY->hidden = false;
 		GUIDER_RATE_PROPERTY->count = 2;
-		strncpy(GUIDER_RATE_PROPERTY->label,"Pulse-Guide Rate", INDIGO_VALUE_SIZE);
-		strncpy(GUIDER_RATE_ITEM->label, "RA Guiding rate (% of sidereal)", INDIGO_VALUE_SIZE);
+		indigo_set_property_label(GUIDER_RATE_PROPERTY, "Pulse-Guide Rate");
+		indigo_set_item_label(GUIDER_RATE_ITEM, "RA Guiding rate (%% of sidereal)");
 
 		INDIGO_DEVICE_ATTACH_LOG(DRIVER_NAME, device->name);
 
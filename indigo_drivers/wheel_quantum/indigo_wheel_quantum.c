@@ -43,12 +43,14 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	int slot;
 } quantum_private_data;
 
 static bool quantum_open(indigo_device *device) {
 	char *name = DEVICE_PORT_ITEM->text.value;
 	PRIVATE_DATA->handle = indigo_open_serial(name);
+	indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 	if (PRIVATE_DATA->handle >= 0) {
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected to %s", name);
 		return true;
@@ -61,7 +63,7 @@ static bool quantum_open(indigo_device *device) {
 static void quantum_query(indigo_device *device) {
 	for (int repeat = 0; repeat < 30; repeat++) {
 		int slot;
-		if (indigo_scanf(PRIVATE_DATA->handle, "P%d", &slot) == 1) {
+		if (indigo_reader_scanf(&PRIVATE_DATA->reader, "P%d", &slot) == 1) {
 			WHEEL_SLOT_ITEM->number.value = PRIVATE_DATA->slot = slot + 1;
 			if (WHEEL_SLOT_ITEM->number.value == WHEEL_SLOT_ITEM->number.target) {
 				WHEEL_SLOT_PROPERTY->state = INDIGO_OK_STATE;
@@ -85,7 +87,7 @@ static void quantum_goto(indigo_device *device, int slot) {
 
 static void quantum_close(indigo_device *device) {
 	if (PRIVATE_DATA->handle > 0) {
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected from %s", DEVICE_PORT_ITEM->text.value);
 	}
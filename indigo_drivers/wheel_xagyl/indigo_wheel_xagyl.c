@@ -43,40 +43,42 @@
 
 typedef struct {
 	int handle;
+	indigo_reader reader;
 	int slot;
 } xagyl_private_data;
 
 static bool xagyl_open(indigo_device *device) {
 	char *name = DEVICE_PORT_ITEM->text.value;
 	PRIVATE_DATA->handle = indigo_open_serial(name);
+	indigo_init_reader(&PRIVATE_DATA->reader, PRIVATE_DATA->handle, 0);
 	if (PRIVATE_DATA->handle >= 0) {
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Connected to %s", name);
 		char buffer[128];
-		if (indigo_printf(PRIVATE_DATA->handle, "I0") && indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer)) > 0) {
+		if (indigo_printf(PRIVATE_DATA->handle, "I0") && indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer)) > 0) {
 			strncpy(INFO_DEVICE_MODEL_ITEM->text.value, buffer, INDIGO_VALUE_SIZE);
 		} else {
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read model name");
 			return false;
 		}
-		if (indigo_printf(PRIVATE_DATA->handle, "I1") && indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer)) > 0) {
+		if (indigo_printf(PRIVATE_DATA->handle, "I1") && indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer)) > 0) {
 			strncpy(INFO_DEVICE_FW_REVISION_ITEM->text.value, buffer, INDIGO_VALUE_SIZE);
 		} else {
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read firmware version");
 			return false;
 		}
-		if (indigo_printf(PRIVATE_DATA->handle, "I3") && indigo_read_line(PRIVATE_DATA->handle, buffer, sizeof(buffer)) > 0) {
+		if (indigo_printf(PRIVATE_DATA->handle, "I3") && indigo_reader_read_line(&PRIVATE_DATA->reader, buffer, sizeof(buffer)) > 0) {
 			strncpy(INFO_DEVICE_SERIAL_NUM_ITEM->text.value, buffer, INDIGO_VALUE_SIZE);
 		} else {
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read S/N");
 			return false;
 		}
-		if (indigo_printf(PRIVATE_DATA->handle, "I8") && indigo_scanf(PRIVATE_DATA->handle, "FilterSlots %d", &PRIVATE_DATA->slot) == 1) {
+		if (indigo_printf(PRIVATE_DATA->handle, "I8") && indigo_reader_scanf(&PRIVATE_DATA->reader, "FilterSlots %d", &PRIVATE_DATA->slot) == 1) {
 			WHEEL_SLOT_ITEM->number.max = PRIVATE_DATA->slot;
 		} else {
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read slot count");
 			return false;
 		}
-		if (indigo_printf(PRIVATE_DATA->handle, "I2") && indigo_scanf(PRIVATE_DATA->handle, "P%d", &PRIVATE_DATA->slot) == 1) {
+		if (indigo_printf(PRIVATE_DATA->handle, "I2") && indigo_reader_scanf(&PRIVATE_DATA->reader, "P%d", &PRIVATE_DATA->slot) == 1) {
 			WHEEL_SLOT_ITEM->number.value = PRIVATE_DATA->slot;
 		} else {
 			INDIGO_DRIVER_ERROR(DRIVER_NAME, "Failed to read position");
@@ -91,7 +93,7 @@ static bool xagyl_open(indigo_device *device) {
 
 static void xagyl_query(indigo_device *device) {
 	for (int repeat = 0; repeat < 60; repeat++) {
-		if (indigo_printf(PRIVATE_DATA->handle, "I2") && indigo_scanf(PRIVATE_DATA->handle, "P%d", &PRIVATE_DATA->slot) == 1) {
+		if (indigo_printf(PRIVATE_DATA->handle, "I2") && indigo_reader_scanf(&PRIVATE_DATA->reader, "P%d", &PRIVATE_DATA->slot) == 1) {
 			if (PRIVATE_DATA->slot == WHEEL_SLOT_ITEM->number.target) {
 				WHEEL_SLOT_ITEM->number.value = PRIVATE_DATA->slot;
 				WHEEL_SLOT_PROPERTY->state = INDIGO_OK_STATE;
@@ -122,7 +124,7 @@ static void xagyl_goto(indigo_device *device, int slot) {
 
 static void xagyl_close(indigo_device *device) {
 	if (PRIVATE_DATA->handle > 0) {
-		close(PRIVATE_DATA->handle);
+		indigo_close(PRIVATE_DATA->handle);
 		PRIVATE_DATA->handle = 0;
 		INDIGO_DRIVER_LOG(DRIVER_NAME, "Disconnected from %s", DEVICE_PORT_ITEM->text.value);
 	}
@@ -201,6 +201,7 @@ typedef enum {
 } indigo_log_levels;
 
 /** Property item definition.
+ Prefer indigo_set_item_label(), indigo_set_item_hints() and indigo_set_number_item_format() to writing label, hints and format directly.
  */
 typedef struct {/* there is no .name =  because of g++ C99 bug affecting string initialier */
 	char name[INDIGO_NAME_SIZE];        ///< property wide unique item name
@@ -244,6 +245,7 @@ typedef struct {/* there is no .name =  because of g++ C99 bug affecting string
 } indigo_item;
 
 /** Property definition.
+ Prefer indigo_set_property_label() and indigo_set_property_hints() to writing label and hints directly.
  */
 typedef struct {
 	char device[INDIGO_NAME_SIZE];      ///< system wide unique device name
@@ -350,14 +352,25 @@ typedef struct {
 	char url_prefix[INDIGO_NAME_SIZE];	///< server url prefix (for BLOB download)
 } indigo_adapter_context;
 
+/** Immutable reference counted BLOB content.
+ */
+typedef struct indigo_blob_buffer {
+	void *content;            					///< BLOB content (NULL if content is read from handle)
+	long size;              						///< BLOB size
+	long capacity;											///< allocated size of content (multiple of 2880, 0 if content is not owned)
+	int handle;													///< handle of local file with the same content or -1
+	char format[INDIGO_NAME_SIZE];  		///< BLOB format, known file type suffix like ".fits" or ".jpeg"
+	int ref_count;											///< number of references
+	struct indigo_blob_buffer *parent;	///< buffer owning the content or NULL
+} indigo_blob_buffer;
+
 /** BLOB entry type.
  */
 typedef struct {
 	indigo_item *item;     							///< BLOB item
-	void *content;            					///< BLOB content
-	long size;              						///< BLOB size
-	char format[INDIGO_NAME_SIZE];  		///< BLOB format, known file type suffix like ".fits" or ".jpeg"
-	pthread_mutex_t mutext;							///< BLOB mutex
+	indigo_blob_buffer *buffer;					///< last content of BLOB item
+	char file_name[INDIGO_VALUE_SIZE];	///< local file with the content of next update
+	indigo_blob_buffer *next_buffer;		///< buffer with the content of next update
 } indigo_blob_entry;
 
 /** Last diagnostic messages.
@@ -487,6 +500,47 @@ extern void indigo_release_property(indigo_property *property);
  */
 extern indigo_blob_entry *indigo_validate_blob(indigo_item *item);
 
+/** Get reference to last cached content of BLOB item or NULL, the reference should be released by indigo_release_blob_buffer().
+ */
+extern indigo_blob_buffer *indigo_retain_blob(indigo_item *item);
+
+/** Release reference to cached BLOB content.
+ */
+extern void indigo_release_blob_buffer(indigo_blob_buffer *buffer);
+
+/** Create reference counted BLOB buffer (page aligned, capacity rounded up to 2880 bytes), the reference should be released by indigo_release_blob_buffer().
+ */
+extern indigo_blob_buffer *indigo_create_blob_buffer(long size);
+
+/** Check if BLOB buffer is referenced by anybody else than the caller.
+ */
+extern bool indigo_is_blob_buffer_shared(indigo_blob_buffer *buffer);
+
+/** Get reference to part of BLOB buffer content (size bytes from content), it keeps the whole buffer alive until it is released by indigo_release_blob_buffer().
+ */
+extern indigo_blob_buffer *indigo_share_blob_buffer(indigo_blob_buffer *buffer, void *content, long size);
+
+/** Tell BLOB cache that content of the next update of BLOB item is in the buffer, so it can be referenced instead of being copied. Content must not be changed while the buffer is shared.
+ */
+extern void indigo_set_blob_buffer(indigo_item *item, indigo_blob_buffer *buffer);
+
+/** Tell BLOB cache that content of the buffer was stored in local file, so cached items referencing it can be served from the file and the buffer can be reused.
+ */
+extern void indigo_set_blob_buffer_file(indigo_blob_buffer *buffer, const char *file_name);
+
+/** Tell BLOB cache that content of the next update of BLOB item is already stored in local file, so it can be served from the file instead of being copied.
+ */
+extern void indigo_set_blob_file(indigo_item *item, const char *file_name);
+
+/** Lock property against replacement of its BLOB item buffers, e.g. by client side parser swapping in newly received content.
+ Lock it to read BLOB item content outside of update_property() callback, don't call any bus function while it is locked.
+ */
+extern void indigo_lock_property(indigo_property *property);
+
+/** Unlock property locked by indigo_lock_property().
+ */
+extern void indigo_unlock_property(indigo_property *property);
+
 /** Initialize text item.
  */
 extern void indigo_init_text_item(indigo_item *item, const char *name, const char *label, const char *format, ...);
@@ -494,7 +548,7 @@ extern void indigo_init_text_item(indigo_item *item, const char *name, const cha
  */
 extern void indigo_init_number_item(indigo_item *item, const char *name, const char *label, double min, double max, double step, double value);
 
-#define indigo_init_sexagesimal_number_item(item, name, label, min, max, step, value) { indigo_init_number_item(item, name, label, min, max, step, value); strcpy(item->number.format, "%12.9m"); }
+#define indigo_init_sexagesimal_number_item(item, name, label, min, max, step, value) { indigo_init_number_item(item, name, label, min, max, step, value); indigo_set_number_item_format(item, "%12.9m"); }
 
 /** Initialize switch item.
  */
@@ -506,6 +560,22 @@ extern void indigo_init_light_item(indigo_item *item, const char *name, const ch
  */
 extern void indigo_init_blob_item(indigo_item *item, const char *name, const char *label);
 
+/** Set property label.
+ */
+extern void indigo_set_property_label(indigo_property *property, const char *format, ...);
+/** Set property GUI hints.
+ */
+extern void indigo_set_property_hints(indigo_property *property, const char *hints);
+/** Set item label.
+ */
+extern void indigo_set_item_label(indigo_item *item, const char *format, ...);
+/** Set item GUI hints.
+ */
+extern void indigo_set_item_hints(indigo_item *item, const char *hints);
+/** Set number item format.
+ */
+extern void indigo_set_number_item_format(indigo_item *item, const char *format);
+
 /** populate BLOB item if url is given.
  */
 extern bool indigo_populate_http_blob_item(indigo_item *blob_item);
@@ -538,6 +608,16 @@ extern void indigo_property_copy_values(indigo_property *property, indigo_proper
  */
 extern void indigo_property_copy_targets(indigo_property *property, indigo_property *other, bool with_state);
 
+/** Copy items (everything except item names) from other property with the same items into property (e.g. cached copy).
+ Only used part of string fields is copied.
+ */
+extern void indigo_property_copy_items(indigo_property *property, indigo_property *other);
+
+/** Copy whole property into property (if NULL, new property is allocated, it has to be released with indigo_release_property()).
+ Only used part of string fields is copied, property has to have room for at least other->count items.
+ */
+extern indigo_property *indigo_copy_property(indigo_property *property, indigo_property *other);
+
 /** Sort item values on description
  */
 
@@ -682,6 +762,16 @@ extern bool indigo_use_blob_caching;
  */
 extern bool indigo_use_strict_locking;
 
+/** Coalesce number and light property updates sent to remote clients within given interval in ms (0 = disabled).
+ Only superseded updates with unchanged state and no message are dropped, switch, text and BLOB updates are always forwarded.
+ */
+extern int indigo_update_coalescing_interval;
+
+/** Sequence number of the last property definition or update broadcast.
+ Protocol adapters use it to serialize one broadcast once and share the encoding between clients.
+ */
+extern unsigned long indigo_bus_sequence;
+
 #ifdef __cplusplus
 }
 #endif
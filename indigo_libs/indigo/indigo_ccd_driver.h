@@ -139,6 +139,38 @@ extern "C" {
  */
 #define CCD_LOCAL_MODE_PREFIX_ITEM        (CCD_LOCAL_MODE_PROPERTY->items+1)
 
+/** CCD_LOCAL_WRITER property pointer, property is mandatory, property change request is fully handled by indigo_ccd_change_property().
+ */
+#define CCD_LOCAL_WRITER_PROPERTY         (CCD_CONTEXT->ccd_local_writer_property)
+
+/** CCD_LOCAL_WRITER.ASYNC property item pointer (write files on background thread).
+ */
+#define CCD_LOCAL_WRITER_ASYNC_ITEM       (CCD_LOCAL_WRITER_PROPERTY->items+0)
+
+/** CCD_LOCAL_WRITER.PREALLOCATE property item pointer (preallocate file space before write).
+ */
+#define CCD_LOCAL_WRITER_PREALLOCATE_ITEM (CCD_LOCAL_WRITER_PROPERTY->items+1)
+
+/** CCD_LOCAL_WRITER.DIRECT property item pointer (bypass page cache).
+ */
+#define CCD_LOCAL_WRITER_DIRECT_ITEM      (CCD_LOCAL_WRITER_PROPERTY->items+2)
+
+/** CCD_LOCAL_WRITER.SYNC property item pointer (flush file data to disk after write).
+ */
+#define CCD_LOCAL_WRITER_SYNC_ITEM        (CCD_LOCAL_WRITER_PROPERTY->items+3)
+
+/** CCD_LOCAL_WRITER_QUEUE property pointer, property is mandatory, read-only property, busy state means pending writes, alert state means capture is waiting for writer.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_PROPERTY   (CCD_CONTEXT->ccd_local_writer_queue_property)
+
+/** CCD_LOCAL_WRITER_QUEUE.FRAMES property item pointer.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_FRAMES_ITEM (CCD_LOCAL_WRITER_QUEUE_PROPERTY->items+0)
+
+/** CCD_LOCAL_WRITER_QUEUE.SIZE property item pointer.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM  (CCD_LOCAL_WRITER_QUEUE_PROPERTY->items+1)
+
 /** CCD_EXPOSURE property pointer, property is mandatory, property change request handler should set property items and state and call indigo_ccd_change_property().
  */
 #define CCD_EXPOSURE_PROPERTY             (CCD_CONTEXT->ccd_exposure_property)
@@ -371,6 +403,10 @@ extern "C" {
  */
 #define CCD_JPEG_SETTINGS_WHITE_TRESHOLD_ITEM     (CCD_JPEG_SETTINGS_PROPERTY->items+4)
 
+/** CCD_JPEG_SETTINGS.PREVIEW_SIZE property item pointer (maximal preview width or height, 0 = full resolution).
+ */
+#define CCD_JPEG_SETTINGS_PREVIEW_SIZE_ITEM     (CCD_JPEG_SETTINGS_PROPERTY->items+5)
+
 /** CCD_RBI_FLUSH property pointer.
  */
 #define CCD_RBI_FLUSH_PROPERTY          (CCD_CONTEXT->ccd_rbi_flush_property)
@@ -395,19 +431,45 @@ extern "C" {
 #define CCD_RBI_FLUSH_DISABLED_ITEM     (CCD_RBI_FLUSH_ENABLE_PROPERTY->items + 1)
 
 
+/** Number of frame buffers in per-device pool.
+ */
+#define CCD_FRAME_BUFFER_COUNT			3
+
 /** CCD device context structure.
  */
 typedef struct {
 	indigo_device_context device_context;         ///< device context base
 	bool countdown_enabled;												///< countdown enabled
 	indigo_timer *countdown_timer;								///< countdown timer
-	void *preview_image;													///< preview image buffer
+	void *preview_image;													///< preview image buffer (reused between frames)
 	unsigned long preview_image_size;							///< preview image buffer size
+	void *scratch_buffer;													///< image processing scratch buffer (reused between frames)
+	unsigned long scratch_buffer_size;						///< image processing scratch buffer size
+	indigo_blob_buffer *frame_buffers[CCD_FRAME_BUFFER_COUNT]; ///< pool of reference counted frame buffers
+	char *fits_header_template;										///< cached geometry dependent part of FITS header
+	int fits_header_template_size;								///< size of cached part of FITS header
+	int fits_header_bpp;													///< bytes per pixel of cached FITS header
+	int fits_header_naxis;												///< number of axes of cached FITS header
+	int fits_header_width;												///< frame width of cached FITS header
+	int fits_header_height;												///< frame height of cached FITS header
+	char local_file_format[INDIGO_VALUE_SIZE];		///< last local file name format
+	int local_file_index;													///< last used local file name index
+	pthread_t local_writer_thread;								///< background local file writer thread
+	pthread_mutex_t local_writer_mutex;						///< background local file writer queue mutex
+	pthread_cond_t local_writer_cond;							///< background local file writer queue condition
+	void *local_writer_queue;											///< frames waiting for background local file writer
+	void *local_writer_spare;											///< written frame buffers for reuse
+	int local_writer_frames;											///< number of frames waiting for background local file writer
+	unsigned long local_writer_size;							///< size of frames waiting for background local file writer
+	bool local_writer_running;										///< background local file writer thread is running
+	bool local_writer_exit;												///< background local file writer thread should exit
 	indigo_property *ccd_info_property;           ///< CCD_INFO property pointer
 	indigo_property *ccd_lens_property;						///< CCD_LENS property pointer
 	indigo_property *ccd_upload_mode_property;    ///< CCD_UPLOAD_MODE property pointer
 	indigo_property *ccd_preview_property;				///< CCD_PREVIEW property pointer
 	indigo_property *ccd_local_mode_property;     ///< CCD_LOCAL_MODE property pointer
+	indigo_property *ccd_local_writer_property;		///< CCD_LOCAL_WRITER property pointer
+	indigo_property *ccd_local_writer_queue_property; ///< CCD_LOCAL_WRITER_QUEUE property pointer
 	indigo_property *ccd_mode_property;	          ///< CCD_MODE property pointer
 	indigo_property *ccd_read_mode_property;	  	///< CCD_READ_MODE property pointer
 	indigo_property *ccd_exposure_property;       ///< CCD_EXPOSURE property pointer
@@ -471,6 +533,11 @@ typedef struct {
 	const char *comment;
 } indigo_fits_keyword;
 
+/** Get frame buffer for next frame from per-device pool. Buffer is at least size bytes long (FITS_HEADER_SIZE included), page aligned and rounded up to 2880 bytes.
+    Buffers still referenced by BLOB cache, HTTP transfers or local writer are never returned, so the driver should call it for every frame and pass the result to indigo_process_image().
+ */
+extern void *indigo_ccd_frame_buffer(indigo_device *device, long size);
+
 /** Process raw image in image buffer (starting on data + FITS_HEADER_SIZE offset).
  */
 extern void indigo_process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords);
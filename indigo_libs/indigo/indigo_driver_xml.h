@@ -33,10 +33,46 @@
 extern "C" {
 #endif
 
+/** Outbound queue policy for slow clients.
+ */
+typedef enum {
+	INDIGO_OUTPUT_QUEUE_KEEP_ALL,				///< queue everything, never coalesce or drop
+	INDIGO_OUTPUT_QUEUE_KEEP_LATEST,		///< keep only latest pending value per property, drop oldest update if queue is full
+	INDIGO_OUTPUT_QUEUE_DROP						///< drop new updates if queue is full
+} indigo_output_queue_policy;
+
+/** Outbound queue policy (only number and light updates without message are coalesced or dropped, pending BLOB update is replaced by newer one unless policy is INDIGO_OUTPUT_QUEUE_KEEP_ALL).
+ */
+extern indigo_output_queue_policy indigo_xml_output_queue_policy;
+
+/** Maximal number of pending number and light updates per client before policy is applied.
+ */
+extern int indigo_xml_output_queue_size;
+
+/** Maximal size of pending messages per client in bytes, client is disconnected if it is exceeded (or if number of pending number and light updates exceeds 4 times indigo_xml_output_queue_size).
+ */
+extern long indigo_xml_output_queue_memory;
+
 /** Create initialized instance of XML wire protocol client side adapter.
+ Messages are serialized on caller thread and written to output by dedicated writer thread.
  */
 extern indigo_client *indigo_xml_device_adapter(int input, int ouput);
 
+/** Output request callback of asynchronous XML wire protocol client side adapter.
+ */
+typedef void (*indigo_xml_output_callback)(void *data);
+
+/** Create initialized instance of XML wire protocol client side adapter without writer thread.
+ Messages are serialized on caller thread, callback is called when output becomes pending and the owner (e.g. server reactor) calls indigo_xml_device_adapter_flush() when output socket is writable.
+ Output must be socket, it is not closed by parser, so input can be its duplicate if output is drained after parser finished.
+ */
+extern indigo_client *indigo_xml_device_adapter_async(int input, int ouput, indigo_xml_output_callback callback, void *data);
+
+/** Write pending output of asynchronous adapter without blocking, return true if some output is still pending.
+ It must not be called concurrently for the same adapter.
+ */
+extern bool indigo_xml_device_adapter_flush(indigo_client *client);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,7 @@ extern "C" {
 #define INDIGO_FILTER_LIST_COUNT							12
 #define INDIGO_FILTER_MAX_DEVICES							32
 #define INDIGO_FILTER_MAX_CACHED_PROPERTIES		256
+#define INDIGO_FILTER_CACHE_HASH_SIZE					512
 	
 #define INDIGO_FILTER_CCD_INDEX								0
 #define INDIGO_FILTER_WHEEL_INDEX							1
@@ -172,6 +173,12 @@ typedef struct {
 	indigo_property *device_property_cache[INDIGO_FILTER_MAX_CACHED_PROPERTIES];
 	indigo_property *agent_property_cache[INDIGO_FILTER_MAX_CACHED_PROPERTIES];
 	indigo_property *connection_property_cache[INDIGO_FILTER_MAX_DEVICES];
+	int device_property_hash[INDIGO_FILTER_CACHE_HASH_SIZE];       ///< (device, name) index to device_property_cache, slot + 1 or 0
+	int device_property_next[INDIGO_FILTER_MAX_CACHED_PROPERTIES]; ///< device_property_hash chains
+	int agent_property_hash[INDIGO_FILTER_CACHE_HASH_SIZE];        ///< (device, name) index to agent_property_cache, slot + 1 or 0
+	int agent_property_next[INDIGO_FILTER_MAX_CACHED_PROPERTIES];  ///< agent_property_hash chains
+	pthread_mutex_t update_mutex;               ///< guards update notification
+	pthread_cond_t update_cond;                 ///< signalled on every property update seen by filter
 } indigo_filter_context;
 
 /** Device attach callback function.
@@ -209,6 +216,12 @@ extern indigo_property *indigo_filter_cached_property(indigo_device *device, int
 /** Forward property change to a different device.
  */
 extern indigo_result indigo_filter_forward_change_property(indigo_client *client, indigo_property *property, char *device_name);
+/** Block until condition returns true or timeout (in seconds) expires, condition is evaluated again after each update of any property seen by filter or change of agent property. Returns the last value of condition.
+ */
+extern bool indigo_filter_wait(indigo_device *device, bool (*condition)(indigo_device *device, void *data), void *data, double timeout);
+/** Wake up all threads blocked in indigo_filter_wait() to evaluate their conditions again.
+ */
+extern void indigo_filter_notify(indigo_device *device);
 #ifdef __cplusplus
 }
 #endif
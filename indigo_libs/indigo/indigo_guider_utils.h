@@ -50,6 +50,8 @@ typedef struct {
 		double centroid_y;
 	};
 	double snr;
+	int roi_x;            /* Origin of the digest window */
+	int roi_y;
 } indigo_frame_digest;
 
 extern indigo_result indigo_find_stars(indigo_raw_type raw_type, const void *data, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found);
@@ -58,6 +60,8 @@ extern indigo_result indigo_selection_psf(indigo_raw_type raw_type, const void *
 extern indigo_result indigo_selection_frame_digest(indigo_raw_type raw_type, const void *data, double *x, double *y, const int radius, const int width, const int height, indigo_frame_digest *c);
 extern indigo_result indigo_centroid_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, indigo_frame_digest *c);
 extern indigo_result indigo_donuts_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, indigo_frame_digest *fdigest);
+extern indigo_result indigo_centroid_roi_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, const int roi_x, const int roi_y, const int roi_width, const int roi_height, indigo_frame_digest *c);
+extern indigo_result indigo_donuts_roi_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, const int roi_x, const int roi_y, const int roi_width, const int roi_height, indigo_frame_digest *fdigest);
 extern indigo_result indigo_calculate_drift(const indigo_frame_digest *ref, const indigo_frame_digest *new, double *drift_x, double *drift_y);
 extern indigo_result indigo_delete_frame_digest(indigo_frame_digest *fdigest);
 
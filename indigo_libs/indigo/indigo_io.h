@@ -40,6 +40,21 @@ typedef enum {
 	INDIGO_PROTOCOL_UDP = 1
 } indigo_network_protocol;
 
+/** Size of buffered reader read ahead buffer.
+ */
+#define INDIGO_READER_BUFFER_SIZE	4096
+
+/** Buffered reader.
+ Reads handle in chunks and serves lines or exact byte counts from the buffer, so all subsequent reads of the handle should go through the same reader.
+ */
+typedef struct {
+	int handle;																///< handle
+	int timeout;															///< read timeout in ms (0 = wait forever)
+	int start;																///< first unread byte in buffer
+	int end;																	///< end of valid data in buffer
+	char buffer[INDIGO_READER_BUFFER_SIZE];		///< read ahead buffer
+} indigo_reader;
+
 /** Open serial connection at speed 9600.
  */
 extern int indigo_open_serial(const char *dev_file);
@@ -78,16 +93,41 @@ extern int indigo_read(int handle, char *buffer, long length);
 /** Read buffer from socket.
  */
 extern int indigo_recv(int handle, char *buffer, long length);
+#endif
 
-/** Read buffer from socket.
+/** Close handle opened by indigo_open_*() functions.
  */
 extern int indigo_close(int handle);
-#endif
 
-/** Read line.
+/** Read line ('\r' is skipped, '\n' is not stored) without reading ahead, socket handles are peeked in chunks, other handles are read byte by byte.
+ Line oriented drivers should use buffered reader instead.
  */
 extern int indigo_read_line(int handle, char *buffer, int length);
 
+/** Initialize buffered reader for handle with timeout in ms (0 = wait forever).
+ */
+extern void indigo_init_reader(indigo_reader *reader, int handle, int timeout);
+
+/** Read line from buffered reader ('\r' is skipped, '\n' is not stored), returns length or -1 on error, end of stream or timeout.
+ */
+extern int indigo_reader_read_line(indigo_reader *reader, char *buffer, int length);
+
+/** Read exactly length bytes from buffered reader, returns length or value <= 0 on error, end of stream or timeout.
+ */
+extern long indigo_reader_read(indigo_reader *reader, char *buffer, long length);
+
+/** Return next byte from buffered reader without consuming it or -1 on error, end of stream or timeout.
+ */
+extern int indigo_reader_peek(indigo_reader *reader);
+
+/** Discard data read ahead by buffered reader (e.g. after tcflush() of its handle).
+ */
+extern void indigo_reader_discard(indigo_reader *reader);
+
+/** Read line from buffered reader and parse it with sscanf() format, returns number of parsed values.
+ */
+extern int indigo_reader_scanf(indigo_reader *reader, const char *format, ...);
+
 /** Write buffer.
  */
 extern bool indigo_write(int handle, const char *buffer, long length);
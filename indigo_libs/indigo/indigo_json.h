@@ -43,10 +43,27 @@ extern "C" {
 #define ntohll(x) ((1==ntohl(1)) ? (x) : ((uint64_t)ntohl((x) & 0xFFFFFFFF) << 32) | ntohl((x) >> 32))
 #endif
 
-/** JSON wire protocol parser.
+/** JSON wire protocol parser, reads input of adapter until end of stream or error and closes it.
  */
 extern void indigo_json_parse(indigo_device *device, indigo_client *client);
 
+/** Incremental JSON wire protocol parser.
+ */
+typedef struct indigo_json_parser indigo_json_parser;
+
+/** Create incremental parser for the same adapters as indigo_json_parse(), data are supplied by caller (e.g. by server reactor when socket is readable).
+ WebSocket frames or lines of plain JSON may be split between chunks arbitrarily.
+ */
+extern indigo_json_parser *indigo_json_parser_create(indigo_device *device, indigo_client *client);
+
+/** Parse next chunk of input, return false on syntax error or oversized WebSocket frame.
+ */
+extern bool indigo_json_parser_feed(indigo_json_parser *parser, const char *data, long length);
+
+/** Release parser, input of adapter is not closed.
+ */
+extern void indigo_json_parser_release(indigo_json_parser *parser);
+
 #ifdef __cplusplus
 }
 #endif
@@ -319,6 +319,40 @@
  */
 #define CCD_LOCAL_MODE_PREFIX_ITEM_NAME       "PREFIX"
 
+//----------------------------------------------------------------------
+/** CCD_LOCAL_WRITER property name.
+ */
+#define CCD_LOCAL_WRITER_PROPERTY_NAME        "CCD_LOCAL_WRITER"
+
+/** CCD_LOCAL_WRITER.ASYNC property item name.
+ */
+#define CCD_LOCAL_WRITER_ASYNC_ITEM_NAME      "ASYNC"
+
+/** CCD_LOCAL_WRITER.PREALLOCATE property item name.
+ */
+#define CCD_LOCAL_WRITER_PREALLOCATE_ITEM_NAME "PREALLOCATE"
+
+/** CCD_LOCAL_WRITER.DIRECT property item name.
+ */
+#define CCD_LOCAL_WRITER_DIRECT_ITEM_NAME     "DIRECT"
+
+/** CCD_LOCAL_WRITER.SYNC property item name.
+ */
+#define CCD_LOCAL_WRITER_SYNC_ITEM_NAME       "SYNC"
+
+//----------------------------------------------------------------------
+/** CCD_LOCAL_WRITER_QUEUE property name.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_PROPERTY_NAME  "CCD_LOCAL_WRITER_QUEUE"
+
+/** CCD_LOCAL_WRITER_QUEUE.FRAMES property item name.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_FRAMES_ITEM_NAME "FRAMES"
+
+/** CCD_LOCAL_WRITER_QUEUE.SIZE property item name.
+ */
+#define CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM_NAME "SIZE"
+
 //----------------------------------------------------------------------
 /** CCD_EXPOSURE property name.
  */
@@ -559,6 +593,10 @@
  */
 #define CCD_JPEG_SETTINGS_WHITE_TRESHOLD_ITEM_NAME			"WHITE_TRESHOLD"
 
+/** CCD_JPEG_SETTINGS.PREVIEW_SIZE property item name.
+ */
+#define CCD_JPEG_SETTINGS_PREVIEW_SIZE_ITEM_NAME			"PREVIEW_SIZE"
+
 /** CCD_RBI_FLUSH_ENABLE property name.
  */
 #define CCD_RBI_FLUSH_PROPERTY_NAME          "CCD_RBI_FLUSH_ENABLE"
@@ -2253,6 +2291,7 @@
 #define AGENT_GUIDER_DETECTION_DONUTS_ITEM_NAME  			"DONUTS"
 #define AGENT_GUIDER_DETECTION_CENTROID_ITEM_NAME    	"CENTROID"
 #define AGENT_GUIDER_DETECTION_SELECTION_ITEM_NAME    "SELECTION"
+#define AGENT_GUIDER_DETECTION_MULTI_STAR_ITEM_NAME   "MULTI_STAR"
 
 #define AGENT_GUIDER_DEC_MODE_PROPERTY_NAME						"AGENT_GUIDER_DEC_MODE"
 #define AGENT_GUIDER_DEC_MODE_BOTH_ITEM_NAME    			"BOTH"
@@ -2260,6 +2299,15 @@
 #define AGENT_GUIDER_DEC_MODE_SOUTH_ITEM_NAME    			"SOUTH"
 #define AGENT_GUIDER_DEC_MODE_NONE_ITEM_NAME    			"NONE"
 
+#define AGENT_GUIDER_ROI_MODE_PROPERTY_NAME						"AGENT_GUIDER_ROI_MODE"
+#define AGENT_GUIDER_ROI_MODE_DISABLED_ITEM_NAME    	"DISABLED"
+#define AGENT_GUIDER_ROI_MODE_WINDOW_ITEM_NAME    		"WINDOW"
+#define AGENT_GUIDER_ROI_MODE_SUBFRAME_ITEM_NAME    	"SUBFRAME"
+
+#define AGENT_GUIDER_CALIBRATION_MODE_PROPERTY_NAME		"AGENT_GUIDER_CALIBRATION_MODE"
+#define AGENT_GUIDER_CALIBRATION_MODE_ALWAYS_ITEM_NAME	"ALWAYS"
+#define AGENT_GUIDER_CALIBRATION_MODE_REUSE_ITEM_NAME		"REUSE"
+
 #define AGENT_GUIDER_SETTINGS_PROPERTY_NAME						"AGENT_GUIDER_SETTINGS"
 #define AGENT_GUIDER_SETTINGS_EXPOSURE_ITEM_NAME   		"EXPOSURE"
 #define AGENT_GUIDER_SETTINGS_DELAY_ITEM_NAME   			"DELAY"
@@ -2282,6 +2330,10 @@
 #define AGENT_GUIDER_SETTINGS_STACK_ITEM_NAME					"STACK"
 #define AGENT_GUIDER_SETTINGS_PW_RA_ITEM_NAME				"PROPORTIONAL_WEIGHT_RA"
 #define AGENT_GUIDER_SETTINGS_PW_DEC_ITEM_NAME				"PROPORTIONAL_WEIGHT_DEC"
+#define AGENT_GUIDER_SETTINGS_ROI_SIZE_ITEM_NAME			"ROI_SIZE"
+#define AGENT_GUIDER_SETTINGS_STAR_COUNT_ITEM_NAME		"STAR_COUNT"
+#define AGENT_GUIDER_SETTINGS_PEC_PERIOD_ITEM_NAME		"PEC_PERIOD"
+#define AGENT_GUIDER_SETTINGS_PEC_GAIN_ITEM_NAME			"PEC_GAIN"
 
 #define AGENT_GUIDER_STARS_PROPERTY_NAME							"AGENT_GUIDER_STARS"
 #define AGENT_GUIDER_STARS_REFRESH_ITEM_NAME					"REFRESH"
@@ -2318,6 +2370,11 @@
 #define AGENT_IMAGER_FOCUS_FINAL_ITEM_NAME  					"FINAL"
 #define AGENT_IMAGER_FOCUS_BACKLASH_ITEM_NAME     		"BACKLASH"
 #define AGENT_IMAGER_FOCUS_STACK_ITEM_NAME  					"STACK"
+#define AGENT_IMAGER_FOCUS_SAMPLES_ITEM_NAME  				"SAMPLES"
+
+#define AGENT_IMAGER_FOCUS_METHOD_PROPERTY_NAME				"AGENT_IMAGER_FOCUS_METHOD"
+#define AGENT_IMAGER_FOCUS_METHOD_ITERATIVE_ITEM_NAME	"ITERATIVE"
+#define AGENT_IMAGER_FOCUS_METHOD_V_CURVE_ITEM_NAME		"V_CURVE"
 
 #define AGENT_IMAGER_DITHERING_PROPERTY_NAME 					"AGENT_IMAGER_DITHERING"
 #define AGENT_IMAGER_DITHERING_AGGRESSIVITY_ITEM_NAME "AGGRESSIVITY"
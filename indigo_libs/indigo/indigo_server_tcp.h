@@ -44,6 +44,10 @@ extern int indigo_server_tcp_port;
  */
 extern bool indigo_is_ephemeral_port;
 
+/** Number of worker threads serving all connections, HTTP requests, BLOB and file transfers and XML and JSON sessions (Linux only, 0 = thread per connection).
+ */
+extern int indigo_server_tcp_workers;
+
 /** Add static document.
  */
 extern void indigo_server_add_resource(const char *path, unsigned char *data, unsigned length, const char *content_type);
@@ -38,10 +38,26 @@ extern "C" {
 
 extern bool indigo_use_blob_urls;
 
-/** XML wire protocol parser.
+/** XML wire protocol parser, reads input of adapter until end of stream or error and closes it.
  */
 extern void indigo_xml_parse(indigo_device *device, indigo_client *client);
 
+/** Incremental XML wire protocol parser.
+ */
+typedef struct indigo_xml_parser indigo_xml_parser;
+
+/** Create incremental parser for the same adapters as indigo_xml_parse(), data are supplied by caller (e.g. by server reactor when socket is readable).
+ */
+extern indigo_xml_parser *indigo_xml_parser_create(indigo_device *device, indigo_client *client);
+
+/** Parse next chunk of input, return false on syntax error.
+ */
+extern bool indigo_xml_parser_feed(indigo_xml_parser *parser, const char *data, long length);
+
+/** Release parser and delete devices defined through it, input of adapter is not closed.
+ */
+extern void indigo_xml_parser_release(indigo_xml_parser *parser);
+
 /** Escape XML string.
  */
 extern char *indigo_xml_escape(char *string);
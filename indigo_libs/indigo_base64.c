@@ -20,9 +20,210 @@
 // 2.0 by Rumen G. Bogdanovski
 
 #include <ctype.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <indigo/indigo_base64.h>
 #include <indigo/indigo_base64_luts.h>
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BASE64_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define BASE64_NEON
+#include <arm_neon.h>
+#endif
+
+/* SIMD paths process whole blocks only and return number of input bytes consumed,
+ * the rest (and any block with invalid characters) is left to the table driven code below.
+ * Encoding follows W. Mula & D. Lemire, "Faster Base64 Encoding and Decoding using AVX2 Instructions".
+ */
+
+#if defined(BASE64_X86)
+
+__attribute__((target("ssse3")))
+static inline __m128i encode_lookup_ssse3(__m128i indices) {
+	__m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+	__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+	result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+	const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	return _mm_add_epi8(_mm_shuffle_epi8(shift, result), indices);
+}
+
+__attribute__((target("ssse3")))
+static long encode_ssse3(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	const __m128i split = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	for (; inlen - done >= 16; done += 12, out += 16) {
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + done)), split);
+		__m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		__m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		_mm_storeu_si128((__m128i *)out, encode_lookup_ssse3(_mm_or_si128(t0, t1)));
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static long encode_avx2(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	const __m256i split = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	for (; inlen - done >= 28; done += 24, out += 32) {
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + done))), _mm_loadu_si128((const __m128i *)(in + done + 12)), 1);
+		v = _mm256_shuffle_epi8(v, split);
+		__m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+		__m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+		__m256i indices = _mm256_or_si256(t0, t1);
+		__m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		__m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+		result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+		_mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(_mm256_shuffle_epi8(shift, result), indices));
+	}
+	return done;
+}
+
+__attribute__((target("ssse3")))
+static long decode_ssse3(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask_2f = _mm_set1_epi8(0x2f);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	for (; inlen - done >= 16; done += 16, out += 12) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + done));
+		__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask_2f);
+		__m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(v, mask_2f));
+		__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+			break;
+		__m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(v, mask_2f), hi_nibbles));
+		v = _mm_maddubs_epi16(_mm_add_epi8(v, roll), _mm_set1_epi32(0x01400140));
+		v = _mm_shuffle_epi8(_mm_madd_epi16(v, _mm_set1_epi32(0x00011000)), pack);
+		_mm_storel_epi64((__m128i *)out, v);
+		uint32_t tail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(out + 8, &tail, 4);
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static long decode_avx2(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i merge = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+	for (; inlen - done >= 32; done += 32, out += 24) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(in + done));
+		__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+		__m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(v, mask_2f));
+		__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+		if (!_mm256_testz_si256(lo, hi))
+			break;
+		__m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(v, mask_2f), hi_nibbles));
+		v = _mm256_maddubs_epi16(_mm256_add_epi8(v, roll), _mm256_set1_epi32(0x01400140));
+		v = _mm256_shuffle_epi8(_mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000)), pack);
+		v = _mm256_permutevar8x32_epi32(v, merge);
+		_mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(v));
+		_mm_storel_epi64((__m128i *)(out + 16), _mm256_extracti128_si256(v, 1));
+	}
+	return done;
+}
+
+static int simd_level(void) {
+	static int level = -1;
+	if (level < 0) {
+		__builtin_cpu_init();
+		level = __builtin_cpu_supports("avx2") ? 2 : __builtin_cpu_supports("ssse3") ? 1 : 0;
+	}
+	return level;
+}
+
+static inline bool simd_available(void) {
+	return simd_level() > 0;
+}
+
+static long simd_encode(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	switch (simd_level()) {
+		case 2:
+			done = encode_avx2(out, in, inlen);
+			/* fall through */
+		case 1:
+			done += encode_ssse3(out + done / 3 * 4, in + done, inlen - done);
+	}
+	return done;
+}
+
+static long simd_decode(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	switch (simd_level()) {
+		case 2:
+			done = decode_avx2(out, in, inlen);
+			if (done + 32 <= inlen)
+				return done; /* invalid character */
+			/* fall through */
+		case 1:
+			done += decode_ssse3(out + done / 4 * 3, in + done, inlen - done);
+	}
+	return done;
+}
+
+#elif defined(BASE64_NEON)
+
+static inline bool simd_available(void) {
+	return true;
+}
+
+static long simd_encode(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	const uint8x16x4_t lut = { { vld1q_u8((const uint8_t *)base64digits), vld1q_u8((const uint8_t *)base64digits + 16), vld1q_u8((const uint8_t *)base64digits + 32), vld1q_u8((const uint8_t *)base64digits + 48) } };
+	const uint8x16_t mask = vdupq_n_u8(0x3f);
+	for (; inlen - done >= 48; done += 48, out += 64) {
+		uint8x16x3_t v = vld3q_u8(in + done);
+		uint8x16x4_t r;
+		r.val[0] = vqtbl4q_u8(lut, vshrq_n_u8(v.val[0], 2));
+		r.val[1] = vqtbl4q_u8(lut, vandq_u8(vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), mask));
+		r.val[2] = vqtbl4q_u8(lut, vandq_u8(vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), mask));
+		r.val[3] = vqtbl4q_u8(lut, vandq_u8(v.val[2], mask));
+		vst4q_u8(out, r);
+	}
+	return done;
+}
+
+static inline uint8x16_t decode_lookup_neon(uint8x16_t c) {
+	uint8x16_t r = vdupq_n_u8(0xff);
+	r = vbslq_u8(vcleq_u8(vsubq_u8(c, vdupq_n_u8('A')), vdupq_n_u8(25)), vsubq_u8(c, vdupq_n_u8('A')), r);
+	r = vbslq_u8(vcleq_u8(vsubq_u8(c, vdupq_n_u8('a')), vdupq_n_u8(25)), vsubq_u8(c, vdupq_n_u8('a' - 26)), r);
+	r = vbslq_u8(vcleq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(9)), vaddq_u8(c, vdupq_n_u8(52 - '0')), r);
+	r = vbslq_u8(vceqq_u8(c, vdupq_n_u8('+')), vdupq_n_u8(62), r);
+	r = vbslq_u8(vceqq_u8(c, vdupq_n_u8('/')), vdupq_n_u8(63), r);
+	return r;
+}
+
+static long simd_decode(unsigned char *out, const unsigned char *in, long inlen) {
+	long done = 0;
+	for (; inlen - done >= 64; done += 64, out += 48) {
+		uint8x16x4_t v = vld4q_u8(in + done);
+		uint8x16_t a = decode_lookup_neon(v.val[0]);
+		uint8x16_t b = decode_lookup_neon(v.val[1]);
+		uint8x16_t c = decode_lookup_neon(v.val[2]);
+		uint8x16_t d = decode_lookup_neon(v.val[3]);
+		if (vmaxvq_u8(vorrq_u8(vorrq_u8(a, b), vorrq_u8(c, d))) > 0x3f)
+			break;
+		uint8x16x3_t r;
+		r.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+		r.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+		r.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+		vst3q_u8(out, r);
+	}
+	return done;
+}
+
+#endif
+
 #include <stdio.h>
 
 /* out size should be at least 4*inlen/3 + 4.
@@ -31,6 +232,12 @@
 long base64_encode(unsigned char *out, const unsigned char *in, long inlen) {
 	uint16_t* b64lut = (uint16_t*)base64lut;
 	long dlen = ((inlen+2)/3)*4; /* 4/3, rounded up */
+#if defined(BASE64_X86) || defined(BASE64_NEON)
+	long done = simd_encode(out, in, inlen);
+	out += done / 3 * 4;
+	in += done;
+	inlen -= done;
+#endif
 	uint16_t* wbuf = (uint16_t*)out;
 
 	for(; inlen > 2; inlen -= 3 ) {
@@ -65,6 +272,14 @@ long base64_decode_fast(unsigned char* out, const unsigned char* in, long inlen)
 	uint16_t s1, s2;
 	uint32_t n32;
 	int j;
+#if defined(BASE64_X86) || defined(BASE64_NEON)
+	/* last quartet may be padded, leave it to the code below */
+	long done = simd_decode(out, in, inlen - 4);
+	out += done / 4 * 3;
+	in += done;
+	inlen -= done;
+	outlen = done / 4 * 3;
+#endif
 	long n = (inlen/4)-1;
 	uint16_t* inp = (uint16_t*)in;
 
@@ -89,7 +304,7 @@ long base64_decode_fast(unsigned char* out, const unsigned char* in, long inlen)
 		inp += 2;
 		out += 3;
 	}
-	outlen = (inlen / 4 - 1) * 3;
+	outlen += (inlen / 4 - 1) * 3;
 
 	s1 = rbase64lut[ inp[0] ];
 	s2 = rbase64lut[ inp[1] ];
@@ -118,17 +333,36 @@ long base64_decode_fast(unsigned char* out, const unsigned char* in, long inlen)
 }
 
 
+/* inlen is number of base64 characters, newline may precede any quartet. */
 long base64_decode_fast_nl(unsigned char* out, const unsigned char* in, long inlen) {
 	long outlen = 0;
 	uint8_t b1, b2, b3;
 	uint16_t s1, s2;
 	uint32_t n32;
-	int j;
+	long j;
 	long n = (inlen/4)-1;
 	uint16_t* inp = (uint16_t*)in;
+#if defined(BASE64_X86) || defined(BASE64_NEON)
+	const unsigned char *line_end = in;
+#endif
 
 	for( j = 0; j < n; j++ ) {
 		if (in[0] == '\n') in++;
+#if defined(BASE64_X86) || defined(BASE64_NEON)
+		if (in >= line_end && n - j >= 8 && simd_available()) {
+			/* whole quartets up to the next newline go to SIMD code, the rest of line and invalid blocks to the code below */
+			line_end = memchr(in, '\n', (n - j) * 4);
+			if (line_end == NULL)
+				line_end = in + (n - j) * 4;
+			long done = simd_decode(out, in, (line_end - in) & ~3L);
+			if (done > 0) {
+				in += done;
+				out += done / 4 * 3;
+				j += done / 4 - 1;
+				continue;
+			}
+		}
+#endif
 		inp = (uint16_t*)in;
 
 		s1 = rbase64lut[ inp[0] ];
@@ -39,7 +39,9 @@
 #include <sys/time.h>
 #include <syslog.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #endif
 #if defined(INDIGO_WINDOWS)
 #include <io.h>
@@ -56,12 +58,18 @@
 #define MAX_DEVICES 256
 #define MAX_CLIENTS 256
 #define MAX_BLOBS	32
+#define MAX_SPARE_BLOB_BUFFERS	4
+#define MAX_SPARE_BLOB_BYTES		(128L * 1024 * 1024)
+#define SPARE_BLOB_IDLE_TIME		60
+#define BLOB_BUFFER_ALIGNMENT		4096
 
 #define BUFFER_SIZE	1024
 
 static indigo_device *devices[MAX_DEVICES];
 static indigo_client *clients[MAX_CLIENTS];
 static indigo_blob_entry *blobs[MAX_BLOBS];
+static indigo_blob_buffer *spare_blob_buffers[MAX_SPARE_BLOB_BUFFERS];
+static time_t spare_blob_released[MAX_SPARE_BLOB_BUFFERS];
 
 static pthread_mutex_t bus_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
 #define client_mutex bus_mutex
@@ -70,6 +78,31 @@ static pthread_mutex_t bus_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
 bool indigo_use_strict_locking = true;
 
 static pthread_mutex_t blob_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t property_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int indigo_update_coalescing_interval = 0;
+unsigned long indigo_bus_sequence = 0;
+
+#define COALESCE_HASH_SIZE	256
+
+typedef struct coalesce_entry {
+	struct coalesce_entry *next;
+	indigo_client *client;
+	indigo_device *device;
+	char device_name[INDIGO_NAME_SIZE];
+	char property_name[INDIGO_NAME_SIZE];
+	int state;
+	double last;
+	unsigned long generation;
+	indigo_property *pending;
+} coalesce_entry;
+
+static coalesce_entry *coalesce_table[COALESCE_HASH_SIZE];
+static pthread_mutex_t coalesce_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t coalesce_cond;
+static pthread_once_t coalesce_once = PTHREAD_ONCE_INIT;
+static bool coalesce_thread_running = false;
+static pthread_t coalesce_thread;
 
 static bool is_started = false;
 
@@ -328,6 +361,333 @@ void indigo_trace_property(const char *message, indigo_property *property, bool
 	}
 }
 
+static void coalesce_init() {
+	pthread_condattr_t cond_attr;
+	pthread_condattr_init(&cond_attr);
+#ifdef INDIGO_LINUX
+	pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+#endif
+	pthread_cond_init(&coalesce_cond, &cond_attr);
+	pthread_condattr_destroy(&cond_attr);
+}
+
+static double coalesce_time() {
+#ifdef INDIGO_LINUX
+	/* coalesce_cond runs on monotonic clock, so wall clock steps don't stall or burst the flushes */
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1000000000.0;
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec + now.tv_usec / 1000000.0;
+#endif
+}
+
+static unsigned coalesce_hash(const char *device_name, const char *property_name) {
+	unsigned hash = 5381;
+	while (*device_name)
+		hash = hash * 33 + *device_name++;
+	while (*property_name)
+		hash = hash * 33 + *property_name++;
+	return hash % COALESCE_HASH_SIZE;
+}
+
+static coalesce_entry *coalesce_find(indigo_client *client, const char *device_name, const char *property_name) {
+	coalesce_entry *entry = coalesce_table[coalesce_hash(device_name, property_name)];
+	while (entry && (entry->client != client || strcmp(entry->device_name, device_name) || strcmp(entry->property_name, property_name)))
+		entry = entry->next;
+	return entry;
+}
+
+static void *coalesce_flush(void *data) {
+	pthread_mutex_lock(&coalesce_mutex);
+	while (coalesce_thread_running) {
+		double interval = indigo_update_coalescing_interval / 1000.0;
+		double now = coalesce_time();
+		double due = 0;
+		coalesce_entry *ready = NULL;
+		for (int i = 0; i < COALESCE_HASH_SIZE; i++) {
+			for (coalesce_entry *entry = coalesce_table[i]; entry; entry = entry->next) {
+				if (entry->pending == NULL)
+					continue;
+				if (entry->last + interval <= now) {
+					coalesce_entry *copy = malloc(sizeof(coalesce_entry));
+					assert(copy != NULL);
+					memcpy(copy, entry, sizeof(coalesce_entry));
+					copy->next = ready;
+					ready = copy;
+					entry->pending = NULL;
+					entry->last = now;
+				} else if (due == 0 || entry->last + interval < due) {
+					due = entry->last + interval;
+				}
+			}
+		}
+		if (ready) {
+			pthread_mutex_unlock(&coalesce_mutex);
+			pthread_mutex_lock(&client_mutex);
+			while (ready) {
+				coalesce_entry *entry = ready;
+				ready = entry->next;
+				bool attached = false;
+				for (int i = 0; i < MAX_CLIENTS && !attached; i++)
+					attached = clients[i] == entry->client;
+				// device detached after pending copy was taken
+				bool device_attached = false;
+				for (int i = 0; i < MAX_DEVICES && !device_attached; i++)
+					device_attached = devices[i] == entry->device;
+				attached = attached && device_attached;
+				// newer update was forwarded (or queued) after pending copy was taken, delivering it now would leave client on stale state
+				pthread_mutex_lock(&coalesce_mutex);
+				coalesce_entry *current = coalesce_find(entry->client, entry->device_name, entry->property_name);
+				bool stale = current == NULL || current->generation != entry->generation;
+				pthread_mutex_unlock(&coalesce_mutex);
+				if (attached && !stale && entry->client->update_property != NULL) {
+					indigo_bus_sequence++;
+					entry->client->last_result = entry->client->update_property(entry->client, entry->device, entry->pending, NULL);
+				}
+				free(entry->pending);
+				free(entry);
+			}
+			pthread_mutex_unlock(&client_mutex);
+			pthread_mutex_lock(&coalesce_mutex);
+		} else if (due == 0) {
+			pthread_cond_wait(&coalesce_cond, &coalesce_mutex);
+		} else {
+			struct timespec end;
+			end.tv_sec = (time_t)due;
+			end.tv_nsec = (long)((due - end.tv_sec) * 1000000000.0);
+			pthread_cond_timedwait(&coalesce_cond, &coalesce_mutex, &end);
+		}
+	}
+	pthread_mutex_unlock(&coalesce_mutex);
+	return NULL;
+}
+
+static bool coalesce_update(indigo_client *client, indigo_device *device, indigo_property *property) {
+	double now = coalesce_time();
+	pthread_mutex_lock(&coalesce_mutex);
+	coalesce_entry *entry = coalesce_find(client, property->device, property->name);
+	if (entry == NULL) {
+		unsigned hash = coalesce_hash(property->device, property->name);
+		entry = malloc(sizeof(coalesce_entry));
+		assert(entry != NULL);
+		memset(entry, 0, sizeof(coalesce_entry));
+		entry->client = client;
+		strncpy(entry->device_name, property->device, INDIGO_NAME_SIZE);
+		strncpy(entry->property_name, property->name, INDIGO_NAME_SIZE);
+		entry->state = -1;
+		entry->next = coalesce_table[hash];
+		coalesce_table[hash] = entry;
+	}
+	bool forward = entry->state != property->state || now >= entry->last + indigo_update_coalescing_interval / 1000.0;
+	entry->generation++;
+	if (forward) {
+		entry->state = property->state;
+		entry->last = now;
+		if (entry->pending) {
+			free(entry->pending);
+			entry->pending = NULL;
+		}
+	} else {
+		long size = sizeof(indigo_property) + property->count * sizeof(indigo_item);
+		entry->pending = realloc(entry->pending, size);
+		assert(entry->pending != NULL);
+		memcpy(entry->pending, property, size);
+		entry->device = device;
+		if (!coalesce_thread_running) {
+			pthread_once(&coalesce_once, coalesce_init);
+			coalesce_thread_running = true;
+			if (pthread_create(&coalesce_thread, NULL, coalesce_flush, NULL) != 0) {
+				coalesce_thread_running = false;
+				forward = true;
+			}
+		}
+		pthread_cond_signal(&coalesce_cond);
+	}
+	pthread_mutex_unlock(&coalesce_mutex);
+	return forward;
+}
+
+static void coalesce_discard(indigo_client *client, indigo_device *device, const char *device_name, const char *property_name) {
+	// entries are selected by client, by device or by device and property name, all entries are discarded if nothing is given
+	pthread_mutex_lock(&coalesce_mutex);
+	for (int i = 0; i < COALESCE_HASH_SIZE; i++) {
+		coalesce_entry **reference = &coalesce_table[i];
+		while (*reference) {
+			coalesce_entry *entry = *reference;
+			bool discard;
+			if (client)
+				discard = entry->client == client;
+			else if (device)
+				discard = entry->device == device;
+			else if (device_name)
+				discard = !strcmp(entry->device_name, device_name) && (*property_name == 0 || !strcmp(entry->property_name, property_name));
+			else
+				discard = true;
+			if (discard) {
+				*reference = entry->next;
+				if (entry->pending)
+					free(entry->pending);
+				free(entry);
+			} else {
+				reference = &entry->next;
+			}
+		}
+	}
+	pthread_mutex_unlock(&coalesce_mutex);
+}
+
+static indigo_blob_entry *blob_entry(indigo_item *item, bool create) {
+	int free_index = -1;
+	for (int j = 0; j < MAX_BLOBS; j++) {
+		indigo_blob_entry *entry = blobs[j];
+		if (entry && entry->item == item)
+			return entry;
+		if (entry == NULL && free_index == -1)
+			free_index = j;
+	}
+	if (!create || free_index == -1)
+		return NULL;
+	indigo_blob_entry *entry = blobs[free_index] = malloc(sizeof(indigo_blob_entry));
+	memset(entry, 0, sizeof(indigo_blob_entry));
+	entry->item = item;
+	return entry;
+}
+
+static indigo_blob_buffer *open_blob_buffer(const char *file_name, long size) {
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+	int handle = open(file_name, O_RDONLY | O_CLOEXEC);
+	if (handle < 0)
+		return NULL;
+	struct stat file_stat;
+	if (fstat(handle, &file_stat) < 0 || file_stat.st_size != size) {
+		close(handle);
+		return NULL;
+	}
+	indigo_blob_buffer *buffer = malloc(sizeof(indigo_blob_buffer));
+	buffer->content = NULL;
+	buffer->size = size;
+	buffer->capacity = 0;
+	buffer->handle = handle;
+	buffer->ref_count = 1;
+	buffer->parent = NULL;
+	return buffer;
+#else
+	return NULL;
+#endif
+}
+
+static void release_blob_buffer(indigo_blob_buffer *buffer);
+
+static void free_blob_buffer(indigo_blob_buffer *buffer) {
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+	if (buffer->handle >= 0)
+		close(buffer->handle);
+#endif
+	if (buffer->parent)
+		release_blob_buffer(buffer->parent);
+	else
+		free(buffer->content);
+	free(buffer);
+}
+
+/** Free spare buffers not reused for SPARE_BLOB_IDLE_TIME seconds (or all of them if all is true), called with blob_mutex locked.
+ */
+static void trim_spare_blob_buffers(bool all) {
+	time_t now = time(NULL);
+	for (int i = 0; i < MAX_SPARE_BLOB_BUFFERS; i++) {
+		indigo_blob_buffer *spare = spare_blob_buffers[i];
+		if (spare && (all || now - spare_blob_released[i] > SPARE_BLOB_IDLE_TIME)) {
+			spare_blob_buffers[i] = NULL;
+			free_blob_buffer(spare);
+		}
+	}
+}
+
+static indigo_blob_buffer *alloc_blob_buffer(long size) {
+	trim_spare_blob_buffers(false);
+	int best = -1;
+	for (int i = 0; i < MAX_SPARE_BLOB_BUFFERS; i++) {
+		indigo_blob_buffer *spare = spare_blob_buffers[i];
+		if (spare && spare->capacity >= size && (best == -1 || spare->capacity < spare_blob_buffers[best]->capacity))
+			best = i;
+	}
+	indigo_blob_buffer *buffer;
+	if (best >= 0) {
+		buffer = spare_blob_buffers[best];
+		spare_blob_buffers[best] = NULL;
+	} else {
+		buffer = malloc(sizeof(indigo_blob_buffer));
+		buffer->capacity = (size / 2880 + 1) * 2880;
+		// page aligned, so drivers can write frames with O_DIRECT
+#if defined(INDIGO_WINDOWS)
+		buffer->content = malloc(buffer->capacity);
+#else
+		if (posix_memalign(&buffer->content, BLOB_BUFFER_ALIGNMENT, buffer->capacity))
+			buffer->content = NULL;
+#endif
+		if (buffer->content == NULL) {
+			free(buffer);
+			return NULL;
+		}
+	}
+	buffer->size = size;
+	buffer->handle = -1;
+	buffer->ref_count = 1;
+	buffer->parent = NULL;
+	return buffer;
+}
+
+static indigo_blob_buffer *share_blob_buffer(indigo_blob_buffer *buffer, void *content, long size) {
+	if (buffer->parent)
+		buffer = buffer->parent;
+	indigo_blob_buffer *slice = malloc(sizeof(indigo_blob_buffer));
+	slice->content = content;
+	slice->size = size;
+	slice->capacity = 0;
+	slice->handle = -1;
+	*slice->format = 0;
+	slice->ref_count = 1;
+	slice->parent = buffer;
+	buffer->ref_count++;
+	return slice;
+}
+
+static void release_blob_buffer(indigo_blob_buffer *buffer) {
+	if (buffer == NULL || --buffer->ref_count > 0)
+		return;
+	trim_spare_blob_buffers(false);
+	if (buffer->content && buffer->parent == NULL) {
+		// keep up to MAX_SPARE_BLOB_BUFFERS largest buffers for reuse, but no more than MAX_SPARE_BLOB_BYTES in total
+		int smallest = -1;
+		long total = 0;
+		for (int i = 0; i < MAX_SPARE_BLOB_BUFFERS; i++) {
+			indigo_blob_buffer *spare = spare_blob_buffers[i];
+			if (spare == NULL) {
+				if (smallest == -1 || spare_blob_buffers[smallest] != NULL)
+					smallest = i;
+				continue;
+			}
+			total += spare->capacity;
+			if (smallest == -1 || (spare_blob_buffers[smallest] != NULL && spare->capacity < spare_blob_buffers[smallest]->capacity))
+				smallest = i;
+		}
+		indigo_blob_buffer *spare = spare_blob_buffers[smallest];
+		if (spare == NULL || spare->capacity < buffer->capacity) {
+			if (total - (spare ? spare->capacity : 0) + buffer->capacity <= MAX_SPARE_BLOB_BYTES) {
+				spare_blob_buffers[smallest] = buffer;
+				spare_blob_released[smallest] = time(NULL);
+				buffer = spare;
+			}
+		}
+		if (buffer == NULL)
+			return;
+	}
+	free_blob_buffer(buffer);
+}
+
 indigo_result indigo_start() {
 	for (int i = 1; i < indigo_main_argc; i++) {
 		if (!strcmp(indigo_main_argv[i], "-v") || !strcmp(indigo_main_argv[i], "--enable-info")) {
@@ -338,6 +698,7 @@ indigo_result indigo_start() {
 			indigo_log_level = INDIGO_LOG_TRACE;
 		}
 	}
+	pthread_once(&coalesce_once, coalesce_init);
 	pthread_mutex_lock(&device_mutex);
 	pthread_mutex_lock(&client_mutex);
 	if (!is_started) {
@@ -408,6 +769,7 @@ indigo_result indigo_detach_device(indigo_device *device) {
 	for (int i = 0; i < MAX_DEVICES; i++) {
 		if (devices[i] == device) {
 			devices[i] = NULL;
+			coalesce_discard(NULL, device, NULL, NULL);
 			pthread_mutex_unlock(&device_mutex);
 			if (device->detach != NULL)
 				device->last_result = device->detach(device);
@@ -426,6 +788,7 @@ indigo_result indigo_detach_client(indigo_client *client) {
 		if (clients[i] == client) {
 			clients[i] = NULL;
 			pthread_mutex_unlock(&client_mutex);
+			coalesce_discard(client, NULL, NULL, NULL);
 			if (client->detach != NULL)
 				client->last_result = client->detach(client);
 			return INDIGO_OK;
@@ -513,6 +876,8 @@ indigo_result indigo_define_property(indigo_device *device, indigo_property *pro
 		pthread_mutex_lock(&client_mutex);
 	if (!property->hidden) {
 		INDIGO_TRACE(indigo_trace_property("INDIGO Bus: property definition", property, true, true));
+		if (indigo_update_coalescing_interval > 0)
+			coalesce_discard(NULL, NULL, property->device, property->name);
 		char message[INDIGO_VALUE_SIZE];
 		if (format != NULL) {
 			va_list args;
@@ -520,6 +885,7 @@ indigo_result indigo_define_property(indigo_device *device, indigo_property *pro
 			vsnprintf(message, INDIGO_VALUE_SIZE, format, args);
 			va_end(args);
 		}
+		indigo_bus_sequence++;
 		for (int i = 0; i < MAX_CLIENTS; i++) {
 			indigo_client *client = clients[i];
 			if (client != NULL && client->define_property != NULL)
@@ -552,27 +918,26 @@ indigo_result indigo_update_property(indigo_device *device, indigo_property *pro
 			pthread_mutex_lock(&blob_mutex);
 			for (int i = 0; i < property->count; i++) {
 				indigo_item *item = property->items + i;
-				indigo_blob_entry *entry = NULL;
-				int free_index = -1;
-				for (int j = 0; j < MAX_BLOBS; j++) {
-					entry = blobs[j];
-					if (entry && entry->item == item) {
-						break;
-					}
-					if (entry == NULL && free_index == -1)
-						free_index = j;
-					entry = NULL;
-				}
-				if (entry == NULL && free_index >= 0) {
-					blobs[free_index] = entry = malloc(sizeof(indigo_blob_entry));
-					memset(entry, 0, sizeof(indigo_blob_entry));
-					entry->item = item;
-					pthread_mutex_init(&entry->mutext, NULL);
-				}
+				indigo_blob_entry *entry = blob_entry(item, true);
 				if (entry) {
-					entry->content = realloc(entry->content, entry->size = item->blob.size);
-					memcpy(entry->content, item->blob.value, entry->size);
-					strcpy(entry->format, item->blob.format);
+					indigo_blob_buffer *buffer = NULL;
+					if (*entry->file_name) {
+						buffer = open_blob_buffer(entry->file_name, item->blob.size);
+						*entry->file_name = 0;
+					}
+					if (buffer == NULL && entry->next_buffer && entry->next_buffer->size == item->blob.size) {
+						// referenced, not copied
+						buffer = entry->next_buffer;
+						entry->next_buffer = NULL;
+					}
+					release_blob_buffer(entry->next_buffer);
+					entry->next_buffer = NULL;
+					if (buffer == NULL && (buffer = alloc_blob_buffer(item->blob.size)) != NULL)
+						memcpy(buffer->content, item->blob.value, buffer->size);
+					if (buffer)
+						strcpy(buffer->format, item->blob.format);
+					release_blob_buffer(entry->buffer);
+					entry->buffer = buffer;
 				} else {
 					pthread_mutex_unlock(&blob_mutex);
 					if (indigo_use_strict_locking)
@@ -582,10 +947,15 @@ indigo_result indigo_update_property(indigo_device *device, indigo_property *pro
 			}
 			pthread_mutex_unlock(&blob_mutex);
 		}
+		bool coalesce = indigo_update_coalescing_interval > 0 && format == NULL && (property->type == INDIGO_NUMBER_VECTOR || property->type == INDIGO_LIGHT_VECTOR);
+		indigo_bus_sequence++;
 		for (int i = 0; i < MAX_CLIENTS; i++) {
 			indigo_client *client = clients[i];
-			if (client != NULL && client->update_property != NULL)
+			if (client != NULL && client->update_property != NULL) {
+				if (coalesce && client->is_remote && !coalesce_update(client, device, property))
+					continue;
 				client->last_result = client->update_property(client, device, property, format != NULL ? message : NULL);
+			}
 		}
 		property->count = count;
 	}
@@ -602,6 +972,8 @@ indigo_result indigo_delete_property(indigo_device *device, indigo_property *pro
 	if (!property->hidden) {
 		char message[INDIGO_VALUE_SIZE];
 		INDIGO_TRACE(indigo_trace_property("INDIGO Bus: property removal", property, false, false));
+		if (indigo_update_coalescing_interval > 0)
+			coalesce_discard(NULL, NULL, *property->device ? property->device : device->name, property->name);
 		if (format != NULL) {
 			va_list args;
 			va_start(args, format);
@@ -657,9 +1029,24 @@ indigo_result indigo_stop() {
 			if (device != NULL && device->detach != NULL)
 				device->last_result = device->detach(device);
 		}
+		pthread_mutex_lock(&blob_mutex);
+		trim_spare_blob_buffers(true);
+		pthread_mutex_unlock(&blob_mutex);
 		pthread_mutex_unlock(&client_mutex);
 		pthread_mutex_unlock(&device_mutex);
+		// flush thread delivers under bus mutex, so it is joined after the mutex is released
+		pthread_mutex_lock(&coalesce_mutex);
+		bool running = coalesce_thread_running;
+		coalesce_thread_running = false;
+		pthread_cond_signal(&coalesce_cond);
+		pthread_mutex_unlock(&coalesce_mutex);
+		if (running)
+			pthread_join(coalesce_thread, NULL);
+		coalesce_discard(NULL, NULL, NULL, NULL);
+		return INDIGO_OK;
 	}
+	pthread_mutex_unlock(&client_mutex);
+	pthread_mutex_unlock(&device_mutex);
 	return INDIGO_OK;
 }
 
@@ -789,12 +1176,8 @@ void indigo_release_property(indigo_property *property) {
 			for (int j = 0; j < MAX_BLOBS; j++) {
 				indigo_blob_entry *entry = blobs[j];
 				if (entry && entry->item == item) {
-					pthread_mutex_lock(&entry->mutext);
-					if (entry->content) {
-						free(entry->content);
-					}
-					pthread_mutex_unlock(&entry->mutext);
-					pthread_mutex_destroy(&entry->mutext);
+					release_blob_buffer(entry->buffer);
+					release_blob_buffer(entry->next_buffer);
 					free(entry);
 					blobs[j] = NULL;
 					break;
@@ -815,6 +1198,126 @@ indigo_blob_entry *indigo_validate_blob(indigo_item *item) {
 	return NULL;
 }
 
+indigo_blob_buffer *indigo_retain_blob(indigo_item *item) {
+	indigo_blob_buffer *buffer = NULL;
+	pthread_mutex_lock(&blob_mutex);
+	indigo_blob_entry *entry = blob_entry(item, false);
+	if (entry && entry->buffer) {
+		buffer = entry->buffer;
+		buffer->ref_count++;
+	}
+	pthread_mutex_unlock(&blob_mutex);
+	return buffer;
+}
+
+void indigo_release_blob_buffer(indigo_blob_buffer *buffer) {
+	pthread_mutex_lock(&blob_mutex);
+	release_blob_buffer(buffer);
+	pthread_mutex_unlock(&blob_mutex);
+}
+
+indigo_blob_buffer *indigo_create_blob_buffer(long size) {
+	pthread_mutex_lock(&blob_mutex);
+	indigo_blob_buffer *buffer = alloc_blob_buffer(size);
+	pthread_mutex_unlock(&blob_mutex);
+	return buffer;
+}
+
+bool indigo_is_blob_buffer_shared(indigo_blob_buffer *buffer) {
+	pthread_mutex_lock(&blob_mutex);
+	bool shared = buffer->ref_count > 1;
+	pthread_mutex_unlock(&blob_mutex);
+	return shared;
+}
+
+indigo_blob_buffer *indigo_share_blob_buffer(indigo_blob_buffer *buffer, void *content, long size) {
+	pthread_mutex_lock(&blob_mutex);
+	indigo_blob_buffer *slice = share_blob_buffer(buffer, content, size);
+	pthread_mutex_unlock(&blob_mutex);
+	return slice;
+}
+
+void indigo_set_blob_buffer(indigo_item *item, indigo_blob_buffer *buffer) {
+	if (!indigo_use_blob_caching)
+		return;
+	pthread_mutex_lock(&blob_mutex);
+	indigo_blob_entry *entry = blob_entry(item, true);
+	if (entry) {
+		// own reference, format is set on update
+		release_blob_buffer(entry->next_buffer);
+		entry->next_buffer = share_blob_buffer(buffer, buffer->content, buffer->size);
+	}
+	pthread_mutex_unlock(&blob_mutex);
+}
+
+void indigo_set_blob_buffer_file(indigo_blob_buffer *buffer, const char *file_name) {
+	if (!indigo_use_blob_caching || buffer->content == NULL)
+		return;
+	pthread_mutex_lock(&blob_mutex);
+	for (int j = 0; j < MAX_BLOBS; j++) {
+		indigo_blob_entry *entry = blobs[j];
+		if (entry == NULL)
+			continue;
+		if (entry->next_buffer && entry->next_buffer->content == buffer->content && entry->next_buffer->size == buffer->size) {
+			// saved before the update
+			strncpy(entry->file_name, file_name, INDIGO_VALUE_SIZE - 1);
+		} else if (entry->buffer && entry->buffer->content == buffer->content && entry->buffer->size == buffer->size) {
+			// transfers in progress keep their reference to memory, new ones are served from the file
+			indigo_blob_buffer *file = open_blob_buffer(file_name, buffer->size);
+			if (file) {
+				strcpy(file->format, entry->buffer->format);
+				release_blob_buffer(entry->buffer);
+				entry->buffer = file;
+			}
+		}
+	}
+	pthread_mutex_unlock(&blob_mutex);
+}
+
+void indigo_set_blob_file(indigo_item *item, const char *file_name) {
+	if (!indigo_use_blob_caching)
+		return;
+	pthread_mutex_lock(&blob_mutex);
+	indigo_blob_entry *entry = blob_entry(item, true);
+	if (entry)
+		strncpy(entry->file_name, file_name, INDIGO_VALUE_SIZE - 1);
+	pthread_mutex_unlock(&blob_mutex);
+}
+
+void indigo_lock_property(indigo_property *property) {
+	pthread_mutex_lock(&property_mutex);
+}
+
+void indigo_unlock_property(indigo_property *property) {
+	pthread_mutex_unlock(&property_mutex);
+}
+
+void indigo_set_property_label(indigo_property *property, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	vsnprintf(property->label, INDIGO_VALUE_SIZE, format, args);
+	va_end(args);
+}
+
+void indigo_set_property_hints(indigo_property *property, const char *hints) {
+	snprintf(property->hints, INDIGO_VALUE_SIZE, "%s", hints ? hints : "");
+}
+
+void indigo_set_item_label(indigo_item *item, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	vsnprintf(item->label, INDIGO_VALUE_SIZE, format, args);
+	va_end(args);
+}
+
+void indigo_set_item_hints(indigo_item *item, const char *hints) {
+	snprintf(item->hints, INDIGO_VALUE_SIZE, "%s", hints ? hints : "");
+}
+
+void indigo_set_number_item_format(indigo_item *item, const char *format) {
+	snprintf(item->number.format, INDIGO_VALUE_SIZE, "%s", format ? format : "");
+}
+
 void indigo_init_text_item(indigo_item *item, const char *name, const char *label, const char *format, ...) {
 	assert(item != NULL);
 	assert(name != NULL);
@@ -885,6 +1388,7 @@ bool indigo_populate_http_blob_item(indigo_item *blob_item) {
 	int http_result = 0;
 	char *image_type;
 	int socket;
+	indigo_reader reader;
 	int res;
 	int count;
 
@@ -898,12 +1402,14 @@ bool indigo_populate_http_blob_item(indigo_item *blob_item) {
 		return false;
 	}
 
+	indigo_init_reader(&reader, socket, 0);
+
 	snprintf(request, BUFFER_SIZE, "GET /%s HTTP/1.1\r\n\r\n", file);
 	res = indigo_write(socket, request, strlen(request));
 	if (res == false)
 		goto clean_return;
 
-	res = indigo_read_line(socket, http_line, BUFFER_SIZE);
+	res = indigo_reader_read_line(&reader, http_line, BUFFER_SIZE);
 	if (res < 0) {
 		res = false;
 		goto clean_return;
@@ -925,7 +1431,7 @@ bool indigo_populate_http_blob_item(indigo_item *blob_item) {
 	INDIGO_DEBUG(indigo_debug("%s(): http_result = %d, response = \"%s\"", __FUNCTION__, http_result, http_response));
 
 	do {
-		res = indigo_read_line(socket, http_line, BUFFER_SIZE);
+		res = indigo_reader_read_line(&reader, http_line, BUFFER_SIZE);
 		if (res < 0) {
 			res = false;
 			goto clean_return;
@@ -941,7 +1447,7 @@ bool indigo_populate_http_blob_item(indigo_item *blob_item) {
 		if (image_type) strncpy(blob_item->blob.format, image_type, INDIGO_NAME_SIZE);
 		blob_item->blob.size = content_len;
 		blob_item->blob.value = realloc(blob_item->blob.value, blob_item->blob.size);
-		res = (indigo_read(socket, blob_item->blob.value, blob_item->blob.size) >= 0) ? true : false;
+		res = (indigo_reader_read(&reader, blob_item->blob.value, blob_item->blob.size) >= 0) ? true : false;
 	} else {
 		res = false;
 	}
@@ -1008,6 +1514,85 @@ bool indigo_get_switch(indigo_property *property, char *item_name) {
 	return false;
 }
 
+/* Unlike strncpy() it doesn't pad the rest of the (mostly empty) buffer with zeros. */
+static void copy_string(char *target, const char *source, size_t size) {
+	size_t length = strnlen(source, size - 1);
+	memcpy(target, source, length);
+	target[length] = 0;
+}
+
+static void copy_item_values(indigo_property_type type, indigo_item *item, indigo_item *other) {
+	switch (type) {
+		case INDIGO_TEXT_VECTOR:
+			copy_string(item->text.value, other->text.value, INDIGO_VALUE_SIZE);
+			break;
+		case INDIGO_NUMBER_VECTOR:
+			copy_string(item->number.format, other->number.format, INDIGO_VALUE_SIZE);
+			item->number.min = other->number.min;
+			item->number.max = other->number.max;
+			item->number.step = other->number.step;
+			item->number.value = other->number.value;
+			item->number.target = other->number.target;
+			break;
+		case INDIGO_SWITCH_VECTOR:
+			item->sw.value = other->sw.value;
+			break;
+		case INDIGO_LIGHT_VECTOR:
+			item->light.value = other->light.value;
+			break;
+		case INDIGO_BLOB_VECTOR:
+			copy_string(item->blob.format, other->blob.format, INDIGO_NAME_SIZE);
+			copy_string(item->blob.url, other->blob.url, INDIGO_VALUE_SIZE);
+			item->blob.size = other->blob.size;
+			item->blob.value = other->blob.value;
+			break;
+	}
+}
+
+void indigo_property_copy_items(indigo_property *property, indigo_property *other) {
+	assert(property != NULL);
+	assert(other != NULL);
+	assert(property->type == other->type);
+	int count = property->count < other->count ? property->count : other->count;
+	for (int i = 0; i < count; i++) {
+		indigo_item *item = property->items + i;
+		indigo_item *other_item = other->items + i;
+		copy_string(item->label, other_item->label, INDIGO_VALUE_SIZE);
+		copy_string(item->hints, other_item->hints, INDIGO_VALUE_SIZE);
+		copy_item_values(property->type, item, other_item);
+	}
+}
+
+indigo_property *indigo_copy_property(indigo_property *property, indigo_property *other) {
+	assert(other != NULL);
+	if (property == NULL) {
+		property = malloc(sizeof(indigo_property) + other->count * sizeof(indigo_item));
+		if (property == NULL) return NULL;
+	}
+	copy_string(property->device, other->device, INDIGO_NAME_SIZE);
+	copy_string(property->name, other->name, INDIGO_NAME_SIZE);
+	copy_string(property->group, other->group, INDIGO_NAME_SIZE);
+	copy_string(property->label, other->label, INDIGO_VALUE_SIZE);
+	copy_string(property->hints, other->hints, INDIGO_VALUE_SIZE);
+	property->state = other->state;
+	property->type = other->type;
+	property->perm = other->perm;
+	property->rule = other->rule;
+	property->access_token = other->access_token;
+	property->version = other->version;
+	property->hidden = other->hidden;
+	property->count = other->count;
+	for (int i = 0; i < other->count; i++) {
+		indigo_item *item = property->items + i;
+		indigo_item *other_item = other->items + i;
+		copy_string(item->name, other_item->name, INDIGO_NAME_SIZE);
+		copy_string(item->label, other_item->label, INDIGO_VALUE_SIZE);
+		copy_string(item->hints, other_item->hints, INDIGO_VALUE_SIZE);
+		copy_item_values(other->type, item, other_item);
+	}
+	return property;
+}
+
 void indigo_property_copy_values(indigo_property *property, indigo_property *other, bool with_state) {
 	assert(property != NULL);
 	assert(other != NULL);
@@ -1023,12 +1608,14 @@ void indigo_property_copy_values(indigo_property *property, indigo_property *oth
 			}
 			for (int i = 0; i < other->count; i++) {
 				indigo_item *other_item = &other->items[i];
-				for (int j = 0; j < property->count; j++) {
+				/* items are usually in the same order, so try the same index first */
+				for (int k = 0; k < property->count; k++) {
+					int j = (i + k) % property->count;
 					indigo_item *property_item = &property->items[j];
 					if (!strcmp(property_item->name, other_item->name)) {
 						switch (property->type) {
 						case INDIGO_TEXT_VECTOR:
-							strncpy(property_item->text.value, other_item->text.value, INDIGO_VALUE_SIZE);
+							copy_string(property_item->text.value, other_item->text.value, INDIGO_VALUE_SIZE);
 							break;
 						case INDIGO_NUMBER_VECTOR:
 							property_item->number.target = property_item->number.value = other_item->number.value;
@@ -1044,8 +1631,8 @@ void indigo_property_copy_values(indigo_property *property, indigo_property *oth
 							property_item->light.value = other_item->light.value;
 							break;
 						case INDIGO_BLOB_VECTOR:
-							strncpy(property_item->blob.format, other_item->blob.format, INDIGO_NAME_SIZE);
-							strncpy(property_item->blob.url, other_item->blob.url, INDIGO_NAME_SIZE);
+							copy_string(property_item->blob.format, other_item->blob.format, INDIGO_NAME_SIZE);
+							copy_string(property_item->blob.url, other_item->blob.url, INDIGO_VALUE_SIZE);
 							property_item->blob.size = other_item->blob.size;
 							property_item->blob.value = other_item->blob.value;
 							break;
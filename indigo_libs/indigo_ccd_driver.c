@@ -23,8 +23,13 @@
  \file indigo_ccd_driver.c
  */
 
+#if defined(INDIGO_LINUX)
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <assert.h>
 #include <string.h>
@@ -36,6 +41,13 @@
 #include <sys/stat.h>
 #include <jpeglib.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CCD_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include <indigo/indigo_ccd_driver.h>
 #include <indigo/indigo_io.h>
 
@@ -64,6 +76,314 @@ void indigo_use_shortest_exposure_if_bias(indigo_device *device) {
 	}
 }
 
+#define CCD_LOCAL_WRITER_QUEUE_LENGTH	4
+#define CCD_LOCAL_WRITER_ALIGNMENT		4096
+#define PREVIEW_MIN_SIZE					64
+
+typedef struct local_writer_job {
+	struct local_writer_job *next;
+	char file_name[INDIGO_VALUE_SIZE];
+	bool preallocate, direct, sync, upload;
+	indigo_blob_buffer *frame;
+	void *data;
+	unsigned long size;
+	char *error;
+} local_writer_job;
+
+static char *write_local_file(const char *file_name, char *data, unsigned long size, bool preallocate, bool direct, bool sync) {
+	// new inode, so the BLOB cache can keep serving previous frame from its handle
+	unlink(file_name);
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	unsigned long direct_size = 0;
+#if defined(INDIGO_LINUX)
+	// O_DIRECT requires aligned buffer and length, the unaligned tail is written through page cache
+	if (direct && ((uintptr_t)data % CCD_LOCAL_WRITER_ALIGNMENT) == 0) {
+		direct_size = size - size % CCD_LOCAL_WRITER_ALIGNMENT;
+		if (direct_size)
+			flags |= O_DIRECT;
+	}
+#endif
+	int handle = open(file_name, flags, 0644);
+	if (handle < 0 && direct_size) {
+		// some filesystems (e.g. tmpfs) doesn't support O_DIRECT
+		direct_size = 0;
+		handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+	if (handle < 0)
+		return strerror(errno);
+#if defined(INDIGO_MACOS)
+	if (direct)
+		fcntl(handle, F_NOCACHE, 1);
+#endif
+	if (preallocate) {
+		// failure is not fatal, not all filesystems support preallocation
+#if defined(INDIGO_LINUX)
+		fallocate(handle, 0, 0, size);
+#elif defined(INDIGO_MACOS)
+		fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0 };
+		if (fcntl(handle, F_PREALLOCATE, &store) == -1) {
+			store.fst_flags = F_ALLOCATEALL;
+			fcntl(handle, F_PREALLOCATE, &store);
+		}
+#endif
+	}
+	bool result = true;
+#if defined(INDIGO_LINUX)
+	if (direct_size) {
+		result = indigo_write(handle, data, direct_size);
+		if (result)
+			fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) & ~O_DIRECT);
+	}
+#endif
+	if (result)
+		result = indigo_write(handle, data + direct_size, size - direct_size);
+	if (result && sync) {
+#if defined(INDIGO_LINUX)
+		result = fdatasync(handle) == 0;
+#else
+		result = fsync(handle) == 0;
+#endif
+	}
+	char *message = result ? NULL : strerror(errno);
+	close(handle);
+	return message;
+}
+
+static void update_local_writer_queue(indigo_device *device, indigo_property_state state) {
+	CCD_LOCAL_WRITER_QUEUE_FRAMES_ITEM->number.value = CCD_CONTEXT->local_writer_frames;
+	CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM->number.value = round(CCD_CONTEXT->local_writer_size / 1048576.0);
+	CCD_LOCAL_WRITER_QUEUE_PROPERTY->state = state;
+}
+
+// background writer is the only one updating CCD_IMAGE_FILE while it is running, capture thread waits for it in synchronous mode
+
+static void *local_writer_thread(indigo_device *device) {
+	INDIGO_DEBUG(indigo_debug("%s: local writer started", device->name));
+	pthread_mutex_lock(&CCD_CONTEXT->local_writer_mutex);
+	while (true) {
+		local_writer_job *job = CCD_CONTEXT->local_writer_queue;
+		if (job == NULL) {
+			if (CCD_CONTEXT->local_writer_exit)
+				break;
+			pthread_cond_wait(&CCD_CONTEXT->local_writer_cond, &CCD_CONTEXT->local_writer_mutex);
+			continue;
+		}
+		pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+		char *message = job->error;
+		if (message == NULL) {
+			INDIGO_DEBUG(clock_t start = clock());
+			message = write_local_file(job->file_name, job->data, job->size, job->preallocate, job->direct, job->sync);
+			INDIGO_DEBUG(indigo_debug("%s: local save of %s in %gs", device->name, job->file_name, (clock() - start) / (double)CLOCKS_PER_SEC));
+		}
+		if (message == NULL) {
+			// BLOB cache can serve the frame from the file and give memory back to the pool
+			if (job->frame)
+				indigo_set_blob_buffer_file(job->frame, job->file_name);
+			else if (job->upload)
+				indigo_set_blob_file(CCD_IMAGE_ITEM, job->file_name);
+		}
+		indigo_release_blob_buffer(job->frame);
+		job->frame = NULL;
+		if (*job->file_name)
+			strncpy(CCD_IMAGE_FILE_ITEM->text.value, job->file_name, INDIGO_VALUE_SIZE);
+		CCD_IMAGE_FILE_PROPERTY->state = message ? INDIGO_ALERT_STATE : INDIGO_OK_STATE;
+		pthread_mutex_lock(&CCD_CONTEXT->local_writer_mutex);
+		CCD_CONTEXT->local_writer_queue = job->next;
+		CCD_CONTEXT->local_writer_frames--;
+		CCD_CONTEXT->local_writer_size -= job->size;
+		job->next = CCD_CONTEXT->local_writer_spare;
+		CCD_CONTEXT->local_writer_spare = job;
+		update_local_writer_queue(device, CCD_CONTEXT->local_writer_frames ? INDIGO_BUSY_STATE : INDIGO_OK_STATE);
+		// wake up capture thread waiting for free slot or for synchronous write before property updates, it may hold bus lock
+		pthread_cond_broadcast(&CCD_CONTEXT->local_writer_cond);
+		pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+		if (IS_CONNECTED) {
+			indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
+			indigo_update_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
+		}
+		pthread_mutex_lock(&CCD_CONTEXT->local_writer_mutex);
+	}
+	pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+	INDIGO_DEBUG(indigo_debug("%s: local writer finished", device->name));
+	return NULL;
+}
+
+static bool queue_local_file(indigo_device *device, const char *file_name, void *data, unsigned long size, indigo_blob_buffer *frame, char *error) {
+	// frame reference is handed to the writer, without it data belong to the caller and it has to wait until they are written
+	bool wait = frame == NULL;
+	pthread_mutex_lock(&CCD_CONTEXT->local_writer_mutex);
+	if (!CCD_CONTEXT->local_writer_running) {
+		CCD_CONTEXT->local_writer_exit = false;
+		if (pthread_create(&CCD_CONTEXT->local_writer_thread, NULL, (void *(*)(void *))local_writer_thread, device)) {
+			pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+			INDIGO_ERROR(indigo_error("%s: failed to start local writer (%s)", device->name, strerror(errno)));
+			return false;
+		}
+		CCD_CONTEXT->local_writer_running = true;
+	}
+	if (CCD_CONTEXT->local_writer_frames >= CCD_LOCAL_WRITER_QUEUE_LENGTH) {
+		// back-pressure, capture has to wait for writer
+		update_local_writer_queue(device, INDIGO_ALERT_STATE);
+		pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+		indigo_update_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, "Local writer is too slow, capture is waiting");
+		pthread_mutex_lock(&CCD_CONTEXT->local_writer_mutex);
+		while (CCD_CONTEXT->local_writer_frames >= CCD_LOCAL_WRITER_QUEUE_LENGTH)
+			pthread_cond_wait(&CCD_CONTEXT->local_writer_cond, &CCD_CONTEXT->local_writer_mutex);
+	}
+	local_writer_job *job = CCD_CONTEXT->local_writer_spare;
+	if (job)
+		CCD_CONTEXT->local_writer_spare = job->next;
+	else
+		job = malloc(sizeof(local_writer_job));
+	strncpy(job->file_name, file_name, INDIGO_VALUE_SIZE);
+	job->preallocate = CCD_LOCAL_WRITER_PREALLOCATE_ITEM->sw.value;
+	job->direct = CCD_LOCAL_WRITER_DIRECT_ITEM->sw.value;
+	job->sync = CCD_LOCAL_WRITER_SYNC_ITEM->sw.value;
+	job->upload = CCD_UPLOAD_MODE_BOTH_ITEM->sw.value;
+	job->frame = frame ? indigo_share_blob_buffer(frame, frame->content, size) : NULL;
+	job->data = frame ? frame->content : data;
+	job->size = size;
+	job->error = error;
+	job->next = NULL;
+	local_writer_job **tail = (local_writer_job **)&CCD_CONTEXT->local_writer_queue;
+	while (*tail)
+		tail = &(*tail)->next;
+	*tail = job;
+	CCD_CONTEXT->local_writer_frames++;
+	CCD_CONTEXT->local_writer_size += size;
+	update_local_writer_queue(device, INDIGO_BUSY_STATE);
+	pthread_cond_broadcast(&CCD_CONTEXT->local_writer_cond);
+	if (wait) {
+		// capture thread is the only producer, so empty queue means the job is done
+		while (CCD_CONTEXT->local_writer_frames > 0)
+			pthread_cond_wait(&CCD_CONTEXT->local_writer_cond, &CCD_CONTEXT->local_writer_mutex);
+		pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+		return true;
+	}
+	pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+	indigo_update_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
+	return true;
+}
+
+static void stop_local_writer(indigo_device *device) {
+	pthread_mutex_lock(&CCD_CONTEXT->local_writer_mutex);
+	bool running = CCD_CONTEXT->local_writer_running;
+	CCD_CONTEXT->local_writer_exit = true;
+	CCD_CONTEXT->local_writer_running = false;
+	pthread_cond_broadcast(&CCD_CONTEXT->local_writer_cond);
+	pthread_mutex_unlock(&CCD_CONTEXT->local_writer_mutex);
+	if (running)
+		pthread_join(CCD_CONTEXT->local_writer_thread, NULL);
+	local_writer_job *job = CCD_CONTEXT->local_writer_spare;
+	while (job) {
+		local_writer_job *next = job->next;
+		free(job);
+		job = next;
+	}
+	CCD_CONTEXT->local_writer_spare = NULL;
+}
+
+static bool local_file_name(indigo_device *device, const char *suffix, char *file_name) {
+	char *dir = CCD_LOCAL_MODE_DIR_ITEM->text.value;
+	char *prefix = CCD_LOCAL_MODE_PREFIX_ITEM->text.value;
+	if (strlen(dir) + strlen(prefix) + strlen(suffix) >= INDIGO_VALUE_SIZE)
+		return false;
+	char *placeholder = strstr(prefix, "XXX");
+	if (placeholder == NULL) {
+		strcpy(file_name, dir);
+		strcat(file_name, prefix);
+		strcat(file_name, suffix);
+	} else {
+		char format[INDIGO_VALUE_SIZE];
+		strcpy(format, dir);
+		strncat(format, prefix, placeholder - prefix);
+		if (!strncmp(placeholder, "XXXX", 4)) {
+			strcat(format, "%04d");
+			strcat(format, placeholder + 4);
+		} else {
+			strcat(format, "%03d");
+			strcat(format, placeholder + 3);
+		}
+		strcat(format, suffix);
+		// continue from last used index, files queued for background writer doesn't exist yet
+		int i = 1;
+		if (!strcmp(format, CCD_CONTEXT->local_file_format))
+			i = CCD_CONTEXT->local_file_index + 1;
+		else
+			strcpy(CCD_CONTEXT->local_file_format, format);
+		struct stat sb;
+		while (i < 10000) {
+			snprintf(file_name, INDIGO_VALUE_SIZE, format, i);
+			if (stat(file_name, &sb) == 0 && S_ISREG(sb.st_mode))
+				i++;
+			else
+				break;
+		}
+		CCD_CONTEXT->local_file_index = i;
+	}
+	return true;
+}
+
+static void save_local_file(indigo_device *device, const char *suffix, void *data, unsigned long size, indigo_blob_buffer *frame) {
+	char file_name[INDIGO_VALUE_SIZE];
+	char *message = NULL;
+	if (local_file_name(device, suffix, file_name)) {
+		if (queue_local_file(device, file_name, data, size, CCD_LOCAL_WRITER_ASYNC_ITEM->sw.value ? frame : NULL, NULL))
+			return;
+		// writer can't be started, so nobody else updates CCD_IMAGE_FILE
+		message = write_local_file(file_name, data, size, CCD_LOCAL_WRITER_PREALLOCATE_ITEM->sw.value, CCD_LOCAL_WRITER_DIRECT_ITEM->sw.value, CCD_LOCAL_WRITER_SYNC_ITEM->sw.value);
+		if (message == NULL && CCD_UPLOAD_MODE_BOTH_ITEM->sw.value)
+			indigo_set_blob_file(CCD_IMAGE_ITEM, file_name);
+	} else {
+		*file_name = 0;
+		message = "dir + prefix + suffix is too long";
+		if (queue_local_file(device, file_name, NULL, 0, NULL, message))
+			return;
+	}
+	if (*file_name)
+		strncpy(CCD_IMAGE_FILE_ITEM->text.value, file_name, INDIGO_VALUE_SIZE);
+	CCD_IMAGE_FILE_PROPERTY->state = message ? INDIGO_ALERT_STATE : INDIGO_OK_STATE;
+	indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
+}
+
+static indigo_blob_buffer *frame_buffer_reference(indigo_device *device, void *data, unsigned long size) {
+	for (int i = 0; i < CCD_FRAME_BUFFER_COUNT; i++) {
+		indigo_blob_buffer *frame = CCD_CONTEXT->frame_buffers[i];
+		if (frame && (char *)data >= (char *)frame->content && (char *)data + size <= (char *)frame->content + frame->capacity)
+			return indigo_share_blob_buffer(frame, data, size);
+	}
+	return NULL;
+}
+
+static void publish_image(indigo_device *device, void *data, unsigned long size, const char *suffix) {
+	// frame from device pool is referenced by local writer and BLOB cache, driver's own buffer is reused for the next frame,
+	// so it is copied once for background writer and the copy is shared with BLOB cache
+	indigo_blob_buffer *frame = frame_buffer_reference(device, data, size);
+	bool upload = CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value;
+	bool save = CCD_UPLOAD_MODE_LOCAL_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value;
+	if (frame == NULL && save && CCD_LOCAL_WRITER_ASYNC_ITEM->sw.value && (frame = indigo_create_blob_buffer(size)) != NULL)
+		memcpy(frame->content, data, size);
+	// set before the frame is queued, so background writer can tell cache about the file even if it is faster than the update
+	if (upload && frame)
+		indigo_set_blob_buffer(CCD_IMAGE_ITEM, frame);
+	if (save) {
+		INDIGO_DEBUG(clock_t start = clock());
+		save_local_file(device, suffix, data, size, frame);
+		INDIGO_DEBUG(indigo_debug("Local save in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+	}
+	if (upload) {
+		INDIGO_DEBUG(clock_t start = clock());
+		*CCD_IMAGE_ITEM->blob.url = 0;
+		CCD_IMAGE_ITEM->blob.value = data;
+		CCD_IMAGE_ITEM->blob.size = size;
+		strncpy(CCD_IMAGE_ITEM->blob.format, suffix, INDIGO_NAME_SIZE);
+		CCD_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
+		indigo_update_property(device, CCD_IMAGE_PROPERTY, NULL);
+		INDIGO_DEBUG(indigo_debug("Client upload in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+	}
+	indigo_release_blob_buffer(frame);
+}
+
 indigo_result indigo_ccd_attach(indigo_device *device, unsigned version) {
 	assert(device != NULL);
 	if (CCD_CONTEXT == NULL) {
@@ -110,6 +430,22 @@ indigo_result indigo_ccd_attach(indigo_device *device, unsigned version) {
 				return INDIGO_FAILED;
 			indigo_init_text_item(CCD_LOCAL_MODE_DIR_ITEM, CCD_LOCAL_MODE_DIR_ITEM_NAME, "Directory", "%s/", getenv("HOME"));
 			indigo_init_text_item(CCD_LOCAL_MODE_PREFIX_ITEM, CCD_LOCAL_MODE_PREFIX_ITEM_NAME, "File name prefix", "IMAGE_XXX");
+			// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER
+			CCD_LOCAL_WRITER_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_LOCAL_WRITER_PROPERTY_NAME, CCD_MAIN_GROUP, "Local writer", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ANY_OF_MANY_RULE, 4);
+			if (CCD_LOCAL_WRITER_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_switch_item(CCD_LOCAL_WRITER_ASYNC_ITEM, CCD_LOCAL_WRITER_ASYNC_ITEM_NAME, "Write in background", true);
+			indigo_init_switch_item(CCD_LOCAL_WRITER_PREALLOCATE_ITEM, CCD_LOCAL_WRITER_PREALLOCATE_ITEM_NAME, "Preallocate file", false);
+			indigo_init_switch_item(CCD_LOCAL_WRITER_DIRECT_ITEM, CCD_LOCAL_WRITER_DIRECT_ITEM_NAME, "Bypass page cache", false);
+			indigo_init_switch_item(CCD_LOCAL_WRITER_SYNC_ITEM, CCD_LOCAL_WRITER_SYNC_ITEM_NAME, "Flush to disk", false);
+			// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER_QUEUE
+			CCD_LOCAL_WRITER_QUEUE_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_LOCAL_WRITER_QUEUE_PROPERTY_NAME, CCD_MAIN_GROUP, "Local writer queue", INDIGO_OK_STATE, INDIGO_RO_PERM, 2);
+			if (CCD_LOCAL_WRITER_QUEUE_PROPERTY == NULL)
+				return INDIGO_FAILED;
+			indigo_init_number_item(CCD_LOCAL_WRITER_QUEUE_FRAMES_ITEM, CCD_LOCAL_WRITER_QUEUE_FRAMES_ITEM_NAME, "Pending frames", 0, CCD_LOCAL_WRITER_QUEUE_LENGTH, 1, 0);
+			indigo_init_number_item(CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM, CCD_LOCAL_WRITER_QUEUE_SIZE_ITEM_NAME, "Pending data (MB)", 0, 0xFFFFFFFF, 0, 0);
+			pthread_mutex_init(&CCD_CONTEXT->local_writer_mutex, NULL);
+			pthread_cond_init(&CCD_CONTEXT->local_writer_cond, NULL);
 			// -------------------------------------------------------------------------------- CCD_MODE
 			CCD_MODE_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_MODE_PROPERTY_NAME, CCD_MAIN_GROUP, "Capture mode", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 64);
 			if (CCD_MODE_PROPERTY == NULL)
@@ -239,7 +575,7 @@ indigo_result indigo_ccd_attach(indigo_device *device, unsigned version) {
 				indigo_init_text_item(CCD_FITS_HEADERS_PROPERTY->items + i, name, label, "");
 			}
 			// -------------------------------------------------------------------------------- CCD_JPEG_SETTINGS
-			CCD_JPEG_SETTINGS_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_JPEG_SETTINGS_PROPERTY_NAME, CCD_IMAGE_GROUP, "JPEG Settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 5);
+			CCD_JPEG_SETTINGS_PROPERTY = indigo_init_number_property(NULL, device->name, CCD_JPEG_SETTINGS_PROPERTY_NAME, CCD_IMAGE_GROUP, "JPEG Settings", INDIGO_OK_STATE, INDIGO_RW_PERM, 6);
 			if (CCD_JPEG_SETTINGS_PROPERTY == NULL)
 				return INDIGO_FAILED;
 			CCD_JPEG_SETTINGS_PROPERTY->hidden = true;
@@ -248,6 +584,7 @@ indigo_result indigo_ccd_attach(indigo_device *device, unsigned version) {
 			indigo_init_number_item(CCD_JPEG_SETTINGS_WHITE_ITEM, CCD_JPEG_SETTINGS_WHITE_ITEM_NAME, "White point", -1, 255, 0, -1);
 			indigo_init_number_item(CCD_JPEG_SETTINGS_BLACK_TRESHOLD_ITEM, CCD_JPEG_SETTINGS_BLACK_TRESHOLD_ITEM_NAME, "Black point treshold", 0, 1, 0, 0.005);
 			indigo_init_number_item(CCD_JPEG_SETTINGS_WHITE_TRESHOLD_ITEM, CCD_JPEG_SETTINGS_WHITE_TRESHOLD_ITEM_NAME, "White point treshold", 0, 1, 0, 0.002);
+			indigo_init_number_item(CCD_JPEG_SETTINGS_PREVIEW_SIZE_ITEM, CCD_JPEG_SETTINGS_PREVIEW_SIZE_ITEM_NAME, "Preview max size (0 = full)", 0, 16384, PREVIEW_MIN_SIZE, 0);
 			// -------------------------------------------------------------------------------- CCD_RBI_FLUSH_ENABLE
 			CCD_RBI_FLUSH_ENABLE_PROPERTY = indigo_init_switch_property(NULL, device->name, CCD_RBI_FLUSH_ENABLE_PROPERTY_NAME, CCD_MAIN_GROUP, "RBI flush", INDIGO_OK_STATE, INDIGO_RW_PERM, INDIGO_ONE_OF_MANY_RULE, 2);
 			if (CCD_RBI_FLUSH_ENABLE_PROPERTY == NULL)
@@ -279,6 +616,10 @@ indigo_result indigo_ccd_enumerate_properties(indigo_device *device, indigo_clie
 			indigo_define_property(device, CCD_LENS_PROPERTY, NULL);
 		if (indigo_property_match(CCD_LOCAL_MODE_PROPERTY, property))
 			indigo_define_property(device, CCD_LOCAL_MODE_PROPERTY, NULL);
+		if (indigo_property_match(CCD_LOCAL_WRITER_PROPERTY, property))
+			indigo_define_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+		if (indigo_property_match(CCD_LOCAL_WRITER_QUEUE_PROPERTY, property))
+			indigo_define_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
 		if (indigo_property_match(CCD_IMAGE_FILE_PROPERTY, property))
 			indigo_define_property(device, CCD_IMAGE_FILE_PROPERTY, NULL);
 		if (indigo_property_match(CCD_MODE_PROPERTY, property))
@@ -343,6 +684,8 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_define_property(device, CCD_UPLOAD_MODE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_PREVIEW_PROPERTY, NULL);
 			indigo_define_property(device, CCD_LOCAL_MODE_PROPERTY, NULL);
+			indigo_define_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+			indigo_define_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_MODE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_READ_MODE_PROPERTY, NULL);
 			indigo_define_property(device, CCD_EXPOSURE_PROPERTY, NULL);
@@ -378,6 +721,8 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_delete_property(device, CCD_UPLOAD_MODE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_PREVIEW_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_LOCAL_MODE_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+			indigo_delete_property(device, CCD_LOCAL_WRITER_QUEUE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_MODE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_READ_MODE_PROPERTY, NULL);
 			indigo_delete_property(device, CCD_EXPOSURE_PROPERTY, NULL);
@@ -409,6 +754,7 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 			indigo_save_property(device, NULL, CCD_READ_MODE_PROPERTY);
 			indigo_save_property(device, NULL, CCD_UPLOAD_MODE_PROPERTY);
 			indigo_save_property(device, NULL, CCD_LOCAL_MODE_PROPERTY);
+			indigo_save_property(device, NULL, CCD_LOCAL_WRITER_PROPERTY);
 			indigo_save_property(device, NULL, CCD_FRAME_PROPERTY);
 			indigo_save_property(device, NULL, CCD_BIN_PROPERTY);
 			indigo_save_property(device, NULL, CCD_OFFSET_PROPERTY);
@@ -661,6 +1007,13 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 		if (IS_CONNECTED)
 			indigo_update_property(device, CCD_LOCAL_MODE_PROPERTY, NULL);
 		return INDIGO_OK;
+	} else if (indigo_property_match(CCD_LOCAL_WRITER_PROPERTY, property)) {
+		// -------------------------------------------------------------------------------- CCD_LOCAL_WRITER
+		indigo_property_copy_values(CCD_LOCAL_WRITER_PROPERTY, property, false);
+		CCD_LOCAL_WRITER_PROPERTY->state = INDIGO_OK_STATE;
+		if (IS_CONNECTED)
+			indigo_update_property(device, CCD_LOCAL_WRITER_PROPERTY, NULL);
+		return INDIGO_OK;
 	} else if (indigo_property_match(CCD_FITS_HEADERS_PROPERTY, property)) {
 		// -------------------------------------------------------------------------------- CCD_FITS_HEADERS
 		indigo_property_copy_values(CCD_FITS_HEADERS_PROPERTY, property, false);
@@ -746,11 +1099,14 @@ indigo_result indigo_ccd_change_property(indigo_device *device, indigo_client *c
 
 indigo_result indigo_ccd_detach(indigo_device *device) {
 	assert(device != NULL);
+	stop_local_writer(device);
 	indigo_release_property(CCD_INFO_PROPERTY);
 	indigo_release_property(CCD_LENS_PROPERTY);
 	indigo_release_property(CCD_UPLOAD_MODE_PROPERTY);
 	indigo_release_property(CCD_PREVIEW_PROPERTY);
 	indigo_release_property(CCD_LOCAL_MODE_PROPERTY);
+	indigo_release_property(CCD_LOCAL_WRITER_PROPERTY);
+	indigo_release_property(CCD_LOCAL_WRITER_QUEUE_PROPERTY);
 	indigo_release_property(CCD_MODE_PROPERTY);
 	indigo_release_property(CCD_READ_MODE_PROPERTY);
 	indigo_release_property(CCD_EXPOSURE_PROPERTY);
@@ -775,6 +1131,14 @@ indigo_result indigo_ccd_detach(indigo_device *device) {
 	indigo_release_property(CCD_RBI_FLUSH_PROPERTY);
 	if (CCD_CONTEXT->preview_image)
 		free(CCD_CONTEXT->preview_image);
+	for (int i = 0; i < CCD_FRAME_BUFFER_COUNT; i++)
+		indigo_release_blob_buffer(CCD_CONTEXT->frame_buffers[i]);
+	if (CCD_CONTEXT->scratch_buffer)
+		free(CCD_CONTEXT->scratch_buffer);
+	if (CCD_CONTEXT->fits_header_template)
+		free(CCD_CONTEXT->fits_header_template);
+	pthread_mutex_destroy(&CCD_CONTEXT->local_writer_mutex);
+	pthread_cond_destroy(&CCD_CONTEXT->local_writer_cond);
 	return indigo_device_detach(device);
 }
 
@@ -817,84 +1181,396 @@ static void set_black_white(indigo_device *device, long *histo, long count) {
 	}
 }
 
-static void raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, void **data_out, unsigned long *size_out) {
-	INDIGO_DEBUG(clock_t start = clock());
-	int size_in = frame_width * frame_height;
-	void *copy = malloc(size_in * bpp / 8);
-	memcpy(copy, data_in + FITS_HEADER_SIZE, size_in * bpp / 8);
-	unsigned char *mem = NULL;
-	unsigned long mem_size = 0;
-	struct jpeg_compress_struct cinfo;
-	struct jpeg_error_mgr jerr;
-	cinfo.err = jpeg_std_error(&jerr);
-	jpeg_create_compress(&cinfo);
-	jpeg_mem_dest(&cinfo, &mem, &mem_size);
-	cinfo.image_width = frame_width;
-	cinfo.image_height = frame_height;
-	long histo[256] = { 0 };
-	if (bpp == 8 || bpp == 24) {
-		unsigned char *b8 = copy;
-		int count = size_in * (bpp == 8 ? 1 : 3);
-		for (int i = 0; i < count; i++) {
-			histo[*b8++]++;
-		}
-		set_black_white(device, histo, count);
-		double scale = (CCD_JPEG_SETTINGS_WHITE_ITEM->number.value - CCD_JPEG_SETTINGS_BLACK_ITEM->number.value) / 255;
-		int offset = CCD_JPEG_SETTINGS_BLACK_ITEM->number.value;
-		b8 = copy;
-		for (int i = 0; i < count; i++) {
-			int value = (*b8 - offset) / scale;
-			if (value < 0)
-				value = 0;
-			else if (value > 255)
-				value = 255;
-			*b8++ = value;
+static void *scratch_buffer(indigo_device *device, unsigned long size) {
+	if (CCD_CONTEXT->scratch_buffer_size < size) {
+		free(CCD_CONTEXT->scratch_buffer);
+		CCD_CONTEXT->scratch_buffer = malloc(CCD_CONTEXT->scratch_buffer_size = size);
+	}
+	return CCD_CONTEXT->scratch_buffer;
+}
+
+void *indigo_ccd_frame_buffer(indigo_device *device, long size) {
+	// pool is ordered by last use, unreferenced buffer large enough is reused, otherwise empty slot, unreferenced small buffer
+	// or the least recently used buffer (left to its other holders) is replaced by a new one
+	indigo_blob_buffer **frames = CCD_CONTEXT->frame_buffers;
+	int index = -1, empty = -1, unused = -1;
+	for (int i = 0; i < CCD_FRAME_BUFFER_COUNT; i++) {
+		if (frames[i] == NULL) {
+			if (empty == -1)
+				empty = i;
+		} else if (!indigo_is_blob_buffer_shared(frames[i])) {
+			if (frames[i]->capacity >= size) {
+				index = i;
+				break;
+			}
+			unused = i;
+		}
+	}
+	if (index == -1) {
+		index = empty != -1 ? empty : unused != -1 ? unused : CCD_FRAME_BUFFER_COUNT - 1;
+		indigo_release_blob_buffer(frames[index]);
+		frames[index] = indigo_create_blob_buffer(size);
+	}
+	indigo_blob_buffer *frame = frames[index];
+	memmove(frames + 1, frames, index * sizeof(indigo_blob_buffer *));
+	frames[0] = frame;
+	return frame ? frame->content : NULL;
+}
+
+#define PREVIEW_MAX_THREADS	8
+#define PREVIEW_TILE_MIN_SIZE	(512 * 512)
+
+typedef struct {
+	const void *data;
+	unsigned char *out;
+	long start, end;
+	int components;
+	bool wide;
+	bool swap;
+	bool bgr;
+	const unsigned char *lut;
+	int offset;
+	int divisor;
+	void *decimated;
+	int width;
+	int factor;
+	long histo[256];
+} preview_tile;
+
+static void *preview_decimate_tile(preview_tile *tile) {
+	// average of factor x factor block for every output pixel and component
+	int factor = tile->factor, components = tile->components;
+	long out_width = tile->width / factor;
+	unsigned long area = factor * factor;
+	for (long row = tile->start; row < tile->end; row++) {
+		for (long column = 0; column < out_width; column++) {
+			for (int c = 0; c < components; c++) {
+				unsigned long sum = 0;
+				for (int y = 0; y < factor; y++) {
+					long index = ((row * factor + y) * tile->width + column * factor) * components + c;
+					if (tile->wide) {
+						const unsigned short *b16 = (const unsigned short *)tile->data + index;
+						for (int x = 0; x < factor; x++, b16 += components)
+							sum += tile->swap ? ((*b16 & 0xff) << 8 | (*b16 & 0xff00) >> 8) : *b16;
+					} else {
+						const unsigned char *b8 = (const unsigned char *)tile->data + index;
+						for (int x = 0; x < factor; x++, b8 += components)
+							sum += *b8;
+					}
+				}
+				long out_index = (row * out_width + column) * components + c;
+				if (tile->wide)
+					((unsigned short *)tile->decimated)[out_index] = sum / area;
+				else
+					((unsigned char *)tile->decimated)[out_index] = sum / area;
+			}
+		}
+	}
+	return NULL;
+}
+
+static void *preview_histogram_tile(preview_tile *tile) {
+	// four interleaved partial histograms to break store-to-load dependency on repeated bins, merged at the end
+	unsigned int partial[4][256] = { 0 };
+	long *histo = tile->histo;
+	long start = tile->start * tile->components, end = tile->end * tile->components, i = start;
+	if (tile->wide) {
+		// histogram of high byte, which is low byte of big endian sample
+		const unsigned short *b16 = tile->data;
+		int shift = tile->swap ? 0 : 8;
+		for (; i + 4 <= end; i += 4) {
+			partial[0][(b16[i] >> shift) & 0xFF]++;
+			partial[1][(b16[i + 1] >> shift) & 0xFF]++;
+			partial[2][(b16[i + 2] >> shift) & 0xFF]++;
+			partial[3][(b16[i + 3] >> shift) & 0xFF]++;
+		}
+		for (; i < end; i++)
+			partial[0][(b16[i] >> shift) & 0xFF]++;
+	} else {
+		const unsigned char *b8 = tile->data;
+		for (; i + 4 <= end; i += 4) {
+			partial[0][b8[i]]++;
+			partial[1][b8[i + 1]]++;
+			partial[2][b8[i + 2]]++;
+			partial[3][b8[i + 3]]++;
+		}
+		for (; i < end; i++)
+			partial[0][b8[i]]++;
+	}
+	for (int j = 0; j < 256; j++)
+		histo[j] = (long)partial[0][j] + partial[1][j] + partial[2][j] + partial[3][j];
+	return NULL;
+}
+
+// 16-bit stretch (sample - offset) / divisor clamped to 0..255 without lookup table, single precision division is exact
+// for integer operands below 2^16, so result is identical to the table; tail and non-integer settings use the table
+
+static long preview_stretch16(const unsigned short *b16, unsigned char *out, long count, bool swap, int offset, int divisor) {
+	long i = 0;
+	if (divisor <= 0)
+		return 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128(), off = _mm_set1_epi32(offset);
+	const __m128 scale = _mm_set1_ps(divisor);
+	for (; i + 16 <= count; i += 16) {
+		__m128i packed[2];
+		for (int k = 0; k < 2; k++) {
+			__m128i v = _mm_loadu_si128((const __m128i *)(b16 + i + 8 * k));
+			if (swap)
+				v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			__m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(v, zero), off);
+			__m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(v, zero), off);
+			lo = _mm_and_si128(lo, _mm_cmpgt_epi32(lo, zero));
+			hi = _mm_and_si128(hi, _mm_cmpgt_epi32(hi, zero));
+			lo = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(lo), scale));
+			hi = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(hi), scale));
+			packed[k] = _mm_packs_epi32(lo, hi);
 		}
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(packed[0], packed[1]));
 	}
-	if (bpp == 16 || bpp == 48) {
-		unsigned short *b16 = copy;
-		int count = size_in * (bpp == 16 ? 1 : 3);
-		if (little_endian) {
-			for (int i = 0; i < count; i++) {
-				histo[*b16++ >> 8]++;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const int32x4_t zero = vdupq_n_s32(0), off = vdupq_n_s32(offset);
+	const float32x4_t scale = vdupq_n_f32(divisor);
+	for (; i + 8 <= count; i += 8) {
+		uint16x8_t v = vld1q_u16(b16 + i);
+		if (swap)
+			v = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+		int32x4_t lo = vmaxq_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), off), zero);
+		int32x4_t hi = vmaxq_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v))), off), zero);
+		lo = vcvtq_s32_f32(vdivq_f32(vcvtq_f32_s32(lo), scale));
+		hi = vcvtq_s32_f32(vdivq_f32(vcvtq_f32_s32(hi), scale));
+		vst1_u8(out + i, vqmovun_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))));
+	}
+#endif
+	return i;
+}
+
+static void *preview_stretch_tile(preview_tile *tile) {
+	const unsigned char *lut = tile->lut;
+	unsigned char *out = tile->out + tile->start * tile->components;
+	if (tile->wide) {
+		const unsigned short *b16 = (const unsigned short *)tile->data + tile->start * tile->components;
+		if (tile->bgr) {
+			for (long i = tile->start; i < tile->end; i++, b16 += 3, out += 3) {
+				out[0] = lut[b16[2]];
+				out[1] = lut[b16[1]];
+				out[2] = lut[b16[0]];
+			}
+		} else {
+			long count = (tile->end - tile->start) * tile->components;
+			for (long i = preview_stretch16(b16, out, count, tile->swap, tile->offset, tile->divisor); i < count; i++)
+				out[i] = lut[b16[i]];
+		}
+	} else {
+		const unsigned char *b8 = (const unsigned char *)tile->data + tile->start * tile->components;
+		if (tile->bgr) {
+			for (long i = tile->start; i < tile->end; i++, b8 += 3, out += 3) {
+				out[0] = lut[b8[2]];
+				out[1] = lut[b8[1]];
+				out[2] = lut[b8[0]];
 			}
 		} else {
-			for (int i = 0; i < count; i++) {
-				int value = *b16;
-				value = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				*b16++ = value;
-				histo[value >> 8]++;
+			long count = (tile->end - tile->start) * tile->components;
+			for (long i = 0; i < count; i++)
+				out[i] = lut[b8[i]];
+		}
+	}
+	return NULL;
+}
+
+// tiles are processed by a pool of worker threads started on first preview and shared by all devices,
+// the calling thread works on its own batch as well and waits until all its tiles are done
+
+typedef struct preview_batch {
+	void *(*worker)(preview_tile *);
+	preview_tile *tiles;
+	int count;
+	int claimed;
+	int done;
+	struct preview_batch *next;
+} preview_batch;
+
+static pthread_once_t preview_pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t preview_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t preview_pool_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t preview_pool_done_cond = PTHREAD_COND_INITIALIZER;
+static preview_batch *preview_pool_batches = NULL;
+
+static preview_tile *claim_preview_tile(preview_batch *batch) {
+	// must be called with preview_pool_mutex locked, fully claimed batch is removed from the queue
+	preview_tile *tile = batch->tiles + batch->claimed++;
+	if (batch->claimed == batch->count) {
+		for (preview_batch **pnt = &preview_pool_batches; *pnt; pnt = &(*pnt)->next) {
+			if (*pnt == batch) {
+				*pnt = batch->next;
+				break;
 			}
 		}
-		set_black_white(device, histo, count);
-		double scale = (CCD_JPEG_SETTINGS_WHITE_ITEM->number.value - CCD_JPEG_SETTINGS_BLACK_ITEM->number.value);
-		int offset = CCD_JPEG_SETTINGS_BLACK_ITEM->number.value;
-		unsigned char *b8 = copy;
-		b16 = copy;
-		for (int i = 0; i < count; i++) {
-			int value = (*b16++ - offset) / scale;
-			if (value < 0)
-				value = 0;
-			else if (value > 255)
-				value = 255;
-			*b8++ = value;
+	}
+	return tile;
+}
+
+static void finish_preview_tile(preview_batch *batch) {
+	// must be called with preview_pool_mutex locked, batch can't be touched after the last tile is done
+	if (++batch->done == batch->count)
+		pthread_cond_broadcast(&preview_pool_done_cond);
+}
+
+static void *preview_pool_worker(void *arg) {
+	pthread_mutex_lock(&preview_pool_mutex);
+	while (true) {
+		preview_batch *batch = preview_pool_batches;
+		if (batch == NULL) {
+			pthread_cond_wait(&preview_pool_work_cond, &preview_pool_mutex);
+			continue;
+		}
+		preview_tile *tile = claim_preview_tile(batch);
+		pthread_mutex_unlock(&preview_pool_mutex);
+		batch->worker(tile);
+		pthread_mutex_lock(&preview_pool_mutex);
+		finish_preview_tile(batch);
+	}
+	return NULL;
+}
+
+static void start_preview_pool(void) {
+	int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (thread_count > PREVIEW_MAX_THREADS)
+		thread_count = PREVIEW_MAX_THREADS;
+	// calling thread is the last worker
+	for (int i = 1; i < thread_count; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, preview_pool_worker, NULL) != 0) {
+			INDIGO_ERROR(indigo_error("Failed to start preview worker thread"));
+			break;
+		}
+		pthread_detach(thread);
+	}
+}
+
+static void run_preview_tiles(void *(*worker)(preview_tile *), preview_tile *tiles, int count) {
+	if (count == 1) {
+		worker(tiles);
+		return;
+	}
+	pthread_once(&preview_pool_once, start_preview_pool);
+	preview_batch batch = { worker, tiles, count, 0, 0, NULL };
+	pthread_mutex_lock(&preview_pool_mutex);
+	preview_batch **pnt = &preview_pool_batches;
+	while (*pnt)
+		pnt = &(*pnt)->next;
+	*pnt = &batch;
+	pthread_cond_broadcast(&preview_pool_work_cond);
+	while (batch.claimed < batch.count) {
+		preview_tile *tile = claim_preview_tile(&batch);
+		pthread_mutex_unlock(&preview_pool_mutex);
+		worker(tile);
+		pthread_mutex_lock(&preview_pool_mutex);
+		finish_preview_tile(&batch);
+	}
+	while (batch.done < batch.count)
+		pthread_cond_wait(&preview_pool_done_cond, &preview_pool_mutex);
+	pthread_mutex_unlock(&preview_pool_mutex);
+}
+
+static void raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, int max_size, void **data_out, unsigned long *size_out) {
+	INDIGO_DEBUG(clock_t start = clock());
+	int components = (bpp == 24 || bpp == 48) ? 3 : 1;
+	bool wide = bpp == 16 || bpp == 48;
+	int factor = 1;
+	// 0 means full size, smaller values would shrink the preview to nothing and libjpeg fails on an empty image
+	if (max_size > 0 && max_size < PREVIEW_MIN_SIZE)
+		max_size = PREVIEW_MIN_SIZE;
+	while (max_size > 0 && (frame_width / factor > max_size || frame_height / factor > max_size) && frame_width / (factor * 2) >= 1 && frame_height / (factor * 2) >= 1)
+		factor *= 2;
+	int width = frame_width / factor;
+	int height = frame_height / factor;
+	long size_in = (long)width * height;
+	// histogram and stretch run in tiles across threads and write 8-bit output directly, raw data are left untouched
+	// decimated samples follow 8-bit output, offset is rounded up to keep them aligned for odd sizes
+	long decimated_offset = (size_in * components + 65536 + 15) & ~15L;
+	unsigned char *copy = scratch_buffer(device, decimated_offset + (factor > 1 ? size_in * components * (wide ? 2 : 1) : 0));
+	const void *samples = (unsigned char *)data_in + FITS_HEADER_SIZE;
+	int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (thread_count > PREVIEW_MAX_THREADS)
+		thread_count = PREVIEW_MAX_THREADS;
+	if (thread_count > (long)frame_width * frame_height / PREVIEW_TILE_MIN_SIZE)
+		thread_count = (int)((long)frame_width * frame_height / PREVIEW_TILE_MIN_SIZE);
+	if (thread_count < 1)
+		thread_count = 1;
+	preview_tile tiles[PREVIEW_MAX_THREADS];
+	if (factor > 1) {
+		// binning average decimation to preview size, decimated samples are in native byte order
+		void *decimated = copy + decimated_offset;
+		for (int i = 0; i < thread_count; i++) {
+			tiles[i].data = samples;
+			tiles[i].decimated = decimated;
+			tiles[i].start = (long)height * i / thread_count;
+			tiles[i].end = (long)height * (i + 1) / thread_count;
+			tiles[i].components = components;
+			tiles[i].wide = wide;
+			tiles[i].swap = wide && !little_endian;
+			tiles[i].width = frame_width;
+			tiles[i].factor = factor;
 		}
+		run_preview_tiles(preview_decimate_tile, tiles, thread_count);
+		samples = decimated;
+		little_endian = true;
+	}
+	for (int i = 0; i < thread_count; i++) {
+		tiles[i].data = samples;
+		tiles[i].out = copy;
+		tiles[i].start = size_in * i / thread_count;
+		tiles[i].end = size_in * (i + 1) / thread_count;
+		tiles[i].components = components;
+		tiles[i].wide = wide;
+		tiles[i].swap = wide && !little_endian;
+		tiles[i].bgr = components == 3 && !byte_order_rgb;
+	}
+	run_preview_tiles(preview_histogram_tile, tiles, thread_count);
+	long histo[256] = { 0 };
+	for (int i = 0; i < thread_count; i++)
+		for (int j = 0; j < 256; j++)
+			histo[j] += tiles[i].histo[j];
+	long count = size_in * components;
+	set_black_white(device, histo, count);
+	// stretch is precomputed for every possible sample value
+	double scale = CCD_JPEG_SETTINGS_WHITE_ITEM->number.value - CCD_JPEG_SETTINGS_BLACK_ITEM->number.value;
+	if (!wide)
+		scale /= 255;
+	if (scale <= 0)
+		scale = 1;
+	int offset = CCD_JPEG_SETTINGS_BLACK_ITEM->number.value;
+	unsigned char *lut = copy + size_in * components;
+	int lut_size = wide ? 65536 : 256;
+	for (int i = 0; i < lut_size; i++) {
+		int sample = (wide && !little_endian) ? ((i & 0xff) << 8 | (i & 0xff00) >> 8) : i;
+		int value = (sample - offset) / scale;
+		lut[i] = value < 0 ? 0 : value > 255 ? 255 : value;
+	}
+	// 16-bit samples with integer black and white points are stretched by vector division where available
+	int divisor = wide && offset == CCD_JPEG_SETTINGS_BLACK_ITEM->number.value && scale == (int)scale ? (int)scale : 0;
+	for (int i = 0; i < thread_count; i++) {
+		tiles[i].lut = lut;
+		tiles[i].offset = offset;
+		tiles[i].divisor = divisor;
 	}
+	run_preview_tiles(preview_stretch_tile, tiles, thread_count);
+	// compressed into preview image buffer, CCD_PREVIEW_IMAGE item keeps pointing to previous preview until it is replaced
+	unsigned char *mem = CCD_CONTEXT->preview_image;
+	unsigned long mem_size = CCD_CONTEXT->preview_image_size;
+	struct jpeg_compress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &mem, &mem_size);
+	cinfo.image_width = width;
+	cinfo.image_height = height;
 	if (bpp == 8 || bpp == 16) {
 		cinfo.input_components = 1;
 		cinfo.in_color_space = JCS_GRAYSCALE;
 	}
 	if (bpp == 24 || bpp == 48) {
-		if (!byte_order_rgb) {
-			unsigned char *b8 = copy;
-			for (int i = 0; i < size_in; i++) {
-				unsigned char b = *b8;
-				unsigned char r = *(b8 + 2);
-				*b8 = r;
-				*(b8 + 2) = b;
-				b8 += 3;
-			}
-		}
 		cinfo.input_components = 3;
 		cinfo.in_color_space = JCS_RGB;
 	}
@@ -908,64 +1584,214 @@ static void raw_to_jpeg(indigo_device *device, void *data_in, int frame_width, i
 	}
 	jpeg_finish_compress(&cinfo);
 	jpeg_destroy_compress(&cinfo);
+	if (mem != CCD_CONTEXT->preview_image) {
+		// libjpeg had to grow the buffer, keep the new one for next frames and don't leave preview item pointing to the old one
+		if (CCD_PREVIEW_IMAGE_ITEM->blob.value == CCD_CONTEXT->preview_image) {
+			CCD_PREVIEW_IMAGE_ITEM->blob.value = NULL;
+			CCD_PREVIEW_IMAGE_ITEM->blob.size = 0;
+		}
+		free(CCD_CONTEXT->preview_image);
+		CCD_CONTEXT->preview_image = mem;
+		CCD_CONTEXT->preview_image_size = mem_size;
+	}
 	*data_out = mem;
 	*size_out = mem_size;
-	free(copy);
-	INDIGO_DEBUG(indigo_debug("RAW to preview conversion in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+	INDIGO_DEBUG(indigo_debug("RAW to preview conversion (%dx%d) in %gs", width, height, (clock() - start) / (double)CLOCKS_PER_SEC));
 }
 
-void indigo_process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords) {
-	assert(device != NULL);
-	assert(data != NULL);
-	INDIGO_DEBUG(clock_t start = clock());
+// FITS 16-bit data are big endian signed with BZERO 32768, i.e. flip sign bit and swap bytes for little endian input and flip sign bit in place for big endian input
 
-	int horizontal_bin = CCD_BIN_HORIZONTAL_ITEM->number.value;
-	int vertical_bin = CCD_BIN_VERTICAL_ITEM->number.value;
-	int byte_per_pixel = bpp / 8;
-	int naxis = 2;
-	unsigned long size = frame_width * frame_height;
-	unsigned long blobsize = byte_per_pixel * size;
-	if (byte_per_pixel == 3) {
-		byte_per_pixel = 1;
-		naxis = 3;
-	} else if (byte_per_pixel == 6) {
-		byte_per_pixel = 2;
-		naxis = 3;
+static void fits_bzero_swap16(unsigned short *data, long count, bool little_endian) {
+	long i = 0;
+#if defined(__SSE2__)
+	if (little_endian) {
+		const __m128i sign = _mm_set1_epi16((short)0x8000);
+		for (; i + 8 <= count; i += 8) {
+			__m128i v = _mm_xor_si128(_mm_loadu_si128((__m128i *)(data + i)), sign);
+			_mm_storeu_si128((__m128i *)(data + i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+		}
+	} else {
+		const __m128i sign = _mm_set1_epi16(0x0080);
+		for (; i + 8 <= count; i += 8)
+			_mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(_mm_loadu_si128((__m128i *)(data + i)), sign));
 	}
+#elif defined(__ARM_NEON)
+	if (little_endian) {
+		const uint16x8_t sign = vdupq_n_u16(0x8000);
+		for (; i + 8 <= count; i += 8)
+			vst1q_u16(data + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(veorq_u16(vld1q_u16(data + i), sign)))));
+	} else {
+		const uint16x8_t sign = vdupq_n_u16(0x0080);
+		for (; i + 8 <= count; i += 8)
+			vst1q_u16(data + i, veorq_u16(vld1q_u16(data + i), sign));
+	}
+#endif
+	if (little_endian) {
+		for (; i < count; i++) {
+			unsigned short value = data[i] ^ 0x8000;
+			data[i] = value << 8 | value >> 8;
+		}
+	} else {
+		for (; i < count; i++)
+			data[i] ^= 0x0080;
+	}
+}
 
-	void *jpeg_data = NULL;
-	unsigned long jpeg_size = 0;
-	if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value || CCD_PREVIEW_ENABLED_ITEM->sw.value) {
-		raw_to_jpeg(device, data, frame_width, frame_height, bpp, little_endian, byte_order_rgb, &jpeg_data, &jpeg_size);
-		if (CCD_PREVIEW_ENABLED_ITEM->sw.value) {
-			if (jpeg_data) {
-				if (CCD_CONTEXT->preview_image) {
-					if (CCD_CONTEXT->preview_image_size < jpeg_size) {
-						CCD_CONTEXT->preview_image = realloc(CCD_CONTEXT->preview_image, CCD_CONTEXT->preview_image_size = jpeg_size);
-					}
-				} else {
-					CCD_CONTEXT->preview_image = malloc(CCD_CONTEXT->preview_image_size = jpeg_size);
-				}
-				memcpy(CCD_CONTEXT->preview_image, jpeg_data, jpeg_size);
-				CCD_PREVIEW_IMAGE_ITEM->blob.value = CCD_CONTEXT->preview_image;
-				CCD_PREVIEW_IMAGE_ITEM->blob.size = jpeg_size;
-				strcpy(CCD_PREVIEW_IMAGE_ITEM->blob.format, ".jpeg");
-				CCD_PREVIEW_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
-				indigo_update_property(device, CCD_PREVIEW_IMAGE_PROPERTY, NULL);
+// RGB to planar conversion is done in place in two steps, every row is split to its R, G and B segments in cache first,
+// then segments are moved to their planes by cycle following of (height x 3) to (3 x height) transposition
+
+#if defined(CCD_X86)
+
+// shuffle masks picking channel c from input vector v of 48 byte group to mask[3 * c + v], for 8 and 16-bit samples
+
+static const signed char fits_split_mask8[9][16] __attribute__((aligned(16))) = {
+	{ 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13 },
+	{ 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14 },
+	{ 2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15 }
+};
+
+static const signed char fits_split_mask16[9][16] __attribute__((aligned(16))) = {
+	{ 0, 1, 6, 7, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, 2, 3, 8, 9, 14, 15, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 5, 10, 11 },
+	{ 2, 3, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, 4, 5, 10, 11, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 6, 7, 12, 13 },
+	{ 4, 5, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, 0, 1, 6, 7, 12, 13, -1, -1, -1, -1, -1, -1 }, { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 8, 9, 14, 15 }
+};
+
+__attribute__((target("ssse3")))
+static long fits_split_ssse3(unsigned char **planes, const unsigned char *in, long bytes, const signed char mask[9][16]) {
+	long done = 0;
+	__m128i m[9];
+	for (int i = 0; i < 9; i++)
+		m[i] = _mm_load_si128((const __m128i *)mask[i]);
+	for (; done + 48 <= bytes; done += 48) {
+		__m128i v0 = _mm_loadu_si128((const __m128i *)(in + done));
+		__m128i v1 = _mm_loadu_si128((const __m128i *)(in + done + 16));
+		__m128i v2 = _mm_loadu_si128((const __m128i *)(in + done + 32));
+		for (int c = 0; c < 3; c++)
+			_mm_storeu_si128((__m128i *)(planes[c] + done / 3), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, m[3 * c]), _mm_shuffle_epi8(v1, m[3 * c + 1])), _mm_shuffle_epi8(v2, m[3 * c + 2])));
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static long fits_split_avx2(unsigned char **planes, const unsigned char *in, long bytes, const signed char mask[9][16]) {
+	long done = 0;
+	__m256i m[9];
+	for (int i = 0; i < 9; i++)
+		m[i] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)mask[i]));
+	// two 48 byte groups side by side in 128-bit lanes
+	for (; done + 96 <= bytes; done += 96) {
+		__m256i v0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + done))), _mm_loadu_si128((const __m128i *)(in + done + 48)), 1);
+		__m256i v1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + done + 16))), _mm_loadu_si128((const __m128i *)(in + done + 64)), 1);
+		__m256i v2 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + done + 32))), _mm_loadu_si128((const __m128i *)(in + done + 80)), 1);
+		for (int c = 0; c < 3; c++)
+			_mm256_storeu_si256((__m256i *)(planes[c] + done / 3), _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, m[3 * c]), _mm256_shuffle_epi8(v1, m[3 * c + 1])), _mm256_shuffle_epi8(v2, m[3 * c + 2])));
+	}
+	return done;
+}
+
+static int fits_simd_level(void) {
+	static int level = -1;
+	if (level < 0) {
+		__builtin_cpu_init();
+		level = __builtin_cpu_supports("avx2") ? 2 : __builtin_cpu_supports("ssse3") ? 1 : 0;
+	}
+	return level;
+}
+
+#endif
+
+// split interleaved row of width pixels to R, G and B segments (in this order)
+
+static void fits_split_row(unsigned char *out, const unsigned char *in, long width, int byte_per_pixel, bool byte_order_rgb) {
+	unsigned char *planes[3];
+	long segment = width * byte_per_pixel;
+	planes[0] = out + (byte_order_rgb ? 0 : 2 * segment);
+	planes[1] = out + segment;
+	planes[2] = out + (byte_order_rgb ? 2 * segment : 0);
+	long i = 0;
+#if defined(CCD_X86)
+	const signed char (*mask)[16] = byte_per_pixel == 1 ? fits_split_mask8 : fits_split_mask16;
+	long done = 0;
+	switch (fits_simd_level()) {
+		case 2:
+			done = fits_split_avx2(planes, in, 3 * segment, mask);
+			/* fall through */
+		case 1:
+			if (done < 3 * segment) {
+				unsigned char *rest[3] = { planes[0] + done / 3, planes[1] + done / 3, planes[2] + done / 3 };
+				done += fits_split_ssse3(rest, in + done, 3 * segment - done, mask);
 			}
+	}
+	i = done / 3 / byte_per_pixel;
+#elif defined(__ARM_NEON)
+	if (byte_per_pixel == 1) {
+		for (; i + 16 <= width; i += 16) {
+			uint8x16x3_t v = vld3q_u8(in + 3 * i);
+			vst1q_u8(planes[0] + i, v.val[0]);
+			vst1q_u8(planes[1] + i, v.val[1]);
+			vst1q_u8(planes[2] + i, v.val[2]);
+		}
+	} else {
+		for (; i + 8 <= width; i += 8) {
+			uint16x8x3_t v = vld3q_u16((const unsigned short *)in + 3 * i);
+			vst1q_u16((unsigned short *)planes[0] + i, v.val[0]);
+			vst1q_u16((unsigned short *)planes[1] + i, v.val[1]);
+			vst1q_u16((unsigned short *)planes[2] + i, v.val[2]);
+		}
+	}
+#endif
+	if (byte_per_pixel == 1) {
+		for (; i < width; i++) {
+			planes[0][i] = in[3 * i];
+			planes[1][i] = in[3 * i + 1];
+			planes[2][i] = in[3 * i + 2];
+		}
+	} else {
+		const unsigned short *in16 = (const unsigned short *)in;
+		for (; i < width; i++) {
+			((unsigned short *)planes[0])[i] = in16[3 * i];
+			((unsigned short *)planes[1])[i] = in16[3 * i + 1];
+			((unsigned short *)planes[2])[i] = in16[3 * i + 2];
 		}
 	}
+}
 
-	if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
-		INDIGO_DEBUG(clock_t start = clock());
-		time_t timer;
-		struct tm* tm_info;
-		char date_time_end[20];
-		time(&timer);
-		timer -= CCD_EXPOSURE_ITEM->number.target;
-		tm_info = gmtime(&timer);
-		strftime(date_time_end, 20, "%Y-%m-%dT%H:%M:%S", tm_info);
-		char *header = data;
+static void fits_planar(indigo_device *device, unsigned char *data, long width, long height, int byte_per_pixel, bool byte_order_rgb, bool little_endian) {
+	long segment = width * byte_per_pixel, units = 3 * height;
+	unsigned char *row = scratch_buffer(device, 4 * segment + (units + 7) / 8);
+	unsigned char *temp = row + 3 * segment;
+	unsigned char *visited = temp + segment;
+	for (long y = 0; y < height; y++) {
+		fits_split_row(row, data + 3 * y * segment, width, byte_per_pixel, byte_order_rgb);
+		if (byte_per_pixel == 2 && little_endian)
+			fits_bzero_swap16((unsigned short *)row, 3 * width, true);
+		memcpy(data + 3 * y * segment, row, 3 * segment);
+	}
+	// segment of row y and channel c moves from 3 * y + c to c * height + y, first and last stay
+	memset(visited, 0, (units + 7) / 8);
+	for (long start = 1; start < units - 1; start++) {
+		if (visited[start >> 3] & (1 << (start & 7)))
+			continue;
+		memcpy(temp, data + start * segment, segment);
+		long target = start;
+		while (true) {
+			visited[target >> 3] |= 1 << (target & 7);
+			long source = 3 * (target % height) + target / height;
+			if (source == start)
+				break;
+			memcpy(data + target * segment, data + source * segment, segment);
+			target = source;
+		}
+		memcpy(data + target * segment, temp, segment);
+	}
+}
+
+static int fits_header_template(indigo_device *device, char *data, int byte_per_pixel, int naxis, int frame_width, int frame_height) {
+	// geometry dependent part of FITS header is generated only if geometry or format changes
+	if (CCD_CONTEXT->fits_header_template == NULL || CCD_CONTEXT->fits_header_bpp != byte_per_pixel || CCD_CONTEXT->fits_header_naxis != naxis || CCD_CONTEXT->fits_header_width != frame_width || CCD_CONTEXT->fits_header_height != frame_height) {
+		if (CCD_CONTEXT->fits_header_template == NULL)
+			CCD_CONTEXT->fits_header_template = malloc(FITS_HEADER_SIZE);
+		char *header = CCD_CONTEXT->fits_header_template;
 		memset(header, ' ', FITS_HEADER_SIZE);
 		int t = sprintf(header, "SIMPLE  =                    T / file conforms to FITS standard");
 		header[t] = ' ';
@@ -1000,6 +1826,63 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 		//	t = sprintf(header += 80, "BSCALE  =                  256 / default scaling factor");
 		//	header[t] = ' ';
 		}
+		CCD_CONTEXT->fits_header_bpp = byte_per_pixel;
+		CCD_CONTEXT->fits_header_naxis = naxis;
+		CCD_CONTEXT->fits_header_width = frame_width;
+		CCD_CONTEXT->fits_header_height = frame_height;
+		CCD_CONTEXT->fits_header_template_size = (int)(header - CCD_CONTEXT->fits_header_template) + 80;
+	}
+	memcpy(data, CCD_CONTEXT->fits_header_template, CCD_CONTEXT->fits_header_template_size);
+	memset(data + CCD_CONTEXT->fits_header_template_size, ' ', FITS_HEADER_SIZE - CCD_CONTEXT->fits_header_template_size);
+	return CCD_CONTEXT->fits_header_template_size;
+}
+
+void indigo_process_image(indigo_device *device, void *data, int frame_width, int frame_height, int bpp, bool little_endian, bool byte_order_rgb, indigo_fits_keyword *keywords) {
+	assert(device != NULL);
+	assert(data != NULL);
+
+	int horizontal_bin = CCD_BIN_HORIZONTAL_ITEM->number.value;
+	int vertical_bin = CCD_BIN_VERTICAL_ITEM->number.value;
+	int byte_per_pixel = bpp / 8;
+	int naxis = 2;
+	unsigned long size = frame_width * frame_height;
+	unsigned long blobsize = byte_per_pixel * size;
+	if (byte_per_pixel == 3) {
+		byte_per_pixel = 1;
+		naxis = 3;
+	} else if (byte_per_pixel == 6) {
+		byte_per_pixel = 2;
+		naxis = 3;
+	}
+
+	void *jpeg_data = NULL;
+	unsigned long jpeg_size = 0;
+	if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value || CCD_PREVIEW_ENABLED_ITEM->sw.value) {
+		// JPEG image format needs full resolution, preview only can be downscaled
+		int max_size = CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value ? 0 : CCD_JPEG_SETTINGS_PREVIEW_SIZE_ITEM->number.value;
+		raw_to_jpeg(device, data, frame_width, frame_height, bpp, little_endian, byte_order_rgb, max_size, &jpeg_data, &jpeg_size);
+		if (CCD_PREVIEW_ENABLED_ITEM->sw.value) {
+			if (jpeg_data) {
+				CCD_PREVIEW_IMAGE_ITEM->blob.value = jpeg_data;
+				CCD_PREVIEW_IMAGE_ITEM->blob.size = jpeg_size;
+				strcpy(CCD_PREVIEW_IMAGE_ITEM->blob.format, ".jpeg");
+				CCD_PREVIEW_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
+				indigo_update_property(device, CCD_PREVIEW_IMAGE_PROPERTY, NULL);
+			}
+		}
+	}
+
+	if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
+		INDIGO_DEBUG(clock_t start = clock());
+		time_t timer;
+		struct tm* tm_info;
+		char date_time_end[20];
+		time(&timer);
+		timer -= CCD_EXPOSURE_ITEM->number.target;
+		tm_info = gmtime(&timer);
+		strftime(date_time_end, 20, "%Y-%m-%dT%H:%M:%S", tm_info);
+		char *header = data + fits_header_template(device, data, byte_per_pixel, naxis, frame_width, frame_height) - 80;
+		int t;
 		t = sprintf(header += 80, "XBINNING= %20d / horizontal binning [pixels]", horizontal_bin);
 		header[t] = ' ';
 		t = sprintf(header += 80, "YBINNING= %20d / vertical binning [pixels]", vertical_bin);
@@ -1078,83 +1961,9 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 		t = sprintf(header += 80, "END");
 		header[t] = ' ';
 		if (byte_per_pixel == 2 && naxis == 2) {
-			short *raw = (short *)(data + FITS_HEADER_SIZE);
-			if (little_endian) {
-				for (int i = 0; i < size; i++) {
-					int value = *raw - 32768;
-					*raw++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				}
-			} else {
-				for (int i = 0; i < size; i++) {
-					int value = *raw;
-					value = ((value & 0xff) << 8 | (value & 0xff00) >> 8) - 32768;
-					*raw++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-				}
-			}
-		} else if (byte_per_pixel == 1 && naxis == 3) {
-			unsigned char *raw = malloc(3 * size);
-			unsigned char *red = raw;
-			unsigned char *green = raw + size;
-			unsigned char *blue = raw + 2 * size;
-			unsigned char *tmp = data + FITS_HEADER_SIZE;
-			if (byte_order_rgb) {
-				for (int i = 0; i < size; i++) {
-					*red++ = *tmp++;
-					*green++ = *tmp++;
-					*blue++ = *tmp++;
-				}
-			} else {
-				for (int i = 0; i < size; i++) {
-					*blue++ = *tmp++;
-					*green++ = *tmp++;
-					*red++ = *tmp++;
-				}
-			}
-			memcpy(data + FITS_HEADER_SIZE, raw, 3 * size);
-			free(raw);
-		} else if (byte_per_pixel == 2 && naxis == 3) {
-			unsigned short *raw = malloc(6 * size);
-			unsigned short *red = raw;
-			unsigned short *green = raw + size;
-			unsigned short *blue = raw + 2 * size;
-			unsigned short *tmp = (unsigned short *)(data + FITS_HEADER_SIZE);
-			if (little_endian) {
-				if (byte_order_rgb) {
-					for (int i = 0; i < size; i++) {
-						int value = *tmp++ - 32768;
-						*red++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-						value = *tmp++ - 32768;
-						*green++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-						value = *tmp++ - 32768;
-						*blue++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-					}
-				} else {
-					for (int i = 0; i < size; i++) {
-						int value = *tmp++ - 32768;
-						*blue++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-						value = *tmp++ - 32768;
-						*green++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-						value = *tmp++ - 32768;
-						*red++ = (value & 0xff) << 8 | (value & 0xff00) >> 8;
-					}
-				}
-			} else {
-				if (byte_order_rgb) {
-					for (int i = 0; i < size; i++) {
-						*red++ = *tmp++;
-						*green++ = *tmp++;
-						*blue++ = *tmp++;
-					}
-				} else {
-					for (int i = 0; i < size; i++) {
-						*blue++ = *tmp++;
-						*green++ = *tmp++;
-						*red++ = *tmp++;
-					}
-				}
-			}
-			memcpy(data + FITS_HEADER_SIZE, raw, 6 * size);
-			free(raw);
+			fits_bzero_swap16((unsigned short *)(data + FITS_HEADER_SIZE), size, little_endian);
+		} else if (naxis == 3) {
+			fits_planar(device, (unsigned char *)(data + FITS_HEADER_SIZE), frame_width, frame_height, byte_per_pixel, byte_order_rgb, little_endian);
 		}
 		int mod2880 = blobsize % 2880;
 		if (mod2880) {
@@ -1397,190 +2206,37 @@ void indigo_process_image(indigo_device *device, void *data, int frame_width, in
 			blobsize = jpeg_size;
 		}
 	}
-	if (CCD_UPLOAD_MODE_LOCAL_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-		char *dir = CCD_LOCAL_MODE_DIR_ITEM->text.value;
-		char *prefix = CCD_LOCAL_MODE_PREFIX_ITEM->text.value;
-		char *suffix = "";
-		if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
-			suffix = ".fits";
-		} else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value) {
-			suffix = ".xisf";
-		} else if (CCD_IMAGE_FORMAT_RAW_ITEM->sw.value) {
-			suffix = ".raw";
-		} else if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value) {
-			suffix = ".jpeg";
-		}
-		int handle = 0;
-		char *message = NULL;
-		if (strlen(dir) + strlen(prefix) + strlen(suffix) < INDIGO_VALUE_SIZE) {
-			char file_name[INDIGO_VALUE_SIZE];
-			char *placeholder = strstr(prefix, "XXX");
-			if (placeholder == NULL) {
-				strncpy(file_name, dir, INDIGO_VALUE_SIZE);
-				strcat(file_name, prefix);
-				strcat(file_name, suffix);
-			} else {
-				char format[INDIGO_VALUE_SIZE];
-				strcpy(format, dir);
-				strncat(format, prefix, placeholder - prefix);
-				if (!strncmp(placeholder, "XXXX", 4)) {
-					strcat(format, "%04d");
-					strcat(format, placeholder + 4);
-				} else {
-					strcat(format, "%03d");
-					strcat(format, placeholder + 3);
-				}
-				strcat(format, suffix);
-				struct stat sb;
-				int i = 1;
-				while (i < 10000) {
-					snprintf(file_name, sizeof(file_name), format, i);
-					if (stat(file_name, &sb) == 0 && S_ISREG(sb.st_mode))
-						i++;
-					else
-						break;
-				}
-			}
-			strncpy(CCD_IMAGE_FILE_ITEM->text.value, file_name, INDIGO_VALUE_SIZE);
-			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
-			handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-			if (handle) {
-				if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
-					if (!indigo_write(handle, data, FITS_HEADER_SIZE + blobsize)) {
-						CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-						message = strerror(errno);
-					}
-				} else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value) {
-					if (!indigo_write(handle, data, FITS_HEADER_SIZE + blobsize)) {
-						CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-						message = strerror(errno);
-					}
-				} else if (CCD_IMAGE_FORMAT_RAW_ITEM->sw.value) {
-					if (!indigo_write(handle, data + FITS_HEADER_SIZE - sizeof(indigo_raw_header), blobsize + sizeof(indigo_raw_header))) {
-						CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-						message = strerror(errno);
-					}
-				} else if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value) {
-					if (!indigo_write(handle, data, blobsize)) {
-						CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-						message = strerror(errno);
-					}
-				}
-				close(handle);
-			} else {
-				CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-				message = strerror(errno);
-			}
-		} else {
-			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-			message = "dir + prefix + suffix is too long";
-		}
-		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
-		INDIGO_DEBUG(indigo_debug("Local save in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
-	}
-	if (CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-		*CCD_IMAGE_ITEM->blob.url = 0;
-		if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
-			CCD_IMAGE_ITEM->blob.value = data;
-			CCD_IMAGE_ITEM->blob.size = FITS_HEADER_SIZE + blobsize;
-			strcpy(CCD_IMAGE_ITEM->blob.format, ".fits");
-		} else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value) {
-			CCD_IMAGE_ITEM->blob.value = data;
-			CCD_IMAGE_ITEM->blob.size = FITS_HEADER_SIZE + blobsize;
-			strcpy(CCD_IMAGE_ITEM->blob.format, ".xisf");
-		} else if (CCD_IMAGE_FORMAT_RAW_ITEM->sw.value) {
-			CCD_IMAGE_ITEM->blob.value = data + FITS_HEADER_SIZE - sizeof(indigo_raw_header);
-			CCD_IMAGE_ITEM->blob.size = blobsize + sizeof(indigo_raw_header);
-			strcpy(CCD_IMAGE_ITEM->blob.format, ".raw");
-		} else if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value) {
-			CCD_IMAGE_ITEM->blob.value = data;
-			CCD_IMAGE_ITEM->blob.size = blobsize;
-			strcpy(CCD_IMAGE_ITEM->blob.format, ".jpeg");
-		}
-		CCD_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
-		indigo_update_property(device, CCD_IMAGE_PROPERTY, NULL);
-		INDIGO_DEBUG(indigo_debug("Client upload in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
+	if (CCD_IMAGE_FORMAT_FITS_ITEM->sw.value) {
+		publish_image(device, data, FITS_HEADER_SIZE + blobsize, ".fits");
+	} else if (CCD_IMAGE_FORMAT_XISF_ITEM->sw.value) {
+		publish_image(device, data, FITS_HEADER_SIZE + blobsize, ".xisf");
+	} else if (CCD_IMAGE_FORMAT_RAW_ITEM->sw.value) {
+		publish_image(device, data + FITS_HEADER_SIZE - sizeof(indigo_raw_header), blobsize + sizeof(indigo_raw_header), ".raw");
+	} else if (CCD_IMAGE_FORMAT_JPEG_ITEM->sw.value) {
+		publish_image(device, data, blobsize, ".jpeg");
 	}
-	if (jpeg_data)
-		free(jpeg_data);
 }
 
 void indigo_process_dslr_image(indigo_device *device, void *data, int blobsize, const char *suffix) {
 	assert(device != NULL);
 	assert(data != NULL);
-	INDIGO_DEBUG(clock_t start = clock());
 	char standard_suffix[16];
 	strncpy(standard_suffix, suffix, sizeof(standard_suffix));
 	for (char *pnt = standard_suffix; *pnt; pnt++)
 		*pnt = tolower(*pnt);
 	if (!strcmp(standard_suffix, ".jpg"))
 		strcpy(standard_suffix, ".jpeg");
-	if (CCD_UPLOAD_MODE_LOCAL_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-		char *dir = CCD_LOCAL_MODE_DIR_ITEM->text.value;
-		char *prefix = CCD_LOCAL_MODE_PREFIX_ITEM->text.value;
-		int handle = 0;
-		char *message = NULL;
-		if (strlen(dir) + strlen(prefix) + strlen(standard_suffix) < INDIGO_VALUE_SIZE) {
-			char file_name[INDIGO_VALUE_SIZE];
-			char *xxx = strstr(prefix, "XXX");
-			if (xxx == NULL) {
-				strncpy(file_name, dir, INDIGO_VALUE_SIZE - strlen(prefix) - strlen(standard_suffix));
-				strcat(file_name, prefix);
-				strcat(file_name, standard_suffix);
-			} else {
-				char format[INDIGO_VALUE_SIZE];
-				strncpy(format, dir, INDIGO_VALUE_SIZE);
-				strncat(format, prefix, xxx - prefix);
-				strcat(format, "%03d");
-				strcat(format, xxx+3);
-				strcat(format, standard_suffix);
-				struct stat sb;
-				int i = 1;
-				while (true) {
-					snprintf(file_name, sizeof(file_name), format, i);
-					if (stat(file_name, &sb) == 0 && S_ISREG(sb.st_mode))
-						i++;
-					else
-						break;
-				}
-			}
-			strncpy(CCD_IMAGE_FILE_ITEM->text.value, file_name, INDIGO_VALUE_SIZE);
-			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_OK_STATE;
-			handle = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-			if (handle) {
-				if (!indigo_write(handle, data, blobsize)) {
-					CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-					message = strerror(errno);
-				}
-				close(handle);
-			} else {
-				CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-				message = strerror(errno);
-			}
-		} else {
-			CCD_IMAGE_FILE_PROPERTY->state = INDIGO_ALERT_STATE;
-			message = "dir + prefix + suffix is too long";
-		}
-		indigo_update_property(device, CCD_IMAGE_FILE_PROPERTY, message);
-		INDIGO_DEBUG(indigo_debug("Local save in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
-	}
-	if (CCD_UPLOAD_MODE_CLIENT_ITEM->sw.value || CCD_UPLOAD_MODE_BOTH_ITEM->sw.value) {
-		*CCD_IMAGE_ITEM->blob.url = 0;
-		CCD_IMAGE_ITEM->blob.value = data;
-		CCD_IMAGE_ITEM->blob.size = blobsize;
-		strncpy(CCD_IMAGE_ITEM->blob.format, standard_suffix, INDIGO_NAME_SIZE);
-		CCD_IMAGE_PROPERTY->state = INDIGO_OK_STATE;
-		indigo_update_property(device, CCD_IMAGE_PROPERTY, NULL);
-		INDIGO_DEBUG(indigo_debug("Client upload in %gs", (clock() - start) / (double)CLOCKS_PER_SEC));
-	}
+	publish_image(device, data, blobsize, standard_suffix);
 }
 
 void indigo_process_dslr_preview_image(indigo_device *device, void *data, int blobsize) {
-	if (CCD_CONTEXT->preview_image) {
-		if (CCD_CONTEXT->preview_image_size < blobsize) {
-			CCD_CONTEXT->preview_image = realloc(CCD_CONTEXT->preview_image, CCD_CONTEXT->preview_image_size = blobsize);
+	// caller owns and usually frees data right after the call, so it is copied to preview image buffer owned by device
+	if (CCD_CONTEXT->preview_image_size < blobsize) {
+		if (CCD_PREVIEW_IMAGE_ITEM->blob.value == CCD_CONTEXT->preview_image) {
+			CCD_PREVIEW_IMAGE_ITEM->blob.value = NULL;
+			CCD_PREVIEW_IMAGE_ITEM->blob.size = 0;
 		}
-	} else {
+		free(CCD_CONTEXT->preview_image);
 		CCD_CONTEXT->preview_image = malloc(CCD_CONTEXT->preview_image_size = blobsize);
 	}
 	memcpy(CCD_CONTEXT->preview_image, data, blobsize);
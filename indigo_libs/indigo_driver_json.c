@@ -41,6 +41,8 @@
 //#undef INDIGO_TRACE_PROTOCOL
 //#define INDIGO_TRACE_PROTOCOL(c) c
 
+#define ENCODED_CACHE_SIZE	16
+
 static pthread_mutex_t json_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static void ws_write(int handle, const char *buffer, long length) {
@@ -81,21 +83,9 @@ static const char *escape(const char *s) {
 	return tmp;
 }
 
-static indigo_result json_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
-	assert(device != NULL);
-	assert(client != NULL);
-	assert(property != NULL);
-	if (!indigo_reshare_remote_devices && device->is_remote)
-		return INDIGO_OK;
-	if (client->version == INDIGO_VERSION_NONE)
-		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	char output_buffer[JSON_BUFFER_SIZE];
+static long json_define_encode(indigo_property *property, const char *message, char *output_buffer) {
 	char *pnt = output_buffer;
-	int size;
+	int size = 0;
 	char b1[32], b2[32], b3[32], b4[32], b5[32];
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
@@ -216,30 +206,12 @@ static indigo_result json_define_property(indigo_client *client, indigo_device *
 			size += pnt - output_buffer;
 			break;
 	}
-	if (client_context->web_socket)
-		ws_write(handle, output_buffer, size);
-	else
-		indigo_write(handle, output_buffer, size);
-	INDIGO_TRACE_PROTOCOL(indigo_trace("%d ← %s\n", handle, output_buffer));
-	pthread_mutex_unlock(&json_mutex);
-	return INDIGO_OK;
+	return size;
 }
 
-static indigo_result json_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
-	assert(device != NULL);
-	assert(client != NULL);
-	assert(property != NULL);
-	if (!indigo_reshare_remote_devices && device->is_remote)
-		return INDIGO_OK;
-	if (client->version == INDIGO_VERSION_NONE)
-		return INDIGO_OK;
-	pthread_mutex_lock(&json_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	char output_buffer[JSON_BUFFER_SIZE];
+static long json_update_encode(indigo_property *property, const char *message, char *output_buffer) {
 	char *pnt = output_buffer;
-	int size;
+	int size = 0;
 	char b1[32], b2[32];
 	switch (property->type) {
 		case INDIGO_TEXT_VECTOR:
@@ -339,6 +311,94 @@ static indigo_result json_update_property(indigo_client *client, indigo_device *
 			size += pnt - output_buffer;
 			break;
 	}
+	return size;
+}
+
+/** Encodings of the current bus broadcast shared by all JSON clients (guarded by json_mutex).
+ */
+static struct {
+	indigo_property *property;
+	bool update;
+	long size;
+	char *data;
+} encoded[ENCODED_CACHE_SIZE];
+static int encoded_count = 0;
+static unsigned long encoded_sequence = 0;
+
+static char *encoded_lookup(indigo_property *property, bool update, long *size) {
+	if (encoded_sequence != indigo_bus_sequence) {
+		for (int i = 0; i < encoded_count; i++)
+			free(encoded[i].data);
+		encoded_count = 0;
+		encoded_sequence = indigo_bus_sequence;
+		return NULL;
+	}
+	for (int i = 0; i < encoded_count; i++) {
+		if (encoded[i].property == property && encoded[i].update == update) {
+			*size = encoded[i].size;
+			return encoded[i].data;
+		}
+	}
+	return NULL;
+}
+
+static char *encode(indigo_property *property, const char *message, bool update, long *size) {
+	char *data = encoded_lookup(property, update, size);
+	if (data == NULL) {
+		char output_buffer[JSON_BUFFER_SIZE];
+		*size = update ? json_update_encode(property, message, output_buffer) : json_define_encode(property, message, output_buffer);
+		data = malloc(*size + 1);
+		assert(data != NULL);
+		memcpy(data, output_buffer, *size);
+		data[*size] = 0;
+		if (encoded_count == ENCODED_CACHE_SIZE)
+			free(encoded[--encoded_count].data);
+		encoded[encoded_count].property = property;
+		encoded[encoded_count].update = update;
+		encoded[encoded_count].size = *size;
+		encoded[encoded_count].data = data;
+		encoded_count++;
+	}
+	return data;
+}
+
+static indigo_result json_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && device->is_remote)
+		return INDIGO_OK;
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	pthread_mutex_lock(&json_mutex);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	int handle = client_context->output;
+	long size;
+	char *output_buffer = encode(property, message, false, &size);
+	if (client_context->web_socket)
+		ws_write(handle, output_buffer, size);
+	else
+		indigo_write(handle, output_buffer, size);
+	INDIGO_TRACE_PROTOCOL(indigo_trace("%d ← %s\n", handle, output_buffer));
+	pthread_mutex_unlock(&json_mutex);
+	return INDIGO_OK;
+}
+
+static indigo_result json_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	assert(device != NULL);
+	assert(client != NULL);
+	assert(property != NULL);
+	if (!indigo_reshare_remote_devices && device->is_remote)
+		return INDIGO_OK;
+	if (client->version == INDIGO_VERSION_NONE)
+		return INDIGO_OK;
+	pthread_mutex_lock(&json_mutex);
+	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
+	assert(client_context != NULL);
+	int handle = client_context->output;
+	long size;
+	char *output_buffer = encode(property, message, true, &size);
 	if (client_context->web_socket)
 		ws_write(handle, output_buffer, size);
 	else
@@ -44,6 +44,15 @@
 #include <ctype.h>
 #include <pthread.h>
 #include <assert.h>
+#include <errno.h>
+#include <time.h>
+#if defined(INDIGO_WINDOWS)
+#include <winsock2.h>
+#else
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <poll.h>
+#endif
 
 #include <indigo/indigo_xml.h>
 #include <indigo/indigo_io.h>
@@ -51,27 +60,660 @@
 #include <indigo/indigo_version.h>
 #include <indigo/indigo_driver_xml.h>
 
-#define RAW_BUF_SIZE 98304
-#define BASE64_BUF_SIZE 131072  /* BASE64_BUF_SIZE >= (RAW_BUF_SIZE + 2) / 3 * 4 */
+static pthread_mutex_t serialize_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define MESSAGE_BUFFER_SIZE 1024
+#define MAX_WRITE_BATCH 64
+#define SHARED_BUFFER_COUNT 8
+#define QUEUE_HARD_LIMIT_FACTOR 4
+#define DRAIN_TIMEOUT 5
 
-static const char *message_attribute(const char *message) {
-	if (message) {
-		static char buffer[INDIGO_VALUE_SIZE];
-		snprintf(buffer, INDIGO_VALUE_SIZE, " message='%s'", indigo_xml_escape((char *)message));
-		return buffer;
+indigo_output_queue_policy indigo_xml_output_queue_policy = INDIGO_OUTPUT_QUEUE_KEEP_LATEST;
+int indigo_xml_output_queue_size = 256;
+long indigo_xml_output_queue_memory = 256L * 1024 * 1024;
+
+/** Serialized message content, shared by all clients receiving the same encoding.
+ */
+typedef struct {
+	int references;											///< number of owners
+	long length;												///< content length
+	long size;													///< buffer size
+	char *data;													///< content (always zero terminated)
+} xml_buffer;
+
+/** Serialized outbound message.
+ */
+typedef struct xml_message {
+	struct xml_message *next;						///< next message in queue
+	char device[INDIGO_NAME_SIZE];			///< device name (for coalescing)
+	char name[INDIGO_NAME_SIZE];				///< property name (for coalescing)
+	bool droppable;											///< message can be coalesced or dropped
+	bool replaceable;										///< message can be replaced by newer one for the same property (BLOB update)
+	int handle;													///< output handle (for tracing)
+	xml_buffer *buffer;									///< message content
+} xml_message;
+
+/** Adapter context extended with outbound queue and writer thread (or output callback of asynchronous adapter).
+ */
+typedef struct {
+	indigo_adapter_context context;			///< must be the first member
+	pthread_t writer_thread;						///< writer thread
+	indigo_xml_output_callback output_callback;	///< output request callback of asynchronous adapter
+	void *output_callback_data;					///< output request callback data
+	bool scheduled;											///< output callback was called and queue was not drained yet
+	xml_message *sending[MAX_WRITE_BATCH];	///< batch being written by asynchronous adapter
+	int sending_count;									///< number of messages in batch
+	int sending_index;									///< first message in batch not written completely
+	long sending_offset;								///< bytes of first message already written
+	pthread_mutex_t queue_mutex;				///< queue mutex
+	pthread_cond_t queue_cond;					///< queue condition
+	xml_message *head;									///< first queued message
+	xml_message *tail;									///< last queued message
+	int count;													///< number of queued messages
+	int droppable;											///< number of queued droppable messages
+	long bytes;													///< size of queued messages
+	long dropped;												///< number of dropped or coalesced messages
+	bool running;												///< writer thread should run
+	bool finished;											///< writer thread wrote everything and exited
+	bool failed;												///< output failed, discard everything
+} xml_adapter_context;
+
+static pthread_mutex_t buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Encodings of the current bus broadcast, reused for clients with the same protocol version (guarded by serialize_mutex).
+ */
+static struct {
+	indigo_property *property;
+	indigo_version version;
+	int variant;
+	xml_buffer *buffer;
+} shared_buffers[SHARED_BUFFER_COUNT];
+static unsigned long shared_sequence = 0;
+static int shared_count = 0;
+
+static xml_buffer *buffer_alloc() {
+	xml_buffer *buffer = malloc(sizeof(xml_buffer));
+	assert(buffer != NULL);
+	buffer->references = 1;
+	buffer->length = 0;
+	buffer->data = malloc(buffer->size = MESSAGE_BUFFER_SIZE);
+	assert(buffer->data != NULL);
+	*buffer->data = 0;
+	return buffer;
+}
+
+static xml_buffer *buffer_retain(xml_buffer *buffer) {
+	pthread_mutex_lock(&buffer_mutex);
+	buffer->references++;
+	pthread_mutex_unlock(&buffer_mutex);
+	return buffer;
+}
+
+static void buffer_release(xml_buffer *buffer) {
+	pthread_mutex_lock(&buffer_mutex);
+	bool last = --buffer->references == 0;
+	pthread_mutex_unlock(&buffer_mutex);
+	if (last) {
+		free(buffer->data);
+		free(buffer);
+	}
+}
+
+static void buffer_reserve(xml_buffer *buffer, long length) {
+	if (buffer->length + length >= buffer->size) {
+		while (buffer->length + length >= buffer->size)
+			buffer->size *= 2;
+		buffer->data = realloc(buffer->data, buffer->size);
+		assert(buffer->data != NULL);
+	}
+}
+
+static void buffer_append(xml_buffer *buffer, const char *string, long length) {
+	buffer_reserve(buffer, length);
+	memcpy(buffer->data + buffer->length, string, length);
+	buffer->length += length;
+	buffer->data[buffer->length] = 0;
+}
+
+static inline void buffer_puts(xml_buffer *buffer, const char *string) {
+	buffer_append(buffer, string, strlen(string));
+}
+
+static void buffer_escape(xml_buffer *buffer, const char *string) {
+	const char *start = string;
+	for (const char *s = string;; s++) {
+		const char *entity;
+		switch (*s) {
+			case 0:
+				buffer_append(buffer, start, s - start);
+				return;
+			case '&':
+				entity = "&amp;";
+				break;
+			case '<':
+				entity = "&lt;";
+				break;
+			case '>':
+				entity = "&gt;";
+				break;
+			case '"':
+				entity = "&quot;";
+				break;
+			case '\'':
+				entity = "&apos;";
+				break;
+			default:
+				continue;
+		}
+		buffer_append(buffer, start, s - start);
+		buffer_puts(buffer, entity);
+		start = s + 1;
+	}
+}
+
+static void buffer_attribute(xml_buffer *buffer, const char *name, const char *value, bool escape) {
+	buffer_puts(buffer, " ");
+	buffer_puts(buffer, name);
+	buffer_puts(buffer, "='");
+	if (escape)
+		buffer_escape(buffer, value);
+	else
+		buffer_puts(buffer, value);
+	buffer_puts(buffer, "'");
+}
+
+static void buffer_number(xml_buffer *buffer, double value) {
+	buffer_reserve(buffer, 32);
+	char *string = buffer->data + buffer->length;
+	buffer->length += snprintf(string, 32, "%g", value);
+	indigo_fix_locale(string);
+}
+
+static void buffer_number_attribute(xml_buffer *buffer, const char *name, double value) {
+	buffer_puts(buffer, " ");
+	buffer_puts(buffer, name);
+	buffer_puts(buffer, "='");
+	buffer_number(buffer, value);
+	buffer_puts(buffer, "'");
+}
+
+static void buffer_base64(xml_buffer *buffer, const unsigned char *data, long length) {
+	buffer_reserve(buffer, (length + 2) / 3 * 4 + 1);
+	buffer->length += base64_encode((unsigned char *)buffer->data + buffer->length, data, length);
+	buffer->data[buffer->length] = 0;
+}
+
+static xml_buffer *shared_buffer(indigo_property *property, indigo_version version, int variant) {
+	unsigned long sequence = indigo_bus_sequence;
+	if (sequence != shared_sequence) {
+		for (int i = 0; i < shared_count; i++)
+			buffer_release(shared_buffers[i].buffer);
+		shared_count = 0;
+		shared_sequence = sequence;
+		return NULL;
+	}
+	for (int i = 0; i < shared_count; i++) {
+		if (shared_buffers[i].property == property && shared_buffers[i].version == version && shared_buffers[i].variant == variant)
+			return buffer_retain(shared_buffers[i].buffer);
+	}
+	return NULL;
+}
+
+static void share_buffer(indigo_property *property, indigo_version version, int variant, xml_buffer *buffer) {
+	if (shared_count < SHARED_BUFFER_COUNT && shared_sequence == indigo_bus_sequence) {
+		shared_buffers[shared_count].property = property;
+		shared_buffers[shared_count].version = version;
+		shared_buffers[shared_count].variant = variant;
+		shared_buffers[shared_count].buffer = buffer_retain(buffer);
+		shared_count++;
+	}
+}
+
+static xml_message *message_alloc(indigo_client *client, indigo_device *device, indigo_property *property, bool droppable, bool replaceable, xml_buffer *buffer) {
+	xml_message *message = malloc(sizeof(xml_message));
+	assert(message != NULL);
+	memset(message, 0, sizeof(xml_message));
+	if (property != NULL) {
+		strncpy(message->device, property->device, INDIGO_NAME_SIZE);
+		strncpy(message->name, property->name, INDIGO_NAME_SIZE);
+	} else if (device != NULL) {
+		strncpy(message->device, device->name, INDIGO_NAME_SIZE);
+	}
+	message->droppable = droppable;
+	message->replaceable = replaceable;
+	message->handle = ((indigo_adapter_context *)client->client_context)->output;
+	message->buffer = buffer;
+	return message;
+}
+
+static void message_free(xml_message *message) {
+	buffer_release(message->buffer);
+	free(message);
+}
+
+/** Free all queued messages, called with queue_mutex locked.
+ */
+static void message_discard_queue(xml_adapter_context *client_context) {
+	while (client_context->head) {
+		xml_message *message = client_context->head;
+		client_context->head = message->next;
+		message_free(message);
+	}
+	client_context->tail = NULL;
+	client_context->count = 0;
+	client_context->droppable = 0;
+	client_context->bytes = 0;
+}
+
+/** Remove message from queue, called with queue_mutex locked.
+ */
+static void message_unlink(xml_adapter_context *client_context, xml_message *previous, xml_message *message) {
+	if (previous == NULL)
+		client_context->head = message->next;
+	else
+		previous->next = message->next;
+	if (client_context->tail == message)
+		client_context->tail = previous;
+	client_context->count--;
+	if (message->droppable)
+		client_context->droppable--;
+	client_context->bytes -= message->buffer->length;
+}
+
+static void message_enqueue(indigo_client *client, xml_message *message) {
+	xml_adapter_context *client_context = (xml_adapter_context *)client->client_context;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("%d ← %s", message->handle, message->buffer->data));
+	pthread_mutex_lock(&client_context->queue_mutex);
+	if (client_context->failed) {
+		pthread_mutex_unlock(&client_context->queue_mutex);
+		message_free(message);
+		return;
+	}
+	bool coalesce = (message->droppable && indigo_xml_output_queue_policy == INDIGO_OUTPUT_QUEUE_KEEP_LATEST) || (message->replaceable && indigo_xml_output_queue_policy != INDIGO_OUTPUT_QUEUE_KEEP_ALL);
+	if (coalesce && client_context->count > 0) {
+		xml_message *pending = NULL, *pending_previous = NULL;
+		for (xml_message *previous = NULL, *queued = client_context->head; queued; previous = queued, queued = queued->next) {
+			if (!strcmp(queued->device, message->device) && (*queued->name == 0 || !strcmp(queued->name, message->name))) {
+				pending = queued;
+				pending_previous = previous;
+			}
+		}
+		if (pending != NULL && pending->droppable == message->droppable && pending->replaceable == message->replaceable && *pending->name) {
+			// superseded update is removed and the new one is queued at the end, so updates of other properties queued meanwhile are not overtaken
+			message_unlink(client_context, pending_previous, pending);
+			message_free(pending);
+			client_context->dropped++;
+		}
+	}
+	if (message->droppable && client_context->droppable >= indigo_xml_output_queue_size) {
+		if (indigo_xml_output_queue_policy == INDIGO_OUTPUT_QUEUE_KEEP_LATEST) {
+			for (xml_message *previous = NULL, *queued = client_context->head; queued; previous = queued, queued = queued->next) {
+				if (queued->droppable) {
+					message_unlink(client_context, previous, queued);
+					message_free(queued);
+					client_context->dropped++;
+					break;
+				}
+			}
+		} else if (indigo_xml_output_queue_policy == INDIGO_OUTPUT_QUEUE_DROP) {
+			client_context->dropped++;
+			pthread_mutex_unlock(&client_context->queue_mutex);
+			INDIGO_DEBUG_PROTOCOL(indigo_debug("XML adapter: output queue full, '%s'.'%s' update dropped", message->device, message->name));
+			message_free(message);
+			return;
+		}
+	}
+	// only droppable backlog is bounded by count, definitions, deletions and messages are limited by size only
+	if (client_context->droppable >= indigo_xml_output_queue_size * QUEUE_HARD_LIMIT_FACTOR || client_context->bytes + message->buffer->length > indigo_xml_output_queue_memory) {
+		// client doesn't read at all, disconnect it instead of growing the queue without limit
+		indigo_error("XML adapter: output queue of %d is full (%d messages, %ld bytes), client disconnected", message->handle, client_context->count, client_context->bytes);
+		client_context->failed = true;
+		message_discard_queue(client_context);
+#if defined(INDIGO_WINDOWS)
+		shutdown(client_context->context.output, SD_BOTH);
+#else
+		shutdown(client_context->context.output, SHUT_RDWR);
+#endif
+		pthread_cond_signal(&client_context->queue_cond);
+		pthread_mutex_unlock(&client_context->queue_mutex);
+		message_free(message);
+		return;
+	}
+	if (client_context->tail == NULL)
+		client_context->head = message;
+	else
+		client_context->tail->next = message;
+	client_context->tail = message;
+	client_context->count++;
+	if (message->droppable)
+		client_context->droppable++;
+	client_context->bytes += message->buffer->length;
+	bool schedule = client_context->output_callback != NULL && !client_context->scheduled;
+	client_context->scheduled |= schedule;
+	pthread_cond_signal(&client_context->queue_cond);
+	pthread_mutex_unlock(&client_context->queue_mutex);
+	if (schedule)
+		client_context->output_callback(client_context->output_callback_data);
+}
+
+static bool write_batch(int handle, xml_message **batch, int count) {
+#if defined(INDIGO_WINDOWS)
+	for (int i = 0; i < count; i++) {
+		if (!indigo_write(handle, batch[i]->buffer->data, batch[i]->buffer->length))
+			return false;
+	}
+	return true;
+#else
+	struct iovec vector[MAX_WRITE_BATCH];
+	for (int i = 0; i < count; i++) {
+		vector[i].iov_base = batch[i]->buffer->data;
+		vector[i].iov_len = batch[i]->buffer->length;
+	}
+	struct iovec *current = vector;
+	while (count > 0) {
+		long bytes_written = writev(handle, current, count);
+		if (bytes_written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		while (count > 0 && bytes_written >= (long)current->iov_len) {
+			bytes_written -= current->iov_len;
+			current++;
+			count--;
+		}
+		if (count > 0) {
+			current->iov_base = (char *)current->iov_base + bytes_written;
+			current->iov_len -= bytes_written;
+		}
+	}
+	return true;
+#endif
+}
+
+static void *writer_thread(xml_adapter_context *client_context) {
+	xml_message *batch[MAX_WRITE_BATCH];
+	pthread_mutex_lock(&client_context->queue_mutex);
+	while (true) {
+		while (client_context->head == NULL && client_context->running)
+			pthread_cond_wait(&client_context->queue_cond, &client_context->queue_mutex);
+		if (client_context->head == NULL)
+			break;
+		int count = 0;
+		while (client_context->head != NULL && count < MAX_WRITE_BATCH) {
+			xml_message *message = client_context->head;
+			if ((client_context->head = message->next) == NULL)
+				client_context->tail = NULL;
+			client_context->count--;
+			if (message->droppable)
+				client_context->droppable--;
+			client_context->bytes -= message->buffer->length;
+			batch[count++] = message;
+		}
+		bool failed = client_context->failed;
+		pthread_mutex_unlock(&client_context->queue_mutex);
+		if (!failed && !write_batch(client_context->context.output, batch, count)) {
+			INDIGO_DEBUG_PROTOCOL(indigo_debug("XML adapter: write to %d failed (%s)", client_context->context.output, strerror(errno)));
+			failed = true;
+		}
+		for (int i = 0; i < count; i++)
+			message_free(batch[i]);
+		pthread_mutex_lock(&client_context->queue_mutex);
+		client_context->failed |= failed;
+	}
+	client_context->finished = true;
+	pthread_cond_broadcast(&client_context->queue_cond);
+	pthread_mutex_unlock(&client_context->queue_mutex);
+	return NULL;
+}
+
+/** Write as much of current batch as possible without blocking, return number of bytes written or -1.
+ */
+static long write_pending(xml_adapter_context *client_context) {
+	xml_message **batch = client_context->sending + client_context->sending_index;
+	int count = client_context->sending_count - client_context->sending_index;
+	long offset = client_context->sending_offset;
+#if defined(INDIGO_WINDOWS)
+	return send(client_context->context.output, batch[0]->buffer->data + offset, batch[0]->buffer->length - offset, 0);
+#else
+	struct iovec vector[MAX_WRITE_BATCH];
+	for (int i = 0; i < count; i++) {
+		vector[i].iov_base = batch[i]->buffer->data;
+		vector[i].iov_len = batch[i]->buffer->length;
+	}
+	vector[0].iov_base = (char *)vector[0].iov_base + offset;
+	vector[0].iov_len -= offset;
+	struct msghdr header = { .msg_iov = vector, .msg_iovlen = count };
+	return sendmsg(client_context->context.output, &header, MSG_DONTWAIT);
+#endif
+}
+
+static void discard_pending(xml_adapter_context *client_context) {
+	while (client_context->sending_index < client_context->sending_count)
+		message_free(client_context->sending[client_context->sending_index++]);
+	client_context->sending_offset = 0;
+}
+
+bool indigo_xml_device_adapter_flush(indigo_client *client) {
+	xml_adapter_context *client_context = (xml_adapter_context *)client->client_context;
+	assert(client_context->output_callback != NULL);
+	while (true) {
+		pthread_mutex_lock(&client_context->queue_mutex);
+		if (client_context->failed)
+			discard_pending(client_context);
+		if (client_context->sending_index == client_context->sending_count) {
+			client_context->sending_count = client_context->sending_index = 0;
+			client_context->sending_offset = 0;
+			if (client_context->head == NULL) {
+				// new message calls output callback again
+				client_context->scheduled = false;
+				pthread_cond_broadcast(&client_context->queue_cond);
+				pthread_mutex_unlock(&client_context->queue_mutex);
+				return false;
+			}
+			while (client_context->head != NULL && client_context->sending_count < MAX_WRITE_BATCH) {
+				xml_message *message = client_context->head;
+				if ((client_context->head = message->next) == NULL)
+					client_context->tail = NULL;
+				client_context->count--;
+				if (message->droppable)
+					client_context->droppable--;
+				client_context->bytes -= message->buffer->length;
+				client_context->sending[client_context->sending_count++] = message;
+			}
+		}
+		pthread_mutex_unlock(&client_context->queue_mutex);
+		long bytes_written = write_pending(client_context);
+		if (bytes_written < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return true;
+			INDIGO_DEBUG_PROTOCOL(indigo_debug("XML adapter: write to %d failed (%s)", client_context->context.output, strerror(errno)));
+			pthread_mutex_lock(&client_context->queue_mutex);
+			client_context->failed = true;
+			message_discard_queue(client_context);
+#if defined(INDIGO_WINDOWS)
+			shutdown(client_context->context.output, SD_BOTH);
+#else
+			shutdown(client_context->context.output, SHUT_RDWR);
+#endif
+			pthread_mutex_unlock(&client_context->queue_mutex);
+			continue;
+		}
+		bytes_written += client_context->sending_offset;
+		while (client_context->sending_index < client_context->sending_count && bytes_written >= client_context->sending[client_context->sending_index]->buffer->length) {
+			bytes_written -= client_context->sending[client_context->sending_index]->buffer->length;
+			message_free(client_context->sending[client_context->sending_index++]);
+		}
+		client_context->sending_offset = bytes_written;
+	}
+}
+
+static bool wait_writable(int handle, int timeout) {
+#if defined(INDIGO_WINDOWS)
+	WSAPOLLFD descriptor = { .fd = handle, .events = POLLOUT };
+	return WSAPoll(&descriptor, 1, timeout) > 0;
+#else
+	struct pollfd descriptor = { .fd = handle, .events = POLLOUT };
+	int result;
+	while ((result = poll(&descriptor, 1, timeout)) < 0 && errno == EINTR)
+		;
+	return result > 0;
+#endif
+}
+
+static void serialize_vector_start(xml_buffer *output, const char *tag, indigo_version version, indigo_property *property) {
+	buffer_puts(output, "<");
+	buffer_puts(output, tag);
+	buffer_attribute(output, "device", property->device, true);
+	buffer_attribute(output, "name", indigo_property_name(version, property), false);
+}
+
+static void serialize_vector_end(xml_buffer *output, const char *state, const char *message) {
+	buffer_attribute(output, "state", state, false);
+	if (message)
+		buffer_attribute(output, "message", message, true);
+	buffer_puts(output, ">\n");
+}
+
+static void serialize_definition(xml_buffer *output, indigo_version version, indigo_property *property, const char *message) {
+	static const char *tags[][2] = {
+		[INDIGO_TEXT_VECTOR] = { "defTextVector", "defText" },
+		[INDIGO_NUMBER_VECTOR] = { "defNumberVector", "defNumber" },
+		[INDIGO_SWITCH_VECTOR] = { "defSwitchVector", "defSwitch" },
+		[INDIGO_LIGHT_VECTOR] = { "defLightVector", "defLight" },
+		[INDIGO_BLOB_VECTOR] = { "defBLOBVector", "defBLOB" }
+	};
+	const char *vector_tag = tags[property->type][0], *item_tag = tags[property->type][1];
+	serialize_vector_start(output, vector_tag, version, property);
+	buffer_attribute(output, "group", property->group, true);
+	buffer_attribute(output, "label", property->label, true);
+	buffer_attribute(output, "perm", indigo_property_perm_text[property->perm], false);
+	buffer_attribute(output, "state", indigo_property_state_text[property->state], false);
+	if (property->type == INDIGO_SWITCH_VECTOR)
+		buffer_attribute(output, "rule", indigo_switch_rule_text[property->rule], false);
+	if (*property->hints)
+		buffer_attribute(output, "hints", property->hints, true);
+	if (message)
+		buffer_attribute(output, "message", message, true);
+	buffer_puts(output, ">\n");
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = &property->items[i];
+		buffer_puts(output, property->type == INDIGO_LIGHT_VECTOR ? " <" : "<");
+		buffer_puts(output, item_tag);
+		buffer_attribute(output, "name", indigo_item_name(version, property, item), false);
+		buffer_attribute(output, "label", item->label, true);
+		if (property->type == INDIGO_NUMBER_VECTOR && version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM) {
+			buffer_attribute(output, "format", item->number.format, false);
+			buffer_number_attribute(output, "min", item->number.min);
+			buffer_number_attribute(output, "max", item->number.max);
+			buffer_number_attribute(output, "step", item->number.step);
+			buffer_number_attribute(output, "target", item->number.target);
+		} else {
+			if (*item->hints)
+				buffer_attribute(output, "hints", item->hints, true);
+			if (property->type == INDIGO_NUMBER_VECTOR) {
+				buffer_attribute(output, "format", item->number.format, false);
+				buffer_number_attribute(output, "min", item->number.min);
+				buffer_number_attribute(output, "max", item->number.max);
+				buffer_number_attribute(output, "step", item->number.step);
+			}
+		}
+		switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				buffer_puts(output, ">");
+				buffer_escape(output, item->text.value);
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				buffer_puts(output, ">");
+				buffer_number(output, item->number.value);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				buffer_puts(output, item->sw.value ? ">On" : ">Off");
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				buffer_puts(output, ">");
+				buffer_puts(output, indigo_property_state_text[item->light.value]);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				buffer_puts(output, "/>\n");
+				continue;
+		}
+		buffer_puts(output, "</");
+		buffer_puts(output, item_tag);
+		buffer_puts(output, ">\n");
 	}
-	return "";
+	buffer_puts(output, "</");
+	buffer_puts(output, vector_tag);
+	buffer_puts(output, ">\n");
 }
 
-static const char *hints_attribute(const char *hints) {
-	if (*hints) {
-		static char buffer[INDIGO_VALUE_SIZE];
-		snprintf(buffer, INDIGO_VALUE_SIZE, " hints='%s'", indigo_xml_escape((char *)hints));
-		return buffer;
+static void serialize_update(xml_buffer *output, indigo_version version, indigo_property *property, const char *message, indigo_enable_blob_mode mode) {
+	static const char *tags[][2] = {
+		[INDIGO_TEXT_VECTOR] = { "setTextVector", "oneText" },
+		[INDIGO_NUMBER_VECTOR] = { "setNumberVector", "oneNumber" },
+		[INDIGO_SWITCH_VECTOR] = { "setSwitchVector", "oneSwitch" },
+		[INDIGO_LIGHT_VECTOR] = { "setLightVector", "oneLight" },
+		[INDIGO_BLOB_VECTOR] = { "setBLOBVector", "oneBLOB" }
+	};
+	const char *vector_tag = tags[property->type][0], *item_tag = tags[property->type][1];
+	if (property->type == INDIGO_BLOB_VECTOR && mode == INDIGO_ENABLE_BLOB_NEVER)
+		return;
+	serialize_vector_start(output, vector_tag, version, property);
+	serialize_vector_end(output, indigo_property_state_text[property->state], message);
+	if (property->type != INDIGO_BLOB_VECTOR || property->state == INDIGO_OK_STATE) {
+		for (int i = 0; i < property->count; i++) {
+			indigo_item *item = &property->items[i];
+			buffer_puts(output, "<");
+			buffer_puts(output, item_tag);
+			buffer_attribute(output, "name", indigo_item_name(version, property, item), false);
+			switch (property->type) {
+				case INDIGO_TEXT_VECTOR:
+					buffer_puts(output, ">");
+					buffer_escape(output, item->text.value);
+					break;
+				case INDIGO_NUMBER_VECTOR:
+					if (version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM)
+						buffer_number_attribute(output, "target", item->number.target);
+					buffer_puts(output, ">");
+					buffer_number(output, item->number.value);
+					break;
+				case INDIGO_SWITCH_VECTOR:
+					buffer_puts(output, item->sw.value ? ">On" : ">Off");
+					break;
+				case INDIGO_LIGHT_VECTOR:
+					buffer_puts(output, ">");
+					buffer_puts(output, indigo_property_state_text[item->light.value]);
+					break;
+				case INDIGO_BLOB_VECTOR: {
+					char path[INDIGO_NAME_SIZE];
+					if (mode == INDIGO_ENABLE_BLOB_URL && version >= INDIGO_VERSION_2_0) {
+						if (*item->blob.url == 0) {
+							snprintf(path, sizeof(path), "/blob/%p%s", item, item->blob.format);
+							buffer_attribute(output, "path", path, false);
+						} else {
+							buffer_attribute(output, "url", item->blob.url, false);
+						}
+						buffer_puts(output, "/>\n");
+						continue;
+					}
+					snprintf(path, sizeof(path), "%ld", item->blob.size);
+					buffer_attribute(output, "format", item->blob.format, false);
+					buffer_attribute(output, "size", path, false);
+					buffer_puts(output, ">\n");
+					buffer_base64(output, item->blob.value, item->blob.size);
+					break;
+				}
+			}
+			buffer_puts(output, "</");
+			buffer_puts(output, item_tag);
+			buffer_puts(output, ">\n");
+		}
 	}
-	return "";
+	buffer_puts(output, "</");
+	buffer_puts(output, vector_tag);
+	buffer_puts(output, ">\n");
 }
 
 static indigo_result xml_device_adapter_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
@@ -82,63 +724,20 @@ static indigo_result xml_device_adapter_define_property(indigo_client *client, i
 		return INDIGO_OK;
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	char b1[32], b2[32], b3[32], b4[32], b5[32];
-	switch (property->type) {
-	case INDIGO_TEXT_VECTOR:
-		indigo_printf(handle, "<defTextVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
-		for (int i = 0; i < property->count; i++) {
-			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<defText name='%s' label='%s'%s>%s</defText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), indigo_xml_escape(item->text.value));
-		}
-		indigo_printf(handle, "</defTextVector>\n");
-		break;
-	case INDIGO_NUMBER_VECTOR:
-		indigo_printf(handle, "<defNumberVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
-		for (int i = 0; i < property->count; i++) {
-			indigo_item *item = &property->items[i];
-			if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM)
-				indigo_printf(handle, "<defNumber name='%s' label='%s' format='%s' min='%s' max='%s' step='%s' target='%s'>%s</defNumber>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), item->number.format, indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), indigo_dtoa(item->number.target, b4), indigo_dtoa(item->number.value, b5));
-			else
-				indigo_printf(handle, "<defNumber name='%s' label='%s'%s format='%s' min='%s' max='%s' step='%s'>%s</defNumber>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), item->number.format, indigo_dtoa(item->number.min, b1), indigo_dtoa(item->number.max, b2), indigo_dtoa(item->number.step, b3), indigo_dtoa(item->number.value, b4));
-		}
-		indigo_printf(handle, "</defNumberVector>\n");
-		break;
-	case INDIGO_SWITCH_VECTOR:
-		indigo_printf(handle, "<defSwitchVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s' rule='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], indigo_switch_rule_text[property->rule], hints_attribute(property->hints), message_attribute(message));
-		for (int i = 0; i < property->count; i++) {
-			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<defSwitch name='%s' label='%s'%s>%s</defSwitch>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), item->sw.value ? "On" : "Off");
-		}
-		indigo_printf(handle, "</defSwitchVector>\n");
-		break;
-	case INDIGO_LIGHT_VECTOR:
-		indigo_printf(handle, "<defLightVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
-		for (int i = 0; i < property->count; i++) {
-			indigo_item *item = &property->items[i];
-			indigo_printf(handle, " <defLight name='%s' label='%s'%s>%s</defLight>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints), indigo_property_state_text[item->light.value]);
-		}
-		indigo_printf(handle, "</defLightVector>\n");
-		break;
-	case INDIGO_BLOB_VECTOR:
-		indigo_printf(handle, "<defBLOBVector device='%s' name='%s' group='%s' label='%s' perm='%s' state='%s'%s%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_xml_escape(property->group), indigo_xml_escape(property->label), indigo_property_perm_text[property->perm], indigo_property_state_text[property->state], hints_attribute(property->hints), message_attribute(message));
-		for (int i = 0; i < property->count; i++) {
-			indigo_item *item = &property->items[i];
-			indigo_printf(handle, "<defBLOB name='%s' label='%s'%s/>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->label), hints_attribute(item->hints));
-		}
-		indigo_printf(handle, "</defBLOBVector>\n");
-		break;
+	assert(client->client_context != NULL);
+	pthread_mutex_lock(&serialize_mutex);
+	xml_buffer *output = shared_buffer(property, client->version, -1);
+	if (output == NULL) {
+		output = buffer_alloc();
+		serialize_definition(output, client->version, property, message);
+		share_buffer(property, client->version, -1, output);
 	}
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_unlock(&serialize_mutex);
+	message_enqueue(client, message_alloc(client, device, property, false, false, output));
 	return INDIGO_OK;
 }
 
 static indigo_result xml_device_adapter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
-	FILE* fh;
-	int handle2;
 	assert(device != NULL);
 	assert(client != NULL);
 	assert(property != NULL);
@@ -146,106 +745,29 @@ static indigo_result xml_device_adapter_update_property(indigo_client *client, i
 		return INDIGO_OK;
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	char b1[32], b2[32];
-	switch (property->type) {
-		case INDIGO_TEXT_VECTOR:
-			indigo_printf(handle, "<setTextVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
-			for (int i = 0; i < property->count; i++) {
-				indigo_item *item = &property->items[i];
-				indigo_printf(handle, "<oneText name='%s'>%s</oneText>\n", indigo_item_name(client->version, property, item), indigo_xml_escape(item->text.value));
-			}
-			indigo_printf(handle, "</setTextVector>\n");
-			break;
-		case INDIGO_NUMBER_VECTOR:
-			indigo_printf(handle, "<setNumberVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
-			for (int i = 0; i < property->count; i++) {
-				indigo_item *item = &property->items[i];
-				if (client->version >= INDIGO_VERSION_2_0 && property->perm != INDIGO_RO_PERM)
-					indigo_printf(handle, "<oneNumber name='%s' target='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), indigo_dtoa(item->number.target, b1), indigo_dtoa(item->number.value, b2));
-				else
-					indigo_printf(handle, "<oneNumber name='%s'>%s</oneNumber>\n", indigo_item_name(client->version, property, item), indigo_dtoa(item->number.value, b1));
-			}
-			indigo_printf(handle, "</setNumberVector>\n");
-			break;
-		case INDIGO_SWITCH_VECTOR:
-			indigo_printf(handle, "<setSwitchVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
-			for (int i = 0; i < property->count; i++) {
-				indigo_item *item = &property->items[i];
-				indigo_printf(handle, "<oneSwitch name='%s'>%s</oneSwitch>\n", indigo_item_name(client->version, property, item), item->sw.value ? "On" : "Off");
-			}
-			indigo_printf(handle, "</setSwitchVector>\n");
-			break;
-		case INDIGO_LIGHT_VECTOR:
-			indigo_printf(handle, "<setLightVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
-			for (int i = 0; i < property->count; i++) {
-				indigo_item *item = &property->items[i];
-				indigo_printf(handle, "<oneLight name='%s'>%s</oneLight>\n", indigo_item_name(client->version, property, item), indigo_property_state_text[item->light.value]);
-			}
-			indigo_printf(handle, "</setLightVector>\n");
-			break;
-		case INDIGO_BLOB_VECTOR: {
-			indigo_enable_blob_mode mode = INDIGO_ENABLE_BLOB_NEVER;
-			indigo_enable_blob_mode_record *record = client->enable_blob_mode_records;
-			while (record) {
-				if ((*record->device == 0 || !strcmp(property->device, record->device)) && (*record->name == 0 || !strcmp(property->name, record->name))) {
-					mode = record->mode;
-					break;
-				}
-				record = record->next;
-			}
-			if (mode != INDIGO_ENABLE_BLOB_NEVER) {
-				indigo_printf(handle, "<setBLOBVector device='%s' name='%s' state='%s'%s>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), indigo_property_state_text[property->state], message_attribute(message));
-				if (property->state == INDIGO_OK_STATE) {
-					for (int i = 0; i < property->count; i++) {
-						indigo_item *item = &property->items[i];
-						long input_length = item->blob.size;
-						unsigned char *data = item->blob.value;
-						if (mode == INDIGO_ENABLE_BLOB_URL && client->version >= INDIGO_VERSION_2_0) {
-							if (*item->blob.url == 0)
-								indigo_printf(handle, "<oneBLOB name='%s' path='/blob/%p%s'/>\n", indigo_item_name(client->version, property, item), item, item->blob.format);
-							else
-								indigo_printf(handle, "<oneBLOB name='%s' url='%s'/>\n", indigo_item_name(client->version, property, item), item->blob.url);
-						} else {
-							indigo_printf(handle, "<oneBLOB name='%s' format='%s' size='%ld'>\n", indigo_item_name(client->version, property, item), item->blob.format, item->blob.size);
-							handle2 = dup(handle);
-							fh = fdopen(handle2, "w");
-							if (client->version >= INDIGO_VERSION_2_0) {
-								while (input_length) {
-									char encoded_data[BASE64_BUF_SIZE + 1];
-									long len = (RAW_BUF_SIZE < input_length) ?  RAW_BUF_SIZE : input_length;
-									long enclen = base64_encode((unsigned char*)encoded_data, (unsigned char*)data, len);
-									fwrite(encoded_data, 1, enclen, fh);
-									input_length -= len;
-									data += len;
-								}
-							} else {
-								static char encoded_data[74];
-								while (input_length) {
-									/* 54 raw = 72 encoded */
-									long len = (54 < input_length) ?  54 : input_length;
-									long enclen = base64_encode((unsigned char*)encoded_data, (unsigned char*)data, len);
-									encoded_data[enclen] = '\n';
-									fwrite(encoded_data, 1, enclen, fh);
-									input_length -= len;
-									data += len;
-								}
-							}
-							fflush(fh);
-							fclose(fh);
-							indigo_printf(handle, "</oneBLOB>\n");
-						}
-					}
-				}
-				indigo_printf(handle, "</setBLOBVector>\n");
+	assert(client->client_context != NULL);
+	indigo_enable_blob_mode mode = INDIGO_ENABLE_BLOB_NEVER;
+	if (property->type == INDIGO_BLOB_VECTOR) {
+		indigo_enable_blob_mode_record *record = client->enable_blob_mode_records;
+		while (record) {
+			if ((*record->device == 0 || !strcmp(property->device, record->device)) && (*record->name == 0 || !strcmp(property->name, record->name))) {
+				mode = record->mode;
+				break;
 			}
-			break;
+			record = record->next;
 		}
+		if (mode == INDIGO_ENABLE_BLOB_NEVER)
+			return INDIGO_OK;
 	}
-	pthread_mutex_unlock(&write_mutex);
+	pthread_mutex_lock(&serialize_mutex);
+	xml_buffer *output = shared_buffer(property, client->version, mode);
+	if (output == NULL) {
+		output = buffer_alloc();
+		serialize_update(output, client->version, property, message, mode);
+		share_buffer(property, client->version, mode, output);
+	}
+	pthread_mutex_unlock(&serialize_mutex);
+	message_enqueue(client, message_alloc(client, device, property, (property->type == INDIGO_NUMBER_VECTOR || property->type == INDIGO_LIGHT_VECTOR) && message == NULL, property->type == INDIGO_BLOB_VECTOR, output));
 	return INDIGO_OK;
 }
 
@@ -257,15 +779,19 @@ static indigo_result xml_device_adapter_delete_property(indigo_client *client, i
 		return INDIGO_OK;
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	if (*property->name)
-		indigo_printf(handle, "<delProperty device='%s' name='%s'%s/>\n", indigo_xml_escape(property->device), indigo_property_name(client->version, property), message_attribute(message));
-	else
-		indigo_printf(handle, "<delProperty device='%s'%s/>\n", device->name, message_attribute(message));
-	pthread_mutex_unlock(&write_mutex);
+	assert(client->client_context != NULL);
+	xml_buffer *output = buffer_alloc();
+	buffer_puts(output, "<delProperty");
+	if (*property->name) {
+		buffer_attribute(output, "device", property->device, true);
+		buffer_attribute(output, "name", indigo_property_name(client->version, property), false);
+	} else {
+		buffer_attribute(output, "device", device->name, false);
+	}
+	if (message)
+		buffer_attribute(output, "message", message, true);
+	buffer_puts(output, "/>\n");
+	message_enqueue(client, message_alloc(client, device, property, false, false, output));
 	return INDIGO_OK;
 }
 
@@ -276,17 +802,18 @@ static indigo_result xml_device_adapter_send_message(indigo_client *client, indi
 		return INDIGO_OK;
 	if (client->version == INDIGO_VERSION_NONE)
 		return INDIGO_OK;
-	pthread_mutex_lock(&write_mutex);
-	indigo_adapter_context *client_context = (indigo_adapter_context *)client->client_context;
-	assert(client_context != NULL);
-	int handle = client_context->output;
-	if (message)
-		indigo_printf(handle, "<message%s/>\n", message_attribute(message));
-	pthread_mutex_unlock(&write_mutex);
+	assert(client->client_context != NULL);
+	if (message) {
+		xml_buffer *output = buffer_alloc();
+		buffer_puts(output, "<message");
+		buffer_attribute(output, "message", message, true);
+		buffer_puts(output, "/>\n");
+		message_enqueue(client, message_alloc(client, device, NULL, false, false, output));
+	}
 	return INDIGO_OK;
 }
 
-indigo_client *indigo_xml_device_adapter(int input, int ouput) {
+static indigo_client *create_adapter(int input, int ouput) {
 	static indigo_client client_template = {
 		"", false, NULL, INDIGO_OK, INDIGO_VERSION_NONE, NULL,
 		NULL,
@@ -299,19 +826,110 @@ indigo_client *indigo_xml_device_adapter(int input, int ouput) {
 	indigo_client *client = malloc(sizeof(indigo_client));
 	assert(client != NULL);
 	memcpy(client, &client_template, sizeof(indigo_client));
-	indigo_adapter_context *client_context = malloc(sizeof(indigo_adapter_context));
+	xml_adapter_context *client_context = malloc(sizeof(xml_adapter_context));
 	assert(client_context != NULL);
-	client_context->input = input;
-	client_context->output = ouput;
+	memset(client_context, 0, sizeof(xml_adapter_context));
+	client_context->context.input = input;
+	client_context->context.output = ouput;
+	pthread_mutex_init(&client_context->queue_mutex, NULL);
+	pthread_condattr_t cond_attr;
+	pthread_condattr_init(&cond_attr);
+#if defined(INDIGO_LINUX)
+	pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+#endif
+	pthread_cond_init(&client_context->queue_cond, &cond_attr);
+	pthread_condattr_destroy(&cond_attr);
 	client->client_context = client_context;
 	client->is_remote = input == ouput;
 	return client;
 }
 
+indigo_client *indigo_xml_device_adapter(int input, int ouput) {
+	indigo_client *client = create_adapter(input, ouput);
+	xml_adapter_context *client_context = (xml_adapter_context *)client->client_context;
+	client_context->running = true;
+	if (pthread_create(&client_context->writer_thread, NULL, (void *(*)(void *))writer_thread, client_context) != 0) {
+		indigo_error("XML adapter: can't create writer thread (%s)", strerror(errno));
+		client_context->running = false;
+	}
+	return client;
+}
+
+indigo_client *indigo_xml_device_adapter_async(int input, int ouput, indigo_xml_output_callback callback, void *data) {
+	assert(callback != NULL);
+	indigo_client *client = create_adapter(input, ouput);
+	xml_adapter_context *client_context = (xml_adapter_context *)client->client_context;
+	client_context->output_callback = callback;
+	client_context->output_callback_data = data;
+	// output is always socket written by sendmsg(), input may be its duplicate closed by parser
+	client->is_remote = true;
+	return client;
+}
+
+/** Write output left in asynchronous adapter on caller thread, owner doesn't flush it anymore.
+ */
+static void drain_async_adapter(indigo_client *client) {
+	xml_adapter_context *client_context = (xml_adapter_context *)client->client_context;
+	struct timespec now, deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += DRAIN_TIMEOUT;
+	while (indigo_xml_device_adapter_flush(client)) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		long timeout = (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+		if (timeout <= 0 || !wait_writable(client_context->context.output, (int)timeout)) {
+			pthread_mutex_lock(&client_context->queue_mutex);
+			INDIGO_DEBUG_PROTOCOL(indigo_debug("XML adapter: output of %d not drained in %ds, %d message(s) discarded", client_context->context.output, DRAIN_TIMEOUT, client_context->count + client_context->sending_count - client_context->sending_index));
+			client_context->failed = true;
+			message_discard_queue(client_context);
+			discard_pending(client_context);
+			pthread_mutex_unlock(&client_context->queue_mutex);
+			break;
+		}
+	}
+}
+
 void indigo_release_xml_device_adapter(indigo_client *client) {
 	assert(client != NULL);
 	assert(client->client_context != NULL);
-	free(client->client_context);
+	xml_adapter_context *client_context = (xml_adapter_context *)client->client_context;
+	if (client_context->output_callback != NULL)
+		drain_async_adapter(client);
+	pthread_mutex_lock(&client_context->queue_mutex);
+	bool running = client_context->running;
+	client_context->running = false;
+	pthread_cond_broadcast(&client_context->queue_cond);
+	if (running) {
+		// messages accepted before disconnect (last deletions and messages) are still delivered unless write fails or takes too long
+		struct timespec deadline;
+#if defined(INDIGO_LINUX)
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+#else
+		clock_gettime(CLOCK_REALTIME, &deadline);
+#endif
+		deadline.tv_sec += DRAIN_TIMEOUT;
+		while (!client_context->finished) {
+			if (pthread_cond_timedwait(&client_context->queue_cond, &client_context->queue_mutex, &deadline) == ETIMEDOUT) {
+				INDIGO_DEBUG_PROTOCOL(indigo_debug("XML adapter: output of %d not drained in %ds, %d message(s) discarded", client_context->context.output, DRAIN_TIMEOUT, client_context->count));
+				client_context->failed = true;
+				message_discard_queue(client_context);
+#if defined(INDIGO_WINDOWS)
+				shutdown(client_context->context.output, SD_BOTH);
+#else
+				shutdown(client_context->context.output, SHUT_RDWR);
+#endif
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&client_context->queue_mutex);
+	if (running)
+		pthread_join(client_context->writer_thread, NULL);
+	message_discard_queue(client_context);
+	if (client_context->dropped)
+		INDIGO_DEBUG_PROTOCOL(indigo_debug("XML adapter: %ld update(s) coalesced or dropped", client_context->dropped));
+	pthread_cond_destroy(&client_context->queue_cond);
+	pthread_mutex_destroy(&client_context->queue_mutex);
+	free(client_context);
 	free(client);
 }
 
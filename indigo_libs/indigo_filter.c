@@ -41,12 +41,72 @@ static char *property_name_prefix[INDIGO_FILTER_LIST_COUNT] = { "CCD_", "WHEEL_"
 static int property_name_prefix_len[INDIGO_FILTER_LIST_COUNT] = { 4, 6, 8, 6, 7, 5, 4, 9, 6, 6, 6, 6 };
 static char *property_name_label[INDIGO_FILTER_LIST_COUNT] = { "CCD ", "Wheel ", "Focuser ", "Mount ", "Guider ", "Dome ", "GPS ", "Joystick", "AUX #1 ", "AUX #2 ", "AUX #3 ", "AUX #4 " };
 
+// Property cache slots never move, hash chains only index them by (device, name)
+
+static unsigned cache_hash(const char *device, const char *name) {
+	unsigned hash = 2166136261u;
+	while (*device)
+		hash = (hash ^ (unsigned char)*device++) * 16777619u;
+	hash = (hash ^ '/') * 16777619u;
+	while (*name)
+		hash = (hash ^ (unsigned char)*name++) * 16777619u;
+	return hash & (INDIGO_FILTER_CACHE_HASH_SIZE - 1);
+}
+
+static int cache_find(indigo_property **cache, int *hash, int *next, const char *device, const char *name) {
+	for (int slot = hash[cache_hash(device, name)]; slot; slot = next[slot - 1]) {
+		indigo_property *property = cache[slot - 1];
+		if (!strcmp(property->name, name) && !strcmp(property->device, device))
+			return slot - 1;
+	}
+	return -1;
+}
+
+static void cache_link(indigo_property **cache, int *hash, int *next, int slot) {
+	int *head = hash + cache_hash(cache[slot]->device, cache[slot]->name);
+	next[slot] = *head;
+	*head = slot + 1;
+}
+
+static void cache_unlink(indigo_property **cache, int *hash, int *next, int slot) {
+	int *link = hash + cache_hash(cache[slot]->device, cache[slot]->name);
+	while (*link) {
+		if (*link == slot + 1) {
+			*link = next[slot];
+			break;
+		}
+		link = next + *link - 1;
+	}
+	next[slot] = 0;
+}
+
+static void cache_remove(indigo_device *device, int slot, const char *message) {
+	indigo_property **device_cache = FILTER_DEVICE_CONTEXT->device_property_cache;
+	indigo_property **agent_cache = FILTER_DEVICE_CONTEXT->agent_property_cache;
+	cache_unlink(device_cache, FILTER_DEVICE_CONTEXT->device_property_hash, FILTER_DEVICE_CONTEXT->device_property_next, slot);
+	device_cache[slot] = NULL;
+	if (agent_cache[slot]) {
+		cache_unlink(agent_cache, FILTER_DEVICE_CONTEXT->agent_property_hash, FILTER_DEVICE_CONTEXT->agent_property_next, slot);
+		indigo_delete_property(device, agent_cache[slot], message);
+		indigo_release_property(agent_cache[slot]);
+		agent_cache[slot] = NULL;
+	}
+}
+
 indigo_result indigo_filter_device_attach(indigo_device *device, unsigned version, indigo_device_interface device_interface) {
 	assert(device != NULL);
 	if (FILTER_DEVICE_CONTEXT == NULL) {
 		device->device_context = malloc(sizeof(indigo_filter_context));
 		assert(device->device_context);
 		memset(device->device_context, 0, sizeof(indigo_filter_context));
+		pthread_mutex_init(&FILTER_DEVICE_CONTEXT->update_mutex, NULL);
+		pthread_condattr_t cond_attr;
+		pthread_condattr_init(&cond_attr);
+#ifdef INDIGO_LINUX
+		pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+#endif
+		pthread_cond_init(&FILTER_DEVICE_CONTEXT->update_cond, &cond_attr);
+		pthread_condattr_destroy(&cond_attr);
 	}
 	FILTER_DEVICE_CONTEXT->device = device;
 	if (FILTER_DEVICE_CONTEXT != NULL) {
@@ -277,17 +337,10 @@ static indigo_result update_device_list(indigo_device *device, indigo_client *cl
 			device_list->items[i].sw.value = false;
 			strcpy(connection_property->device, device_list->items[i].name);
 			indigo_property **device_cache = FILTER_DEVICE_CONTEXT->device_property_cache;
-			indigo_property **agent_cache = FILTER_DEVICE_CONTEXT->agent_property_cache;
 			for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
 				indigo_property *device_property = device_cache[i];
-				if (device_property && !strcmp(connection_property->device, device_property->device)) {
-					device_cache[i] = NULL;
-					if (agent_cache[i]) {
-						indigo_delete_property(device, agent_cache[i], NULL);
-						indigo_release_property(agent_cache[i]);
-						agent_cache[i] = NULL;
-					}
-				}
+				if (device_property && !strcmp(connection_property->device, device_property->device))
+					cache_remove(device, i, NULL);
 			}
 			indigo_init_switch_item(connection_property->items, CONNECTION_DISCONNECTED_ITEM_NAME, NULL, true);
 			connection_property->access_token = indigo_get_device_or_master_token(connection_property->device);
@@ -371,10 +424,7 @@ static indigo_result update_related_agent_list(indigo_device *device, indigo_pro
 	return INDIGO_OK;
 }
 
-indigo_result indigo_filter_change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
-	assert(device != NULL);
-	assert(DEVICE_CONTEXT != NULL);
-	assert(property != NULL);
+static indigo_result filter_change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
 	for (int i = 0; i < INDIGO_FILTER_LIST_COUNT; i++) {
 		indigo_property *device_list = FILTER_DEVICE_CONTEXT->filter_device_list_properties[i];
 		if (indigo_property_match(device_list, property))
@@ -385,23 +435,29 @@ indigo_result indigo_filter_change_property(indigo_device *device, indigo_client
 	}
 	if (indigo_property_match(FILTER_DEVICE_CONTEXT->filter_related_agent_list_property, property))
 		return update_related_agent_list(device, property);
-	indigo_property **agent_cache = FILTER_DEVICE_CONTEXT->agent_property_cache;
-	for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
-		if (agent_cache[i] && indigo_property_match(agent_cache[i], property)) {
-			int size = sizeof(indigo_property) + property->count * sizeof(indigo_item);
-			indigo_property *copy = (indigo_property *)malloc(size);
-			memcpy(copy, property, size);
-			strcpy(copy->device, FILTER_DEVICE_CONTEXT->device_property_cache[i]->device);
-			strcpy(copy->name, FILTER_DEVICE_CONTEXT->device_property_cache[i]->name);
-			copy->access_token = indigo_get_device_or_master_token(copy->device);
-			indigo_change_property(client, copy);
-			indigo_release_property(copy);
-			return INDIGO_OK;
-		}
+	int i = cache_find(FILTER_DEVICE_CONTEXT->agent_property_cache, FILTER_DEVICE_CONTEXT->agent_property_hash, FILTER_DEVICE_CONTEXT->agent_property_next, property->device, property->name);
+	if (i >= 0) {
+		indigo_property *copy = indigo_copy_property(NULL, property);
+		strcpy(copy->device, FILTER_DEVICE_CONTEXT->device_property_cache[i]->device);
+		strcpy(copy->name, FILTER_DEVICE_CONTEXT->device_property_cache[i]->name);
+		copy->access_token = indigo_get_device_or_master_token(copy->device);
+		indigo_change_property(client, copy);
+		indigo_release_property(copy);
+		return INDIGO_OK;
 	}
 	return indigo_device_change_property(device, client, property);
 }
 
+indigo_result indigo_filter_change_property(indigo_device *device, indigo_client *client, indigo_property *property) {
+	assert(device != NULL);
+	assert(DEVICE_CONTEXT != NULL);
+	assert(property != NULL);
+	indigo_result result = filter_change_property(device, client, property);
+	/* waiters are woken only after the change is applied, so they can't miss it */
+	indigo_filter_notify(device);
+	return result;
+}
+
 indigo_result indigo_filter_device_detach(indigo_device *device) {
 	assert(device != NULL);
 	for (int i = 0; i < INDIGO_FILTER_LIST_COUNT; i++) {
@@ -409,6 +465,8 @@ indigo_result indigo_filter_device_detach(indigo_device *device) {
 		indigo_release_property(FILTER_DEVICE_CONTEXT->filter_related_device_list_properties[i]);
 	}
 	indigo_release_property(FILTER_DEVICE_CONTEXT->filter_related_agent_list_property);
+	pthread_cond_destroy(&FILTER_DEVICE_CONTEXT->update_cond);
+	pthread_mutex_destroy(&FILTER_DEVICE_CONTEXT->update_mutex);
 	return indigo_device_detach(device);
 }
 
@@ -417,11 +475,15 @@ indigo_result indigo_filter_client_attach(indigo_client *client) {
 	assert (FILTER_CLIENT_CONTEXT != NULL);
 	FILTER_CLIENT_CONTEXT->client = client;
 	indigo_property **device_cache = FILTER_CLIENT_CONTEXT->device_property_cache;
-	indigo_property **agent_cache = FILTER_CLIENT_CONTEXT->device_property_cache;
+	indigo_property **agent_cache = FILTER_CLIENT_CONTEXT->agent_property_cache;
 	for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
 		device_cache[i] = NULL;
 		agent_cache[i] = NULL;
 	}
+	memset(FILTER_CLIENT_CONTEXT->device_property_hash, 0, sizeof(FILTER_CLIENT_CONTEXT->device_property_hash));
+	memset(FILTER_CLIENT_CONTEXT->device_property_next, 0, sizeof(FILTER_CLIENT_CONTEXT->device_property_next));
+	memset(FILTER_CLIENT_CONTEXT->agent_property_hash, 0, sizeof(FILTER_CLIENT_CONTEXT->agent_property_hash));
+	memset(FILTER_CLIENT_CONTEXT->agent_property_next, 0, sizeof(FILTER_CLIENT_CONTEXT->agent_property_next));
 	indigo_property all_properties;
 	memset(&all_properties, 0, sizeof(all_properties));
 	indigo_enumerate_properties(client, &all_properties);
@@ -533,20 +595,17 @@ indigo_result indigo_filter_define_property(indigo_client *client, indigo_device
 			int name_prefix_length = property_name_prefix_len[i];
 			if (strcmp(property->device, FILTER_CLIENT_CONTEXT->device_name[i]))
 				continue;
-			bool found = false;
-			for (int j = 0; j < INDIGO_FILTER_MAX_CACHED_PROPERTIES; j++) {
-				if (device_cache[j] == property) {
-					found = true;
-					break;
-				}
+			int cached = cache_find(device_cache, FILTER_CLIENT_CONTEXT->device_property_hash, FILTER_CLIENT_CONTEXT->device_property_next, property->device, property->name);
+			if (cached >= 0 && device_cache[cached] != property) {
+				cache_remove(device, cached, NULL);
+				cached = -1;
 			}
-			if (!found) {
+			if (cached < 0) {
 				for (int j = 0; j < INDIGO_FILTER_MAX_CACHED_PROPERTIES; j++) {
 					if (device_cache[j] == NULL) {
 						device_cache[j] = property;
-						int size = sizeof(indigo_property) + property->count * sizeof(indigo_item);
-						indigo_property *copy = (indigo_property *)malloc(size);
-						memcpy(copy, property, size);
+						cache_link(device_cache, FILTER_CLIENT_CONTEXT->device_property_hash, FILTER_CLIENT_CONTEXT->device_property_next, j);
+						indigo_property *copy = indigo_copy_property(NULL, property);
 						strcpy(copy->device, device->name);
 						bool translate = strncmp(name_prefix, copy->name, name_prefix_length);
 						if (translate && !strcmp(name_prefix, "CCD_") && !strncmp(copy->name, "DSLR_", 5))
@@ -558,6 +617,7 @@ indigo_result indigo_filter_define_property(indigo_client *client, indigo_device
 							strcat(copy->label, property->label);
 						}
 						agent_cache[j] = copy;
+						cache_link(agent_cache, FILTER_CLIENT_CONTEXT->agent_property_hash, FILTER_CLIENT_CONTEXT->agent_property_next, j);
 						indigo_define_property(device, copy, message);
 						break;
 					}
@@ -569,10 +629,7 @@ indigo_result indigo_filter_define_property(indigo_client *client, indigo_device
 	return INDIGO_OK;
 }
 
-indigo_result indigo_filter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
-	if (device == FILTER_CLIENT_CONTEXT->device)
-		return INDIGO_OK;
-	device = FILTER_CLIENT_CONTEXT->device;
+static indigo_result filter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
 	indigo_property **device_cache = FILTER_CLIENT_CONTEXT->device_property_cache;
 	indigo_property **agent_cache = FILTER_CLIENT_CONTEXT->agent_property_cache;
 	for (int i = 0; i < INDIGO_FILTER_LIST_COUNT; i++) {
@@ -612,21 +669,27 @@ indigo_result indigo_filter_update_property(indigo_client *client, indigo_device
 		} else {
 			if (strcmp(property->device, FILTER_CLIENT_CONTEXT->device_name[i]))
 				continue;
-			for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
-				if (device_cache[i] == property) {
-					if (agent_cache[i]) {
-						memcpy(agent_cache[i]->items, device_cache[i]->items, device_cache[i]->count * sizeof(indigo_item));
-						agent_cache[i]->state = device_cache[i]->state;
-						indigo_update_property(device, agent_cache[i], message);
-					}
-					return INDIGO_OK;
-				}
+			int cached = cache_find(device_cache, FILTER_CLIENT_CONTEXT->device_property_hash, FILTER_CLIENT_CONTEXT->device_property_next, property->device, property->name);
+			if (cached >= 0 && device_cache[cached] == property && agent_cache[cached]) {
+				indigo_property_copy_items(agent_cache[cached], property);
+				agent_cache[cached]->state = property->state;
+				indigo_update_property(device, agent_cache[cached], message);
 			}
+			return INDIGO_OK;
 		}
 	}
 	return INDIGO_OK;
 }
 
+indigo_result indigo_filter_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	if (device == FILTER_CLIENT_CONTEXT->device)
+		return INDIGO_OK;
+	device = FILTER_CLIENT_CONTEXT->device;
+	indigo_result result = filter_update_property(client, device, property, message);
+	indigo_filter_notify(device);
+	return result;
+}
+
 static void remove_from_list(indigo_device *device, indigo_property *device_list, indigo_property *property, char *device_name) {
 	for (int i = 1; i < device_list->count; i++) {
 		if (!strcmp(property->device, device_list->items[i].name)) {
@@ -653,7 +716,6 @@ indigo_result indigo_filter_delete_property(indigo_client *client, indigo_device
 		return INDIGO_OK;
 	device = FILTER_CLIENT_CONTEXT->device;
 	indigo_property **device_cache = FILTER_CLIENT_CONTEXT->device_property_cache;
-	indigo_property **agent_cache = FILTER_CLIENT_CONTEXT->agent_property_cache;
 	if (*property->name == 0 || !strcmp(property->name, CONNECTION_PROPERTY_NAME)) {
 		for (int i = 0; i < INDIGO_FILTER_MAX_DEVICES; i++) {
 			if (FILTER_CLIENT_CONTEXT->connection_property_cache[i] == property) {
@@ -663,27 +725,13 @@ indigo_result indigo_filter_delete_property(indigo_client *client, indigo_device
 		}
 	}
 	if (*property->name) {
-		for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
-			if (device_cache[i] == property) {
-				device_cache[i] = NULL;
-				if (agent_cache[i]) {
-					indigo_delete_property(device, agent_cache[i], NULL);
-					indigo_release_property(agent_cache[i]);
-					agent_cache[i] = NULL;
-				}
-				break;
-			}
-		}
+		int cached = cache_find(device_cache, FILTER_CLIENT_CONTEXT->device_property_hash, FILTER_CLIENT_CONTEXT->device_property_next, property->device, property->name);
+		if (cached >= 0 && device_cache[cached] == property)
+			cache_remove(device, cached, NULL);
 	} else {
 		for (int i = 0; i < INDIGO_FILTER_MAX_CACHED_PROPERTIES; i++) {
-			if (device_cache[i] && !strcmp(device_cache[i]->device, property->device)) {
-				device_cache[i] = NULL;
-				if (agent_cache[i]) {
-					indigo_delete_property(device, agent_cache[i], message);
-					indigo_release_property(agent_cache[i]);
-					agent_cache[i] = NULL;
-				}
-			}
+			if (device_cache[i] && !strcmp(device_cache[i]->device, property->device))
+				cache_remove(device, i, message);
 		}
 	}
 	if (*property->name == 0 || !strcmp(property->name, INFO_PROPERTY_NAME)) {
@@ -707,22 +755,12 @@ indigo_result indigo_filter_client_detach(indigo_client *client) {
 
 indigo_property *indigo_filter_cached_property(indigo_device *device, int index, char *name) {
 	indigo_property **cache = FILTER_DEVICE_CONTEXT->device_property_cache;
-	char *device_name = FILTER_DEVICE_CONTEXT->device_name[index];
-	indigo_property *property;
-	for (int j = 0; j < INDIGO_FILTER_MAX_CACHED_PROPERTIES; j++) {
-		if ((property = cache[j])) {
-			if (!strcmp(property->device, device_name) && !strcmp(property->name, name)) {
-				return cache[j];
-			}
-		}
-	}
-	return NULL;
+	int slot = cache_find(cache, FILTER_DEVICE_CONTEXT->device_property_hash, FILTER_DEVICE_CONTEXT->device_property_next, FILTER_DEVICE_CONTEXT->device_name[index], name);
+	return slot < 0 ? NULL : cache[slot];
 }
 
 indigo_result indigo_filter_forward_change_property(indigo_client *client, indigo_property *property, char *device_name) {
-	int size = sizeof(indigo_property) + property->count * (sizeof(indigo_item));
-	indigo_property *local_property = malloc(size);
-	memcpy(local_property, property, size);
+	indigo_property *local_property = indigo_copy_property(NULL, property);
 	strcpy(local_property->device, device_name);
 	local_property->access_token = indigo_get_device_or_master_token(local_property->device);
 	property->perm = INDIGO_RW_PERM;
@@ -730,3 +768,36 @@ indigo_result indigo_filter_forward_change_property(indigo_client *client, indig
 	free(local_property);
 	return result;
 }
+
+bool indigo_filter_wait(indigo_device *device, bool (*condition)(indigo_device *device, void *data), void *data, double timeout) {
+	struct timespec deadline;
+#ifdef INDIGO_LINUX
+	/* update_cond runs on monotonic clock, so wall clock steps don't stretch or cut the wait */
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+#else
+	clock_gettime(CLOCK_REALTIME, &deadline);
+#endif
+	deadline.tv_sec += (time_t)timeout;
+	deadline.tv_nsec += (long)((timeout - floor(timeout)) * 1e9);
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	/* condition is checked under the lock notifier takes, so no update can slip in between check and wait */
+	pthread_mutex_lock(&FILTER_DEVICE_CONTEXT->update_mutex);
+	bool result;
+	while (!(result = condition(device, data))) {
+		if (pthread_cond_timedwait(&FILTER_DEVICE_CONTEXT->update_cond, &FILTER_DEVICE_CONTEXT->update_mutex, &deadline) == ETIMEDOUT) {
+			result = condition(device, data);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&FILTER_DEVICE_CONTEXT->update_mutex);
+	return result;
+}
+
+void indigo_filter_notify(indigo_device *device) {
+	pthread_mutex_lock(&FILTER_DEVICE_CONTEXT->update_mutex);
+	pthread_cond_broadcast(&FILTER_DEVICE_CONTEXT->update_cond);
+	pthread_mutex_unlock(&FILTER_DEVICE_CONTEXT->update_mutex);
+}
@@ -10,8 +10,13 @@
 //
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <indigo/indigo_bus.h>
 #include <indigo/indigo_ccd_driver.h>
@@ -33,108 +38,194 @@ static int median(int a, int b, int c) {
 	}
 }
 
-static void _fft(const int n, const int offset, const int delta, const double (*x)[2], double (*X)[2], double (*_X)[2]);
+/* Luminance of count pixels of row y starting at x0, RGB pixels are summed */
 
-static void fft(const int n, const double (*x)[2], double (*X)[2]) {
-	double (*_X)[2] = malloc(2 * n * sizeof(double));
-	_fft(n, 0, 1, x, X, _X);
-	free(_X);
+static void raw_row(indigo_raw_type raw_type, const void *data, const int width, const int y, const int x0, const int count, int *row) {
+	switch (raw_type) {
+		case INDIGO_RAW_MONO8: {
+			const uint8_t *data8 = (const uint8_t *)data + (long)y * width + x0;
+			for (int i = 0; i < count; i++)
+				row[i] = data8[i];
+			break;
+		}
+		case INDIGO_RAW_MONO16: {
+			const uint16_t *data16 = (const uint16_t *)data + (long)y * width + x0;
+			for (int i = 0; i < count; i++)
+				row[i] = data16[i];
+			break;
+		}
+		case INDIGO_RAW_RGB24: {
+			const uint8_t *data8 = (const uint8_t *)data + 3L * ((long)y * width + x0);
+			for (int i = 0; i < count; i++, data8 += 3)
+				row[i] = data8[0] + data8[1] + data8[2];
+			break;
+		}
+		case INDIGO_RAW_RGB48: {
+			const uint16_t *data16 = (const uint16_t *)data + 3L * ((long)y * width + x0);
+			for (int i = 0; i < count; i++, data16 += 3)
+				row[i] = data16[0] + data16[1] + data16[2];
+			break;
+		}
+	}
 }
 
-static void _fft(const int n, const int offset, const int delta, const double (*x)[2], double (*X)[2], double (*_X)[2]) {
-	int n2 = n / 2;
-	int k;
-	double ccos, csin;
-	int k00, k01, k10, k11;
-	double tmp0, tmp1;
-	if (n != 2) {
-		_fft(n2, offset, 2 * delta, x, _X, X);
-		_fft(n2, offset + delta, 2 * delta, x, _X, X);
-		for (k = 0; k < n2; k++) {
-			k00 = offset + k * delta;
-			k01 = k00 + n2 * delta;
-			k10 = offset + 2 * k * delta;
-			k11 = k10 + delta;
-			ccos = cos(PI_2 * k / (double)n);
-			csin = sin(PI_2 * k / (double)n);
-			tmp0 = ccos * _X[k11][RE] + csin * _X[k11][IM];
-			tmp1 = ccos * _X[k11][IM] - csin * _X[k11][RE];
-			X[k01][RE] = _X[k10][RE] - tmp0;
-			X[k01][IM] = _X[k10][IM] - tmp1;
-			X[k00][RE] = _X[k10][RE] + tmp0;
-			X[k00][IM] = _X[k10][IM] + tmp1;
+/* FFT plans are cached per size, plan is immutable once created and shared by all digests */
+
+typedef struct {
+	int n;                   /* complex transform size, real input size is 2 * n */
+	int *bit_reverse;
+	double (*twiddle)[2];    /* exp(-2 pi i k / n) for k < n / 2 */
+	double (*split)[2];      /* exp(-2 pi i k / 2n) for k < n, real input split */
+} fft_plan;
+
+#define FFT_MAX_PLANS	32
+
+static fft_plan *fft_plans[FFT_MAX_PLANS];
+static pthread_mutex_t fft_plans_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const fft_plan *fft_get_plan(const int size) {
+	int log2n = 0;
+	while ((1 << log2n) < size)
+		log2n++;
+	pthread_mutex_lock(&fft_plans_mutex);
+	fft_plan *plan = fft_plans[log2n];
+	if (plan == NULL) {
+		int n = size / 2, bits = log2n - 1;
+		plan = malloc(sizeof(fft_plan));
+		plan->n = n;
+		plan->bit_reverse = malloc(n * sizeof(int));
+		plan->twiddle = malloc(n / 2 * 2 * sizeof(double));
+		plan->split = malloc(n * 2 * sizeof(double));
+		for (int i = 0; i < n; i++) {
+			int r = 0;
+			for (int b = 0; b < bits; b++)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			plan->bit_reverse[i] = r;
+		}
+		for (int k = 0; k < n / 2; k++) {
+			plan->twiddle[k][RE] = cos(PI_2 * k / n);
+			plan->twiddle[k][IM] = -sin(PI_2 * k / n);
+		}
+		for (int k = 0; k < n; k++) {
+			plan->split[k][RE] = cos(PI_2 * k / size);
+			plan->split[k][IM] = -sin(PI_2 * k / size);
+		}
+		fft_plans[log2n] = plan;
+	}
+	pthread_mutex_unlock(&fft_plans_mutex);
+	return plan;
+}
+
+/* in-place iterative radix-2 complex FFT */
+static void fft_complex(const fft_plan *plan, double (*x)[2]) {
+	const int n = plan->n;
+	for (int i = 0; i < n; i++) {
+		int j = plan->bit_reverse[i];
+		if (i < j) {
+			double tmp0 = x[i][RE], tmp1 = x[i][IM];
+			x[i][RE] = x[j][RE];
+			x[i][IM] = x[j][IM];
+			x[j][RE] = tmp0;
+			x[j][IM] = tmp1;
+		}
+	}
+	for (int size = 2; size <= n; size <<= 1) {
+		const int half = size / 2, step = n / size;
+		for (int start = 0; start < n; start += size) {
+			double (*a)[2] = x + start;
+			double (*b)[2] = x + start + half;
+			for (int k = 0; k < half; k++) {
+				const double *w = plan->twiddle[k * step];
+				double tmp0 = w[RE] * b[k][RE] - w[IM] * b[k][IM];
+				double tmp1 = w[RE] * b[k][IM] + w[IM] * b[k][RE];
+				b[k][RE] = a[k][RE] - tmp0;
+				b[k][IM] = a[k][IM] - tmp1;
+				a[k][RE] += tmp0;
+				a[k][IM] += tmp1;
+			}
 		}
-	} else {
-		k00 = offset;
-		k01 = k00 + delta;
-		X[k01][RE] = x[k00][RE] - x[k01][RE];
-		X[k01][IM] = x[k00][IM] - x[k01][IM];
-		X[k00][RE] = x[k00][RE] + x[k01][RE];
-		X[k00][IM] = x[k00][IM] + x[k01][IM];
 	}
 }
 
-static void ifft(const int n, const double (*X)[2], double (*x)[2]) {
-	int n2 = n / 2;
-	int i;
-	double tmp0, tmp1;
-	fft(n, X, x);
-	x[0][RE] = x[0][RE] / n;
-	x[0][IM] = x[0][IM] / n;
-	x[n2][RE] = x[n2][RE] / n;
-	x[n2][IM] = x[n2][IM] / n;
-	for (i = 1; i < n2; i++) {
-		tmp0 = x[i][RE] / n;
-		tmp1 = x[i][IM] / n;
-		x[i][RE] = x[n-i][RE] / n;
-		x[i][IM] = x[n-i][IM] / n;
-		x[n-i][RE] = tmp0;
-		x[n-i][IM] = tmp1;
+/* FFT of real vector x of size 2n via complex FFT of size n, X gets full (hermitian) spectrum of size 2n */
+static void fft_real(const fft_plan *plan, const double *x, double (*X)[2]) {
+	const int n = plan->n, size = 2 * n;
+	for (int k = 0; k < n; k++) {
+		X[k][RE] = x[2 * k];
+		X[k][IM] = x[2 * k + 1];
+	}
+	fft_complex(plan, X);
+	double z0 = X[0][RE], z1 = X[0][IM];
+	X[0][RE] = z0 + z1;
+	X[0][IM] = 0;
+	X[n][RE] = z0 - z1;
+	X[n][IM] = 0;
+	for (int k = 1; k <= n / 2; k++) {
+		int m = n - k;
+		/* even and odd part spectra */
+		double e_re = (X[k][RE] + X[m][RE]) / 2, e_im = (X[k][IM] - X[m][IM]) / 2;
+		double o_re = (X[k][IM] + X[m][IM]) / 2, o_im = (X[m][RE] - X[k][RE]) / 2;
+		const double *wk = plan->split[k], *wm = plan->split[m];
+		X[k][RE] = e_re + wk[RE] * o_re - wk[IM] * o_im;
+		X[k][IM] = e_im + wk[RE] * o_im + wk[IM] * o_re;
+		X[m][RE] = e_re + wm[RE] * o_re + wm[IM] * o_im;
+		X[m][IM] = -e_im + wm[IM] * o_re - wm[RE] * o_im;
+	}
+	for (int k = 1; k < n; k++) {
+		X[size - k][RE] = X[k][RE];
+		X[size - k][IM] = -X[k][IM];
+	}
+}
+
+/* inverse FFT of hermitian spectrum X of size 2n to real vector x, X is used as workspace */
+static void ifft_real(const fft_plan *plan, double (*X)[2], double *x) {
+	const int n = plan->n;
+	for (int k = 0; k < n; k++) {
+		const double *w = plan->split[k];
+		double e_re = (X[k][RE] + X[k + n][RE]) / 2, e_im = (X[k][IM] + X[k + n][IM]) / 2;
+		double d_re = (X[k][RE] - X[k + n][RE]) / 2, d_im = (X[k][IM] - X[k + n][IM]) / 2;
+		/* odd part spectrum is difference multiplied by conjugate twiddle, Z = E + iO is conjugated for forward FFT */
+		double o_re = d_re * w[RE] + d_im * w[IM], o_im = d_im * w[RE] - d_re * w[IM];
+		X[k][RE] = e_re - o_im;
+		X[k][IM] = -(e_im + o_re);
+	}
+	fft_complex(plan, X);
+	for (int k = 0; k < n; k++) {
+		x[2 * k] = X[k][RE] / n;
+		x[2 * k + 1] = -X[k][IM] / n;
 	}
 }
 
-static void corellate_fft(const int n, const double (*X1)[2], const double (*X2)[2], double (*c)[2]) {
-	int i;
-	double (*C)[2] = malloc(2 * n * sizeof(double));
-	/* pointwise multiply X1 conjugate with X2 here, store in X1 */
-	for (i = 0; i < n; i++) {
+static void corellate_fft(const fft_plan *plan, const double (*X1)[2], const double (*X2)[2], double (*C)[2], double *c) {
+	const int size = 2 * plan->n;
+	/* pointwise multiply X1 conjugate with X2 here */
+	for (int i = 0; i < size; i++) {
 		C[i][RE] = X1[i][RE] * X2[i][RE] + X1[i][IM] * X2[i][IM];
 		C[i][IM] = X1[i][IM] * X2[i][RE] - X1[i][RE] * X2[i][IM];
 	}
-	ifft(n, C, c);
-	free(C);
+	ifft_real(plan, C, c);
 }
 
-static double find_distance(const int n, const double (*c)[2]) {
-	int i;
+static double find_distance(const int n, const double *c) {
 	const int n2 = n / 2;
-	int max=0;
-	int prev, next;
-	for (i = 0; i < n; i++) {
-		max = (c[i][0] > c[max][0]) ? i : max;
-	}
-	/* find previous and next positions to calculate quadratic interpolation */
-	if ((max == 0) || (max == n2)) {
-		prev = n - 1;
-		next = 1;
-	} else if (max == (n-1)) {
-		prev = n - 2;
-		next = 0;
-	} else {
-		prev = max - 1;
-		next = max + 1;
+	int max = 0;
+	for (int i = 0; i < n; i++) {
+		max = (c[i] > c[max]) ? i : max;
 	}
+	/* correlation is circular, neighbours of the maximum wrap around */
+	int prev = (max + n - 1) % n;
+	int next = (max + 1) % n;
 	/* find subpixel offset of the maximum position using quadratic interpolation */
-	double max_subp = (c[next][RE] - c[prev][RE]) / (2 * (2 * c[max][RE] - c[next][RE] - c[prev][RE]));
-//	INDIGO_DEBUG(indigo_debug("max_subp = %5.2f max: %d -> %5.2f %5.2f %5.2f\n", max_subp, max, c[prev][0], c[max][0], c[next][0]));
+	double max_subp = 0;
+	double denominator = 2 * (2 * c[max] - c[next] - c[prev]);
+	if (denominator > 0)
+		max_subp = (c[next] - c[prev]) / denominator;
 	if (max == n2) {
 		return max_subp;
 	} else if (max > n2) {
 		return (double)((max - n) + max_subp);
-	} else if (max < n2) {
+	} else {
 		return (double)(max + max_subp);
-	} else { /* should not be reached */
-		return 0;
 	}
 }
 
@@ -420,53 +511,27 @@ indigo_result indigo_selection_frame_digest(indigo_raw_type raw_type, const void
 	return INDIGO_OK;
 }
 
-indigo_result indigo_centroid_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, indigo_frame_digest *c) {
-	if ((width < 3) || (height < 3))
+static indigo_result centroid_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, const int roi_x, const int roi_y, const int roi_width, const int roi_height, const bool subtract_background, indigo_frame_digest *c) {
+	if ((roi_width < 3) || (roi_height < 3))
+		return INDIGO_FAILED;
+	if ((roi_x < 0) || (roi_y < 0) || (roi_x + roi_width > width) || (roi_y + roi_height > height))
 		return INDIGO_FAILED;
 	if ((data == NULL) || (c == NULL))
 		return INDIGO_FAILED;
 
-	uint8_t *data8 = (uint8_t *)data;
-	uint16_t *data16 = (uint16_t *)data;
-
+	/* the window is read once into luminance rows, both passes work on them */
+	int size = roi_width * roi_height;
+	int *pixels = malloc(size * sizeof(int));
 	double m10 = 0, m01 = 0, m00 = 0;
-	int ci = 0, li = 0, size = width * height;
 	double sum = 0, max = 0;
 	double value;
-	switch (raw_type) {
-		case INDIGO_RAW_MONO8: {
-			for (int i = 0; i < size; i++) {
-				value = data8[i];
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
-		}
-		case INDIGO_RAW_MONO16: {
-			for (int i = 0; i < size; i++) {
-				value = data16[i];
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB24: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data8[i] + data8[i + 1] + data8[i + 2];
-				i += 2;
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB48: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data16[i] + data16[i + 1] + data16[i + 2];
-				i += 2;
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
+	for (int j = 0; j < roi_height; j++) {
+		int *row = pixels + j * roi_width;
+		raw_row(raw_type, data, width, roi_y + j, roi_x, roi_width, row);
+		for (int i = 0; i < roi_width; i++) {
+			value = row[i];
+			sum += value;
+			if (value > max) max = value;
 		}
 	}
 
@@ -475,110 +540,82 @@ indigo_result indigo_centroid_frame_digest(indigo_raw_type raw_type, const void
 
 	INDIGO_DEBUG(indigo_log("Centroid threshold = %.3f, max = %.3f", threshold, max));
 
-	ci = 1; li = 1;
-	switch (raw_type) {
-		case INDIGO_RAW_MONO8: {
-			for (int i = 0; i < size; i++) {
-				value = data8[i];
-				m10 += ci * value;
-				m01 += li * value;
-				m00 += value;
-				ci++;
-				if (ci > width) {
-					ci = 1;
-					li++;
-				}
-			}
-			break;
-		}
-		case INDIGO_RAW_MONO16: {
-			for (int i = 0; i < size; i++) {
-				value = data16[i];
-				m10 += ci * value;
-				m01 += li * value;
-				m00 += value;
-				ci++;
-				if (ci > width) {
-					ci = 1;
-					li++;
-				}
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB24: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data8[i] + data8[i + 1] + data8[i + 2];
-				i += 2;
-				m10 += ci * value;
-				m01 += li * value;
-				m00 += value;
-				ci++;
-				if (ci > width) {
-					ci = 1;
-					li++;
-				}
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB48: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data16[i] + data16[i + 1] + data16[i + 2];
-				i += 2;
-				m10 += ci * value;
-				m01 += li * value;
-				m00 += value;
-				ci++;
-				if (ci > width) {
-					ci = 1;
-					li++;
-				}
+	/* Background is subtracted only for windows, otherwise it would pull the centroid to the window centre */
+	if (subtract_background && max <= threshold) {
+		free(pixels);
+		return INDIGO_GUIDE_ERROR;
+	}
+	for (int j = 0; j < roi_height; j++) {
+		int *row = pixels + j * roi_width;
+		for (int i = 0; i < roi_width; i++) {
+			value = row[i];
+			if (subtract_background) {
+				value -= threshold;
+				/* Set all values below the threshold to 0 */
+				if (value < 0) value = 0;
 			}
-			break;
+			m10 += (i + 1) * value;
+			m01 += (j + 1) * value;
+			m00 += value;
 		}
 	}
+	free(pixels);
 
-	c->width = width;
-	c->height = height;
-	/* Calculate centroid for the frame and subtract 0.5
+	if (m00 == 0)
+		return INDIGO_GUIDE_ERROR;
+
+	c->width = roi_width;
+	c->height = roi_height;
+	/* Calculate centroid for the window, add the offset and subtract 0.5
 	   as the centroid of a single pixel is 0.5,0.5 not 1,1.
 	*/
-	c->centroid_x = m10 / m00 - 0.5;
-	c->centroid_y = m01 / m00 - 0.5;
+	c->centroid_x = roi_x + m10 / m00 - 0.5;
+	c->centroid_y = roi_y + m01 / m00 - 0.5;
+	c->roi_x = roi_x;
+	c->roi_y = roi_y;
 	c->algorithm = centroid;
 	//INDIGO_DEBUG(indigo_debug("indigo_centroid_frame_digest: centroid = [%5.2f, %5.2f]", c->centroid_x, c->centroid_y));
 	return INDIGO_OK;
 }
 
+indigo_result indigo_centroid_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, indigo_frame_digest *c) {
+	return centroid_digest(raw_type, data, width, height, 0, 0, width, height, false, c);
+}
+
+indigo_result indigo_centroid_roi_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, const int roi_x, const int roi_y, const int roi_width, const int roi_height, indigo_frame_digest *c) {
+	return centroid_digest(raw_type, data, width, height, roi_x, roi_y, roi_width, roi_height, true, c);
+}
+
 #define BG_RADIUS	5
 
-static double calibrate_re(double (*vector)[2], int size) {
+static double calibrate_re(double *vector, int size) {
 	int first = BG_RADIUS + 1, last = size - BG_RADIUS - 1;
 	double avg = 0;
 	double mins[size];
 	for (int i = first; i <= last; i++) {
-		double min = vector[i - BG_RADIUS][RE];
+		double min = vector[i - BG_RADIUS];
 		for (int j = -BG_RADIUS + 1; j <= BG_RADIUS; j++) {
-			double value = vector[i + j][RE];
+			double value = vector[i + j];
 			if (value < min)
 				min = value;
 		}
 		mins[i] = min;
 	}
 	for (int i = 0; i < first; i++)
-		vector[i][RE] = 0;
+		vector[i] = 0;
 	for (int i = last + 1; i < size; i++)
-		vector[i][RE] = 0;
+		vector[i] = 0;
 	avg = 0;
 	int count = last - first + 1;
 	for (int i = first; i <= last; i++) {
-		double value = vector[i][RE] - mins[i];
-		vector[i][RE] = value;
+		double value = vector[i] - mins[i];
+		vector[i] = value;
 		avg += value;
 	}
 	avg /= count;
 	double stddev = 0;
 	for (int i = first; i <= last; i++) {
-		double value = vector[i][RE] - avg;
+		double value = vector[i] - avg;
 		stddev += value * value;
 	}
 	stddev /= count;
@@ -586,7 +623,7 @@ static double calibrate_re(double (*vector)[2], int size) {
 	double signal_ms = 0, noise_ms = 0;
 	int signal_count = 0, noise_count = 0;
 	for (int i = first; i <= last; i++) {
-		double value = vector[i][RE];
+		double value = vector[i];
 		if (value > threshold) {
 			signal_ms += value * value;
 			signal_count++;
@@ -602,50 +639,29 @@ static double calibrate_re(double (*vector)[2], int size) {
 }
 
 indigo_result indigo_donuts_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, indigo_frame_digest *c) {
-	if ((width < 3) || (height < 3))
+	return indigo_donuts_roi_frame_digest(raw_type, data, width, height, 0, 0, width, height, c);
+}
+
+indigo_result indigo_donuts_roi_frame_digest(indigo_raw_type raw_type, const void *data, const int width, const int height, const int roi_x, const int roi_y, const int roi_width, const int roi_height, indigo_frame_digest *c) {
+	if ((roi_width < 3) || (roi_height < 3))
+		return INDIGO_FAILED;
+	if ((roi_x < 0) || (roi_y < 0) || (roi_x + roi_width > width) || (roi_y + roi_height > height))
 		return INDIGO_FAILED;
 	if ((data == NULL) || (c == NULL))
 		return INDIGO_FAILED;
 
-	uint8_t *data8 = (uint8_t *)data;
-	uint16_t *data16 = (uint16_t *)data;
-	int size = width * height;
+	/* the window is read once into luminance rows, both passes work on them */
+	int size = roi_width * roi_height;
+	int *pixels = malloc(size * sizeof(int));
 	double sum = 0, max = 0;
 	double value;
-	switch (raw_type) {
-		case INDIGO_RAW_MONO8: {
-			for (int i = 0; i < size; i++) {
-				value = data8[i];
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
-		}
-		case INDIGO_RAW_MONO16: {
-			for (int i = 0; i < size; i++) {
-				value = data16[i];
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB24: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data8[i] + data8[i + 1] + data8[i + 2];
-				i += 2;
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB48: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data16[i] + data16[i + 1] + data16[i + 2];
-				i += 2;
-				sum += value;
-				if (value > max) max = value;
-			}
-			break;
+	for (int j = 0; j < roi_height; j++) {
+		int *row = pixels + j * roi_width;
+		raw_row(raw_type, data, width, roi_y + j, roi_x, roi_width, row);
+		for (int i = 0; i < roi_width; i++) {
+			value = row[i];
+			sum += value;
+			if (value > max) max = value;
 		}
 	}
 
@@ -655,118 +671,57 @@ indigo_result indigo_donuts_frame_digest(indigo_raw_type raw_type, const void *d
 	//INDIGO_DEBUG(indigo_log("Donuts threshold = %.3f, max = %.3f", threshold, max));
 
 	/* If max is below the thresold no guiding is possible */
-	if (max <= threshold) return INDIGO_GUIDE_ERROR;
+	if (max <= threshold) {
+		free(pixels);
+		return INDIGO_GUIDE_ERROR;
+	}
 
-	c->width = next_power_2(width);
-	c->height = next_power_2(height);
-	double (*col_x)[2] = calloc(2 * width * sizeof(double), 1);
-	double (*col_y)[2] = calloc(2 * height * sizeof(double), 1);
-	double (*fcol_x)[2] = calloc(2 * c->width * sizeof(double), 1);
-	double (*fcol_y)[2] = calloc(2 * c->height * sizeof(double), 1);
-	c->fft_x = malloc(2 * c->width * sizeof(double));
-	c->fft_y = malloc(2 * c->height * sizeof(double));
+	/* spectra are reused if digest of the same size is passed again */
+	if (c->algorithm != donuts || c->width != next_power_2(roi_width) || c->height != next_power_2(roi_height)) {
+		indigo_delete_frame_digest(c);
+		c->width = next_power_2(roi_width);
+		c->height = next_power_2(roi_height);
+		c->fft_x = malloc(2 * c->width * sizeof(double));
+		c->fft_y = malloc(2 * c->height * sizeof(double));
+	}
+	double *col_x = calloc(roi_width + roi_height + c->width + c->height, sizeof(double));
+	double *col_y = col_x + roi_width;
+	double *fcol_x = col_y + roi_height;
+	double *fcol_y = fcol_x + c->width;
 
-	int ci = 0, li = 0;
-	switch (raw_type) {
-		case INDIGO_RAW_MONO8: {
-			for (int i = 0; i < size; i++) {
-				value = data8[i] - threshold;
-				/* Set all values below the threshold to 0 */
-				if (value < 0) value = 0;
+	for (int j = 0; j < roi_height; j++) {
+		int *row = pixels + j * roi_width;
+		for (int i = 0; i < roi_width; i++) {
+			value = row[i] - threshold;
+			/* Set all values below the threshold to 0 */
+			if (value < 0) value = 0;
 
-				col_x[ci][RE] += value;
-				col_y[li][RE] += value;
-				ci++;
-				if (ci == width) {
-					ci = 0;
-					li++;
-				}
-			}
-			break;
+			col_x[i] += value;
+			col_y[j] += value;
 		}
-		case INDIGO_RAW_MONO16: {
-			for (int i = 0; i < size; i++) {
-				value = data16[i] - threshold;
-				/* Set all values below the threshold to 0 */
-				if (value < 0) value = 0;
-
-				col_x[ci][RE] += value;
-				col_y[li][RE] += value;
-				ci++;
-				if (ci == width) {
-					ci = 0;
-					li++;
-				}
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB24: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data8[i] + data8[i + 1] + data8[i + 2] - threshold;
-				i += 2;
-				/* Set all values below the threshold to 0 */
-				if (value < 0) value = 0;
+	}
+	free(pixels);
 
-				col_x[ci][RE] += value;
-				col_y[li][RE] += value;
-				ci++;
-				if (ci == width) {
-					ci = 0;
-					li++;
-				}
-			}
-			break;
-		}
-		case INDIGO_RAW_RGB48: {
-			for (int i = 0; i < 3 * size; i++) {
-				value = data16[i] + data16[i + 1] + data16[i + 2] - threshold;
-				i += 2;
-				/* Set all values below the threshold to 0 */
-				if (value < 0) value = 0;
+	/* Remove hot from the digest */
+	fcol_x[0] = median(0, col_x[0], col_x[1]);
+	for (int i = 1; i < roi_width - 1; i++) {
+		fcol_x[i] = median(col_x[i - 1], col_x[i], col_x[i + 1]);
+	}
+	fcol_x[roi_width - 1] = median(col_x[roi_width - 2], col_x[roi_width - 1], 0);
 
-				col_x[ci][RE] += value;
-				col_y[li][RE] += value;
-				ci++;
-				if (ci == width) {
-					ci = 0;
-					li++;
-				}
-			}
-			break;
-		}
+	fcol_y[0] = median(0, col_y[0], col_y[1]);
+	for (int i = 1; i < roi_height - 1; i++) {
+		fcol_y[i] = median(col_y[i - 1], col_y[i], col_y[i + 1]);
 	}
+	fcol_y[roi_height - 1] = median(col_y[roi_height - 2], col_y[roi_height - 1], 0);
 
-	/* Remove hot from the digest */
-	fcol_x[0][RE] = median(0, col_x[0][RE], col_x[1][RE]);
-	for (int i = 1; i < width-1; i++) {
-		fcol_x[i][RE] = median(col_x[i - 1][RE], col_x[i][RE], col_x[i + 1][RE]);
-	}
-	fcol_x[width - 1][RE] = median(col_x[width - 2][RE], col_x[width - 1][RE], 0);
-
-	fcol_y[0][RE] = median(0, col_y[0][RE], col_y[1][RE]);
-	for (int i = 1; i < height-1; i++) {
-		fcol_y[i][RE] = median(col_y[i - 1][RE], col_y[i][RE], col_y[i + 1][RE]);
-	}
-	fcol_y[height - 1][RE] = median(col_y[height - 2][RE], col_y[height - 1][RE], 0);
-
-	c->snr = (calibrate_re(fcol_x, width) + calibrate_re(fcol_y, height)) / 2;
-//	printf("col_x:");
-//	for (i=0; i < c->width; i++) {
-//		printf(" %5.2f\n",col_x[i][RE]);
-//	}
-//	printf("\n");
-//	printf("col_y:");
-//	for (i=0; i < fdigest->height; i++) {
-//		printf(" %5.2f",col_y[i][RE]);
-//	}
-//	printf("\n");
-	fft(c->width, fcol_x, c->fft_x);
-	fft(c->height, fcol_y, c->fft_y);
+	c->snr = (calibrate_re(fcol_x, roi_width) + calibrate_re(fcol_y, roi_height)) / 2;
+	fft_real(fft_get_plan(c->width), fcol_x, c->fft_x);
+	fft_real(fft_get_plan(c->height), fcol_y, c->fft_y);
+	c->roi_x = roi_x;
+	c->roi_y = roi_y;
 	c->algorithm = donuts;
 	free(col_x);
-	free(col_y);
-	free(fcol_x);
-	free(fcol_y);
 	return INDIGO_OK;
 }
 
@@ -781,16 +736,16 @@ indigo_result indigo_calculate_drift(const indigo_frame_digest *ref, const indig
 		return INDIGO_OK;
 	}
 	if (ref->algorithm == donuts) {
-		double (*c_buf)[2];
 		int max_dim = (ref->width > ref->height) ? ref->width : ref->height;
-		c_buf = malloc(2 * max_dim * sizeof(double));
-		/* find X correction */
-		corellate_fft(ref->width, new->fft_x, ref->fft_x, c_buf);
-		*drift_x = find_distance(ref->width, c_buf);
+		double (*C)[2] = malloc(3 * max_dim * sizeof(double));
+		double *c_buf = (double *)(C + max_dim);
+		/* find X correction, shift of the window is added back */
+		corellate_fft(fft_get_plan(ref->width), new->fft_x, ref->fft_x, C, c_buf);
+		*drift_x = find_distance(ref->width, c_buf) + (new->roi_x - ref->roi_x);
 		/* find Y correction */
-		corellate_fft(ref->height, new->fft_y, ref->fft_y, c_buf);
-		*drift_y = find_distance(ref->height, c_buf);
-		free(c_buf);
+		corellate_fft(fft_get_plan(ref->height), new->fft_y, ref->fft_y, C, c_buf);
+		*drift_y = find_distance(ref->height, c_buf) + (new->roi_y - ref->roi_y);
+		free(C);
 		return INDIGO_OK;
 	}
 	return INDIGO_FAILED;
@@ -806,6 +761,8 @@ indigo_result indigo_delete_frame_digest(indigo_frame_digest *fdigest) {
 		}
 		fdigest->width = 0;
 		fdigest->height = 0;
+		fdigest->roi_x = 0;
+		fdigest->roi_y = 0;
 		fdigest->algorithm = none;
 		return INDIGO_OK;
 	}
@@ -814,108 +771,374 @@ indigo_result indigo_delete_frame_digest(indigo_frame_digest *fdigest) {
 
 static const double FIND_STAR_CLIP_EDGE = 20;
 
-indigo_result indigo_find_stars(indigo_raw_type raw_type, const void *data, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found) {
-	if (data == NULL || star_list == NULL || stars_found == NULL) return INDIGO_FAILED;
+#define FIND_STARS_MAX_THREADS	8
+#define FIND_STARS_TILE_MIN_SIZE	(512 * 512)
+#define FIND_STARS_DEBLEND_CONTRAST	1.5
+#define FIND_STARS_MAX_AREA	4096
 
-	int  size = width * height;
-	double *buf = malloc(size * sizeof(double));
-	int star_size = 10;
-	int clip_edge   = height >= FIND_STAR_CLIP_EDGE * 4 ? FIND_STAR_CLIP_EDGE : (height / 4);
-	int clip_width  = width - clip_edge;
-	int clip_height = height - clip_edge;
-	double lmax = 1;
+typedef struct {
+	int y, x0, x1;        /* pixels x0..x1 on row y */
+	int parent;           /* union-find parent (index into run list) */
+	int peak, peak_x;     /* brightest pixel of the run */
+	double flux, flux_x, flux_y;
+} star_run;
 
-	uint8_t *data8 = (uint8_t *)data;
-	uint16_t *data16 = (uint16_t *)data;
-	double threshold = 0;
+typedef struct {
+	int value;
+	int x, y;
+} star_pixel;
 
-	switch (raw_type) {
-		case INDIGO_RAW_MONO8: {
-			for (int i = 0; i < size; i++) {
-				buf[i] = data8[i];
-				threshold += buf[i];
+typedef struct {
+	indigo_raw_type raw_type;
+	const void *data;
+	int width, height;
+	int clip_edge;
+	int y0, y1;
+	double sum;
+	double background, threshold;
+	int *rows;
+	star_run *runs;
+	int run_count, run_size;
+} star_tile;
+
+static void star_row(const star_tile *tile, int y, int *row) {
+	raw_row(tile->raw_type, tile->data, tile->width, y, 0, tile->width, row);
+}
+
+static void *star_sum_tile(star_tile *tile) {
+	int *row = tile->rows;
+	uint64_t sum = 0;
+	for (int j = tile->y0; j < tile->y1; j++) {
+		star_row(tile, j, row);
+		for (int i = 0; i < tile->width; i++)
+			sum += row[i];
+	}
+	tile->sum = sum;
+	return NULL;
+}
+
+static void *star_runs_tile(star_tile *tile) {
+	int width = tile->width;
+	int clip_width = width - tile->clip_edge;
+	int y0 = tile->y0 > tile->clip_edge ? tile->y0 : tile->clip_edge;
+	int y1 = tile->y1 < tile->height - tile->clip_edge ? tile->y1 : tile->height - tile->clip_edge;
+	int threshold = (int)tile->threshold;
+	double background = tile->background;
+	int *prev = tile->rows, *cur = prev + width, *next = cur + width;
+	tile->run_count = 0;
+	if (y0 >= y1)
+		return NULL;
+	star_row(tile, y0 - 1, prev);
+	star_row(tile, y0, cur);
+	for (int j = y0; j < y1; j++) {
+		star_row(tile, j + 1, next);
+		star_run *run = NULL;
+		for (int i = tile->clip_edge; i < clip_width; i++) {
+			int value = cur[i];
+			/* pixel has to be above threshold, median of the neighbouring pixels is checked to avoid hot pixels and lines */
+			if (value > threshold && median(cur[i - 1], value, cur[i + 1]) > threshold && median(prev[i], value, next[i]) > threshold) {
+				if (run == NULL) {
+					if (tile->run_count == tile->run_size) {
+						tile->run_size = tile->run_size ? 2 * tile->run_size : 256;
+						tile->runs = realloc(tile->runs, tile->run_size * sizeof(star_run));
+					}
+					run = tile->runs + tile->run_count++;
+					run->y = j;
+					run->x0 = i;
+					run->peak = 0;
+					run->flux = run->flux_x = run->flux_y = 0;
+				}
+				double weight = value - background;
+				run->x1 = i;
+				run->flux += weight;
+				run->flux_x += weight * i;
+				run->flux_y += weight * j;
+				if (value > run->peak) {
+					run->peak = value;
+					run->peak_x = i;
+				}
+			} else {
+				run = NULL;
 			}
-			break;
 		}
-		case INDIGO_RAW_MONO16: {
-			for (int i = 0; i < size; i++) {
-				buf[i] = data16[i];
-				threshold += buf[i];
-			}
-			break;
+		int *tmp = prev;
+		prev = cur;
+		cur = next;
+		next = tmp;
+	}
+	return NULL;
+}
+
+static void run_star_tiles(void *(*worker)(star_tile *), star_tile *tiles, int count) {
+	pthread_t threads[FIND_STARS_MAX_THREADS];
+	bool started[FIND_STARS_MAX_THREADS] = { false };
+	for (int i = 1; i < count; i++)
+		started[i] = pthread_create(threads + i, NULL, (void *(*)(void *))worker, tiles + i) == 0;
+	worker(tiles);
+	for (int i = 1; i < count; i++) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			worker(tiles + i);
+	}
+}
+
+static int star_root(star_run *runs, int i) {
+	while (runs[i].parent != i)
+		i = runs[i].parent = runs[runs[i].parent].parent;
+	return i;
+}
+
+static int star_pixel_compare(const void *a, const void *b) {
+	const star_pixel *pixel_a = (const star_pixel *)a;
+	const star_pixel *pixel_b = (const star_pixel *)b;
+	if (pixel_a->value != pixel_b->value)
+		return pixel_b->value - pixel_a->value;
+	if (pixel_a->y != pixel_b->y)
+		return pixel_a->y - pixel_b->y;
+	return pixel_a->x - pixel_b->x;
+}
+
+static void star_append(star_run **stars, int *count, int *size, const star_run *star) {
+	if (*count == *size) {
+		*size = *size ? 2 * *size : 256;
+		*stars = realloc(*stars, *size * sizeof(star_run));
+	}
+	(*stars)[(*count)++] = *star;
+}
+
+/* Pixels of the star chained from root are flooded from the brightest one down (watershed), two parts are kept
+   apart as separate stars if the fainter one rises well enough above the level where they meet (deblending).
+   Too large components are nebulosity or merged star fields and are skipped. */
+static void star_split(const star_tile *tile, star_run *runs, const int *chain, int root, star_run **stars, int *star_count, int *star_size) {
+	int x0 = runs[root].x0, x1 = runs[root].x1, y0 = runs[root].y, y1 = runs[root].y, area = 0;
+	for (int i = root; i != -1; i = chain[i]) {
+		star_run *run = runs + i;
+		if (run->x0 < x0)
+			x0 = run->x0;
+		if (run->x1 > x1)
+			x1 = run->x1;
+		if (run->y < y0)
+			y0 = run->y;
+		if (run->y > y1)
+			y1 = run->y;
+		area += run->x1 - run->x0 + 1;
+	}
+	if (area > FIND_STARS_MAX_AREA)
+		return;
+	if (chain[root] == -1) {
+		star_append(stars, star_count, star_size, runs + root);
+		return;
+	}
+	double background = tile->background;
+	double margin = tile->threshold - background;
+	/* box has one pixel border, so all 8 neighbours of any pixel are inside, labels are 0 outside, -1 not flooded yet, part + 1 otherwise */
+	int box_width = x1 - x0 + 3;
+	int box_size = box_width * (y1 - y0 + 3);
+	int *labels = calloc(box_size, sizeof(int));
+	star_pixel *pixels = malloc(area * sizeof(star_pixel));
+	star_run *parts = malloc(area * sizeof(star_run));
+	int *row = malloc((x1 - x0 + 1) * sizeof(int));
+	int count = 0;
+	for (int i = root; i != -1; i = chain[i]) {
+		star_run *run = runs + i;
+		raw_row(tile->raw_type, tile->data, tile->width, run->y, run->x0, run->x1 - run->x0 + 1, row);
+		for (int x = run->x0; x <= run->x1; x++) {
+			labels[(run->y - y0 + 1) * box_width + x - x0 + 1] = -1;
+			pixels[count].value = row[x - run->x0];
+			pixels[count].x = x;
+			pixels[count].y = run->y;
+			count++;
 		}
-		case INDIGO_RAW_RGB24: {
-			for (int i = 0, j = 0; i < 3 * size; i++, j++) {
-				buf[j] = data8[i] + data8[i + 1] + data8[i + 2];
-				threshold += buf[j];
-				i += 2;
+	}
+	free(row);
+	qsort(pixels, area, sizeof(star_pixel), star_pixel_compare);
+	int part_count = 0;
+	for (int n = 0; n < area; n++) {
+		star_pixel *pixel = pixels + n;
+		int offset = (pixel->y - y0 + 1) * box_width + pixel->x - x0 + 1;
+		int best = -1;
+		for (int dy = -box_width; dy <= box_width; dy += box_width) {
+			for (int dx = -1; dx <= 1; dx++) {
+				int label = labels[offset + dy + dx];
+				if (label <= 0)
+					continue;
+				int part = star_root(parts, label - 1);
+				if (best == -1) {
+					best = part;
+				} else if (part != best) {
+					int bright = parts[part].peak > parts[best].peak ? part : best;
+					int faint = bright == part ? best : part;
+					double top = parts[faint].peak - background;
+					double saddle = pixel->value - background;
+					if (top < FIND_STARS_DEBLEND_CONTRAST * saddle || top - saddle < margin)
+						parts[faint].parent = bright;
+					best = bright;
+				}
 			}
-			break;
 		}
-		case INDIGO_RAW_RGB48: {
-			for (int i = 0, j = 0; i < 3 * size; i++, j++) {
-				buf[j] = data16[i] + data16[i + 1] + data16[i + 2];
-				threshold += buf[j];
-				i += 2;
-			}
-			break;
+		if (best == -1) {
+			star_run *part = parts + part_count;
+			part->parent = best = part_count++;
+			part->y = pixel->y;
+			part->x0 = part->x1 = part->peak_x = pixel->x;
+			part->peak = pixel->value;
+			part->flux = part->flux_x = part->flux_y = 0;
 		}
+		labels[offset] = best + 1;
+	}
+	for (int n = 0; n < area; n++) {
+		star_pixel *pixel = pixels + n;
+		star_run *part = parts + star_root(parts, labels[(pixel->y - y0 + 1) * box_width + pixel->x - x0 + 1] - 1);
+		double weight = pixel->value - background;
+		part->flux += weight;
+		part->flux_x += weight * pixel->x;
+		part->flux_y += weight * pixel->y;
 	}
+	for (int i = 0; i < part_count; i++) {
+		if (parts[i].parent == i)
+			star_append(stars, star_count, star_size, parts + i);
+	}
+	free(parts);
+	free(pixels);
+	free(labels);
+}
+
+static int star_compare(const void *a, const void *b) {
+	const star_run *run_a = (const star_run *)a;
+	const star_run *run_b = (const star_run *)b;
+	if (run_a->peak != run_b->peak)
+		return run_b->peak - run_a->peak;
+	if (run_a->y != run_b->y)
+		return run_a->y - run_b->y;
+	return run_a->peak_x - run_b->peak_x;
+}
+
+indigo_result indigo_find_stars(indigo_raw_type raw_type, const void *data, const int width, const int height, const int stars_max, indigo_star_detection star_list[], int *stars_found) {
+	if (data == NULL || star_list == NULL || stars_found == NULL) return INDIGO_FAILED;
 
+	INDIGO_DEBUG(clock_t start = clock());
+	int size = width * height;
+	int clip_edge = height >= FIND_STAR_CLIP_EDGE * 4 ? FIND_STAR_CLIP_EDGE : (height / 4);
+	if (clip_edge < 1)
+		clip_edge = 1;
+
+	/* frame is split into horizontal bands processed in parallel, native pixel data are converted row by row */
+	int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (thread_count > FIND_STARS_MAX_THREADS)
+		thread_count = FIND_STARS_MAX_THREADS;
+	if (thread_count > size / FIND_STARS_TILE_MIN_SIZE)
+		thread_count = size / FIND_STARS_TILE_MIN_SIZE;
+	if (thread_count < 1)
+		thread_count = 1;
+	star_tile tiles[FIND_STARS_MAX_THREADS] = { 0 };
+	int *rows = malloc(3 * thread_count * width * sizeof(int));
+	for (int i = 0; i < thread_count; i++) {
+		tiles[i].raw_type = raw_type;
+		tiles[i].data = data;
+		tiles[i].width = width;
+		tiles[i].height = height;
+		tiles[i].clip_edge = clip_edge;
+		tiles[i].y0 = (int)((long)height * i / thread_count);
+		tiles[i].y1 = (int)((long)height * (i + 1) / thread_count);
+		tiles[i].rows = rows + 3 * i * width;
+	}
+	run_star_tiles(star_sum_tile, tiles, thread_count);
+	double sum = 0;
+	for (int i = 0; i < thread_count; i++)
+		sum += tiles[i].sum;
 	/* Look for stars 30% brighter than the frame average */
-	threshold = 1.30 * threshold / (double)size;
-
-	int found = 0;
-	while (lmax > 0) {
-		lmax = 0;
-		indigo_star_detection star = {0};
-		for (int j = clip_edge; j < clip_height; j++) {
-			for (int i = clip_edge; i < clip_width; i++) {
-				int off = j * width + i;
-				if (buf[off] > threshold && lmax < buf[off] &&
-					/* also check median of the neighbouring pixels to avoid hot pixels and lines */
-				    median(buf[off - 1], buf[off], buf[off + 1]) > threshold &&
-				    median(buf[(j - 1) * width + i], buf[off], buf[(j + 1) * width + i]) > threshold)
-				{
-					lmax = buf[off];
-					star.x = (double)i;
-					star.y = (double)j;
-					star.nc_distance = sqrt((star.x - width/2) * (star.x - width/2) + (star.y - height/2) * (star.y - height/2));
-					int divider = (width > height) ? height / 2 : width / 2;
-					star.nc_distance /= divider;
-				}
+	double background = sum / (double)size;
+	double threshold = 1.30 * background;
+	for (int i = 0; i < thread_count; i++) {
+		tiles[i].background = background;
+		tiles[i].threshold = threshold;
+	}
+	run_star_tiles(star_runs_tile, tiles, thread_count);
+	free(rows);
+
+	/* runs of all bands in row order, 8-connected runs on adjacent rows are merged into stars */
+	int run_count = 0;
+	for (int i = 0; i < thread_count; i++)
+		run_count += tiles[i].run_count;
+	star_run *runs = malloc((run_count + 1) * sizeof(star_run));
+	run_count = 0;
+	for (int i = 0; i < thread_count; i++) {
+		if (tiles[i].run_count)
+			memcpy(runs + run_count, tiles[i].runs, tiles[i].run_count * sizeof(star_run));
+		run_count += tiles[i].run_count;
+		free(tiles[i].runs);
+	}
+	int row_start = 0, prev_start = 0, prev_end = 0;
+	for (int i = 0; i < run_count; i++) {
+		star_run *run = runs + i;
+		run->parent = i;
+		if (i > 0 && run->y != runs[i - 1].y) {
+			if (runs[i - 1].y == run->y - 1) {
+				prev_start = row_start;
+				prev_end = i;
+			} else {
+				prev_start = prev_end = i;
 			}
+			row_start = i;
 		}
-		if (lmax > 0) {
-			star_list[found] = star;
-			for (int j = -star_size; j < star_size; j++) {
-				for (int i = -star_size; i < star_size; i++) {
-					if ((int)star.x + i < 0 || star.x + i >= width || (int)star.y + j < 0 || star.y + i >= height) {
-						star_list[found] = star;
-						found++;
-						continue;
-					}
-					int off = ((int)star.y + j) * width + (int)star.x + i;
-					if (buf[off] > star.luminance) {
-						star.luminance = buf[off];
-					}
-					buf[off] = 0;
-				}
-			}
-			star.luminance = log(fabs(star.luminance));
-			star_list[found] = star;
-			found++;
+		for (int k = prev_start; k < prev_end; k++) {
+			if (runs[k].x1 < run->x0 - 1)
+				continue;
+			if (runs[k].x0 > run->x1 + 1)
+				break;
+			int root_k = star_root(runs, k);
+			int root = star_root(runs, i);
+			/* root is always the first run of the star */
+			if (root_k < root)
+				runs[root].parent = root_k;
+			else if (root < root_k)
+				runs[root_k].parent = root;
 		}
-		if (found >= stars_max) {
-			break;
+	}
+	/* runs of each star are chained from its root */
+	int *chain = malloc((run_count + 1) * sizeof(int));
+	for (int i = 0; i < run_count; i++)
+		chain[i] = -1;
+	for (int i = 0; i < run_count; i++) {
+		int root = star_root(runs, i);
+		if (root != i) {
+			chain[i] = chain[root];
+			chain[root] = i;
 		}
 	}
-
-	free(buf);
+	star_run *stars = NULL;
+	int star_count = 0, star_size = 0;
+	for (int i = 0; i < run_count; i++) {
+		if (runs[i].parent == i)
+			star_split(tiles, runs, chain, i, &stars, &star_count, &star_size);
+	}
+	free(chain);
+	free(runs);
+	qsort(stars, star_count, sizeof(star_run), star_compare);
+	int found = star_count;
+	if (found > stars_max)
+		found = stars_max > 0 ? stars_max : 0;
+	int divider = (width > height) ? height / 2 : width / 2;
+	for (int i = 0; i < found; i++) {
+		star_run *star = stars + i;
+		indigo_star_detection *detection = star_list + i;
+		if (star->flux > 0) {
+			detection->x = star->flux_x / star->flux;
+			detection->y = star->flux_y / star->flux;
+		} else {
+			detection->x = star->peak_x;
+			detection->y = star->y;
+		}
+		detection->nc_distance = sqrt((detection->x - width / 2) * (detection->x - width / 2) + (detection->y - height / 2) * (detection->y - height / 2)) / divider;
+		detection->luminance = log(fabs((double)star->peak));
+	}
+	free(stars);
 
 	for (size_t i = 0;i < found; i++) {
 		INDIGO_DEBUG(indigo_log("indigo_find_stars: star #%u: x = %lf, y = %lf, ncdist = %lf, lum = %lf", i+1, star_list[i].x, star_list[i].y, star_list[i].nc_distance, star_list[i].luminance));
 	}
+	INDIGO_DEBUG(indigo_log("indigo_find_stars: %d stars in %gs", star_count, (clock() - start) / (double)CLOCKS_PER_SEC));
 
 	*stars_found = found;
 	return INDIGO_OK;
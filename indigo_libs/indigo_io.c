@@ -37,6 +37,7 @@
 #include <termios.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #endif
@@ -53,6 +54,18 @@
 
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
 
+// handles known not to be sockets, so indigo_read_line() doesn't try MSG_PEEK on every call
+static bool not_socket[FD_SETSIZE];
+
+static inline void mark_not_socket(int handle, bool value) {
+	if (handle >= 0 && handle < FD_SETSIZE)
+		not_socket[handle] = value;
+}
+
+static inline bool is_not_socket(int handle) {
+	return handle >= 0 && handle < FD_SETSIZE && not_socket[handle];
+}
+
 typedef struct {
 	int value;
 	size_t len;
@@ -211,6 +224,7 @@ static int open_tty(const char *tty_name, const struct termios *options, struct
 		return -1;
 	}
 
+	mark_not_socket(tty_fd, true);
 	return tty_fd;
 }
 
@@ -251,6 +265,9 @@ int indigo_open_tcp(const char *host, int port) {
 	if ((sock = socket(AF_INET, SOCK_STREAM, 0))== -1) {
 		return -1;
 	}
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+	mark_not_socket(sock, false);
+#endif
 	memset(&srv_info, 0, sizeof(srv_info));
 	srv_info.sin_family = AF_INET;
 	srv_info.sin_port = htons(port);
@@ -282,6 +299,9 @@ int indigo_open_udp(const char *host, int port) {
 	if ((sock = socket(AF_INET, SOCK_DGRAM, 0))== -1) {
 		return -1;
 	}
+#if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
+	mark_not_socket(sock, false);
+#endif
 	memset(&srv_info, 0, sizeof(srv_info));
 	srv_info.sin_family = AF_INET;
 	srv_info.sin_port = htons(port);
@@ -387,29 +407,64 @@ int indigo_recv(int handle, char *buffer, long length) {
 int indigo_close(int handle) {
 	return closesocket(handle);
 }
+#else
+int indigo_close(int handle) {
+	// handle number can be reused for a socket
+	mark_not_socket(handle, false);
+	return close(handle);
+}
 #endif
 
+static long scan_line(const char *data, long count, char *buffer, long *total_bytes, int length, bool *complete) {
+	long i = 0;
+	while (i < count && *total_bytes < length - 1) {
+		char c = data[i++];
+		if (c == '\n') {
+			*complete = true;
+			break;
+		}
+		if (c != '\r')
+			buffer[(*total_bytes)++] = c;
+	}
+	return i;
+}
+
 int indigo_read_line(int handle, char *buffer, int length) {
-	char c = '\0';
+	char chunk[1024];
 	long total_bytes = 0;
-	while (total_bytes < length) {
+	bool complete = false;
+#if defined(INDIGO_WINDOWS)
+	bool peek = true;
+#else
+	bool peek = !is_not_socket(handle);
+#endif
+	while (!complete && total_bytes < length - 1) {
+		// sockets are peeked and only the bytes up to the end of line are consumed, so no data is lost for subsequent raw reads
 #if defined(INDIGO_WINDOWS)
-		long bytes_read = recv(handle, &c, 1, 0);
+		long bytes_read = recv(handle, chunk, sizeof(chunk), MSG_PEEK);
 		if (bytes_read == -1 && WSAGetLastError() == WSAETIMEDOUT) {
 			Sleep(500);
 			continue;
 		}
 #else
-		long bytes_read = read(handle, &c, 1);
+		long bytes_read;
+		if (peek) {
+			bytes_read = recv(handle, chunk, sizeof(chunk), MSG_PEEK);
+			if (bytes_read == -1 && errno == ENOTSOCK) {
+				mark_not_socket(handle, true);
+				peek = false;
+				continue;
+			}
+		} else {
+			bytes_read = read(handle, chunk, 1);
+		}
 #endif
 		if (bytes_read > 0) {
-			if (c == '\r')
-				;
-			else if (c != '\n')
-				buffer[total_bytes++] = c;
-			else
-				break;
-		} else {
+			long consumed = scan_line(chunk, bytes_read, buffer, &total_bytes, length, &complete);
+			if (peek && recv(handle, chunk, (int)consumed, 0) != consumed)
+				bytes_read = -1;
+		}
+		if (bytes_read <= 0) {
 			errno = ECONNRESET;
 			INDIGO_TRACE_PROTOCOL(indigo_trace("%d → ERROR", handle));
 			return -1;
@@ -420,6 +475,124 @@ int indigo_read_line(int handle, char *buffer, int length) {
 	return (int)total_bytes;
 }
 
+void indigo_init_reader(indigo_reader *reader, int handle, int timeout) {
+	reader->handle = handle;
+	reader->timeout = timeout;
+	reader->start = reader->end = 0;
+}
+
+static long reader_recv(indigo_reader *reader, char *buffer, long length) {
+	while (true) {
+		if (reader->timeout > 0) {
+			fd_set readout;
+			struct timeval tv;
+			FD_ZERO(&readout);
+			FD_SET(reader->handle, &readout);
+			tv.tv_sec = reader->timeout / 1000;
+			tv.tv_usec = (reader->timeout % 1000) * 1000;
+			int result = select(reader->handle + 1, &readout, NULL, NULL, &tv);
+			if (result == 0) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			if (result < 0) {
+				if (errno == EINTR)
+					continue;
+				return -1;
+			}
+		}
+#if defined(INDIGO_WINDOWS)
+		long bytes_read = recv(reader->handle, buffer, length, 0);
+		if (bytes_read == -1 && WSAGetLastError() == WSAETIMEDOUT) {
+			Sleep(500);
+			continue;
+		}
+#else
+		long bytes_read = read(reader->handle, buffer, length);
+		if (bytes_read == -1 && errno == EINTR)
+			continue;
+#endif
+		return bytes_read;
+	}
+}
+
+static long reader_fill(indigo_reader *reader) {
+	if (reader->start > 0) {
+		memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+	long bytes_read = reader_recv(reader, reader->buffer + reader->end, INDIGO_READER_BUFFER_SIZE - reader->end);
+	if (bytes_read > 0)
+		reader->end += bytes_read;
+	return bytes_read;
+}
+
+int indigo_reader_read_line(indigo_reader *reader, char *buffer, int length) {
+	long total_bytes = 0;
+	bool complete = false;
+	while (!complete && total_bytes < length - 1) {
+		if (reader->start == reader->end && reader_fill(reader) <= 0) {
+			if (errno != ETIMEDOUT)
+				errno = ECONNRESET;
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d → ERROR", reader->handle));
+			return -1;
+		}
+		reader->start += scan_line(reader->buffer + reader->start, reader->end - reader->start, buffer, &total_bytes, length, &complete);
+	}
+	buffer[total_bytes] = '\0';
+	INDIGO_TRACE_PROTOCOL(indigo_trace("%d → %s", reader->handle, buffer));
+	return (int)total_bytes;
+}
+
+long indigo_reader_read(indigo_reader *reader, char *buffer, long length) {
+	long total_bytes = 0;
+	while (total_bytes < length) {
+		long available = reader->end - reader->start;
+		if (available > 0) {
+			long count = length - total_bytes < available ? length - total_bytes : available;
+			memcpy(buffer + total_bytes, reader->buffer + reader->start, count);
+			reader->start += count;
+			total_bytes += count;
+			continue;
+		}
+		long bytes_read;
+		if (length - total_bytes >= INDIGO_READER_BUFFER_SIZE) {
+			// large payloads bypass the buffer
+			bytes_read = reader_recv(reader, buffer + total_bytes, length - total_bytes);
+			if (bytes_read > 0)
+				total_bytes += bytes_read;
+		} else {
+			reader->start = reader->end = 0;
+			bytes_read = reader_fill(reader);
+		}
+		if (bytes_read <= 0)
+			return bytes_read;
+	}
+	return total_bytes;
+}
+
+int indigo_reader_peek(indigo_reader *reader) {
+	if (reader->start == reader->end && reader_fill(reader) <= 0)
+		return -1;
+	return (unsigned char)reader->buffer[reader->start];
+}
+
+void indigo_reader_discard(indigo_reader *reader) {
+	reader->start = reader->end = 0;
+}
+
+int indigo_reader_scanf(indigo_reader *reader, const char *format, ...) {
+	char buffer[1024];
+	if (indigo_reader_read_line(reader, buffer, sizeof(buffer)) <= 0)
+		return 0;
+	va_list args;
+	va_start(args, format);
+	int count = vsscanf(buffer, format, args);
+	va_end(args);
+	return count;
+}
+
 bool indigo_write(int handle, const char *buffer, long length) {
 	long remains = length;
 	while (true) {
@@ -45,34 +45,6 @@
 
 #define PROPERTY_SIZE sizeof(indigo_property)+INDIGO_MAX_ITEMS*(sizeof(indigo_item))
 
-static long ws_read(int handle, char *buffer, long length) {
-	uint8_t header[14];
-	if (indigo_read(handle, (char *)header, 6) <= 0)
-		return -1;
-	INDIGO_TRACE_PARSER(indigo_trace("ws_read -> %2x", header[0]));
-	uint8_t *masking_key = header+2;
-	uint64_t payload_length = header[1] & 0x7F;
-	if (payload_length == 0x7E) {
-		if (indigo_read(handle, (char *)header + 6, 2) <= 0)
-			return -1;
-		masking_key = header + 4;
-		payload_length = ntohs(*((uint16_t *)(header+2)));
-	} else if (payload_length == 0x7F) {
-		if (indigo_read(handle, (char *)header + 6, 8) <= 0)
-			return -1;
-		masking_key = header+10;
-		payload_length = ntohll(*((uint64_t *)(header+2)));
-	}
-	if (length < payload_length)
-		return -1;
-	if (indigo_read(handle, buffer, payload_length) <= 0)
-		return -1;
-	for (uint64_t i = 0; i < payload_length; i++) {
-		buffer[i] ^= masking_key[i%4];
-	}
-	return payload_length;
-}
-
 typedef enum {
 	ERROR,
 	IDLE,
@@ -261,46 +233,83 @@ static void *top_level_handler(parser_state state, char *name, char *value, indi
 	return top_level_handler;
 }
 
-void indigo_json_parse(indigo_device *device, indigo_client *client) {
-	indigo_adapter_context *context = (indigo_adapter_context*)client->client_context;
-	int handle = context->input;
-	char buffer[JSON_BUFFER_SIZE];
-	char *pointer = buffer;
-	char *buffer_end = NULL;
+/** Incremental parser state, everything the byte loop keeps between chunks.
+ */
+struct indigo_json_parser {
 	char property_buffer[PROPERTY_SIZE];
+	indigo_device *device;
+	indigo_client *client;
+	int handle;												/* input handle, used for trace only */
+	bool web_socket;
+	parser_handler handler;
+	parser_state state;
 	char message[INDIGO_VALUE_SIZE];
-	char name_buffer[INDIGO_NAME_SIZE];
-	char *name_pointer = name_buffer;
-	char value_buffer[INDIGO_VALUE_SIZE];
-	char *value_pointer = value_buffer;
-	*pointer = 0;
-	char c = 0;
-	char q = '"';
-	int depth = 0;
-	parser_handler handler = top_level_handler;
-	parser_state state = IDLE;
-	indigo_property *property = (indigo_property *)property_buffer;
-	memset(property_buffer, 0, PROPERTY_SIZE);
+	char name_buffer[INDIGO_NAME_SIZE + 1];
+	char *name_pointer;
+	char value_buffer[INDIGO_VALUE_SIZE + 1];
+	char *value_pointer;
+	char q;
+	int depth;
+	uint8_t frame_header[14];					/* WebSocket frame header being collected */
+	int frame_header_length;
+	uint8_t masking_key[4];
+	char *frame;											/* WebSocket frame payload being collected */
+	uint64_t frame_length;
+	uint64_t frame_received;
+};
 
+indigo_json_parser *indigo_json_parser_create(indigo_device *device, indigo_client *client) {
+	indigo_adapter_context *context = (indigo_adapter_context*)client->client_context;
+	indigo_json_parser *parser = malloc(sizeof(indigo_json_parser));
+	assert(parser != NULL);
+	memset(parser, 0, sizeof(indigo_json_parser));
+	parser->device = device;
+	parser->client = client;
+	parser->handle = context->input;
+	parser->web_socket = context->web_socket;
+	parser->name_pointer = parser->name_buffer;
+	parser->value_pointer = parser->value_buffer;
+	parser->q = '"';
+	parser->handler = top_level_handler;
+	parser->state = IDLE;
+	if (parser->web_socket) {
+		parser->frame = malloc(JSON_BUFFER_SIZE);
+		assert(parser->frame != NULL);
+	}
+	return parser;
+}
+
+/** Parse one line or WebSocket frame payload.
+ */
+static bool parse(indigo_json_parser *parser, const char *pointer, const char *buffer_end) {
+	indigo_device *device = parser->device;
+	indigo_client *client = parser->client;
+	indigo_property *property = (indigo_property *)parser->property_buffer;
+	char *message = parser->message;
+	char *name_buffer = parser->name_buffer;
+	char *value_buffer = parser->value_buffer;
+	char *name_pointer = parser->name_pointer;
+	char *value_pointer = parser->value_pointer;
+	char q = parser->q;
+	int depth = parser->depth;
+	parser_handler handler = parser->handler;
+	parser_state state = parser->state;
+	bool result = true;
+	char c = 0;
 	while (true) {
-		assert(pointer - buffer <= JSON_BUFFER_SIZE);
 		assert(name_pointer - name_buffer <= INDIGO_NAME_SIZE);
 		if (state == ERROR) {
 			indigo_error("JSON Parser: syntax error");
-			goto exit_loop;
-		}
-		while ((c = *pointer++) == 0) {
-			ssize_t count = (int)context->web_socket ? ws_read(handle, buffer, JSON_BUFFER_SIZE) : indigo_read_line(handle, buffer, JSON_BUFFER_SIZE);
-			if (count <= 0) {
-				goto exit_loop;
-			}
-			pointer = buffer;
-			buffer_end = buffer + count;
-			buffer[count] = 0;
-			INDIGO_TRACE_PROTOCOL(indigo_trace("%d → %s", handle, buffer));
+			result = false;
+			break;
 		}
+		if (pointer == buffer_end)
+			break;
+		if ((c = *pointer++) == 0)
+			continue;
 		switch (state) {
 			case ERROR:
+				result = false;
 				goto exit_loop;
 			case IDLE:
 				if (isspace(c)) {
@@ -467,6 +476,104 @@ void indigo_json_parse(indigo_device *device, indigo_client *client) {
 		}
 	}
 exit_loop:
+	parser->name_pointer = name_pointer;
+	parser->value_pointer = value_pointer;
+	parser->q = q;
+	parser->depth = depth;
+	parser->handler = handler;
+	parser->state = state;
+	return result;
+}
+
+static int frame_header_size(indigo_json_parser *parser) {
+	if (parser->frame_header_length < 2)
+		return 2;
+	uint8_t payload_length = parser->frame_header[1] & 0x7F;
+	return payload_length == 0x7E ? 8 : payload_length == 0x7F ? 14 : 6;
+}
+
+bool indigo_json_parser_feed(indigo_json_parser *parser, const char *data, long length) {
+	const char *end = data + length;
+	if (!parser->web_socket) {
+		/* plain JSON is line oriented, line breaks are not passed to parser */
+		while (data < end) {
+			const char *line_end = data;
+			while (line_end < end && *line_end != '\n' && *line_end != '\r')
+				line_end++;
+			if (line_end > data) {
+				INDIGO_TRACE_PROTOCOL(indigo_trace("%d → %.*s", parser->handle, (int)(line_end - data), data));
+				if (!parse(parser, data, line_end))
+					return false;
+			}
+			data = line_end < end ? line_end + 1 : end;
+		}
+		return true;
+	}
+	while (data < end) {
+		if (parser->frame_header_length < frame_header_size(parser)) {
+			parser->frame_header[parser->frame_header_length++] = *data++;
+			if (parser->frame_header_length < 6 || parser->frame_header_length < frame_header_size(parser))
+				continue;
+			uint8_t *header = parser->frame_header;
+			INDIGO_TRACE_PARSER(indigo_trace("ws_read -> %2x", header[0]));
+			uint8_t *masking_key = header + 2;
+			uint64_t payload_length = header[1] & 0x7F;
+			if (payload_length == 0x7E) {
+				uint16_t length16;
+				memcpy(&length16, header + 2, sizeof(length16));
+				masking_key = header + 4;
+				payload_length = ntohs(length16);
+			} else if (payload_length == 0x7F) {
+				uint64_t length64;
+				memcpy(&length64, header + 2, sizeof(length64));
+				masking_key = header + 10;
+				payload_length = ntohll(length64);
+			}
+			if (payload_length > JSON_BUFFER_SIZE) {
+				indigo_error("JSON Parser: WebSocket frame too large (%llu bytes)", (unsigned long long)payload_length);
+				return false;
+			}
+			memcpy(parser->masking_key, masking_key, 4);
+			parser->frame_length = payload_length;
+			parser->frame_received = 0;
+		} else {
+			uint64_t count = parser->frame_length - parser->frame_received;
+			if (count > (uint64_t)(end - data))
+				count = end - data;
+			memcpy(parser->frame + parser->frame_received, data, count);
+			parser->frame_received += count;
+			data += count;
+		}
+		if (parser->frame_received == parser->frame_length) {
+			for (uint64_t i = 0; i < parser->frame_length; i++)
+				parser->frame[i] ^= parser->masking_key[i % 4];
+			parser->frame_header_length = 0;
+			INDIGO_TRACE_PROTOCOL(indigo_trace("%d → %.*s", parser->handle, (int)parser->frame_length, parser->frame));
+			if (!parse(parser, parser->frame, parser->frame + parser->frame_length))
+				return false;
+		}
+	}
+	return true;
+}
+
+void indigo_json_parser_release(indigo_json_parser *parser) {
+	if (parser->frame)
+		free(parser->frame);
+	free(parser);
+}
+
+void indigo_json_parse(indigo_device *device, indigo_client *client) {
+	indigo_json_parser *parser = indigo_json_parser_create(device, client);
+	int handle = parser->handle;
+	char *buffer = malloc(JSON_BUFFER_SIZE);
+	assert(buffer != NULL);
+	while (true) {
+		ssize_t count = read(handle, buffer, JSON_BUFFER_SIZE);
+		if (count <= 0 || !indigo_json_parser_feed(parser, buffer, count))
+			break;
+	}
+	free(buffer);
+	indigo_json_parser_release(parser);
 	close(handle);
 	indigo_log("JSON Parser: parser finished");
 }
@@ -34,15 +34,20 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <fcntl.h>
+#include <stddef.h>
+#include <time.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 
 #ifdef INDIGO_LINUX
 #include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
 #endif
 
 #include <indigo/indigo_bus.h>
@@ -65,10 +70,19 @@ void sha1(unsigned char h[static SHA1_SIZE], const void *_sha1_restrict p, size_
 static int server_socket;
 static bool shutdown_initiated = false;
 static int client_count = 0;
+static pthread_mutex_t client_count_mutex = PTHREAD_MUTEX_INITIALIZER;
 static indigo_server_tcp_callback server_callback;
 
+#ifdef INDIGO_LINUX
+static int epoll_handle = -1;
+static int wakeup_pipe[2];
+static pthread_t *reactor_workers;
+static int reactor_worker_count;
+#endif
+
 int indigo_server_tcp_port = 7624;
 bool indigo_is_ephemeral_port = false;
+int indigo_server_tcp_workers = 4;
 
 static struct resource {
 	const char *path;
@@ -80,192 +94,883 @@ static struct resource {
 } *resources = NULL;
 
 #define BUFFER_SIZE	1024
+#define HTTP_HEADER_SIZE	8192
+#define HTTP_TIMEOUT	30
+#define DRAIN_TIMEOUT	5
+
+typedef enum {
+	CONNECTION_CLOSE,
+	CONNECTION_KEEP_ALIVE,
+	CONNECTION_WEB_SOCKET
+} connection_state;
+
+static void update_client_count(int delta) {
+	pthread_mutex_lock(&client_count_mutex);
+	int count = client_count += delta;
+	pthread_mutex_unlock(&client_count_mutex);
+	server_callback(count);
+}
+
+static void close_connection(int socket) {
+	shutdown(socket, SHUT_RDWR);
+	close(socket);
+	update_client_count(-1);
+}
+
+static void xml_session(int socket) {
+	INDIGO_LOG(indigo_log("Protocol switched to XML"));
+	indigo_client *protocol_adapter = indigo_xml_device_adapter(socket, socket);
+	assert(protocol_adapter != NULL);
+	indigo_attach_client(protocol_adapter);
+	indigo_xml_parse(NULL, protocol_adapter);
+	indigo_detach_client(protocol_adapter);
+	indigo_release_xml_device_adapter(protocol_adapter);
+}
+
+static void json_session(int socket, bool web_socket) {
+	INDIGO_LOG(indigo_log("Protocol switched to %s", web_socket ? "JSON-over-WebSockets" : "JSON"));
+	indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, web_socket);
+	assert(protocol_adapter != NULL);
+	indigo_attach_client(protocol_adapter);
+	indigo_json_parse(NULL, protocol_adapter);
+	indigo_detach_client(protocol_adapter);
+	indigo_release_json_device_adapter(protocol_adapter);
+}
+
+static bool parse_range(const char *range, long size, long *start, long *end) {
+	long first, last;
+	if (strchr(range, ','))
+		return false;
+	if (*range == '-') {
+		if (sscanf(range + 1, "%ld", &last) != 1 || last <= 0)
+			return false;
+		*start = last < size ? size - last : 0;
+		*end = size - 1;
+	} else {
+		int count = sscanf(range, "%ld-%ld", &first, &last);
+		if (count < 1 || first >= size || (count == 2 && last < first))
+			return false;
+		*start = first;
+		*end = count == 2 && last < size ? last : size - 1;
+	}
+	return true;
+}
+
+/** HTTP response prepared by http_response(), header is followed by content from memory or from file.
+ It is written by transfer_write() in as many steps as the socket needs.
+ */
+typedef struct {
+	bool active;											///< response is not written completely
+	connection_state state;						///< connection state after response is written
+	const unsigned char *content;			///< content in memory (or NULL)
+	int handle;												///< content in file (or -1)
+	indigo_blob_buffer *buffer;				///< retained BLOB buffer owning content or handle (or NULL)
+	long offset;											///< next content byte to write
+	long remaining;										///< content bytes to write
+	long length;											///< content length
+	long header_length;								///< bytes in header
+	long header_offset;								///< header bytes written
+	char request[BUFFER_SIZE];				///< request line for log (or empty if result is not logged)
+	char header[HTTP_HEADER_SIZE];		///< response header (and short response body)
+} http_transfer;
+
+static void transfer_init(http_transfer *transfer) {
+	memset(transfer, 0, offsetof(http_transfer, request));
+	transfer->request[0] = 0;
+	transfer->handle = -1;
+	transfer->active = true;
+	transfer->state = CONNECTION_CLOSE;
+}
+
+static void transfer_printf(http_transfer *transfer, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	long length = vsnprintf(transfer->header + transfer->header_length, sizeof(transfer->header) - transfer->header_length, format, args);
+	va_end(args);
+	if (length > 0)
+		transfer->header_length += length;
+	if (transfer->header_length >= sizeof(transfer->header))
+		transfer->header_length = sizeof(transfer->header) - 1;
+}
+
+/** Write response, return 1 if it is written completely, 0 if socket is not writable now or -1 on error.
+ */
+static int transfer_write(int socket, http_transfer *transfer) {
+	while (transfer->header_offset < transfer->header_length || transfer->remaining > 0) {
+		ssize_t bytes_written;
+		if (transfer->header_offset < transfer->header_length || transfer->content) {
+			// header and content in one syscall, content is immutable so no lock is held during transfer
+			long header_remaining = transfer->header_length - transfer->header_offset;
+			struct iovec iov[2] = {
+				{ transfer->header + transfer->header_offset, header_remaining },
+				{ transfer->content ? (unsigned char *)transfer->content + transfer->offset : NULL, transfer->content ? transfer->remaining : 0 }
+			};
+			struct msghdr message = { .msg_iov = iov, .msg_iovlen = 2 };
+			bytes_written = sendmsg(socket, &message, 0);
+			if (bytes_written > 0) {
+				long header_part = bytes_written < header_remaining ? bytes_written : header_remaining;
+				transfer->header_offset += header_part;
+				transfer->offset += bytes_written - header_part;
+				transfer->remaining -= bytes_written - header_part;
+			}
+		} else {
+#ifdef INDIGO_LINUX
+			off_t position = transfer->offset;
+			bytes_written = sendfile(socket, transfer->handle, &position, transfer->remaining);
+#else
+			char data[128 * 1024];
+			ssize_t bytes_read = pread(transfer->handle, data, transfer->remaining < sizeof(data) ? transfer->remaining : sizeof(data), transfer->offset);
+			if (bytes_read <= 0)
+				return -1;
+			bytes_written = write(socket, data, bytes_read);
+#endif
+			if (bytes_written > 0) {
+				transfer->offset += bytes_written;
+				transfer->remaining -= bytes_written;
+			}
+		}
+		if (bytes_written < 0 && errno == EINTR)
+			continue;
+		if (bytes_written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return 0;
+		if (bytes_written <= 0)
+			return -1;
+	}
+	return 1;
+}
+
+/** Log result of response and release its content.
+ */
+static void transfer_finish(http_transfer *transfer, bool success) {
+	if (*transfer->request) {
+		if (success) {
+			INDIGO_LOG(indigo_log("%s -> OK (%ld bytes)", transfer->request, transfer->length));
+		} else {
+			INDIGO_LOG(indigo_log("%s -> Failed (%s)", transfer->request, strerror(errno)));
+		}
+	}
+	if (transfer->buffer)
+		indigo_release_blob_buffer(transfer->buffer);
+	else if (transfer->handle >= 0)
+		close(transfer->handle);
+	transfer->buffer = NULL;
+	transfer->handle = -1;
+	transfer->active = false;
+}
+
+static void set_timeouts(int socket, int seconds) {
+	struct timeval timeout = { seconds, 0 };
+	setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static char *next_line(char **cursor) {
+	char *line = *cursor;
+	if (*line == 0)
+		return NULL;
+	char *end = strchr(line, '\n');
+	if (end == NULL) {
+		*cursor = line + strlen(line);
+		return line;
+	}
+	*cursor = end + 1;
+	if (end > line && end[-1] == '\r')
+		end--;
+	*end = 0;
+	return line;
+}
+
+/** Find end of header block (empty line) in data, return length of the block including terminating empty line or 0.
+ */
+static long header_length(const char *data) {
+	for (const char *line = data; (line = strchr(line, '\n')) != NULL; ) {
+		line++;
+		if (*line == '\n')
+			return line - data + 1;
+		if (*line == '\r' && line[1] == '\n')
+			return line - data + 2;
+	}
+	return 0;
+}
+
+/** Prepare response to complete request (request line and headers, lines are separated by new line), nothing is written to socket here.
+ */
+static connection_state http_response(int socket, char *data, http_transfer *transfer) {
+	transfer_init(transfer);
+	char *cursor = data;
+	char *request = next_line(&cursor);
+	char *header;
+	if (request == NULL)
+		return CONNECTION_CLOSE;
+	bool keep_alive = false;
+	if (!strncmp(request, "GET /", 5)) {
+		char *path = request + 4;
+		char *space = strchr(path, ' ');
+		if (space)
+			*space = 0;
+		char *param = strchr(path, '?');
+		if (param)
+			*param = 0;
+		char websocket_key[256] = "";
+		char range[256] = "";
+		while ((header = next_line(&cursor)) != NULL && *header) {
+			if (!strncasecmp(header, "Sec-WebSocket-Key: ", 19))
+				strncpy(websocket_key, header + 19, sizeof(websocket_key));
+			if (!strncasecmp(header, "Range: bytes=", 13))
+				strncpy(range, header + 13, sizeof(range) - 1);
+			if (!strcasecmp(header, "Connection: keep-alive"))
+				keep_alive = true;
+		}
+		if (!strcmp(path, "/")) {
+			if (*websocket_key) {
+				unsigned char shaHash[SHA1_SIZE];
+				memset(shaHash, 0, sizeof(shaHash));
+				strcat(websocket_key, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+				sha1(shaHash, websocket_key, strlen(websocket_key));
+				transfer_printf(transfer, "HTTP/1.1 101 Switching Protocols\r\n");
+				transfer_printf(transfer, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+				transfer_printf(transfer, "Upgrade: websocket\r\n");
+				transfer_printf(transfer, "Connection: upgrade\r\n");
+				base64_encode((unsigned char *)websocket_key, shaHash, 20);
+				transfer_printf(transfer, "Sec-WebSocket-Accept: %s\r\n", websocket_key);
+				transfer_printf(transfer, "\r\n");
+				return transfer->state = CONNECTION_WEB_SOCKET;
+			} else {
+				transfer_printf(transfer, "HTTP/1.1 301 OK\r\n");
+				transfer_printf(transfer, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+				transfer_printf(transfer, "Location: /mng.html\r\n");
+				transfer_printf(transfer, "Content-type: text/html\r\n");
+				transfer_printf(transfer, "\r\n");
+				transfer_printf(transfer, "<a href='/mng.html'>INDIGO Server Manager</a>");
+			}
+			keep_alive = false;
+		} else if (!strncmp(path, "/blob/", 6)) {
+			indigo_item *item;
+			indigo_blob_buffer *buffer;
+			if (sscanf(path, "/blob/%p.", &item) && (buffer = indigo_retain_blob(item))) {
+				long start = 0, end = buffer->size - 1;
+				if (*range && !parse_range(range, buffer->size, &start, &end)) {
+					transfer_printf(transfer, "HTTP/1.1 416 Range Not Satisfiable\r\n");
+					transfer_printf(transfer, "Content-Range: bytes */%ld\r\n", buffer->size);
+					transfer_printf(transfer, "Content-Length: 0\r\n");
+					transfer_printf(transfer, "\r\n");
+					INDIGO_LOG(indigo_log("%s -> Failed (range %s)", request, range));
+					indigo_release_blob_buffer(buffer);
+				} else {
+					transfer_printf(transfer, "HTTP/1.1 %s\r\nServer: INDIGO/%d.%d-%s\r\n", *range ? "206 Partial Content" : "200 OK", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+					if (!strcmp(buffer->format, ".jpeg"))
+						transfer_printf(transfer, "Content-Type: image/jpeg\r\n");
+					else
+						transfer_printf(transfer, "Content-Type: application/octet-stream\r\nContent-Disposition: attachment; filename=\"%p%s\"\r\n", item, buffer->format);
+					if (keep_alive)
+						transfer_printf(transfer, "Connection: keep-alive\r\n");
+					if (*range)
+						transfer_printf(transfer, "Content-Range: bytes %ld-%ld/%ld\r\n", start, end, buffer->size);
+					transfer_printf(transfer, "Accept-Ranges: bytes\r\nContent-Length: %ld\r\n\r\n", end - start + 1);
+					INDIGO_TRACE_PROTOCOL(indigo_trace("%d ← %s", socket, transfer->header));
+					// buffer stays retained until the transfer is finished
+					transfer->buffer = buffer;
+					transfer->content = buffer->content;
+					transfer->handle = buffer->handle;
+					transfer->offset = start;
+					transfer->remaining = transfer->length = end - start + 1;
+					snprintf(transfer->request, sizeof(transfer->request), "%s", request);
+				}
+			} else {
+				transfer_printf(transfer, "HTTP/1.1 404 Not found\r\n");
+				transfer_printf(transfer, "Content-Type: text/plain\r\n");
+				transfer_printf(transfer, "\r\n");
+				transfer_printf(transfer, "BLOB not found!\r\n");
+				INDIGO_LOG(indigo_log("%s -> Failed", request));
+				keep_alive = false;
+			}
+		} else {
+			struct resource *resource = resources;
+			while (resource) {
+				if (!strcmp(resource->path, path))
+					break;
+				resource = resource->next;
+			}
+			if (resource == NULL) {
+				transfer_printf(transfer, "HTTP/1.1 404 Not found\r\n");
+				transfer_printf(transfer, "Content-Type: text/plain\r\n");
+				transfer_printf(transfer, "\r\n");
+				transfer_printf(transfer, "%s not found!\r\n", path);
+				INDIGO_LOG(indigo_log("%s -> Failed", request));
+				keep_alive = false;
+			} else if (resource->data) {
+				transfer_printf(transfer, "HTTP/1.1 200 OK\r\n");
+				transfer_printf(transfer, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+				transfer_printf(transfer, "Content-Type: %s\r\n", resource->content_type);
+				transfer_printf(transfer, "Content-Length: %d\r\n", resource->length);
+				transfer_printf(transfer, "Content-Encoding: gzip\r\n");
+				transfer_printf(transfer, "\r\n");
+				transfer->content = resource->data;
+				transfer->remaining = transfer->length = resource->length;
+				snprintf(transfer->request, sizeof(transfer->request), "%s", request);
+			} else if (resource->file_name) {
+				char file_name[256];
+				struct stat file_stat;
+				int handle;
+				snprintf(file_name, sizeof(file_name), "%s/%s", getenv("HOME"), resource->file_name);
+				if (stat(file_name, &file_stat) < 0 || (handle = open(file_name, O_RDONLY)) < 0) {
+					transfer_printf(transfer, "HTTP/1.1 404 Not found\r\n");
+					transfer_printf(transfer, "Content-Type: text/plain\r\n");
+					transfer_printf(transfer, "\r\n");
+					transfer_printf(transfer, "%s not found (%s)\r\n", file_name, strerror(errno));
+					INDIGO_LOG(indigo_log("%s -> Failed to stat/open file (%s, %s)", request, file_name, strerror(errno)));
+					keep_alive = false;
+				} else {
+					transfer_printf(transfer, "HTTP/1.1 200 OK\r\n");
+					transfer_printf(transfer, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
+					transfer_printf(transfer, "Content-Type: %s\r\n", resource->content_type);
+					transfer_printf(transfer, "Content-Length: %ld\r\n", (long)file_stat.st_size);
+					transfer_printf(transfer, "\r\n");
+					transfer->handle = handle;
+					transfer->remaining = transfer->length = file_stat.st_size;
+					snprintf(transfer->request, sizeof(transfer->request), "%s", request);
+				}
+			}
+		}
+	}
+	return transfer->state = keep_alive ? CONNECTION_KEEP_ALIVE : CONNECTION_CLOSE;
+}
+
+static connection_state http_request(int socket, http_transfer *transfer) {
+	char data[HTTP_HEADER_SIZE];
+	long length = 0;
+	int line_length;
+	do {
+		line_length = indigo_read_line(socket, data + length, (int)(sizeof(data) - length - 1));
+		if (line_length < 0)
+			return CONNECTION_CLOSE;
+		length += line_length;
+		data[length++] = '\n';
+	} while (line_length > 0 && length < sizeof(data) - 2);
+	data[length] = 0;
+	connection_state state = http_response(socket, data, transfer);
+	// socket is blocking, so EAGAIN means send timeout
+	int result = transfer_write(socket, transfer);
+	transfer_finish(transfer, result > 0);
+	return result > 0 ? state : CONNECTION_CLOSE;
+}
 
 static void start_worker_thread(int *client_socket) {
 	int socket = *client_socket;
 	INDIGO_LOG(indigo_log("Worker thread started socket = %d", socket));
-	server_callback(++client_count);
-	int res = 0;
 	char c;
 	if (recv(socket, &c, 1, MSG_PEEK) == 1) {
 		if (c == '<') {
-			INDIGO_LOG(indigo_log("Protocol switched to XML"));
-			indigo_client *protocol_adapter = indigo_xml_device_adapter(socket, socket);
-			assert(protocol_adapter != NULL);
-			indigo_attach_client(protocol_adapter);
-			indigo_xml_parse(NULL, protocol_adapter);
-			indigo_detach_client(protocol_adapter);
-			indigo_release_xml_device_adapter(protocol_adapter);
+			xml_session(socket);
 		} else if (c == '{') {
-			INDIGO_LOG(indigo_log("Protocol switched to JSON"));
-			indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, false);
-			assert(protocol_adapter != NULL);
-			indigo_attach_client(protocol_adapter);
-			indigo_json_parse(NULL, protocol_adapter);
-			indigo_detach_client(protocol_adapter);
-			indigo_release_json_device_adapter(protocol_adapter);
+			json_session(socket, false);
 		} else if (c == 'G') {
-			char request[BUFFER_SIZE];
-			char header[BUFFER_SIZE];
-			while ((res = indigo_read_line(socket, request, BUFFER_SIZE)) >= 0) {
-				bool keep_alive = false;
-				if (!strncmp(request, "GET /", 5)) {
-					char *path = request + 4;
-					char *space = strchr(path, ' ');
-					if (space)
-						*space = 0;
-					char *param = strchr(path, '?');
-					if (param)
-						*param = 0;
-					char websocket_key[256] = "";
-					while (indigo_read_line(socket, header, BUFFER_SIZE) > 0) {
-						if (!strncasecmp(header, "Sec-WebSocket-Key: ", 19))
-							strncpy(websocket_key, header + 19, sizeof(websocket_key));
-						if (!strcasecmp(header, "Connection: keep-alive"))
-							keep_alive = true;
-					}
-					if (!strcmp(path, "/")) {
-						if (*websocket_key) {
-							unsigned char shaHash[SHA1_SIZE];
-							memset(shaHash, 0, sizeof(shaHash));
-							strcat(websocket_key, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
-							sha1(shaHash, websocket_key, strlen(websocket_key));
-							indigo_printf(socket, "HTTP/1.1 101 Switching Protocols\r\n");
-							indigo_printf(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							indigo_printf(socket, "Upgrade: websocket\r\n");
-							indigo_printf(socket, "Connection: upgrade\r\n");
-							base64_encode((unsigned char *)websocket_key, shaHash, 20);
-							indigo_printf(socket, "Sec-WebSocket-Accept: %s\r\n", websocket_key);
-							indigo_printf(socket, "\r\n");
-							INDIGO_LOG(indigo_log("Protocol switched to JSON-over-WebSockets"));
-							indigo_client *protocol_adapter = indigo_json_device_adapter(socket, socket, true);
-							assert(protocol_adapter != NULL);
-							indigo_attach_client(protocol_adapter);
-							indigo_json_parse(NULL, protocol_adapter);
-							indigo_detach_client(protocol_adapter);
-						} else {
-							indigo_printf(socket, "HTTP/1.1 301 OK\r\n");
-							indigo_printf(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							indigo_printf(socket, "Location: /mng.html\r\n");
-							indigo_printf(socket, "Content-type: text/html\r\n");
-							indigo_printf(socket, "\r\n");
-							indigo_printf(socket, "<a href='/mng.html'>INDIGO Server Manager</a>");
-						}
-						keep_alive = false;
-					} else if (!strncmp(path, "/blob/", 6)) {
-						indigo_item *item;
-						indigo_blob_entry *entry;
-						if (sscanf(path, "/blob/%p.", &item) && (entry = indigo_validate_blob(item))) {
-							indigo_printf(socket, "HTTP/1.1 200 OK\r\n");
-							indigo_printf(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							if (!strcmp(entry->format, ".jpeg")) {
-								indigo_printf(socket, "Content-Type: image/jpeg\r\n");
-							} else {
-								indigo_printf(socket, "Content-Type: application/octet-stream\r\n");
-								indigo_printf(socket, "Content-Disposition: attachment; filename=\"%p%s\"\r\n", item, entry->format);
-							}
-							if (keep_alive)
-								indigo_printf(socket, "Connection: keep-alive\r\n");
-							indigo_printf(socket, "Content-Length: %ld\r\n", entry->size);
-							indigo_printf(socket, "\r\n");
-							pthread_mutex_lock(&entry->mutext);
-							if (indigo_write(socket, entry->content, entry->size)) {
-								INDIGO_LOG(indigo_log("%s -> OK (%ld bytes)", request, entry->size));
-							} else {
-								INDIGO_LOG(indigo_log("%s -> Failed (%s)", request, strerror(errno)));
-								keep_alive = false;
-							}
-							pthread_mutex_unlock(&entry->mutext);
-						} else {
-							indigo_printf(socket, "HTTP/1.1 404 Not found\r\n");
-							indigo_printf(socket, "Content-Type: text/plain\r\n");
-							indigo_printf(socket, "\r\n");
-							indigo_printf(socket, "BLOB not found!\r\n");
-							shutdown(socket,SHUT_RDWR);
-							indigo_usleep(ONE_SECOND_DELAY);
-							close(socket);
-							INDIGO_LOG(indigo_log("%s -> Failed", request));
-							keep_alive = false;
-						}
-					} else {
-						struct resource *resource = resources;
-						while (resource) {
-							if (!strcmp(resource->path, path))
-								break;
-							resource = resource->next;
-						}
-						if (resource == NULL) {
-							indigo_printf(socket, "HTTP/1.1 404 Not found\r\n");
-							indigo_printf(socket, "Content-Type: text/plain\r\n");
-							indigo_printf(socket, "\r\n");
-							indigo_printf(socket, "%s not found!\r\n", path);
-							INDIGO_LOG(indigo_log("%s -> Failed", request));
-							keep_alive = false;
-						} else if (resource->data) {
-							indigo_printf(socket, "HTTP/1.1 200 OK\r\n");
-							indigo_printf(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-							indigo_printf(socket, "Content-Type: %s\r\n", resource->content_type);
-							indigo_printf(socket, "Content-Length: %d\r\n", resource->length);
-							indigo_printf(socket, "Content-Encoding: gzip\r\n");
-							indigo_printf(socket, "\r\n");
-							indigo_write(socket, (const char *)resource->data, resource->length);
-							INDIGO_LOG(indigo_log("%s -> OK (%d bytes)", request, resource->length));
-						} else if (resource->file_name) {
-							char file_name[256];
-							struct stat file_stat;
-							int handle;
-							sprintf(file_name, "%s/%s", getenv("HOME"), resource->file_name);
-							if (stat(file_name, &file_stat) < 0 || (handle = open(file_name, O_RDONLY)) < 0) {
-								indigo_printf(socket, "HTTP/1.1 404 Not found\r\n");
-								indigo_printf(socket, "Content-Type: text/plain\r\n");
-								indigo_printf(socket, "\r\n");
-								indigo_printf(socket, "%s not found (%s)\r\n", file_name, strerror(errno));
-								INDIGO_LOG(indigo_log("%s -> Failed to stat/open file (%s, %s)", request, file_name, strerror(errno)));
-								keep_alive = false;
-							} else {
-								indigo_printf(socket, "HTTP/1.1 200 OK\r\n");
-								indigo_printf(socket, "Server: INDIGO/%d.%d-%s\r\n", (INDIGO_VERSION_CURRENT >> 8) & 0xFF, INDIGO_VERSION_CURRENT & 0xFF, INDIGO_BUILD);
-								indigo_printf(socket, "Content-Type: %s\r\n", resource->content_type);
-								indigo_printf(socket, "Content-Length: %d\r\n", file_stat.st_size);
-								indigo_printf(socket, "\r\n");
-								long remaining = file_stat.st_size;
-								char buffer[128 * 1024];
-								while (remaining > 0) {
-									long count = read(handle, buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
-									if (count < 0) {
-										INDIGO_LOG(indigo_log("%s -> Failed to read file (%s)", request, strerror(errno)));
-										break;
-									}
-									if (indigo_write(socket, buffer, count)) {
-										INDIGO_LOG(indigo_log("%s -> OK (%ld bytes)", request, count));
-									} else {
-										INDIGO_LOG(indigo_log("%s -> Failed (%s)", request, strerror(errno)));
-										keep_alive = false;
-										break;
-									}
-									remaining -= count;
-								}
-								close(handle);
-							}
-						}
-					}
-				}
-				if (!keep_alive) {
-					break;
-				}
+			connection_state state;
+			http_transfer *transfer = malloc(sizeof(http_transfer));
+			assert(transfer != NULL);
+			set_timeouts(socket, HTTP_TIMEOUT);
+			while ((state = http_request(socket, transfer)) == CONNECTION_KEEP_ALIVE)
+				;
+			free(transfer);
+			if (state == CONNECTION_WEB_SOCKET) {
+				set_timeouts(socket, 0);
+				json_session(socket, true);
 			}
 		} else {
 			INDIGO_LOG(indigo_log("Unrecognised protocol"));
 		}
 	}
-	shutdown(socket, SHUT_RDWR);
-	//indigo_usleep(ONE_SECOND_DELAY); // ???
-	close(socket);
-	server_callback(--client_count);
+	close_connection(socket);
 	free(client_socket);
 	INDIGO_LOG(indigo_log("Worker thread finished"));
 }
 
+static void start_session_thread(int socket, void (*thread)(int *)) {
+	int *pointer = malloc(sizeof(int));
+	*pointer = socket;
+	if (!indigo_async((void *(*)(void *))thread, pointer)) {
+		indigo_error("Can't create worker thread for connection (%s)", strerror(errno));
+		free(pointer);
+		close_connection(socket);
+	}
+}
+
+#ifdef INDIGO_LINUX
+
+#define SESSION_BUFFER_SIZE	(64 * 1024)
+#define SESSION_READS	16
+
+struct http_connection;
+
+/** Epoll registration of connection, XML session has another one for its output written to duplicate of socket.
+ */
+typedef struct {
+	struct http_connection *connection;
+	bool output;
+} reactor_source;
+
+/** Connection served by reactor, no thread is created for it.
+ HTTP requests are read without blocking and collected in data, complete requests are served by workers and responses are written when socket is writable.
+ XML and JSON sessions are parsed incrementally by workers when socket is readable.
+ XML session output is written by workers when socket is writable, JSON session output is written by bus as before (socket is blocking).
+ Connection (and output of XML session) is owned either by epoll or by single worker serving it (busy).
+ */
+typedef struct http_connection {
+	struct http_connection *previous, *next;
+	int socket;
+	int output;												///< XML session output (duplicate of socket or -1)
+	reactor_source source;						///< epoll data of socket
+	reactor_source output_source;			///< epoll data of output
+	bool busy;												///< being served (not armed in epoll)
+	bool detected;										///< protocol detected as HTTP
+	bool expired;											///< socket was shut down by timeout
+	bool output_registered;						///< output was added to epoll
+	bool output_armed;								///< XML session is waiting for writable socket in epoll
+	bool output_busy;									///< XML session output is being written
+	bool output_pending;							///< XML session output was requested while being written
+	bool closing;											///< XML session ended, output is being drained
+	indigo_client *session;						///< XML or JSON session adapter
+	indigo_xml_parser *xml_parser;		///< XML session parser
+	indigo_json_parser *json_parser;	///< JSON session parser
+	time_t deadline;									///< next request (or drain of ended XML session) has to be complete by this time
+	long length;											///< bytes in data
+	http_transfer transfer;						///< response being written
+	char data[HTTP_HEADER_SIZE];			///< partial request
+} http_connection;
+
+static pthread_mutex_t connections_mutex = PTHREAD_MUTEX_INITIALIZER;
+static http_connection *connections = NULL;
+static bool reactor_running = false;
+static time_t last_expiration = 0;
+
+static void reactor_unlink(http_connection *connection) {
+	if (connection->previous)
+		connection->previous->next = connection->next;
+	else
+		connections = connection->next;
+	if (connection->next)
+		connection->next->previous = connection->previous;
+}
+
+static void reactor_add(int socket) {
+	http_connection *connection = malloc(sizeof(http_connection));
+	assert(connection != NULL);
+	memset(connection, 0, offsetof(http_connection, transfer.request));
+	connection->transfer.request[0] = 0;
+	connection->transfer.handle = -1;
+	connection->socket = socket;
+	connection->output = -1;
+	connection->source.connection = connection->output_source.connection = connection;
+	connection->output_source.output = true;
+	connection->deadline = time(NULL) + HTTP_TIMEOUT;
+	struct epoll_event event = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = &connection->source };
+	pthread_mutex_lock(&connections_mutex);
+	connection->next = connections;
+	if (connections)
+		connections->previous = connection;
+	connections = connection;
+	bool added = reactor_running && epoll_ctl(epoll_handle, EPOLL_CTL_ADD, socket, &event) == 0;
+	if (!added)
+		reactor_unlink(connection);
+	pthread_mutex_unlock(&connections_mutex);
+	if (!added) {
+		indigo_error("Can't add connection to epoll (%s)", strerror(errno));
+		close_connection(socket);
+		free(connection);
+	}
+}
+
+static void reactor_close(http_connection *connection) {
+	pthread_mutex_lock(&connections_mutex);
+	reactor_unlink(connection);
+	pthread_mutex_unlock(&connections_mutex);
+	close_connection(connection->socket);
+	free(connection);
+}
+
+/** Shut down connections not completing request (or drain of ended XML session) in time, worker then gets EOF or error and closes them.
+ */
+static void reactor_expire() {
+	time_t now = time(NULL);
+	pthread_mutex_lock(&connections_mutex);
+	if (now != last_expiration) {
+		last_expiration = now;
+		for (http_connection *connection = connections; connection; connection = connection->next) {
+			if (connection->expired || now <= connection->deadline)
+				continue;
+			if (connection->session ? connection->closing && !connection->output_busy : !connection->busy) {
+				INDIGO_LOG(indigo_log("Connection %d timed out", connection->socket));
+				connection->expired = true;
+				shutdown(connection->socket, SHUT_RDWR);
+			}
+		}
+	}
+	pthread_mutex_unlock(&connections_mutex);
+}
+
+/** Wait for writable socket of XML session, called with connections_mutex locked.
+ Return false only if output can't be armed in running reactor, when reactor is stopped connection is closed by stop_reactor().
+ */
+static bool reactor_arm_output(http_connection *connection) {
+	if (!reactor_running)
+		return true;
+	if (!connection->output_armed) {
+		struct epoll_event event = { .events = EPOLLOUT | EPOLLONESHOT, .data.ptr = &connection->output_source };
+		connection->output_armed = epoll_ctl(epoll_handle, connection->output_registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, connection->output, &event) == 0;
+		if (connection->output_armed)
+			connection->output_registered = true;
+		else
+			indigo_error("Can't arm connection %d in epoll (%s)", connection->socket, strerror(errno));
+	}
+	return connection->output_armed;
+}
+
+/** Output callback of XML session adapter, called on bus thread when new output is queued.
+ */
+static void reactor_schedule_output(http_connection *connection) {
+	pthread_mutex_lock(&connections_mutex);
+	connection->output_pending = true;
+	if (!connection->output_busy)
+		reactor_arm_output(connection);
+	pthread_mutex_unlock(&connections_mutex);
+}
+
+/** Remove ended XML session from reactor and close it.
+ */
+static void reactor_close_session(http_connection *connection) {
+	pthread_mutex_lock(&connections_mutex);
+	reactor_unlink(connection);
+	if (reactor_running) {
+		epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->socket, NULL);
+		if (connection->output_registered)
+			epoll_ctl(epoll_handle, EPOLL_CTL_DEL, connection->output, NULL);
+	}
+	pthread_mutex_unlock(&connections_mutex);
+	indigo_release_xml_device_adapter(connection->session);
+	close(connection->output);
+	close_connection(connection->socket);
+	free(connection);
+}
+
+static void reactor_write(http_connection *connection) {
+	bool pending = indigo_xml_device_adapter_flush(connection->session);
+	bool drained = false;
+	pthread_mutex_lock(&connections_mutex);
+	connection->output_busy = false;
+	if (pending || connection->output_pending)
+		drained = !reactor_arm_output(connection) && connection->closing;
+	else
+		drained = connection->closing && reactor_running;
+	pthread_mutex_unlock(&connections_mutex);
+	if (drained)
+		reactor_close_session(connection);
+}
+
+/** End XML or JSON session, output left by XML session is written by workers and connection is closed when it is drained or deadline expires.
+ */
+static void reactor_end_session(http_connection *connection) {
+	indigo_detach_client(connection->session);
+	if (connection->json_parser) {
+		indigo_json_parser_release(connection->json_parser);
+		indigo_release_json_device_adapter(connection->session);
+		reactor_close(connection);
+		return;
+	}
+	indigo_xml_parser_release(connection->xml_parser);
+	connection->xml_parser = NULL;
+	bool failed = false;
+	pthread_mutex_lock(&connections_mutex);
+	connection->closing = true;
+	connection->deadline = time(NULL) + DRAIN_TIMEOUT;
+	connection->output_pending = true;
+	if (!connection->output_busy)
+		failed = !reactor_arm_output(connection);
+	pthread_mutex_unlock(&connections_mutex);
+	if (failed)
+		reactor_close_session(connection);
+}
+
+/** Return connection to epoll, connection left busy when reactor is stopped meanwhile is closed by stop_reactor().
+ */
+static void reactor_rearm(http_connection *connection, uint32_t events) {
+	struct epoll_event event = { .events = events | EPOLLONESHOT, .data.ptr = &connection->source };
+	bool armed = true;
+	pthread_mutex_lock(&connections_mutex);
+	if (reactor_running) {
+		connection->busy = false;
+		armed = epoll_ctl(epoll_handle, EPOLL_CTL_MOD, connection->socket, &event) == 0;
+		connection->busy = !armed;
+	}
+	pthread_mutex_unlock(&connections_mutex);
+	if (!armed) {
+		indigo_error("Can't rearm connection %d in epoll (%s)", connection->socket, strerror(errno));
+		if (connection->session)
+			reactor_end_session(connection);
+		else
+			reactor_close(connection);
+	}
+}
+
+static bool reactor_feed(http_connection *connection, const char *data, long length) {
+	if (connection->xml_parser)
+		return indigo_xml_parser_feed(connection->xml_parser, data, length);
+	return indigo_json_parser_feed(connection->json_parser, data, length);
+}
+
+/** Switch connection to XML or JSON session, parser gets data read together with request.
+ */
+static void reactor_start_session(http_connection *connection, bool xml, bool web_socket) {
+	int socket = connection->socket;
+	indigo_client *protocol_adapter;
+	if (xml) {
+		INDIGO_LOG(indigo_log("Protocol switched to XML"));
+		// output is registered in epoll separately, so bus thread never touches registration of input
+		if ((connection->output = dup(socket)) < 0) {
+			indigo_error("Can't duplicate socket for XML session (%s)", strerror(errno));
+			reactor_close(connection);
+			return;
+		}
+		protocol_adapter = indigo_xml_device_adapter_async(socket, socket, (indigo_xml_output_callback)reactor_schedule_output, connection);
+		assert(protocol_adapter != NULL);
+		connection->xml_parser = indigo_xml_parser_create(NULL, protocol_adapter);
+	} else {
+		INDIGO_LOG(indigo_log("Protocol switched to %s", web_socket ? "JSON-over-WebSockets" : "JSON"));
+		protocol_adapter = indigo_json_device_adapter(socket, socket, web_socket);
+		assert(protocol_adapter != NULL);
+		connection->json_parser = indigo_json_parser_create(NULL, protocol_adapter);
+	}
+	pthread_mutex_lock(&connections_mutex);
+	connection->session = protocol_adapter;
+	pthread_mutex_unlock(&connections_mutex);
+	indigo_attach_client(protocol_adapter);
+	if (connection->length > 0) {
+		long length = connection->length;
+		connection->length = 0;
+		if (!reactor_feed(connection, connection->data, length)) {
+			reactor_end_session(connection);
+			return;
+		}
+	}
+	reactor_rearm(connection, EPOLLIN);
+}
+
+/** Parse data available on session socket, number of reads per event is limited so that one busy session can't hold worker.
+ */
+static void reactor_session_read(http_connection *connection) {
+	char buffer[SESSION_BUFFER_SIZE];
+	for (int i = 0; i < SESSION_READS; i++) {
+		ssize_t bytes_read = recv(connection->socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (bytes_read < 0 && errno == EINTR)
+			continue;
+		if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (bytes_read <= 0 || !reactor_feed(connection, buffer, bytes_read)) {
+			reactor_end_session(connection);
+			return;
+		}
+		if (bytes_read < sizeof(buffer))
+			break;
+	}
+	reactor_rearm(connection, EPOLLIN);
+}
+
+/** Write pending response and serve all complete requests collected in connection, connection is rearmed when socket is not writable or request is not complete.
+ */
+static void reactor_dispatch(http_connection *connection) {
+	int socket = connection->socket;
+	http_transfer *transfer = &connection->transfer;
+	while (true) {
+		if (transfer->active) {
+			int result = transfer_write(socket, transfer);
+			if (result == 0) {
+				connection->deadline = time(NULL) + HTTP_TIMEOUT;
+				reactor_rearm(connection, EPOLLOUT);
+				return;
+			}
+			transfer_finish(transfer, result > 0);
+			if (result < 0 || transfer->state == CONNECTION_CLOSE) {
+				reactor_close(connection);
+				return;
+			}
+			if (transfer->state == CONNECTION_WEB_SOCKET) {
+				// JSON adapter writes on bus thread, so session socket is blocking again
+				fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) & ~O_NONBLOCK);
+				reactor_start_session(connection, false, true);
+				return;
+			}
+			connection->deadline = time(NULL) + HTTP_TIMEOUT;
+		}
+		connection->data[connection->length] = 0;
+		long length = header_length(connection->data);
+		if (length == 0) {
+			if (connection->length == HTTP_HEADER_SIZE - 1) {
+				INDIGO_LOG(indigo_log("Request header too large"));
+				reactor_close(connection);
+			} else {
+				reactor_rearm(connection, EPOLLIN);
+			}
+			return;
+		}
+		char request[HTTP_HEADER_SIZE];
+		memcpy(request, connection->data, length);
+		request[length] = 0;
+		memmove(connection->data, connection->data + length, connection->length - length);
+		connection->length -= length;
+		http_response(socket, request, transfer);
+	}
+}
+
+static void reactor_read(http_connection *connection) {
+	int socket = connection->socket;
+	if (!connection->detected) {
+		char c;
+		ssize_t bytes_read = recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			reactor_rearm(connection, EPOLLIN);
+			return;
+		}
+		if (bytes_read != 1) {
+			reactor_close(connection);
+			return;
+		}
+		if (c == '<' || c == '{') {
+			reactor_start_session(connection, c == '<', false);
+			return;
+		}
+		if (c != 'G') {
+			INDIGO_LOG(indigo_log("Unrecognised protocol"));
+			reactor_close(connection);
+			return;
+		}
+		// responses are written without blocking, reactor_expire() closes connections not making progress
+		fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+		connection->detected = true;
+	}
+	while (connection->length < HTTP_HEADER_SIZE - 1) {
+		ssize_t bytes_read = recv(socket, connection->data + connection->length, HTTP_HEADER_SIZE - 1 - connection->length, MSG_DONTWAIT);
+		if (bytes_read < 0 && errno == EINTR)
+			continue;
+		if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (bytes_read <= 0) {
+			reactor_close(connection);
+			return;
+		}
+		connection->length += bytes_read;
+	}
+	reactor_dispatch(connection);
+}
+
+static void *reactor_worker(void *data) {
+	struct epoll_event event;
+	while (true) {
+		int count = epoll_wait(epoll_handle, &event, 1, 1000);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count < 0 || (count == 1 && event.data.ptr == NULL))
+			break;
+		reactor_expire();
+		if (count == 0)
+			continue;
+		reactor_source *source = event.data.ptr;
+		http_connection *connection = source->connection;
+		pthread_mutex_lock(&connections_mutex);
+		if (source->output) {
+			connection->output_busy = true;
+			connection->output_armed = connection->output_pending = false;
+		} else {
+			connection->busy = true;
+		}
+		pthread_mutex_unlock(&connections_mutex);
+		if (source->output)
+			reactor_write(connection);
+		else if (connection->session)
+			reactor_session_read(connection);
+		else if (connection->transfer.active)
+			reactor_dispatch(connection);
+		else
+			reactor_read(connection);
+	}
+	return NULL;
+}
+
+static bool start_reactor() {
+	if (indigo_server_tcp_workers <= 0)
+		return false;
+	epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_handle < 0) {
+		indigo_error("Can't create epoll (%s)", strerror(errno));
+		return false;
+	}
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+	if (pipe(wakeup_pipe) < 0 || epoll_ctl(epoll_handle, EPOLL_CTL_ADD, wakeup_pipe[0], &event) < 0) {
+		indigo_error("Can't create reactor wakeup pipe (%s)", strerror(errno));
+		close(epoll_handle);
+		return false;
+	}
+	reactor_running = true;
+	reactor_workers = malloc(indigo_server_tcp_workers * sizeof(pthread_t));
+	for (reactor_worker_count = 0; reactor_worker_count < indigo_server_tcp_workers; reactor_worker_count++) {
+		if (pthread_create(reactor_workers + reactor_worker_count, NULL, reactor_worker, NULL) != 0) {
+			indigo_error("Can't create reactor worker (%s)", strerror(errno));
+			break;
+		}
+	}
+	if (reactor_worker_count == 0) {
+		reactor_running = false;
+		free(reactor_workers);
+		close(wakeup_pipe[0]);
+		close(wakeup_pipe[1]);
+		close(epoll_handle);
+		return false;
+	}
+	INDIGO_LOG(indigo_log("Reactor started with %d workers", reactor_worker_count));
+	return true;
+}
+
+static void stop_reactor() {
+	pthread_mutex_lock(&connections_mutex);
+	reactor_running = false;
+	pthread_mutex_unlock(&connections_mutex);
+	close(wakeup_pipe[1]);
+	for (int i = 0; i < reactor_worker_count; i++)
+		pthread_join(reactor_workers[i], NULL);
+	free(reactor_workers);
+	close(wakeup_pipe[0]);
+	// workers are finished, so every connection left is owned by this thread, sessions are detached from bus before they are released
+	pthread_mutex_lock(&connections_mutex);
+	http_connection *connection = connections;
+	connections = NULL;
+	pthread_mutex_unlock(&connections_mutex);
+	while (connection) {
+		http_connection *next = connection->next;
+		shutdown(connection->socket, SHUT_RDWR);
+		if (connection->session) {
+			if (!connection->closing)
+				indigo_detach_client(connection->session);
+			if (connection->json_parser) {
+				indigo_json_parser_release(connection->json_parser);
+				indigo_release_json_device_adapter(connection->session);
+			} else {
+				if (connection->xml_parser)
+					indigo_xml_parser_release(connection->xml_parser);
+				indigo_release_xml_device_adapter(connection->session);
+				close(connection->output);
+			}
+		} else if (connection->transfer.active) {
+			transfer_finish(&connection->transfer, false);
+		}
+		close_connection(connection->socket);
+		free(connection);
+		connection = next;
+	}
+	close(epoll_handle);
+	epoll_handle = -1;
+	INDIGO_LOG(indigo_log("Reactor stopped"));
+}
+
+#endif
+
 void indigo_server_shutdown() {
 	if (!shutdown_initiated) {
 		shutdown_initiated = true;
@@ -374,6 +1079,9 @@ indigo_result indigo_server_start(indigo_server_tcp_callback callback) {
 	INDIGO_LOG(indigo_log("Server started on %d", indigo_server_tcp_port));
 	server_callback(client_count);
 	signal(SIGPIPE, SIG_IGN);
+#ifdef INDIGO_LINUX
+	bool use_reactor = start_reactor();
+#endif
 	while (1) {
 		client_socket = accept(server_socket, (struct sockaddr *)&client_name, &name_len);
 		if (client_socket == -1) {
@@ -381,12 +1089,20 @@ indigo_result indigo_server_start(indigo_server_tcp_callback callback) {
 				break;
 			indigo_error("Can't accept connection (%s)", strerror(errno));
 		} else {
-			int *pointer = malloc(sizeof(int));
-			*pointer = client_socket;
-			if (!indigo_async((void *(*)(void *))&start_worker_thread, pointer))
-				indigo_error("Can't create worker thread for connection (%s)", strerror(errno));
+			update_client_count(1);
+#ifdef INDIGO_LINUX
+			if (use_reactor) {
+				reactor_add(client_socket);
+				continue;
+			}
+#endif
+			start_session_thread(client_socket, start_worker_thread);
 		}
 	}
+#ifdef INDIGO_LINUX
+	if (use_reactor)
+		stop_reactor();
+#endif
 	shutdown_initiated = false;
 	return INDIGO_OK;
 }
@@ -35,6 +35,12 @@
 #include <math.h>
 #include <fcntl.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #if defined(INDIGO_LINUX) || defined(INDIGO_MACOS)
 #include <unistd.h>
 #endif
@@ -125,16 +131,57 @@ static indigo_rule parse_rule(char *value) {
 	return INDIGO_ANY_OF_MANY_RULE;
 }
 
+/** Find the first occurrence of a or b in [pointer, end), returns end if there is none.
+ */
+static const char *scan_run(const char *pointer, const char *end, char a, char b) {
+#if defined(__SSE2__)
+	const __m128i va = _mm_set1_epi8(a);
+	const __m128i vb = _mm_set1_epi8(b);
+	while (pointer + 16 <= end) {
+		__m128i v = _mm_loadu_si128((__m128i *)pointer);
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+		if (mask)
+			return pointer + __builtin_ctz(mask);
+		pointer += 16;
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const uint8x16_t va = vdupq_n_u8(a);
+	const uint8x16_t vb = vdupq_n_u8(b);
+	while (pointer + 16 <= end) {
+		uint8x16_t v = vld1q_u8((uint8_t *)pointer);
+		if (vmaxvq_u8(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb))))
+			break;
+		pointer += 16;
+	}
+#endif
+	while (pointer < end && *pointer != a && *pointer != b)
+		pointer++;
+	return pointer;
+}
+
+typedef struct {
+	long capacity;					/* allocated size of defined item buffer */
+	unsigned char *spare;		/* parser owned buffer the next BLOB is decoded to */
+	long spare_capacity;		/* allocated size of spare buffer */
+} blob_slot;
+
 typedef struct {
 	char property_buffer[PROPERTY_SIZE];
 	indigo_device *device;
 	indigo_client *client;
 	int count;
 	indigo_property **properties;
+	blob_slot **blob_slots; /* BLOB item buffers of defined properties, parallel to properties */
 } parser_context;
 
 bool indigo_use_blob_urls = true;
 
+/** Clear property buffer after a message. Items above property->count are never written, so they are still zeroed.
+ */
+static void reset_property(indigo_property *property) {
+	memset(property, 0, sizeof(indigo_property) + property->count * sizeof(indigo_item));
+}
+
 typedef void *(* parser_handler)(parser_state state, parser_context *context, char *name, char *value, char *message);
 
 static void *top_level_handler(parser_state state, parser_context *context, char *name, char *value, char *message);
@@ -197,7 +244,7 @@ static void *enable_blob_handler(parser_state state, parser_context *context, ch
 			indigo_enable_blob(client, property, INDIGO_ENABLE_BLOB_NEVER);
 		}
 	} else if (state == END_TAG) {
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return enable_blob_handler;
@@ -235,7 +282,7 @@ static void *get_properties_handler(parser_state state, parser_context *context,
 		}
 	} else if (state == END_TAG) {
 		indigo_enumerate_properties(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return get_properties_handler;
@@ -277,7 +324,7 @@ static void *new_text_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		indigo_change_property(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return new_text_vector_handler;
@@ -319,7 +366,7 @@ static void *new_number_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		indigo_change_property(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return new_number_vector_handler;
@@ -362,7 +409,7 @@ static void *new_switch_vector_handler(parser_state state, parser_context *conte
 		return new_switch_vector_handler;
 	} else if (state == END_TAG) {
 		indigo_change_property(client, property);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return new_switch_vector_handler;
@@ -388,6 +435,9 @@ static void set_property(parser_context *context, indigo_property *other, char *
 	for (int index = 0; index < context->count; index++) {
 		indigo_property *property = context->properties[index];
 		if (property != NULL && !strncmp(property->device, other->device, INDIGO_NAME_SIZE) && !strncmp(property->name, other->name, INDIGO_NAME_SIZE)) {
+			/* BLOB item buffers are swapped under property lock, so consumers reading content under the lock never see it replaced */
+			if (property->type == INDIGO_BLOB_VECTOR)
+				indigo_lock_property(property);
 			property->state = other->state;
 			if (property->type == INDIGO_SWITCH_VECTOR && property->rule != INDIGO_ANY_OF_MANY_RULE) {
 				for (int j = 0; j < property->count; j++) {
@@ -429,21 +479,39 @@ static void set_property(parser_context *context, indigo_property *other, char *
 							case INDIGO_LIGHT_VECTOR:
 								property_item->light.value = other_item->light.value;
 								break;
-							case INDIGO_BLOB_VECTOR:
+							case INDIGO_BLOB_VECTOR: {
 								strncpy(property_item->blob.format, other_item->blob.format, INDIGO_NAME_SIZE);
 								strncpy(property_item->blob.url, other_item->blob.url, INDIGO_VALUE_SIZE);
 								property_item->blob.size = other_item->blob.size;
-								if (property_item->blob.value != NULL)
-									property_item->blob.value = realloc(property_item->blob.value, property_item->blob.size);
-								else
-									property_item->blob.value = malloc(property_item->blob.size);
-								memcpy(property_item->blob.value, other_item->blob.value, property_item->blob.size);
+								blob_slot *slot = context->blob_slots[index] + j;
+								if (other_item->blob.value != NULL && other_item->blob.value == slot->spare) {
+									/* inline BLOB was decoded to the spare buffer, previous item buffer becomes spare for the next one */
+									unsigned char *value = property_item->blob.value;
+									long capacity = slot->capacity;
+									property_item->blob.value = slot->spare;
+									slot->capacity = slot->spare_capacity;
+									slot->spare = value;
+									slot->spare_capacity = value ? capacity : 0;
+								} else if (other_item->blob.value == NULL && property_item->blob.value != NULL) {
+									/* URL only BLOB has no content */
+									if (slot->spare == NULL) {
+										slot->spare = property_item->blob.value;
+										slot->spare_capacity = slot->capacity;
+									} else {
+										free(property_item->blob.value);
+									}
+									property_item->blob.value = NULL;
+									slot->capacity = 0;
+								}
 								break;
+							}
 						}
 						break;
 					}
 				}
 			}
+			if (property->type == INDIGO_BLOB_VECTOR)
+				indigo_unlock_property(property);
 			INDIGO_TRACE_PARSER(indigo_trace("XML Parser: set_property '%s' '%s' %d", property->device, property->name, index));
 			indigo_update_property(context->device, property, *message ? message : NULL);
 			break;
@@ -451,6 +519,55 @@ static void set_property(parser_context *context, indigo_property *other, char *
 	}
 }
 
+/** Returns parser owned spare buffer of the defined property item the incoming BLOB is decoded to (or NULL if the property is unknown).
+ Item buffer is never touched while decoding, set_property() swaps the buffers. Spare is reallocated only if BLOB grows.
+ */
+static unsigned char *blob_destination(parser_context *context, indigo_property *other, indigo_item *other_item, long size) {
+	for (int index = 0; index < context->count; index++) {
+		indigo_property *property = context->properties[index];
+		if (property != NULL && property->type == INDIGO_BLOB_VECTOR && !strncmp(property->device, other->device, INDIGO_NAME_SIZE) && !strncmp(property->name, other->name, INDIGO_NAME_SIZE)) {
+			for (int j = 0; j < property->count; j++) {
+				indigo_item *property_item = &property->items[j];
+				if (!strcmp(property_item->name, other_item->name)) {
+					blob_slot *slot = context->blob_slots[index] + j;
+					if (slot->spare == NULL || slot->spare_capacity < size + 3) {
+						void *tmp = realloc(slot->spare, size + 3); /* +3 to handle indi - reason unknown */
+						assert(tmp != NULL);
+						slot->spare = tmp;
+						slot->spare_capacity = size + 3;
+					}
+					return slot->spare;
+				}
+			}
+			break;
+		}
+	}
+	return NULL;
+}
+
+/** Release property defined by remote device together with its BLOB buffers.
+ */
+static void release_defined_property(parser_context *context, int index) {
+	indigo_property *property = context->properties[index];
+	if (property->type == INDIGO_BLOB_VECTOR) {
+		for (int i = 0; i < property->count; i++) {
+			void *blob = property->items[i].blob.value;
+			if (blob)
+				free(blob);
+		}
+	}
+	if (context->blob_slots[index]) {
+		for (int i = 0; i < property->count; i++) {
+			if (context->blob_slots[index][i].spare)
+				free(context->blob_slots[index][i].spare);
+		}
+		free(context->blob_slots[index]);
+		context->blob_slots[index] = NULL;
+	}
+	indigo_release_property(property);
+	context->properties[index] = NULL;
+}
+
 static void *set_one_text_vector_handler(parser_state state, parser_context *context, char *name, char *value, char *message) {
 	indigo_property *property = (indigo_property *)context->property_buffer;
 	indigo_device *device = context->device;
@@ -492,7 +609,7 @@ static void *set_text_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return set_text_vector_handler;
@@ -553,7 +670,7 @@ static void *set_number_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return set_number_vector_handler;
@@ -600,7 +717,7 @@ static void *set_switch_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return set_switch_vector_handler;
@@ -647,7 +764,7 @@ static void *set_light_vector_handler(parser_state state, parser_context *contex
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return set_light_vector_handler;
@@ -705,7 +822,7 @@ static void *set_blob_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		set_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return set_blob_vector_handler;
@@ -724,6 +841,8 @@ static void def_property(parser_context *context, indigo_property *other, char *
 	if (index == context->count) {
 		context->properties = realloc(context->properties, context->count * 2 * sizeof(indigo_property *));
 		memset(context->properties + context->count, 0, context->count * sizeof(indigo_property *));
+		context->blob_slots = realloc(context->blob_slots, context->count * 2 * sizeof(blob_slot *));
+		memset(context->blob_slots + context->count, 0, context->count * sizeof(blob_slot *));
 		context->count *= 2;
 		property = NULL;
 	}
@@ -748,12 +867,15 @@ static void def_property(parser_context *context, indigo_property *other, char *
 			case INDIGO_BLOB_VECTOR:
 				property = indigo_init_blob_property(property, other->device, other->name, other->group, other->label, other->state, other->count);
 				memcpy(property->items, other->items, other->count * sizeof(indigo_item));
+				context->blob_slots[index] = calloc(property->count, sizeof(blob_slot));
+				assert(context->blob_slots[index] != NULL);
 				for (int i = 0; i < property->count; i++) {
 					indigo_item *item = property->items + i;
 					if (item->blob.size > 0 && item->blob.value != NULL) {
 						void *tmp = malloc(item->blob.size);
 						memcpy(tmp, item->blob.value, item->blob.size);
 						item->blob.value = tmp;
+						context->blob_slots[index][i].capacity = item->blob.size;
 					}
 				}
 				break;
@@ -817,7 +939,7 @@ static void *def_text_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return def_text_vector_handler;
@@ -886,7 +1008,7 @@ static void *def_number_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return def_number_vector_handler;
@@ -947,7 +1069,7 @@ static void *def_switch_vector_handler(parser_state state, parser_context *conte
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return def_switch_vector_handler;
@@ -1004,7 +1126,7 @@ static void *def_light_vector_handler(parser_state state, parser_context *contex
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return def_light_vector_handler;
@@ -1065,7 +1187,7 @@ static void *def_blob_vector_handler(parser_state state, parser_context *context
 		}
 	} else if (state == END_TAG) {
 		def_property(context, property, message);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return def_blob_vector_handler;
@@ -1092,15 +1214,7 @@ static void *del_property_handler(parser_state state, parser_context *context, c
 				indigo_property *tmp = context->properties[i];
 				if (tmp != NULL && !strncmp(tmp->device, property->device, INDIGO_NAME_SIZE) && !strncmp(tmp->name, property->name, INDIGO_NAME_SIZE)) {
 					indigo_delete_property(device, tmp, *message ? message : NULL);
-					if (tmp->type == INDIGO_BLOB_VECTOR) {
-						for (int i = 0; i < tmp->count; i++) {
-							void *blob = tmp->items[i].blob.value;
-							if (blob)
-								free(blob);
-						}
-					}
-					indigo_release_property(tmp);
-					context->properties[i] = NULL;
+					release_defined_property(context, i);
 					break;
 				}
 			}
@@ -1109,12 +1223,11 @@ static void *del_property_handler(parser_state state, parser_context *context, c
 				indigo_property *tmp = context->properties[i];
 				if (tmp != NULL && !strncmp(tmp->device, property->device, INDIGO_NAME_SIZE)) {
 					indigo_delete_property(device, tmp, *message ? message : NULL);
-					indigo_release_property(tmp);
-					context->properties[i] = NULL;
+					release_defined_property(context, i);
 				}
 			}
 		}
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return del_property_handler;
@@ -1135,7 +1248,7 @@ static void *message_handler(parser_state state, parser_context *context, char *
 		}
 	} else if (state == END_TAG) {
 		indigo_send_message(device, *message ? message : NULL);
-		memset(property, 0, PROPERTY_SIZE);
+		reset_property(property);
 		return top_level_handler;
 	}
 	return message_handler;
@@ -1213,77 +1326,135 @@ static void *top_level_handler(parser_state state, parser_context *context, char
 	return top_level_handler;
 }
 
-void indigo_xml_parse(indigo_device *device, indigo_client *client) {
-	char *buffer = malloc(BUFFER_SIZE+3); /* BUFFER_SIZE % 4 == 0 and keep always +3 for base64 alignmet */
-	assert(buffer != NULL);
-	char *value_buffer = malloc(BUFFER_SIZE+1); /* +1 to accomodate \0" */
-	assert(value_buffer != NULL);
+/** Incremental parser state, everything the byte loop keeps between chunks.
+ */
+struct indigo_xml_parser {
+	parser_context *context;
+	int handle;											/* input handle, used for trace only */
+	parser_handler handler;
+	parser_state state;
 	char name_buffer[INDIGO_NAME_SIZE];
-	unsigned char *blob_buffer = NULL;
-	char *pointer = buffer;
-	char *buffer_end = NULL;
-	char *name_pointer = name_buffer;
-	char *value_pointer = value_buffer;
-	unsigned char *blob_pointer = NULL;
-	long blob_size = 0;
+	char *name_pointer;
+	char *value_buffer;
+	char *value_pointer;
 	char message[INDIGO_VALUE_SIZE];
-	char q = '"';
-	int depth = 0;
-	char c = 0;
 	char entity_buffer[8];
-	char *entity_pointer = NULL;
-	bool is_escaped = false;
-	/* (void)parser_state_name; */
-
-	parser_handler handler = top_level_handler;
+	char *entity_pointer;
+	bool is_escaped;
+	char q;
+	int depth;
+	unsigned char *blob_buffer;			/* used if BLOB can't be decoded to spare buffer of defined item */
+	unsigned char *blob_pointer;
+	unsigned char *blob_value;
+	long blob_size;
+	long blob_remaining;						/* base64 characters of INDIGO 2.0 BLOB not consumed yet */
+	unsigned char blob_carry[4];		/* base64 quartet split between chunks */
+	int blob_carry_length;
+};
 
-	parser_state state = IDLE;
+indigo_xml_parser *indigo_xml_parser_create(indigo_device *device, indigo_client *client) {
+	indigo_xml_parser *parser = malloc(sizeof(indigo_xml_parser));
+	assert(parser != NULL);
+	memset(parser, 0, sizeof(indigo_xml_parser));
+	parser->value_buffer = malloc(BUFFER_SIZE+1); /* +1 to accomodate \0" */
+	assert(parser->value_buffer != NULL);
+	parser->name_pointer = parser->name_buffer;
+	parser->value_pointer = parser->value_buffer;
+	parser->q = '"';
+	parser->handler = top_level_handler;
+	parser->state = IDLE;
 
-	parser_context *context = malloc(sizeof(parser_context));
+	parser_context *context = parser->context = malloc(sizeof(parser_context));
+	assert(context != NULL);
 	context->client = client;
 	context->device = device;
 	if (device != NULL) {
 		context->count = 32;
 		context->properties = malloc(context->count * sizeof(indigo_property *));
 		memset(context->properties, 0, context->count * sizeof(indigo_property *));
+		context->blob_slots = malloc(context->count * sizeof(blob_slot *));
+		memset(context->blob_slots, 0, context->count * sizeof(blob_slot *));
 	} else {
 		context->count = 0;
 		context->properties = NULL;
+		context->blob_slots = NULL;
 	}
-
-	indigo_property *property = (indigo_property *)&context->property_buffer;
 	memset(context->property_buffer, 0, PROPERTY_SIZE);
 
-	int handle = 0;
 	if (device != NULL) {
-		handle = ((indigo_adapter_context *)device->device_context)->input;
+		parser->handle = ((indigo_adapter_context *)device->device_context)->input;
 		device->enumerate_properties(device, client, NULL);
 	} else {
-		handle = ((indigo_adapter_context *)client->client_context)->input;
+		parser->handle = ((indigo_adapter_context *)client->client_context)->input;
 	}
-	*pointer = 0;
+	return parser;
+}
+
+bool indigo_xml_parser_feed(indigo_xml_parser *parser, const char *data, long length) {
+	parser_context *context = parser->context;
+	indigo_device *device = context->device;
+	indigo_property *property = (indigo_property *)&context->property_buffer;
+	char *name_buffer = parser->name_buffer;
+	char *value_buffer = parser->value_buffer;
+	char *entity_buffer = parser->entity_buffer;
+	char *message = parser->message;
+	char *name_pointer = parser->name_pointer;
+	char *value_pointer = parser->value_pointer;
+	char *entity_pointer = parser->entity_pointer;
+	bool is_escaped = parser->is_escaped;
+	char q = parser->q;
+	int depth = parser->depth;
+	parser_handler handler = parser->handler;
+	parser_state state = parser->state;
+	const char *pointer = data;
+	const char *buffer_end = data + length;
+	bool result = true;
+	char c = 0;
+	INDIGO_TRACE_PROTOCOL(indigo_trace("%d → %.*s", parser->handle, (int)length, data));
 	while (true) {
-		assert(pointer - buffer <= BUFFER_SIZE);
 		assert(value_pointer - value_buffer <= BUFFER_SIZE);
 		assert(name_pointer - name_buffer <= INDIGO_NAME_SIZE);
 		if (state == ERROR) {
 			indigo_error("XML Parser: syntax error");
-			goto exit_loop;
+			result = false;
+			break;
 		}
-		while ((c = *pointer++) == 0) {
-#if defined(INDIGO_WINDOWS)
-			ssize_t count = indigo_recv(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
-#else
-			ssize_t count = (int)read(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
-#endif
-			if (count <= 0) {
-				goto exit_loop;
+		if (entity_pointer == NULL && pointer < buffer_end) {
+			/* consume runs of plain characters at once */
+			const char *run;
+			switch (state) {
+				case IDLE:
+					pointer = scan_run(pointer, buffer_end, '<', '<');
+					break;
+				case TEXT:
+					run = scan_run(pointer, buffer_end, '<', '&');
+					if (depth == 2 || handler == enable_blob_handler) {
+						long length = run - pointer;
+						if (length > INDIGO_VALUE_SIZE - (value_pointer - value_buffer))
+							length = INDIGO_VALUE_SIZE - (value_pointer - value_buffer);
+						if (length > 0) {
+							memcpy(value_pointer, pointer, length);
+							value_pointer += length;
+						}
+					}
+					pointer = run;
+					break;
+				case ATTRIBUTE_VALUE:
+					run = scan_run(pointer, buffer_end, q, '&');
+					if (run - pointer > BUFFER_SIZE - (value_pointer - value_buffer))
+						run = pointer + (BUFFER_SIZE - (value_pointer - value_buffer));
+					memcpy(value_pointer, pointer, run - pointer);
+					value_pointer += run - pointer;
+					pointer = run;
+					break;
+				default:
+					break;
 			}
-			pointer = buffer;
-			buffer_end = buffer + count;
-			buffer[count] = 0;
-			INDIGO_TRACE_PROTOCOL(indigo_trace("%d → %s", handle, buffer));
 		}
+		if (pointer == buffer_end)
+			break;
+		if ((c = *pointer++) == 0)
+			continue;
 		if (c == '&') {
 			entity_pointer = entity_buffer;
 			continue;
@@ -1447,64 +1618,53 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 					state = TEXT1;
 					INDIGO_TRACE_PARSER(indigo_trace("XML Parser: '%c' BLOB_END -> TEXT1", c));
 				}
-				*name_pointer++ = c;
 				break;
 			case BLOB:
 				if (device->version >= INDIGO_VERSION_2_0) {
-					ssize_t count;
+					if (parser->blob_remaining == (parser->blob_size + 2) / 3 * 4 && isspace(c))
+						break;
+					/* decode whole quartets available in this chunk, incomplete one is carried over to the next chunk */
 					pointer--;
-					while (isspace(*pointer)) pointer++;
-					unsigned long blob_len = (blob_size + 2) / 3 * 4;
-					unsigned long len = (long)(buffer_end - pointer);
-					len = (len < blob_len) ? len : blob_len;
-					ssize_t bytes_needed = len % 4;
-					if(bytes_needed) bytes_needed = 4 - bytes_needed;
-					while (bytes_needed) {
-#if defined(INDIGO_WINDOWS)
-						count = indigo_recv(handle, (void *)buffer_end, bytes_needed);
-#else
-						count = (int)read(handle, (void *)buffer_end, bytes_needed);
-#endif
-						if (count <= 0)
-							goto exit_loop;
-						len += count;
-						bytes_needed -= count;
-						buffer_end += count;
-					}
-					blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)pointer, len);
-					pointer += len;
-					blob_len -= len;
-					while(blob_len) {
-						len = ((BUFFER_SIZE) < blob_len) ? (BUFFER_SIZE) : blob_len;
-						ssize_t to_read = len;
-						char *ptr = buffer;
-						while(to_read) {
-#if defined(INDIGO_WINDOWS)
-							count = indigo_recv(handle, (void *)ptr, to_read);
-#else
-							count = (int)read(handle, (void *)ptr, to_read);
-#endif
-							if (count <= 0)
-								goto exit_loop;
-							ptr += count;
-							to_read -= count;
+					long length = buffer_end - pointer;
+					if (length > parser->blob_remaining)
+						length = parser->blob_remaining;
+					parser->blob_remaining -= length;
+					if (parser->blob_carry_length > 0) {
+						long count = 4 - parser->blob_carry_length;
+						if (count > length)
+							count = length;
+						memcpy(parser->blob_carry + parser->blob_carry_length, pointer, count);
+						parser->blob_carry_length += count;
+						pointer += count;
+						length -= count;
+						if (parser->blob_carry_length == 4) {
+							parser->blob_pointer += base64_decode_fast(parser->blob_pointer, parser->blob_carry, 4);
+							parser->blob_carry_length = 0;
 						}
-						blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)buffer, len);
-						blob_len -= len;
 					}
-
-					handler = handler(BLOB, context, NULL, (char *)blob_buffer, message);
-					pointer = buffer;
-					*pointer = 0;
-					state = BLOB_END;
-					INDIGO_TRACE_PARSER(indigo_trace("XML Parser: '%c' %d BLOB -> BLOB_END", c, depth));
+					long whole = length & ~3L;
+					if (whole > 0) {
+						parser->blob_pointer += base64_decode_fast(parser->blob_pointer, (const unsigned char *)pointer, whole);
+						pointer += whole;
+						length -= whole;
+					}
+					if (length > 0) {
+						memcpy(parser->blob_carry, pointer, length);
+						parser->blob_carry_length = (int)length;
+						pointer += length;
+					}
+					if (parser->blob_remaining == 0) {
+						handler = handler(BLOB, context, NULL, (char *)parser->blob_value, message);
+						state = BLOB_END;
+						INDIGO_TRACE_PARSER(indigo_trace("XML Parser: '%c' %d BLOB -> BLOB_END", c, depth));
+					}
 					break;
 				} else {
 					if (c == '<') {
 						if (depth == 2) {
 							*value_pointer = 0;
-							blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)value_buffer, (int)(value_pointer-value_buffer));
-							handler = handler(BLOB, context, NULL, (char *)blob_buffer, message);
+							parser->blob_pointer += base64_decode_fast(parser->blob_pointer, (unsigned char*)value_buffer, (int)(value_pointer-value_buffer));
+							handler = handler(BLOB, context, NULL, (char *)parser->blob_value, message);
 						}
 						state = TEXT1;
 						INDIGO_TRACE_PARSER(indigo_trace("XML Parser: '%c' %d BLOB -> TEXT1", c, depth));
@@ -1515,7 +1675,7 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 								*value_pointer++ = c;
 							} else {
 								*value_pointer = 0;
-								blob_pointer += base64_decode_fast((unsigned char*)blob_pointer, (unsigned char*)value_buffer, (int)(value_pointer-value_buffer));
+								parser->blob_pointer += base64_decode_fast(parser->blob_pointer, (unsigned char*)value_buffer, (int)(value_pointer-value_buffer));
 								value_pointer = value_buffer;
 								*value_pointer++ = c;
 							}
@@ -1537,18 +1697,19 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 				} else if (c == '>') {
 					value_pointer = value_buffer;
 					if (handler == set_one_blob_vector_handler) {
-						blob_size = property->items[property->count-1].blob.size;
-						if (blob_size > 0) {
+						parser->blob_size = property->items[property->count-1].blob.size;
+						if (parser->blob_size > 0) {
 							state = BLOB;
-							if (blob_buffer != NULL) {
-								unsigned char *ptmp = realloc(blob_buffer, blob_size + 3); /* +3 to handle indi - reason unknown */
-								assert(ptmp != NULL);
-								blob_buffer = ptmp;
-							} else {
-								blob_buffer = malloc(blob_size + 3); /* +3 to handle indi - reason unknown */
-								assert(blob_buffer != NULL);
+							/* decode to the spare buffer of the defined property item if possible, set_property() swaps it in without copying */
+							parser->blob_pointer = blob_destination(context, property, property->items + property->count - 1, parser->blob_size);
+							if (parser->blob_pointer == NULL) {
+								unsigned char *tmp = realloc(parser->blob_buffer, parser->blob_size + 3); /* +3 to handle indi - reason unknown */
+								assert(tmp != NULL);
+								parser->blob_pointer = parser->blob_buffer = tmp;
 							}
-							blob_pointer = blob_buffer;
+							parser->blob_value = parser->blob_pointer;
+							parser->blob_remaining = (parser->blob_size + 2) / 3 * 4;
+							parser->blob_carry_length = 0;
 						} else {
 							state = TEXT;
 						}
@@ -1599,7 +1760,19 @@ void indigo_xml_parse(indigo_device *device, indigo_client *client) {
 				break;
 		}
 	}
-exit_loop:
+	parser->name_pointer = name_pointer;
+	parser->value_pointer = value_pointer;
+	parser->entity_pointer = entity_pointer;
+	parser->is_escaped = is_escaped;
+	parser->q = q;
+	parser->depth = depth;
+	parser->handler = handler;
+	parser->state = state;
+	return result;
+}
+
+void indigo_xml_parser_release(indigo_xml_parser *parser) {
+	parser_context *context = parser->context;
 	while (true) {
 		indigo_property *property = NULL;
 		int index;
@@ -1618,26 +1791,37 @@ exit_loop:
 		indigo_release_property(all_properties);
 		for (; index < context->count; index++) {
 			indigo_property *property = context->properties[index];
-			if (property != NULL && !strncmp(remote_device.name, property->device, INDIGO_NAME_SIZE)) {
-				if (property->type == INDIGO_BLOB_VECTOR) {
-					for (int i = 0; i < property->count; i++) {
-						void *blob = property->items[i].blob.value;
-						if (blob)
-							free(blob);
-					}
-				}
-				indigo_release_property(property);
-				context->properties[index] = NULL;
-			}
+			if (property != NULL && !strncmp(remote_device.name, property->device, INDIGO_NAME_SIZE))
+				release_defined_property(context, index);
 		}
 	}
-	if (blob_buffer != NULL)
-		free(blob_buffer);
+	if (parser->blob_buffer != NULL)
+		free(parser->blob_buffer);
 	if (context->properties)
 		free(context->properties);
+	if (context->blob_slots)
+		free(context->blob_slots);
 	free(context);
+	free(parser->value_buffer);
+	free(parser);
+}
+
+void indigo_xml_parse(indigo_device *device, indigo_client *client) {
+	indigo_xml_parser *parser = indigo_xml_parser_create(device, client);
+	int handle = parser->handle;
+	char *buffer = malloc(BUFFER_SIZE);
+	assert(buffer != NULL);
+	while (true) {
+#if defined(INDIGO_WINDOWS)
+		ssize_t count = indigo_recv(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
+#else
+		ssize_t count = (int)read(handle, (void *)buffer, (ssize_t)BUFFER_SIZE);
+#endif
+		if (count <= 0 || !indigo_xml_parser_feed(parser, buffer, count))
+			break;
+	}
 	free(buffer);
-	free(value_buffer);
+	indigo_xml_parser_release(parser);
 	close(handle);
 	INDIGO_TRACE_PARSER(indigo_trace("XML Parser: parser finished"));
 }
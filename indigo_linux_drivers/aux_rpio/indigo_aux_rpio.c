@@ -614,23 +614,23 @@ static indigo_result aux_change_property(indigo_device *device, indigo_client *c
 			indigo_delete_property(device, AUX_GPIO_OUTLET_PROPERTY, NULL);
 			indigo_delete_property(device, AUX_OUTLET_PULSE_LENGTHS_PROPERTY, NULL);
 		}
-		snprintf(AUX_GPIO_OUTLET_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_2_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_3_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_4_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_5_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_5_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_6_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_6_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_7_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_7_ITEM->text.value);
-		snprintf(AUX_GPIO_OUTLET_8_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_8_ITEM->text.value);
-
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_2_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_3_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_4_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_5_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_5_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_6_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_6_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_7_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_7_ITEM->text.value);
-		snprintf(AUX_OUTLET_PULSE_LENGTHS_8_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_OUTLET_NAME_8_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_1_ITEM, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_2_ITEM, "%s", AUX_OUTLET_NAME_2_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_3_ITEM, "%s", AUX_OUTLET_NAME_3_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_4_ITEM, "%s", AUX_OUTLET_NAME_4_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_5_ITEM, "%s", AUX_OUTLET_NAME_5_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_6_ITEM, "%s", AUX_OUTLET_NAME_6_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_7_ITEM, "%s", AUX_OUTLET_NAME_7_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_OUTLET_8_ITEM, "%s", AUX_OUTLET_NAME_8_ITEM->text.value);
+
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_1_ITEM, "%s", AUX_OUTLET_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_2_ITEM, "%s", AUX_OUTLET_NAME_2_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_3_ITEM, "%s", AUX_OUTLET_NAME_3_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_4_ITEM, "%s", AUX_OUTLET_NAME_4_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_5_ITEM, "%s", AUX_OUTLET_NAME_5_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_6_ITEM, "%s", AUX_OUTLET_NAME_6_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_7_ITEM, "%s", AUX_OUTLET_NAME_7_ITEM->text.value);
+		indigo_set_item_label(AUX_OUTLET_PULSE_LENGTHS_8_ITEM, "%s", AUX_OUTLET_NAME_8_ITEM->text.value);
 
 		AUX_OUTLET_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 		if (IS_CONNECTED) {
@@ -664,14 +664,14 @@ static indigo_result aux_change_property(indigo_device *device, indigo_client *c
 		if (IS_CONNECTED) {
 			indigo_delete_property(device, AUX_GPIO_SENSORS_PROPERTY, NULL);
 		}
-		snprintf(AUX_GPIO_SENSOR_1_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_1_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_2_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_2_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_3_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_3_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_4_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_4_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_5_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_5_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_6_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_6_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_7_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_7_ITEM->text.value);
-		snprintf(AUX_GPIO_SENSOR_8_ITEM->label, INDIGO_NAME_SIZE, "%s", AUX_SENSOR_NAME_8_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_1_ITEM, "%s", AUX_SENSOR_NAME_1_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_2_ITEM, "%s", AUX_SENSOR_NAME_2_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_3_ITEM, "%s", AUX_SENSOR_NAME_3_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_4_ITEM, "%s", AUX_SENSOR_NAME_4_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_5_ITEM, "%s", AUX_SENSOR_NAME_5_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_6_ITEM, "%s", AUX_SENSOR_NAME_6_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_7_ITEM, "%s", AUX_SENSOR_NAME_7_ITEM->text.value);
+		indigo_set_item_label(AUX_GPIO_SENSOR_8_ITEM, "%s", AUX_SENSOR_NAME_8_ITEM->text.value);
 		AUX_SENSOR_NAMES_PROPERTY->state = INDIGO_OK_STATE;
 		if (IS_CONNECTED) {
 			indigo_define_property(device, AUX_GPIO_SENSORS_PROPERTY, NULL);
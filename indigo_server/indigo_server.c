@@ -47,6 +47,7 @@
 #include <indigo/indigo_driver.h>
 #include <indigo/indigo_client.h>
 #include <indigo/indigo_xml.h>
+#include <indigo/indigo_driver_xml.h>
 #include <indigo/indigo_token.h>
 
 #include "indigo_cat_data.h"
@@ -981,6 +982,28 @@ static void server_main() {
 			use_web_apps = false;
 		} else if (!strcmp(server_argv[i], "-u-") || !strcmp(server_argv[i], "--disable-blob-urls")) {
 			indigo_use_blob_urls = false;
+		} else if ((!strcmp(server_argv[i], "-q") || !strcmp(server_argv[i], "--output-queue-policy")) && i < server_argc - 1) {
+			if (!strcmp(server_argv[i + 1], "all"))
+				indigo_xml_output_queue_policy = INDIGO_OUTPUT_QUEUE_KEEP_ALL;
+			else if (!strcmp(server_argv[i + 1], "latest"))
+				indigo_xml_output_queue_policy = INDIGO_OUTPUT_QUEUE_KEEP_LATEST;
+			else if (!strcmp(server_argv[i + 1], "drop"))
+				indigo_xml_output_queue_policy = INDIGO_OUTPUT_QUEUE_DROP;
+			else
+				indigo_error("Unknown output queue policy '%s'", server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-Q") || !strcmp(server_argv[i], "--output-queue-size")) && i < server_argc - 1) {
+			indigo_xml_output_queue_size = atoi(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-M") || !strcmp(server_argv[i], "--output-queue-memory")) && i < server_argc - 1) {
+			indigo_xml_output_queue_memory = atol(server_argv[i + 1]) * 1024 * 1024;
+			i++;
+		} else if ((!strcmp(server_argv[i], "-U") || !strcmp(server_argv[i], "--coalesce-updates")) && i < server_argc - 1) {
+			indigo_update_coalescing_interval = atoi(server_argv[i + 1]);
+			i++;
+		} else if ((!strcmp(server_argv[i], "-W") || !strcmp(server_argv[i], "--server-workers")) && i < server_argc - 1) {
+			indigo_server_tcp_workers = atoi(server_argv[i + 1]);
+			i++;
 #ifdef RPI_MANAGEMENT
 		} else if (!strcmp(server_argv[i], "-f") || !strcmp(server_argv[i], "--enable-rpi-management")) {
 			FILE *output = popen("which s_rpi_ctrl.sh", "r");
@@ -1243,6 +1266,11 @@ int main(int argc, const char * argv[]) {
 			       "       -a  | --acl-file file\n"
 			       "       -b- | --disable-bonjour\n"
 			       "       -u- | --disable-blob-urls\n"
+			       "       -q  | --output-queue-policy all|latest|drop (default: latest)\n"
+			       "       -Q  | --output-queue-size size        (default: 256)\n"
+			       "       -M  | --output-queue-memory MB        (default: 256)\n"
+			       "       -U  | --coalesce-updates ms           (default: 0 = disabled)\n"
+			       "       -W  | --server-workers count          (default: 4, 0 = thread per connection)\n"
 			       "       -w- | --disable-web-apps\n"
 			       "       -c- | --disable-control-panel\n"
 #ifdef RPI_MANAGEMENT
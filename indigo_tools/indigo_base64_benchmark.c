@@ -0,0 +1,112 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// base64 encoder and decoder benchmark, best of given number of runs over a random buffer
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <indigo/indigo_base64.h>
+
+#define LINE_LENGTH	76
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+	long size = 64 * 1024 * 1024;
+	int runs = 10;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			size = atol(argv[++i]);
+		} else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			runs = atoi(argv[++i]);
+		} else {
+			printf("usage: %s [-s buffer size] [-r runs]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (size < 1)
+		size = 1;
+	if (runs < 1)
+		runs = 1;
+	long encoded_size = (size + 2) / 3 * 4;
+	unsigned char *data = malloc(size);
+	unsigned char *encoded = malloc(encoded_size + 4);
+	unsigned char *wrapped = malloc(encoded_size + encoded_size / LINE_LENGTH + 4);
+	unsigned char *decoded = malloc(size + 4);
+	if (data == NULL || encoded == NULL || wrapped == NULL || decoded == NULL) {
+		printf("Can't allocate buffers\n");
+		return 1;
+	}
+	srand(1);
+	for (long i = 0; i < size; i++)
+		data[i] = rand();
+	double encode_time = 1e9, decode_time = 1e9, decode_nl_time = 1e9;
+	long length = 0, decoded_length = 0, decoded_nl_length = 0;
+	for (int run = 0; run < runs; run++) {
+		double start = now();
+		length = base64_encode(encoded, data, size);
+		double time = now() - start;
+		if (time < encode_time)
+			encode_time = time;
+	}
+	for (int run = 0; run < runs; run++) {
+		double start = now();
+		decoded_length = base64_decode_fast(decoded, encoded, length);
+		double time = now() - start;
+		if (time < decode_time)
+			decode_time = time;
+	}
+	bool ok = decoded_length == size && !memcmp(decoded, data, size);
+	long wrapped_length = 0;
+	for (long i = 0; i < length; i += LINE_LENGTH) {
+		long line = length - i < LINE_LENGTH ? length - i : LINE_LENGTH;
+		if (i)
+			wrapped[wrapped_length++] = '\n';
+		memcpy(wrapped + wrapped_length, encoded + i, line);
+		wrapped_length += line;
+	}
+	memset(decoded, 0, size);
+	for (int run = 0; run < runs; run++) {
+		double start = now();
+		decoded_nl_length = base64_decode_fast_nl(decoded, wrapped, length);
+		double time = now() - start;
+		if (time < decode_nl_time)
+			decode_nl_time = time;
+	}
+	ok = ok && decoded_nl_length == size && !memcmp(decoded, data, size);
+	double mb = size / 1048576.0;
+	printf("%ld bytes, best of %d runs\n", size, runs);
+	printf("base64_encode:         %8.1f MB/s\n", mb / encode_time);
+	printf("base64_decode_fast:    %8.1f MB/s\n", mb / decode_time);
+	printf("base64_decode_fast_nl: %8.1f MB/s (%d character lines)\n", mb / decode_nl_time, LINE_LENGTH);
+	if (!ok)
+		printf("Decoded data don't match\n");
+	free(data);
+	free(encoded);
+	free(wrapped);
+	free(decoded);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2026 CloudMakers, s. r. o.
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// XML parser benchmark, client side parser is fed by a pipe with number updates and inline BLOBs
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <indigo/indigo_bus.h>
+#include <indigo/indigo_xml.h>
+#include <indigo/indigo_client_xml.h>
+#include <indigo/indigo_base64.h>
+
+static long number_count = 100000;
+static long blob_count = 100;
+static long blob_size = 8 * 1024 * 1024;
+static int output;
+
+static long number_updates = 0;
+static long blob_updates = 0;
+static long blob_errors = 0;
+static double numbers_done = 0;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void write_all(const char *data, long length) {
+	while (length > 0) {
+		ssize_t written = write(output, data, length);
+		if (written <= 0)
+			return;
+		data += written;
+		length -= written;
+	}
+}
+
+static void *feed(void *arg) {
+	char buffer[1024];
+	unsigned char *blob = malloc(blob_size);
+	char *encoded = malloc((blob_size + 2) / 3 * 4 + 1);
+	write_all("<switchProtocol version='2.0'/>", 31);
+	int length = sprintf(buffer, "<defNumberVector device='Benchmark' name='NUMBERS' group='Main' label='Numbers' state='Idle' perm='ro'><defNumber name='A' label='A' format='%%g' min='0' max='1e9' step='1'>0</defNumber><defNumber name='B' label='B' format='%%g' min='0' max='1e9' step='1'>0</defNumber></defNumberVector>");
+	write_all(buffer, length);
+	length = sprintf(buffer, "<defBLOBVector device='Benchmark' name='IMAGE' group='Main' label='Image' state='Idle' perm='ro'><defBLOB name='IMAGE' label='Image'/></defBLOBVector>");
+	write_all(buffer, length);
+	for (long i = 0; i < number_count; i++) {
+		length = sprintf(buffer, "<setNumberVector device='Benchmark' name='NUMBERS' state='Busy'><oneNumber name='A'>%ld</oneNumber><oneNumber name='B'>%ld.5</oneNumber></setNumberVector>", i, i);
+		write_all(buffer, length);
+	}
+	for (long i = 0; i < blob_count; i++) {
+		memset(blob, (int)(i & 0xFF), blob_size);
+		long encoded_length = base64_encode((unsigned char *)encoded, blob, blob_size);
+		length = sprintf(buffer, "<setBLOBVector device='Benchmark' name='IMAGE' state='Ok'><oneBLOB name='IMAGE' format='.raw' size='%ld'>", blob_size);
+		write_all(buffer, length);
+		write_all(encoded, encoded_length);
+		write_all("</oneBLOB></setBLOBVector>", 26);
+	}
+	free(encoded);
+	free(blob);
+	close(output);
+	return NULL;
+}
+
+static indigo_result client_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
+	if (property->type == INDIGO_NUMBER_VECTOR) {
+		if (++number_updates == number_count)
+			numbers_done = now();
+	} else if (property->type == INDIGO_BLOB_VECTOR) {
+		unsigned char *value = property->items[0].blob.value;
+		unsigned char expected = (unsigned char)(blob_updates & 0xFF);
+		if (value == NULL || property->items[0].blob.size != blob_size || value[0] != expected || value[blob_size - 1] != expected)
+			blob_errors++;
+		blob_updates++;
+	}
+	return INDIGO_OK;
+}
+
+static indigo_client client = {
+	"indigo_parser_benchmark", false, NULL, INDIGO_OK, INDIGO_VERSION_CURRENT, NULL,
+	NULL,
+	NULL,
+	client_update_property,
+	NULL,
+	NULL,
+	NULL
+};
+
+int main(int argc, char **argv) {
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			number_count = atol(argv[++i]);
+		} else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			blob_count = atol(argv[++i]);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			blob_size = atol(argv[++i]);
+		} else {
+			printf("usage: %s [-n number updates] [-b BLOB updates] [-s BLOB size]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (blob_size < 1)
+		blob_size = 1;
+	int input[2];
+	if (pipe(input) < 0) {
+		perror("pipe");
+		return 1;
+	}
+	output = input[1];
+	int null = open("/dev/null", O_WRONLY);
+	indigo_start();
+	indigo_attach_client(&client);
+	indigo_device *adapter = indigo_xml_client_adapter("Benchmark", "", input[0], null);
+	indigo_attach_device(adapter);
+	pthread_t thread;
+	pthread_create(&thread, NULL, feed, NULL);
+	double start = now();
+	indigo_xml_parse(adapter, NULL);
+	double time = now() - start;
+	pthread_join(thread, NULL);
+	indigo_detach_device(adapter);
+	free(adapter->device_context);
+	free(adapter);
+	indigo_detach_client(&client);
+	indigo_stop();
+	double number_time = number_count > 0 ? numbers_done - start : 0, blob_time = time - number_time;
+	printf("%ld number updates, %ld BLOB updates of %ld bytes (%ld errors) in %.3fs\n", number_updates, blob_updates, blob_size, blob_errors, time);
+	if (number_time > 0)
+		printf("number updates: %.0f messages/s\n", number_updates / number_time);
+	if (blob_time > 0 && blob_updates > 0)
+		printf("BLOB updates: %.1f frames/s, %.1f MB/s decoded\n", blob_updates / blob_time, blob_updates * (double)blob_size / blob_time / 1048576);
+	return blob_errors || number_updates != number_count || blob_updates != blob_count;
+}